@@ -18,17 +18,24 @@
  *
  */
 
+#include <algorithm>
 #include <assert.h>
 #include <boost/program_options.hpp>
 #include <filesystem>
 #include <iostream>
-#include <map>
+#include <memory>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
+#ifdef BBASM_ZLIB
+#include <zlib.h>
+#endif
 
 enum TokenType : int8_t
 {
@@ -49,15 +56,27 @@ struct Stream
 
 Stream stringStream;
 std::vector<Stream> streams;
-std::map<std::string, int> streamIndex;
+std::unordered_map<std::string, int> streamIndex;
 std::vector<int> streamStack;
 
 std::vector<int> labels;
 std::vector<std::string> labelNames;
-std::map<std::string, int> labelIndex;
+std::unordered_map<std::string, int> labelIndex;
 
 std::vector<std::string> preText, postText;
 
+bool debug = false;
+
+// Compressed output: the blob is split into blocks of this size, each compressed on its own with zlib (see README.md)
+const char compressedMagic[8] = {'B', 'B', 'A', 'Z', 'L', 'I', 'B', '1'};
+const uint32_t compressedBlockSize = 1024 * 1024;
+
+void writeU32(std::vector<uint8_t> &out, uint32_t value, bool bigEndian)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(value >> (bigEndian ? (24 - 8 * i) : (8 * i)));
+}
+
 const char *skipWhitespace(const char *p)
 {
     if (p == nullptr)
@@ -67,14 +86,408 @@ const char *skipWhitespace(const char *p)
     return p;
 }
 
+// Input is parsed in batches of lines. Each batch is split into one chunk per thread, and the chunks are parsed in
+// parallel, which leaves only the bookkeeping of streams and labels to be done in order, when merging the parsed chunks.
+// The batch size doesn't depend on the number of threads, so neither does the memory used by the buffer.
+const size_t batchSize = 16 * 1024 * 1024;
+
+enum CommandType : int8_t
+{
+    CMD_PRE,
+    CMD_POST,
+    CMD_PUSH,
+    CMD_POP,
+    CMD_TOKEN,
+    CMD_STR
+};
+
+struct Command
+{
+    CommandType type;
+    TokenType tokenType;
+    // For labels, references and strings, a label index local to the chunk. For pre, post and push, an index into
+    // Chunk::text. Otherwise the value of the token.
+    uint32_t value;
+};
+
+struct Chunk
+{
+    std::vector<Command> commands;
+    std::vector<const char *> text;
+    // Only kept for debug output
+    std::vector<const char *> comments;
+    // Labels are numbered by first use within the chunk, and only given global indices when merging. Strings have
+    // their own labels, named after their contents.
+    std::vector<std::pair<std::string_view, bool>> labelNames;
+    std::unordered_map<std::string_view, int> labelIndex, stringIndex;
+    // The contents of each string, in the order of their commands
+    std::vector<const char *> strings;
+};
+
+// Split off the next whitespace separated word of a zero-terminated line, like strtok
+char *nextWord(char *&p)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    char *word = p;
+    while (*p != 0 && *p != ' ' && *p != '\t')
+        p++;
+    if (*p != 0)
+        *p++ = 0;
+    return word;
+}
+
+int chunkLabel(Chunk &chunk, std::string_view name, bool isString)
+{
+    auto &index = isString ? chunk.stringIndex : chunk.labelIndex;
+    auto found = index.emplace(name, int(chunk.labelNames.size()));
+    if (found.second)
+        chunk.labelNames.emplace_back(name, isString);
+    return found.first->second;
+}
+
+// Parse the complete lines in [begin, end), modifying the text in place
+void parseChunk(char *begin, char *end, Chunk &chunk, bool keepComments)
+{
+    auto addComment = [&](const char *comment) {
+        if (keepComments)
+            chunk.comments.push_back(comment);
+    };
+    for (char *line = begin; line < end;) {
+        char *lineEnd = static_cast<char *>(memchr(line, '\n', end - line));
+        assert(lineEnd != nullptr);
+        *lineEnd = 0;
+        if (lineEnd > line && lineEnd[-1] == '\r')
+            lineEnd[-1] = 0;
+        char *p = line;
+        line = lineEnd + 1;
+
+        std::string_view cmd = nextWord(p);
+        if (cmd.empty())
+            continue;
+
+        if (cmd == "pre" || cmd == "post" || cmd == "push") {
+            const char *text = skipWhitespace(cmd == "push" ? nextWord(p) : p);
+            chunk.commands.push_back({cmd == "pre" ? CMD_PRE : cmd == "post" ? CMD_POST : CMD_PUSH, TOK_LABEL,
+                                      uint32_t(chunk.text.size())});
+            chunk.text.push_back(text);
+            continue;
+        }
+
+        if (cmd == "pop") {
+            chunk.commands.push_back({CMD_POP, TOK_LABEL, 0});
+            continue;
+        }
+
+        if (cmd == "label" || cmd == "ref") {
+            const char *label = nextWord(p);
+            chunk.commands.push_back(
+                    {CMD_TOKEN, cmd == "label" ? TOK_LABEL : TOK_REF, uint32_t(chunkLabel(chunk, label, false))});
+            addComment(skipWhitespace(p));
+            continue;
+        }
+
+        if (cmd == "u8" || cmd == "u16" || cmd == "u32") {
+            const char *value = nextWord(p);
+            chunk.commands.push_back(
+                    {CMD_TOKEN, cmd == "u8" ? TOK_U8 : cmd == "u16" ? TOK_U16 : TOK_U32, uint32_t(atoll(value))});
+            addComment(skipWhitespace(p));
+            continue;
+        }
+
+        if (cmd == "str") {
+            char *value = const_cast<char *>(skipWhitespace(p));
+            assert(*value != 0);
+            char *strEnd = strchr(value + 1, *value);
+            assert(strEnd != nullptr);
+            *strEnd = 0;
+            value += 1;
+            chunk.commands.push_back({CMD_STR, TOK_REF, uint32_t(chunkLabel(chunk, value, true))});
+            chunk.strings.push_back(value);
+            addComment(skipWhitespace(strEnd + 1));
+            continue;
+        }
+
+        printf("Unknown command '%s'\n", std::string(cmd).c_str());
+        exit(-1);
+    }
+}
+
+int globalLabel(const std::string &name)
+{
+    auto found = labelIndex.emplace(name, int(labels.size()));
+    if (found.second) {
+        if (debug)
+            labelNames.push_back(name);
+        labels.push_back(-1);
+    }
+    return found.first->second;
+}
+
+void pushString(const char *value)
+{
+    while (1) {
+        stringStream.tokenTypes.push_back(TOK_U8);
+        stringStream.tokenValues.push_back(*value);
+        if (debug) {
+            char char_comment[4] = {'\'', *value, '\'', 0};
+            if (*value < 32 || *value >= 127)
+                char_comment[0] = 0;
+            stringStream.tokenComments.push_back(char_comment);
+        }
+        if (*value == 0)
+            break;
+        value++;
+    }
+}
+
+// Add the commands of a parsed chunk to the streams, in order
+void mergeChunk(const Chunk &chunk)
+{
+    std::vector<int> globalLabels;
+    globalLabels.reserve(chunk.labelNames.size());
+    for (auto &label : chunk.labelNames)
+        globalLabels.push_back(globalLabel((label.second ? "str:" : "") + std::string(label.first)));
+
+    size_t nextComment = 0, nextString = 0;
+    for (auto &c : chunk.commands) {
+        switch (c.type) {
+        case CMD_PRE:
+            preText.push_back(chunk.text.at(c.value));
+            break;
+        case CMD_POST:
+            postText.push_back(chunk.text.at(c.value));
+            break;
+        case CMD_PUSH: {
+            const char *name = chunk.text.at(c.value);
+            auto found = streamIndex.emplace(name, int(streams.size()));
+            if (found.second) {
+                streams.resize(streams.size() + 1);
+                streams.back().name = name;
+            }
+            streamStack.push_back(found.first->second);
+            break;
+        }
+        case CMD_POP:
+            streamStack.pop_back();
+            break;
+        case CMD_TOKEN:
+        case CMD_STR: {
+            Stream &s = streams.at(streamStack.back());
+            bool isLabel = c.type == CMD_STR || c.tokenType == TOK_LABEL || c.tokenType == TOK_REF;
+            s.tokenTypes.push_back(c.tokenType);
+            s.tokenValues.push_back(isLabel ? globalLabels.at(c.value) : c.value);
+            if (debug)
+                s.tokenComments.push_back(chunk.comments.at(nextComment++));
+            if (c.type == CMD_STR) {
+                stringStream.tokenTypes.push_back(TOK_LABEL);
+                stringStream.tokenValues.push_back(globalLabels.at(c.value));
+                if (debug)
+                    stringStream.tokenComments.push_back("");
+                pushString(chunk.strings.at(nextString++));
+            }
+            break;
+        }
+        }
+    }
+}
+
+void readText(FILE *fileIn, int threads)
+{
+    // Not a std::vector, which would zero the whole buffer before it is read into. One more byte than the batch is
+    // allocated, for the newline added after an unterminated last line.
+    size_t capacity = batchSize;
+    std::unique_ptr<char[]> buffer(new char[capacity + 1]);
+    size_t chunkSize = std::max<size_t>(1, batchSize / threads);
+    size_t carried = 0;
+    bool eof = false;
+    while (!eof) {
+        // Read a batch, keeping any incomplete line at its end for the next one
+        size_t count = fread(buffer.get() + carried, 1, capacity - carried, fileIn);
+        eof = count < capacity - carried;
+        size_t size = carried + count;
+        if (eof && size > 0 && buffer[size - 1] != '\n')
+            buffer[size++] = '\n';
+        char *begin = buffer.get();
+        char *end = begin + size;
+        while (end > begin && end[-1] != '\n')
+            end--;
+        if (end == begin && !eof) {
+            // A line longer than a whole batch, so make room for more of it
+            std::unique_ptr<char[]> grown(new char[2 * capacity + 1]);
+            std::copy(begin, begin + size, grown.get());
+            buffer = std::move(grown);
+            capacity *= 2;
+            carried = size;
+            continue;
+        }
+
+        // Split into chunks at line boundaries
+        std::vector<std::pair<char *, char *>> ranges;
+        for (char *p = begin; p < end;) {
+            char *q = p + std::min<size_t>(chunkSize, end - p);
+            while (q < end && q[-1] != '\n')
+                q++;
+            ranges.emplace_back(p, q);
+            p = q;
+        }
+        std::vector<Chunk> chunks(ranges.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < ranges.size(); i++)
+            workers.emplace_back(parseChunk, ranges[i].first, ranges[i].second, std::ref(chunks[i]), debug);
+        if (!ranges.empty())
+            parseChunk(ranges[0].first, ranges[0].second, chunks[0], debug);
+        for (auto &w : workers)
+            w.join();
+        for (auto &chunk : chunks)
+            mergeChunk(chunk);
+
+        carried = size - (end - begin);
+        std::copy(end, begin + size, begin);
+    }
+}
+
+// Compact binary input, as written by BinaryBBAWriter in himbaechel_dbgen/bba.py: after the magic, a sequence of
+// commands, each one byte followed by its arguments. Numbers are unsigned LEB128, strings are a length followed by that
+// many bytes. Label names are given once, by BIN_NAME, and then referred to by their number in order of definition.
+const char binaryMagic[8] = {'B', 'B', 'A', 'B', 'I', 'N', '0', '1'};
+
+enum BinaryCommand : uint8_t
+{
+    BIN_PRE,
+    BIN_POST,
+    BIN_PUSH,
+    BIN_POP,
+    BIN_NAME,
+    BIN_LABEL,
+    BIN_REF,
+    BIN_U8,
+    BIN_U16,
+    BIN_U32,
+    BIN_STR
+};
+
+struct BinaryReader
+{
+    FILE *f;
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(1024 * 1024);
+    size_t pos = 0, size = 0;
+
+    bool atEnd()
+    {
+        if (pos == size) {
+            size = fread(buffer.data(), 1, buffer.size(), f);
+            pos = 0;
+        }
+        return size == 0;
+    }
+
+    uint8_t byte()
+    {
+        if (atEnd()) {
+            printf("Unexpected end of binary input\n");
+            exit(-1);
+        }
+        return buffer[pos++];
+    }
+
+    uint32_t number()
+    {
+        uint32_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b = byte();
+            value |= uint32_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+    }
+
+    std::string string()
+    {
+        std::string s(number(), '\0');
+        for (auto &c : s)
+            c = byte();
+        return s;
+    }
+};
+
+void readBinary(FILE *fileIn)
+{
+    BinaryReader in{fileIn};
+    std::vector<int> names;
+    auto addToken = [&](TokenType type, uint32_t value) {
+        Stream &s = streams.at(streamStack.back());
+        s.tokenTypes.push_back(type);
+        s.tokenValues.push_back(value);
+        if (debug)
+            s.tokenComments.push_back("");
+    };
+    while (!in.atEnd()) {
+        switch (in.byte()) {
+        case BIN_PRE:
+            preText.push_back(in.string());
+            break;
+        case BIN_POST:
+            postText.push_back(in.string());
+            break;
+        case BIN_PUSH: {
+            std::string name = in.string();
+            auto found = streamIndex.emplace(name, int(streams.size()));
+            if (found.second) {
+                streams.resize(streams.size() + 1);
+                streams.back().name = name;
+            }
+            streamStack.push_back(found.first->second);
+            break;
+        }
+        case BIN_POP:
+            streamStack.pop_back();
+            break;
+        case BIN_NAME:
+            names.push_back(globalLabel(in.string()));
+            break;
+        case BIN_LABEL:
+            addToken(TOK_LABEL, names.at(in.number()));
+            break;
+        case BIN_REF:
+            addToken(TOK_REF, names.at(in.number()));
+            break;
+        case BIN_U8:
+            addToken(TOK_U8, in.number());
+            break;
+        case BIN_U16:
+            addToken(TOK_U16, in.number());
+            break;
+        case BIN_U32:
+            addToken(TOK_U32, in.number());
+            break;
+        case BIN_STR: {
+            std::string value = in.string();
+            int label = globalLabel("str:" + value);
+            addToken(TOK_REF, label);
+            stringStream.tokenTypes.push_back(TOK_LABEL);
+            stringStream.tokenValues.push_back(label);
+            if (debug)
+                stringStream.tokenComments.push_back("");
+            pushString(value.c_str());
+            break;
+        }
+        default:
+            printf("Invalid binary input\n");
+            exit(-1);
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
-    bool debug = false;
     bool verbose = false;
     bool bigEndian;
     bool writeC = false;
     bool writeE = false;
-    char buffer[512];
+    bool writeZ = false;
+    // A few threads are enough to keep up with reading the input, and bbasm usually runs alongside other build jobs
+    int threads = std::max(1U, std::min(4U, std::thread::hardware_concurrency()));
 
     namespace po = boost::program_options;
     po::positional_options_description pos;
@@ -86,6 +499,8 @@ int main(int argc, char **argv)
     options.add_options()("le,l", "little endian");
     options.add_options()("c,c", "write C strings");
     options.add_options()("e,e", "write #embed C");
+    options.add_options()("z,z", "write compressed binary");
+    options.add_options()("threads,j", po::value<int>(), "number of threads used to parse text input and compress output (default: up to 4)");
     options.add_options()("files", po::value<std::vector<std::string>>(), "file parameters");
     pos.add("files", -1);
 
@@ -120,11 +535,21 @@ int main(int argc, char **argv)
         writeC = true;
     if (vm.count("e"))
         writeE = true;
+    if (vm.count("z"))
+        writeZ = true;
+    if (vm.count("threads"))
+        threads = std::max(1, vm["threads"].as<int>());
 
-    if (writeC && writeE) {
+    if (int(writeC) + int(writeE) + int(writeZ) > 1) {
         printf("Incompatible modes\n");
         exit(-1);
     }
+#ifndef BBASM_ZLIB
+    if (writeZ) {
+        printf("Compressed output requires bbasm to be built with zlib\n");
+        exit(-1);
+    }
+#endif
     if (vm.count("files") == 0) {
         printf("File parameters are mandatory\n");
         exit(-1);
@@ -135,111 +560,18 @@ int main(int argc, char **argv)
         exit(-1);
     }
 
-    FILE *fileIn = fopen(files.at(0).c_str(), "rt");
+    FILE *fileIn = fopen(files.at(0).c_str(), "rb");
     assert(fileIn != nullptr);
 
     FILE *fileOut = fopen(files.at(1).c_str(), writeC ? "wt" : "wb");
     assert(fileOut != nullptr);
 
-    while (fgets(buffer, 512, fileIn) != nullptr) {
-        std::string cmd = strtok(buffer, " \t\r\n");
-
-        if (cmd == "pre") {
-            const char *p = skipWhitespace(strtok(nullptr, "\r\n"));
-            preText.push_back(p);
-            continue;
-        }
-
-        if (cmd == "post") {
-            const char *p = skipWhitespace(strtok(nullptr, "\r\n"));
-            postText.push_back(p);
-            continue;
-        }
-
-        if (cmd == "push") {
-            const char *p = strtok(nullptr, " \t\r\n");
-            if (streamIndex.count(p) == 0) {
-                streamIndex[p] = streams.size();
-                streams.resize(streams.size() + 1);
-                streams.back().name = p;
-            }
-            streamStack.push_back(streamIndex.at(p));
-            continue;
-        }
-
-        if (cmd == "pop") {
-            streamStack.pop_back();
-            continue;
-        }
-
-        if (cmd == "label" || cmd == "ref") {
-            const char *label = strtok(nullptr, " \t\r\n");
-            const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
-            Stream &s = streams.at(streamStack.back());
-            if (labelIndex.count(label) == 0) {
-                labelIndex[label] = labels.size();
-                if (debug)
-                    labelNames.push_back(label);
-                labels.push_back(-1);
-            }
-            s.tokenTypes.push_back(cmd == "label" ? TOK_LABEL : TOK_REF);
-            s.tokenValues.push_back(labelIndex.at(label));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            continue;
-        }
-
-        if (cmd == "u8" || cmd == "u16" || cmd == "u32") {
-            const char *value = strtok(nullptr, " \t\r\n");
-            const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
-            Stream &s = streams.at(streamStack.back());
-            s.tokenTypes.push_back(cmd == "u8" ? TOK_U8 : cmd == "u16" ? TOK_U16 : TOK_U32);
-            s.tokenValues.push_back(atoll(value));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            continue;
-        }
-
-        if (cmd == "str") {
-            const char *value = skipWhitespace(strtok(nullptr, "\r\n"));
-            assert(*value != 0);
-            char *end = strchr((char *)value + 1, *value);
-            assert(end != nullptr);
-            *end = 0;
-            value += 1;
-            const char *comment = skipWhitespace(strtok(end + 1, "\r\n"));
-            std::string label = std::string("str:") + value;
-            Stream &s = streams.at(streamStack.back());
-            if (labelIndex.count(label) == 0) {
-                labelIndex[label] = labels.size();
-                if (debug)
-                    labelNames.push_back(label);
-                labels.push_back(-1);
-            }
-            s.tokenTypes.push_back(TOK_REF);
-            s.tokenValues.push_back(labelIndex.at(label));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            stringStream.tokenTypes.push_back(TOK_LABEL);
-            stringStream.tokenValues.push_back(labelIndex.at(label));
-            stringStream.tokenComments.push_back("");
-            while (1) {
-                stringStream.tokenTypes.push_back(TOK_U8);
-                stringStream.tokenValues.push_back(*value);
-                if (debug) {
-                    char char_comment[4] = {'\'', *value, '\'', 0};
-                    if (*value < 32 || *value >= 127)
-                        char_comment[0] = 0;
-                    stringStream.tokenComments.push_back(char_comment);
-                }
-                if (*value == 0)
-                    break;
-                value++;
-            }
-            continue;
-        }
-
-        assert(0);
+    char magic[sizeof(binaryMagic)];
+    if (fread(magic, 1, sizeof(magic), fileIn) == sizeof(magic) && memcmp(magic, binaryMagic, sizeof(magic)) == 0) {
+        readBinary(fileIn);
+    } else {
+        rewind(fileIn);
+        readText(fileIn, threads);
     }
 
     if (verbose) {
@@ -457,6 +789,39 @@ int main(int argc, char **argv)
 
         for (auto &s : postText)
             fprintf(fileOut, "%s\n", s.c_str());
+#ifdef BBASM_ZLIB
+    } else if (writeZ) {
+        uint32_t blockCount = (data.size() + compressedBlockSize - 1) / compressedBlockSize;
+        std::vector<uint8_t> header(compressedMagic, compressedMagic + sizeof(compressedMagic));
+        writeU32(header, data.size(), bigEndian);
+        writeU32(header, compressedBlockSize, bigEndian);
+        writeU32(header, blockCount, bigEndian);
+        std::vector<std::vector<uint8_t>> blocks(blockCount);
+        auto compressBlocks = [&](uint32_t first) {
+            for (uint32_t i = first; i < blockCount; i += threads) {
+                uLong rawSize = std::min<size_t>(compressedBlockSize, data.size() - size_t(i) * compressedBlockSize);
+                uLongf size = compressBound(rawSize);
+                blocks[i].resize(size);
+                int result = compress2(blocks[i].data(), &size, data.data() + size_t(i) * compressedBlockSize,
+                                       rawSize, Z_BEST_COMPRESSION);
+                assert(result == Z_OK);
+                blocks[i].resize(size);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(compressBlocks, i);
+        compressBlocks(0);
+        for (auto &w : workers)
+            w.join();
+        for (auto &block : blocks)
+            writeU32(header, block.size(), bigEndian);
+        fwrite(header.data(), header.size(), 1, fileOut);
+        for (auto &block : blocks)
+            fwrite(block.data(), block.size(), 1, fileOut);
+        if (verbose)
+            printf("compressed to %.2f MB in %d blocks\n", double(ftell(fileOut)) / (1024 * 1024), int(blockCount));
+#endif
     } else {
         fwrite(data.data(), int(data.size()), 1, fileOut);
     }
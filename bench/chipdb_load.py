@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# Compares the time and memory nextpnr needs to start up with a raw chip database and with the same database in the
+# compressed container written by `bbasm --z`. See bench/README.md.
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="nextpnr chip database load benchmark")
+    parser.add_argument("--nextpnr", required=True, help="nextpnr binary")
+    parser.add_argument("--device", required=True, help="device to load")
+    parser.add_argument("--raw", required=True, help="chip database written by bbasm")
+    parser.add_argument("--compressed", required=True, help="the same chip database written by bbasm --z")
+    parser.add_argument("--runs", type=int, default=5, help="runs of each (default: %(default)s)")
+    parser.add_argument("--json", help="also pack, place and route this design, to include the memory it touches")
+    return parser.parse_args()
+
+
+def run_once(args, chipdb):
+    cmd = [args.nextpnr, "--device", args.device, "--chipdb", chipdb, "--quiet"]
+    if args.json:
+        cmd += ["--json", args.json]
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    elapsed = time.monotonic() - start
+    if status != 0:
+        raise RuntimeError("%s failed" % " ".join(cmd))
+    # ru_maxrss is in KiB on Linux
+    return elapsed, usage.ru_maxrss / 1024
+
+
+def main():
+    args = parse_args()
+    results = {}
+    for kind, chipdb in (("raw", args.raw), ("compressed", args.compressed)):
+        # The first run warms up the page cache, the decompressed chipdb cache and, with a design, the routing
+        # lookahead cache
+        run_once(args, chipdb)
+        times, rss = zip(*(run_once(args, chipdb) for _ in range(args.runs)))
+        results[kind] = (os.path.getsize(chipdb) / (1024 * 1024), statistics.median(times), max(rss))
+
+    print("%-12s %12s %12s %14s" % ("", "file (MiB)", "time (s)", "peak RSS (MiB)"))
+    for kind, (size, elapsed, rss) in results.items():
+        print("%-12s %12.2f %12.3f %14.1f" % (kind, size, elapsed, rss))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,167 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Intern and lookup throughput of the IdString table, against the single-threaded map it replaced.
+//
+// Usage: nextpnr-bench-idstring [names] [threads]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifndef NPNR_DISABLE_THREADS
+#include <thread>
+#endif
+
+#include "idstring_db.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+
+// The previous IdString storage
+struct MapDb
+{
+    std::unordered_map<std::string, int> str_to_idx;
+    std::vector<const std::string *> idx_to_str;
+
+    int intern(const std::string &s)
+    {
+        auto found = str_to_idx.find(s);
+        if (found != str_to_idx.end())
+            return found->second;
+        int idx = int(idx_to_str.size());
+        auto inserted = str_to_idx.emplace(s, idx);
+        idx_to_str.push_back(&inserted.first->first);
+        return idx;
+    }
+    const std::string &str(int idx) const { return *idx_to_str.at(idx); }
+};
+
+template <typename Func> double time_ms(Func func)
+{
+    auto startt = std::chrono::high_resolution_clock::now();
+    func();
+    auto endt = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(endt - startt).count() * 1000.0;
+}
+
+template <typename Func> void run_threads(int threads, Func func)
+{
+#ifndef NPNR_DISABLE_THREADS
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&func, t]() { func(t); });
+    for (auto &w : workers)
+        w.join();
+#else
+    for (int t = 0; t < threads; t++)
+        func(t);
+#endif
+}
+
+void report(const char *what, size_t ops, double ms)
+{
+    printf("%-40s %10.2f ms %10.2f Mops/s\n", what, ms, (ops / 1e6) / (ms / 1000.0));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int count = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+    int threads = (argc > 2) ? std::atoi(argv[2]) : 4;
+    if (count <= 0 || threads <= 0) {
+        fprintf(stderr, "usage: %s [names] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    // Names shaped like typical tile/wire/cell names
+    std::vector<std::string> names;
+    for (int i = 0; i < count; i++)
+        names.push_back("X" + std::to_string(i % 317) + "Y" + std::to_string(i / 317) + "/SLICE" +
+                        std::to_string(i % 8) + "_LUT" + std::to_string(i));
+
+    size_t checksum = 0;
+    {
+        MapDb db;
+        report("map: intern new", count, time_ms([&]() {
+                   for (auto &n : names)
+                       db.intern(n);
+               }));
+        report("map: intern existing", count, time_ms([&]() {
+                   for (auto &n : names)
+                       checksum += db.intern(n);
+               }));
+        report("map: index to string", count, time_ms([&]() {
+                   for (int i = 0; i < count; i++)
+                       checksum += db.str(i).size();
+               }));
+    }
+    {
+        IdStringDb db;
+        report("sharded: intern new", count, time_ms([&]() {
+                   for (auto &n : names)
+                       db.intern(n);
+               }));
+        report("sharded: intern existing", count, time_ms([&]() {
+                   for (auto &n : names)
+                       checksum += db.intern(n);
+               }));
+        report("sharded: index to string", count, time_ms([&]() {
+                   for (int i = 0; i < count; i++)
+                       checksum += db.str(i).size();
+               }));
+    }
+    {
+        // Every thread interns every name, starting at a different point, so inserts and hits race with each other
+        IdStringDb db;
+        std::string what = "sharded: intern, " + std::to_string(threads) + " threads";
+        report(what.c_str(), size_t(count) * threads, time_ms([&]() {
+                   run_threads(threads, [&](int t) {
+                       for (int i = 0; i < count; i++)
+                           db.intern(names.at((i + t * (count / threads)) % count));
+                   });
+               }));
+        what = "sharded: index to string, " + std::to_string(threads) + " threads";
+        report(what.c_str(), size_t(count) * threads, time_ms([&]() {
+                   run_threads(threads, [&](int t) {
+                       size_t sum = 0;
+                       for (int i = 0; i < count; i++)
+                           sum += db.str(i).size();
+                       if (sum == 0)
+                           printf("unexpected\n");
+                   });
+               }));
+        if (db.size() != count) {
+            fprintf(stderr, "expected %d names after concurrent interning, got %d\n", count, db.size());
+            return 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (db.intern(db.str(i)) != i) {
+                fprintf(stderr, "name %d does not map back to its own index\n", i);
+                return 1;
+            }
+        }
+    }
+    printf("checksum %zu\n", checksum);
+    return 0;
+}
@@ -0,0 +1,14 @@
+// Free-running counter with synchronous reset, the example uarch's blinky.v widened to 32 bits. The *-counter.json
+// netlists implement this module; see ../gen_designs.py.
+module top(input clk, input rst, output [7:0] leds);
+
+reg [31:0] ctr;
+always @(posedge clk)
+	if (rst)
+		ctr <= 32'h0;
+	else
+		ctr <= ctr + 1'b1;
+
+assign leds = ctr[31:24];
+
+endmodule
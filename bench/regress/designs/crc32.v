@@ -0,0 +1,24 @@
+// Ethernet CRC-32 (reflected polynomial 0xEDB88320) over WIDTH data bits per cycle, as found in MACs and packet
+// checkers. The *-crc32.json netlists implement this module with the default WIDTH of 8, and *-crc32wide.json with
+// a WIDTH of 16; see ../gen_designs.py.
+module top #(parameter WIDTH = 8) (input clk, input rst, input valid, input [WIDTH-1:0] data, output [31:0] crc);
+
+function [31:0] next_crc(input [31:0] c, input [WIDTH-1:0] d);
+	integer i;
+	begin
+		next_crc = c;
+		for (i = 0; i < WIDTH; i = i + 1)
+			next_crc = (next_crc >> 1) ^ ((next_crc[0] ^ d[i]) ? 32'hEDB88320 : 32'h0);
+	end
+endfunction
+
+reg [31:0] state;
+always @(posedge clk)
+	if (rst)
+		state <= 32'hFFFFFFFF;
+	else if (valid)
+		state <= next_crc(state, data);
+
+assign crc = ~state;
+
+endmodule
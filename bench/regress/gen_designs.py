@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+# Generates the netlists of the regression benchmark suite in designs/, in the JSON format written by Yosys. Each
+# one implements a Verilog module in designs/ (counter.v, crc32.v), mapped to the LUT4 and
+# flip-flop primitives of an architecture the way synth_* would map it, so that the suite doesn't depend on a
+# synthesis flow. Only the designs that suite.json refers to are written.
+#
+# Usage: gen_designs.py [output dir]
+
+import json
+import sys
+from os import path
+
+here = path.dirname(path.abspath(__file__))
+
+# Primitive cells of each architecture, as produced by the Yosys synth_* script for it:
+#   lut: (type, input ports, output port, init parameter)
+#   ff: (type, clock port, data port, output port, parameters)
+#   ibuf/obuf: (type, input port, output port), or None where nextpnr inserts IO buffers itself
+#   clk_ibuf_attrs: extra attributes for the clock input buffer
+LIBRARIES = {
+    "example": dict(
+        lut=("LUT4", ["I[0]", "I[1]", "I[2]", "I[3]"], "F", "INIT"),
+        ff=("DFF", "CLK", "D", "Q", {}),
+        ibuf=("INBUF", "PAD", "O"),
+        obuf=("OUTBUF", "I", "PAD"),
+        # The only global clock entry point of the example architecture
+        clk_ibuf_attrs={"BEL": "X1Y0/IO0"},
+    ),
+    "ice40": dict(
+        lut=("SB_LUT4", ["I0", "I1", "I2", "I3"], "O", "LUT_INIT"),
+        ff=("SB_DFF", "C", "D", "Q", {}),
+        ibuf=None,
+        obuf=None,
+    ),
+    "ecp5": dict(
+        lut=("LUT4", ["A", "B", "C", "D"], "Z", "INIT"),
+        ff=("TRELLIS_FF", "CLK", "DI", "Q", {"GSR": "DISABLED", "CEMUX": "1", "CLKMUX": "CLK", "LSRMUX": "LSR",
+                                            "REGSET": "RESET", "SRMODE": "LSR_OVER_CE"}),
+        ibuf=None,
+        obuf=None,
+    ),
+    "gowin": dict(
+        lut=("LUT4", ["I0", "I1", "I2", "I3"], "F", "INIT"),
+        ff=("DFF", "CLK", "D", "Q", {}),
+        ibuf=("IBUF", "I", "O"),
+        obuf=("OBUF", "I", "O"),
+    ),
+}
+
+
+class Netlist:
+    def __init__(self, lib):
+        self.lib = lib
+        self.cells = {}
+        self.ports = {}
+        self.netnames = {}
+        self.next_bit = 2
+
+    def bit(self):
+        self.next_bit += 1
+        return self.next_bit
+
+    def cell(self, name, type, dirs, conns, params={}, attrs={}):
+        self.cells[name] = {"type": type, "port_directions": dirs,
+                            "connections": {port: [bit] for port, bit in conns.items()},
+                            "parameters": params, "attributes": attrs}
+
+    def net(self, name, bits):
+        self.netnames[name] = {"hide_name": 0, "bits": bits, "attributes": {}}
+
+    def input(self, name, attrs={}):
+        pad = self.bit()
+        self.ports[name] = {"direction": "input", "bits": [pad]}
+        if self.lib["ibuf"] is None:
+            return pad
+        type, i, o = self.lib["ibuf"]
+        sig = self.bit()
+        self.cell(name + "_ibuf", type, {i: "input", o: "output"}, {i: pad, o: sig}, attrs=attrs)
+        self.net(name + "_buf", [sig])
+        return sig
+
+    def output(self, name, sig):
+        if self.lib["obuf"] is None:
+            self.ports[name] = {"direction": "output", "bits": [sig]}
+            return
+        pad = self.bit()
+        self.ports[name] = {"direction": "output", "bits": [pad]}
+        type, i, o = self.lib["obuf"]
+        self.cell(name + "_obuf", type, {i: "input", o: "output"}, {i: sig, o: pad})
+
+    def lut(self, name, inputs, func):
+        # func maps the values of the connected inputs to the output; unconnected inputs don't affect the INIT
+        type, ins, out, param = self.lib["lut"]
+        f = self.bit()
+        dirs = {port: "input" for port in ins}
+        dirs[out] = "output"
+        conns = dict(zip(ins, inputs))
+        conns[out] = f
+        init = 0
+        for i in range(16):
+            if func([(i >> j) & 1 for j in range(len(inputs))]):
+                init |= 1 << i
+        self.cell(name, type, dirs, conns, params={param: format(init, "016b")})
+        return f
+
+    def xor(self, name, inputs):
+        # Balanced tree of 4-input XORs
+        level = 0
+        while len(inputs) > 1:
+            inputs = [self.lut("%s_x%d_%d" % (name, level, i // 4), inputs[i:i + 4], lambda v: sum(v) % 2)
+                      for i in range(0, len(inputs), 4)]
+            level += 1
+        return inputs[0]
+
+    def ff(self, name, clk, d, q):
+        type, c, di, o, params = self.lib["ff"]
+        self.cell(name, type, {c: "input", di: "input", o: "output"}, {c: clk, di: d, o: q}, params=dict(params))
+
+    def write(self, filename):
+        top = {"attributes": {"top": "00000000000000000000000000000001"}, "ports": self.ports, "cells": self.cells,
+               "netnames": self.netnames}
+        with open(filename, "w") as f:
+            json.dump({"creator": "nextpnr bench/regress/gen_designs.py", "modules": {"top": top}}, f, sort_keys=True)
+            f.write("\n")
+
+
+def counter(lib):
+    # counter.v: an incrementer without carry logic, so the carry ripples through one LUT per bit
+    width = 32
+    nl = Netlist(lib)
+    clk = nl.input("clk", lib.get("clk_ibuf_attrs", {}))
+    rst = nl.input("rst")
+    ctr = [nl.bit() for i in range(width)]
+    nl.net("ctr", ctr)
+    carry = None
+    for i in range(width):
+        if carry is None:
+            d = nl.lut("ctr_d%d" % i, [rst, ctr[i]], lambda v: not v[0] and not v[1])
+            carry = ctr[i]
+        else:
+            d = nl.lut("ctr_d%d" % i, [rst, ctr[i], carry], lambda v: not v[0] and v[1] != v[2])
+            if i < width - 1:
+                carry = nl.lut("ctr_c%d" % (i + 1), [ctr[i], carry], lambda v: v[0] and v[1])
+        nl.ff("ctr_reg%d" % i, clk, d, ctr[i])
+    for i in range(8):
+        nl.output("leds[%d]" % i, ctr[24 + i])
+    return nl
+
+
+def crc32_terms(width):
+    # The state and data bits that each bit of next_crc() in crc32.v XORs together
+    c = [{("state", i)} for i in range(32)]
+    for i in range(width):
+        fb = c[0] ^ {("data", i)}
+        c = c[1:] + [set()]
+        for j in range(32):
+            if (0xEDB88320 >> j) & 1:
+                c[j] = c[j] ^ fb
+    return [sorted(terms) for terms in c]
+
+
+def crc32(lib, width):
+    # crc32.v with WIDTH data bits: wide XOR trees with a lot of fanout from the state and data bits
+    nl = Netlist(lib)
+    clk = nl.input("clk", lib.get("clk_ibuf_attrs", {}))
+    rst = nl.input("rst")
+    valid = nl.input("valid")
+    data = [nl.input("data[%d]" % i) for i in range(width)]
+    state = [nl.bit() for i in range(32)]
+    nl.net("state", state)
+    bits = {"state": state, "data": data}
+    for i, terms in enumerate(crc32_terms(width)):
+        x = nl.xor("crc_n%d" % i, [bits[kind][j] for kind, j in terms])
+        # rst ? 1 : valid ? x : state
+        d = nl.lut("state_d%d" % i, [rst, valid, state[i], x], lambda v: v[0] or (v[3] if v[1] else v[2]))
+        nl.ff("state_reg%d" % i, clk, d, state[i])
+        nl.output("crc[%d]" % i, nl.lut("crc_o%d" % i, [state[i]], lambda v: not v[0]))
+    return nl
+
+
+CIRCUITS = {
+    "counter": counter,
+    "crc32": lambda lib: crc32(lib, 8),
+    # Two bytes per cycle, for a design that takes several seconds to place and route
+    "crc32wide": lambda lib: crc32(lib, 16),
+}
+
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else path.join(here, "designs")
+    with open(path.join(here, "suite.json")) as f:
+        suite = json.load(f)
+    for bench in suite["benchmarks"]:
+        # designs/<architecture>-<circuit>.json
+        lib, circuit = path.splitext(path.basename(bench["design"]))[0].split("-", 1)
+        CIRCUITS[circuit](LIBRARIES[lib]).write(path.join(outdir, path.basename(bench["design"])))
+
+
+if __name__ == "__main__":
+    main()
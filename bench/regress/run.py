@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+#
+# Runs the place and route regression suite described in suite.json, and compares runtime, memory and quality of
+# result against the stored baselines in baselines.json. Runtimes are compared after scaling the baselines by the
+# speed of this machine relative to the one that recorded them. Runtimes of multi-threaded benchmarks are only compared
+# on a machine with as many CPUs as the one that recorded them. See bench/README.md.
+
+import argparse
+import fnmatch
+import json
+import os
+import random
+import subprocess
+import sys
+import time
+import zlib
+from os import path
+
+here = path.dirname(path.abspath(__file__))
+
+# Metric name -> (description, unit, whether a larger value is better, tolerance kind)
+METRICS = {
+    "total_time": ("total runtime", "s", False, "time"),
+    "pack_time": ("packing", "s", False, "time"),
+    "place_time": ("placement", "s", False, "time"),
+    "route_time": ("routing", "s", False, "time"),
+    "peak_rss": ("peak memory", "MiB", False, "memory"),
+    "wirelength": ("wirelength", "wires", False, "qor"),
+    "fmax": ("worst Fmax", "MHz", True, "qor"),
+}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="nextpnr place and route regression benchmarks")
+    parser.add_argument("--nextpnr", action="append", default=[], metavar="ARCH=PATH",
+                        help="nextpnr binary to use for benchmarks of an architecture")
+    parser.add_argument("--uarch", action="append", default=[],
+                        help="himbaechel microarchitecture included in the himbaechel binary")
+    parser.add_argument("--suite", default=path.join(here, "suite.json"), help="benchmark suite description")
+    parser.add_argument("--baselines", default=path.join(here, "baselines.json"), help="stored baseline results")
+    parser.add_argument("--work-dir", default="bench-work", help="directory for logs, reports and routed designs")
+    parser.add_argument("--only", action="append", default=[], metavar="PATTERN",
+                        help="only run benchmarks whose name matches this pattern")
+    parser.add_argument("--update", action="store_true",
+                        help="store the results as the new baselines instead of checking against them")
+    parser.add_argument("--time-tolerance", type=float, default=0.25,
+                        help="allowed relative increase in runtime (default: %(default)s)")
+    parser.add_argument("--memory-tolerance", type=float, default=0.10,
+                        help="allowed relative increase in peak memory (default: %(default)s)")
+    parser.add_argument("--qor-tolerance", type=float, default=0.02,
+                        help="allowed relative loss in wirelength and Fmax (default: %(default)s)")
+    parser.add_argument("--min-time", type=float, default=0.5,
+                        help="runtime differences below this many seconds are ignored as noise (default: %(default)s)")
+    return parser.parse_args()
+
+
+def calibrate():
+    # Seconds taken by a fixed single-threaded workload in native code, the best of a few runs. The ratio of this to
+    # the calibration stored with a baseline estimates how much faster or slower this machine is.
+    rng = random.Random(1)
+    data = bytes(rng.getrandbits(4) + 97 for i in range(1 << 20))
+    best = None
+    for i in range(3):
+        start = time.perf_counter()
+        for j in range(4):
+            zlib.compress(data, 6)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def routed_wirelength(routed_json):
+    with open(routed_json) as f:
+        design = json.load(f)
+    wires = 0
+    for module in design["modules"].values():
+        for net in module.get("netnames", {}).values():
+            routing = net.get("attributes", {}).get("ROUTING", "")
+            # wire;pip;strength for each bound wire
+            if routing:
+                wires += len(routing.split(";")) // 3
+    return wires
+
+
+def run_benchmark(bench, binary, common_args, work_dir):
+    name = bench["name"]
+    report = path.join(work_dir, name + ".report.json")
+    routed = path.join(work_dir, name + ".routed.json")
+    cmd = [binary] + common_args + bench.get("args", []) + [
+        "--json", path.join(here, bench["design"]), "--report", report, "--write", routed]
+    start = time.monotonic()
+    with open(path.join(work_dir, name + ".log"), "w") as log:
+        result = subprocess.run(cmd, stdout=log, stderr=subprocess.STDOUT)
+    elapsed = time.monotonic() - start
+    if result.returncode != 0:
+        return None
+    with open(report) as f:
+        profile = json.load(f)
+    passes = {p["name"]: p["wall_time"] for p in profile["profile"]["passes"]}
+    fmax = [clk["achieved"] for clk in profile["fmax"].values()]
+    return {
+        "total_time": round(elapsed, 2),
+        "pack_time": round(passes.get("pack", 0), 2),
+        "place_time": round(passes.get("place", 0), 2),
+        "route_time": round(passes.get("route", 0), 2),
+        "peak_rss": round(profile["profile"]["peak_rss"] / (1024 * 1024), 1),
+        "wirelength": routed_wirelength(routed),
+        "fmax": round(min(fmax), 2) if fmax else None,
+    }
+
+
+def bench_threads(bench, common_args):
+    args = common_args + bench.get("args", [])
+    return int(args[args.index("--threads") + 1]) if "--threads" in args else 1
+
+
+def check(name, result, baseline, tolerances, min_time, calibration, compare_time):
+    failures = []
+    speed = calibration / baseline["calibration"]
+    if compare_time:
+        print("    baseline runtimes scaled by %.2f for this machine" % speed)
+    else:
+        print("    runtimes not compared, the baseline was recorded with %d CPUs" % baseline["cpus"])
+    for metric, (desc, unit, higher_better, kind) in METRICS.items():
+        new, old = result.get(metric), baseline.get(metric)
+        if new is None or old is None:
+            continue
+        if kind == "time":
+            if not compare_time:
+                continue
+            old *= speed
+        tol = tolerances[kind]
+        if higher_better:
+            bad = new < old * (1 - tol)
+        else:
+            bad = new > old * (1 + tol)
+            if kind == "time" and new - old < min_time:
+                bad = False
+        change = (100.0 * (new - old) / old) if old else 0.0
+        line = "    %-14s %10.2f %-5s (baseline %.2f, %+.1f%%)" % (desc, new, unit, old, change)
+        print(line + ("  REGRESSION" if bad else ""))
+        if bad:
+            failures.append("%s: %s %.2f %s vs baseline %.2f" % (name, desc, new, unit, old))
+    return failures
+
+
+def main():
+    args = parse_args()
+    binaries = dict(item.split("=", 1) for item in args.nextpnr)
+    with open(args.suite) as f:
+        suite = json.load(f)
+    baselines = {}
+    if path.exists(args.baselines):
+        with open(args.baselines) as f:
+            baselines = json.load(f)
+    os.makedirs(args.work_dir, exist_ok=True)
+    default_tolerances = {"time": args.time_tolerance, "memory": args.memory_tolerance, "qor": args.qor_tolerance}
+    calibration = calibrate()
+    print("calibration: %.3f s" % calibration)
+
+    failures = []
+    ran = 0
+    for bench in suite["benchmarks"]:
+        name = bench["name"]
+        if args.only and not any(fnmatch.fnmatch(name, pattern) for pattern in args.only):
+            continue
+        binary = binaries.get(bench["arch"])
+        if binary is None or ("uarch" in bench and bench["uarch"] not in args.uarch):
+            print("%s: skipped, %s not built" % (name, bench.get("uarch", bench["arch"])))
+            continue
+        print("%s:" % name)
+        sys.stdout.flush()
+        result = run_benchmark(bench, binary, suite.get("common_args", []), args.work_dir)
+        ran += 1
+        if result is None:
+            print("    FAILED, see %s" % path.join(args.work_dir, name + ".log"))
+            failures.append("%s: place and route failed" % name)
+            continue
+        if args.update:
+            baselines[name] = dict(result, calibration=round(calibration, 3), cpus=os.cpu_count())
+            for metric, (desc, unit, _, _) in METRICS.items():
+                if result[metric] is not None:
+                    print("    %-14s %10.2f %s" % (desc, result[metric], unit))
+        elif name not in baselines:
+            print("    no baseline, run with --update to record one")
+            failures.append("%s: no baseline" % name)
+        else:
+            tolerances = dict(default_tolerances)
+            tolerances.update(bench.get("tolerances", {}))
+            baseline = baselines[name]
+            # Scaling by the single-threaded calibration doesn't account for a different number of CPUs
+            compare_time = bench_threads(bench, suite.get("common_args", [])) == 1 or \
+                baseline.get("cpus") == os.cpu_count()
+            failures += check(name, result, baseline, tolerances, args.min_time, calibration, compare_time)
+
+    if args.update:
+        # Drop the baselines of benchmarks that are no longer part of the suite
+        names = set(bench["name"] for bench in suite["benchmarks"])
+        baselines = {name: baseline for name, baseline in baselines.items() if name in names}
+        with open(args.baselines, "w") as f:
+            json.dump(baselines, f, indent=4, sort_keys=True)
+            f.write("\n")
+        print("Updated %s." % args.baselines)
+    if ran == 0:
+        print("No benchmarks were run.")
+    if failures:
+        print("\n%d regression(s):" % len(failures))
+        for failure in failures:
+            print("    " + failure)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+#
+# Measures how the router2 search uses the cache: the time and the last level cache misses per wire it expands, from
+# the perf profile of a place and route run. See bench/README.md.
+
+import argparse
+import re
+import statistics
+import subprocess
+import sys
+
+EXPLORED_RE = re.compile(r"(\d+) wires explored, ([0-9.]+)ns per explored wire")
+MISSES_RE = re.compile(r"(\d+) last level cache misses while routing, ([0-9.]+) per explored wire")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="nextpnr router2 cache benchmark")
+    parser.add_argument("--nextpnr", required=True, action="append",
+                        help="nextpnr binary; give more than one to compare them")
+    parser.add_argument("--device", required=True, help="device to route on")
+    parser.add_argument("--json", required=True, help="design to pack, place and route")
+    parser.add_argument("--threads", type=int, default=1, help="router threads (default: %(default)s)")
+    parser.add_argument("--seed", type=int, default=1, help="placer seed (default: %(default)s)")
+    parser.add_argument("--runs", type=int, default=3, help="runs of each binary (default: %(default)s)")
+    return parser.parse_args()
+
+
+def run_once(args, nextpnr):
+    cmd = [nextpnr, "--device", args.device, "--json", args.json, "--seed", str(args.seed), "--threads",
+           str(args.threads), "--router", "router2", "--router2-perf-profile"]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if proc.returncode != 0:
+        raise RuntimeError("%s failed" % " ".join(cmd))
+    explored = EXPLORED_RE.search(proc.stdout)
+    if explored is None:
+        raise RuntimeError("%s printed no router2 perf profile" % nextpnr)
+    misses = MISSES_RE.search(proc.stdout)
+    # Without hardware performance counters, only the time is reported
+    return int(explored.group(1)), float(explored.group(2)), float(misses.group(2)) if misses else None
+
+
+def main():
+    args = parse_args()
+    print("%-40s %12s %16s %16s" % ("", "wires", "ns per wire", "misses per wire"))
+    for nextpnr in args.nextpnr:
+        # The first run builds the routing lookahead cache, if it isn't there yet
+        run_once(args, nextpnr)
+        results = [run_once(args, nextpnr) for _ in range(args.runs)]
+        wires = results[0][0]
+        ns = statistics.median(r[1] for r in results)
+        misses = [r[2] for r in results if r[2] is not None]
+        print("%-40s %12d %16.1f %16s" % (nextpnr[-40:], wires, ns,
+                                          "%.2f" % statistics.median(misses) if misses else "unavailable"))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
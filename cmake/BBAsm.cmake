@@ -110,10 +110,16 @@ endfunction()
 #       MODE    binary
 #   )
 #
-# Paths must be absolute.
+# Paths must be absolute. In binary mode, `COMPRESS ON` writes the compressed container described in bba/README.md,
+# which only loaders that support it (currently Himbaechel) can read.
 #
 function(add_bba_compile_command)
-    cmake_parse_arguments(arg "" "TARGET;OUTPUT;INPUT;MODE" "" ${ARGN})
+    cmake_parse_arguments(arg "" "TARGET;OUTPUT;INPUT;MODE;COMPRESS" "" ${ARGN})
+
+    set(arg_COMPRESS_FLAG "")
+    if (arg_COMPRESS AND arg_MODE STREQUAL "binary")
+        set(arg_COMPRESS_FLAG "--z")
+    endif()
 
     cmake_path(GET arg_OUTPUT PARENT_PATH arg_OUTPUT_DIR)
     cmake_path(GET arg_OUTPUT FILENAME arg_OUTPUT_NAME)
@@ -127,7 +133,7 @@ function(add_bba_compile_command)
             OUTPUT
                 ${CMAKE_CURRENT_BINARY_DIR}/${arg_OUTPUT_NAME}
             COMMAND
-                bbasm ${BBASM_ENDIAN_FLAG}
+                bbasm ${BBASM_ENDIAN_FLAG} ${arg_COMPRESS_FLAG}
                 ${arg_INPUT}
                 ${CMAKE_CURRENT_BINARY_DIR}/${arg_OUTPUT_NAME}
             DEPENDS
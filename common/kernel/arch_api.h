@@ -156,6 +156,8 @@ template <typename R> struct ArchAPI : BaseCtx
     virtual bool place() = 0;
     virtual bool route() = 0;
     virtual void assignArchInfo() = 0;
+    virtual bool canForkDesign() const = 0;
+    virtual void forkArchState(Context *target) const = 0;
 };
 
 NEXTPNR_NAMESPACE_END
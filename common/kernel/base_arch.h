@@ -454,6 +454,13 @@ template <typename R> struct BaseArch : ArchAPI<R>
 
     // Flow methods
     virtual void assignArchInfo() override {};
+    // Whether Context::forkInto gives a usable copy of a packed design: everything the arch derives while packing
+    // must live in the netlist and ArchCellInfo/ArchNetInfo, be rebuilt by assignArchInfo, binding or prePlace-style
+    // hooks, or be copied by forkArchState. Off unless an arch has been checked.
+    virtual bool canForkDesign() const override { return false; }
+    // Copies the rest of the state packing left in the arch into the arch of target, once the netlist has been
+    // copied and assignArchInfo has run there, but before any placement or routing is bound
+    virtual void forkArchState(Context *target) const override {};
 
     // --------------------------------------------------------------
     // These structures are used to provide default implementations of bel/wire/pip binding. Arches might want to
@@ -306,6 +306,19 @@ CellInfo *BaseCtx::createCell(IdString name, IdString type)
     return ptr;
 }
 
+CellInfo *BaseCtx::getPortCell(IdString port) const
+{
+    auto found = port_cells.find(port);
+    if (found == port_cells.end())
+        return nullptr;
+    // The cell is named after the port, so it is still valid only if that name still refers to it. The pointer may
+    // dangle, so it must not be dereferenced before this check.
+    auto cell = cells.find(port);
+    if (cell == cells.end() || cell->second.get() != found->second)
+        return nullptr;
+    return found->second;
+}
+
 void BaseCtx::copyBelPorts(IdString cell, BelId bel)
 {
     CellInfo *cell_info = cells.at(cell).get();
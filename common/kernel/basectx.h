@@ -30,6 +30,7 @@
 
 #include "hashlib.h"
 #include "idstring.h"
+#include "idstring_db.h"
 #include "nextpnr_namespaces.h"
 #include "nextpnr_types.h"
 #include "property.h"
@@ -52,9 +53,8 @@ struct BaseCtx
     std::mutex ui_mutex;
 #endif
 
-    // ID String database.
-    mutable std::unordered_map<std::string, int> *idstring_str_to_idx;
-    mutable std::vector<const std::string *> *idstring_idx_to_str;
+    // ID String database. Safe to add to from multiple threads
+    mutable IdStringDb *idstring_db;
 
     // Temporary string backing store for logging
     mutable StrRingBuffer log_strs;
@@ -94,8 +94,7 @@ struct BaseCtx
 
     BaseCtx()
     {
-        idstring_str_to_idx = new std::unordered_map<std::string, int>;
-        idstring_idx_to_str = new std::vector<const std::string *>;
+        idstring_db = new IdStringDb;
         IdString::initialize_add(this, "", 0);
         IdString::initialize_arch(this);
 
@@ -104,8 +103,7 @@ struct BaseCtx
 
     virtual ~BaseCtx()
     {
-        delete idstring_str_to_idx;
-        delete idstring_idx_to_str;
+        delete idstring_db;
     }
 
     // Must be called before performing any mutating changes on the Ctx/Arch.
@@ -241,6 +239,10 @@ struct BaseCtx
     CellInfo *createCell(IdString name, IdString type);
     void copyBelPorts(IdString cell, BelId bel);
 
+    // The cell in port_cells for a top-level port, or nullptr if it is no longer part of the design. Packers usually
+    // replace these $nextpnr_[io]buf cells, and not all of them update port_cells when they do.
+    CellInfo *getPortCell(IdString port) const;
+
     // Workaround for lack of wrappable constructors
     DecalXY constructDecalXY(DecalId decal, float x, float y);
 
@@ -0,0 +1,784 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+#include "checkpoint.h"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "log.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+
+const char checkpoint_magic[8] = {'N', 'P', 'N', 'R', 'C', 'K', 'P', 'T'};
+const uint32_t checkpoint_version = 1;
+// Stored in host order, to detect checkpoints written on a machine of the other endianness
+const uint32_t byte_order_mark = 0x01020304;
+const uint32_t none_idx = 0xFFFFFFFF;
+
+// Cluster constraints are saved for arches that use the basic cluster data, which is all of them at present
+constexpr bool save_clusters =
+        std::is_base_of_v<BaseClusterInfo, ArchCellInfo> && std::is_same_v<ClusterId, IdString>;
+
+// How each wire of a net's routing is stored
+enum RoutingKind : uint8_t
+{
+    // A wire without an uphill pip, by name
+    ROUTE_WIRE = 0,
+    // A pip by name, where its source wire isn't part of the net's routing
+    ROUTE_PIP = 1,
+    // A pip as an index into the downhill pips of its source wire, which is another wire of the net; this avoids name
+    // lookups, which are slow for some arches
+    ROUTE_DOWNHILL = 2,
+};
+
+enum PropertyKind : uint8_t
+{
+    PROP_BITS = 0,
+    PROP_STRING = 1,
+    // NEXTPNR_BEL and ROUTING attributes that match the bound placement and routing, and are rebuilt from them on load
+    PROP_BEL_NAME = 2,
+    PROP_ROUTING = 3,
+};
+
+// The ROUTING attribute of a net, as produced by BaseCtx::archInfoToAttributes
+std::string routing_attr(const Context *ctx, const NetInfo *ni)
+{
+    std::string routing;
+    bool first = true;
+    for (auto &item : ni->wires) {
+        if (!first)
+            routing += ";";
+        routing += ctx->getWireName(item.first).str(ctx);
+        routing += ";";
+        if (item.second.pip != PipId())
+            routing += ctx->getPipName(item.second.pip).str(ctx);
+        routing += ";" + std::to_string(item.second.strength);
+        first = false;
+    }
+    return routing;
+}
+
+struct CheckpointWriter
+{
+    explicit CheckpointWriter(Context *ctx)
+            : ctx(ctx), id_nextpnr_bel(ctx->id("NEXTPNR_BEL")), id_routing(ctx->id("ROUTING")) {};
+    Context *ctx;
+    IdString id_nextpnr_bel, id_routing;
+
+    std::string body;
+    // Strings other than IdStrings referred to by the body, which must remain valid until the checkpoint is written
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> string_idx;
+    dict<IdString, uint32_t> cell_idx, net_idx;
+
+    void put_u8(uint8_t value) { body.push_back(char(value)); }
+    void put_u32(uint32_t value) { body.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+    void put_str(std::string_view str)
+    {
+        auto found = string_idx.emplace(str, uint32_t(strings.size()));
+        if (found.second)
+            strings.push_back(str);
+        put_u32(found.first->second);
+    }
+
+    // IdStrings are written as their index, as the whole IdString table is saved
+    void put_id(IdString id) { put_u32(uint32_t(id.index)); }
+
+    void put_list(const IdStringList &list)
+    {
+        put_u32(uint32_t(list.size()));
+        for (auto id : list)
+            put_id(id);
+    }
+
+    void put_ids(const std::vector<IdString> &ids)
+    {
+        put_u32(uint32_t(ids.size()));
+        for (auto id : ids)
+            put_id(id);
+    }
+
+    void put_id_dict(const dict<IdString, IdString> &map)
+    {
+        put_u32(uint32_t(map.size()));
+        for (auto &entry : map) {
+            put_id(entry.first);
+            put_id(entry.second);
+        }
+    }
+
+    void put_props(const dict<IdString, Property> &props, const CellInfo *ci = nullptr, const NetInfo *ni = nullptr)
+    {
+        put_u32(uint32_t(props.size()));
+        for (auto &prop : props) {
+            put_id(prop.first);
+            const Property &value = prop.second;
+            if (ci && prop.first == id_nextpnr_bel && ci->bel != BelId() && value.is_string &&
+                value.str == ctx->getBelName(ci->bel).str(ctx)) {
+                put_u8(PROP_BEL_NAME);
+            } else if (ni && prop.first == id_routing && value.is_string && value.str == routing_attr(ctx, ni)) {
+                put_u8(PROP_ROUTING);
+            } else {
+                put_u8(value.is_string ? PROP_STRING : PROP_BITS);
+                put_str(value.str);
+            }
+        }
+    }
+
+    void put_routing(const NetInfo *ni)
+    {
+        dict<WireId, uint32_t> wire_idx;
+        for (auto &wire : ni->wires)
+            wire_idx[wire.first] = uint32_t(wire_idx.size());
+        put_u32(uint32_t(ni->wires.size()));
+        for (auto &wire : ni->wires) {
+            put_u8(uint8_t(wire.second.strength));
+            PipId pip = wire.second.pip;
+            if (pip == PipId()) {
+                put_u8(ROUTE_WIRE);
+                put_list(ctx->getWireName(wire.first));
+                continue;
+            }
+            WireId src = ctx->getPipSrcWire(pip);
+            auto src_idx = wire_idx.find(src);
+            if (src_idx == wire_idx.end()) {
+                put_u8(ROUTE_PIP);
+                put_list(ctx->getPipName(pip));
+                continue;
+            }
+            uint32_t downhill_idx = 0;
+            for (PipId downhill : ctx->getPipsDownhill(src)) {
+                if (downhill == pip)
+                    break;
+                downhill_idx++;
+            }
+            put_u8(ROUTE_DOWNHILL);
+            put_u32(src_idx->second);
+            put_u32(downhill_idx);
+        }
+    }
+
+    void put_cell(const CellInfo *ci) { put_u32(ci ? cell_idx.at(ci->name) : none_idx); }
+    void put_net(const NetInfo *ni) { put_u32(ni ? net_idx.at(ni->name) : none_idx); }
+
+    void write_design()
+    {
+        put_str(ctx->archId().str(ctx));
+        put_str(ctx->archArgsToId(ctx->archArgs()).str(ctx));
+
+        for (auto &cell : ctx->cells)
+            cell_idx[cell.first] = uint32_t(cell_idx.size());
+        for (auto &net : ctx->nets)
+            net_idx[net.first] = uint32_t(net_idx.size());
+        put_u32(uint32_t(ctx->cells.size()));
+        put_u32(uint32_t(ctx->nets.size()));
+
+        put_u32(uint32_t(ctx->rngstate));
+        put_u32(uint32_t(ctx->rngstate >> 32));
+        put_id(ctx->top_module);
+        put_props(ctx->settings);
+        put_props(ctx->attrs);
+
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get();
+            put_id(ci->name);
+            put_id(ci->type);
+            put_id(ci->hierpath);
+            put_props(ci->params);
+            put_props(ci->attrs, ci);
+            put_u32(uint32_t(ci->ports.size()));
+            for (auto &port : ci->ports) {
+                put_id(port.first);
+                put_u8(uint8_t(port.second.type));
+                put_net(port.second.net);
+            }
+            if constexpr (save_clusters) {
+                put_id(ci->cluster);
+                put_u32(uint32_t(ci->constr_children.size()));
+                for (auto child : ci->constr_children)
+                    put_cell(child);
+                put_u32(uint32_t(ci->constr_x));
+                put_u32(uint32_t(ci->constr_y));
+                put_u32(uint32_t(ci->constr_z));
+                put_u8(ci->constr_abs_z ? 1 : 0);
+            }
+            if (ci->bel != BelId()) {
+                put_u8(1);
+                put_u8(uint8_t(ci->belStrength));
+                put_list(ctx->getBelName(ci->bel));
+            } else {
+                put_u8(0);
+            }
+        }
+
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get();
+            put_id(ni->name);
+            put_id(ni->hierpath);
+            put_id(ni->constant_value);
+            put_props(ni->attrs, nullptr, ni);
+            put_ids(ni->aliases);
+            put_cell(ni->driver.cell);
+            put_id(ni->driver.port);
+            put_u32(uint32_t(ni->users.entries()));
+            for (auto &usr : ni->users) {
+                put_cell(usr.cell);
+                put_id(usr.port);
+            }
+            put_routing(ni);
+        }
+
+        // As with port_cells, packers may delete the net a top-level port was connected to without clearing it here
+        pool<const NetInfo *, hash_ptr_ops> live_nets;
+        for (auto &net : ctx->nets)
+            live_nets.insert(net.second.get());
+        put_u32(uint32_t(ctx->ports.size()));
+        for (auto &port : ctx->ports) {
+            put_id(port.first);
+            put_id(port.second.name);
+            put_u8(uint8_t(port.second.type));
+            put_net(live_nets.count(port.second.net) ? port.second.net : nullptr);
+        }
+        // Entries for cells that packing removed are left out
+        std::vector<std::pair<IdString, const CellInfo *>> port_cells;
+        for (auto &port : ctx->port_cells) {
+            if (const CellInfo *cell = ctx->getPortCell(port.first))
+                port_cells.emplace_back(port.first, cell);
+        }
+        put_u32(uint32_t(port_cells.size()));
+        for (auto &port : port_cells) {
+            put_id(port.first);
+            put_cell(port.second);
+        }
+        put_id_dict(ctx->net_aliases);
+
+        put_u32(uint32_t(ctx->hierarchy.size()));
+        for (auto &entry : ctx->hierarchy) {
+            const HierarchicalCell &hc = entry.second;
+            put_id(entry.first);
+            put_id(hc.name);
+            put_id(hc.type);
+            put_id(hc.parent);
+            put_id(hc.fullpath);
+            put_id_dict(hc.leaf_cells);
+            put_id_dict(hc.nets);
+            put_id_dict(hc.leaf_cells_by_gname);
+            put_id_dict(hc.nets_by_gname);
+            put_id_dict(hc.hier_cells);
+            put_u32(uint32_t(hc.ports.size()));
+            for (auto &port : hc.ports) {
+                put_id(port.first);
+                put_id(port.second.name);
+                put_u8(uint8_t(port.second.dir));
+                put_ids(port.second.nets);
+                put_u32(uint32_t(port.second.offset));
+                put_u8(port.second.upto ? 1 : 0);
+            }
+            put_props(hc.attrs);
+        }
+    }
+
+    void write(std::ostream &out)
+    {
+        out.write(checkpoint_magic, sizeof(checkpoint_magic));
+        out.write(reinterpret_cast<const char *>(&checkpoint_version), sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(&byte_order_mark), sizeof(uint32_t));
+        // The IdString table in index order, so that loading it into a fresh context of the same architecture gives
+        // every IdString the same index as it had here. As the iteration order of hashed containers depends on
+        // these, this makes a flow resumed from a checkpoint produce the same results as an uninterrupted one
+        std::vector<std::string_view> ids;
+        for (int i = 0; i < ctx->idstring_db->size(); i++)
+            ids.push_back(ctx->idstring_db->str(i));
+        write_strings(out, ids);
+        write_strings(out, strings);
+        out.write(body.data(), body.size());
+    }
+
+    // A string table is written as a count, the lengths, then the concatenated characters
+    static void write_strings(std::ostream &out, const std::vector<std::string_view> &table)
+    {
+        std::vector<uint32_t> lengths;
+        lengths.reserve(table.size());
+        for (auto str : table)
+            lengths.push_back(uint32_t(str.size()));
+        uint32_t count = uint32_t(table.size());
+        out.write(reinterpret_cast<const char *>(&count), sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(lengths.data()), lengths.size() * sizeof(uint32_t));
+        for (auto str : table)
+            out.write(str.data(), str.size());
+    }
+};
+
+struct CheckpointReader
+{
+    CheckpointReader(Context *ctx, const std::string &filename, const char *data, size_t size)
+            : ctx(ctx), filename(filename), data(data), size(size) {};
+    Context *ctx;
+    const std::string &filename;
+    const char *data;
+    size_t size;
+    size_t pos = 0;
+
+    // Saved IdString index -> IdString index in this context
+    std::vector<int> id_map;
+    // Views into the mapped file
+    std::vector<std::string_view> strings;
+    std::vector<CellInfo *> cells;
+    std::vector<NetInfo *> nets;
+    // Attributes to rebuild from placement and routing once they are bound
+    std::vector<std::pair<CellInfo *, IdString>> bel_name_attrs;
+    std::vector<std::pair<NetInfo *, IdString>> routing_attrs;
+
+    struct RoutingEntry
+    {
+        PlaceStrength strength;
+        RoutingKind kind;
+        IdStringList name;
+        uint32_t src_idx, downhill_idx;
+        // Filled in as the routing is resolved
+        WireId wire;
+        PipId pip;
+    };
+    // Wires and pips of each net, in the order they were written
+    std::vector<std::vector<RoutingEntry>> net_routing;
+
+    [[noreturn]] void corrupt() { log_error("Checkpoint file '%s' is truncated or corrupt.\n", filename.c_str()); }
+
+    const char *take(size_t n)
+    {
+        if (size - pos < n)
+            corrupt();
+        const char *ptr = data + pos;
+        pos += n;
+        return ptr;
+    }
+
+    uint8_t get_u8() { return uint8_t(*take(1)); }
+
+    uint32_t get_u32()
+    {
+        uint32_t value;
+        memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    std::string_view get_str()
+    {
+        uint32_t idx = get_u32();
+        if (idx >= strings.size())
+            corrupt();
+        return strings[idx];
+    }
+
+    IdString get_id()
+    {
+        uint32_t idx = get_u32();
+        if (idx >= id_map.size())
+            corrupt();
+        return IdString(id_map[idx]);
+    }
+
+    IdStringList get_list()
+    {
+        size_t count = get_u32();
+        IdStringList list(count);
+        for (size_t i = 0; i < list.size(); i++)
+            list.ids[i] = get_id();
+        return list;
+    }
+
+    std::vector<IdString> get_ids()
+    {
+        std::vector<IdString> ids(get_u32());
+        for (auto &id : ids)
+            id = get_id();
+        return ids;
+    }
+
+    CellInfo *get_cell()
+    {
+        uint32_t idx = get_u32();
+        if (idx == none_idx)
+            return nullptr;
+        if (idx >= cells.size())
+            corrupt();
+        return cells[idx];
+    }
+
+    NetInfo *get_net()
+    {
+        uint32_t idx = get_u32();
+        if (idx == none_idx)
+            return nullptr;
+        if (idx >= nets.size())
+            corrupt();
+        return nets[idx];
+    }
+
+    template <typename T, typename TFunc> std::vector<T> get_entries(TFunc read_entry)
+    {
+        std::vector<T> entries(get_u32());
+        for (auto &entry : entries)
+            read_entry(entry);
+        return entries;
+    }
+
+    // Containers were written in iteration order, which for hashlib containers is the reverse of insertion order; so
+    // the entries are inserted backwards to get the same order again
+    template <typename K, typename V, typename TFunc> void get_dict(dict<K, V> &map, TFunc read_entry)
+    {
+        auto entries =
+                get_entries<std::pair<K, V>>([&](std::pair<K, V> &entry) { read_entry(entry.first, entry.second); });
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+            map[it->first] = std::move(it->second);
+    }
+
+    void get_id_dict(dict<IdString, IdString> &map)
+    {
+        get_dict(map, [&](IdString &key, IdString &value) {
+            key = get_id();
+            value = get_id();
+        });
+    }
+
+    void get_props(dict<IdString, Property> &props, CellInfo *ci = nullptr, NetInfo *ni = nullptr)
+    {
+        get_dict(props, [&](IdString &key, Property &value) {
+            key = get_id();
+            uint8_t kind = get_u8();
+            if (kind == PROP_BITS || kind == PROP_STRING) {
+                value.is_string = (kind == PROP_STRING);
+                value.str = std::string(get_str());
+                if (!value.is_string)
+                    value.update_intval();
+            } else if (kind == PROP_BEL_NAME && ci) {
+                bel_name_attrs.emplace_back(ci, key);
+            } else if (kind == PROP_ROUTING && ni) {
+                routing_attrs.emplace_back(ni, key);
+            } else {
+                corrupt();
+            }
+        });
+    }
+
+    void read_header()
+    {
+        if (memcmp(take(sizeof(checkpoint_magic)), checkpoint_magic, sizeof(checkpoint_magic)) != 0)
+            log_error("File '%s' is not a nextpnr checkpoint.\n", filename.c_str());
+        uint32_t version = get_u32();
+        if (version != checkpoint_version)
+            log_error("Checkpoint '%s' has version %u, but this nextpnr build only supports version %u.\n",
+                      filename.c_str(), version, checkpoint_version);
+        if (get_u32() != byte_order_mark)
+            log_error("Checkpoint '%s' was written on a machine with a different byte order.\n", filename.c_str());
+        std::vector<std::string_view> ids;
+        read_strings(ids);
+        // Interned in order, so that they get the same indices as when saved if this context has the same initial
+        // IdStrings as the one that wrote the checkpoint
+        id_map.reserve(ids.size());
+        for (auto id : ids)
+            id_map.push_back(ctx->idstring_db->intern(id));
+        read_strings(strings);
+    }
+
+    void read_strings(std::vector<std::string_view> &table)
+    {
+        uint32_t count = get_u32();
+        const char *lengths = take(size_t(count) * sizeof(uint32_t));
+        table.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t length;
+            memcpy(&length, lengths + i * sizeof(uint32_t), sizeof(uint32_t));
+            table.emplace_back(take(length), length);
+        }
+    }
+
+    void read_design()
+    {
+        std::string_view arch_name = get_str(), arch_type = get_str();
+        if (arch_name != ctx->archId().str(ctx) || arch_type != ctx->archArgsToId(ctx->archArgs()).str(ctx))
+            log_error("Checkpoint '%s' was written for %s (%s), but the current device is %s (%s).\n",
+                      filename.c_str(), std::string(arch_name).c_str(), std::string(arch_type).c_str(),
+                      ctx->archId().c_str(ctx), ctx->archArgsToId(ctx->archArgs()).c_str(ctx));
+
+        std::vector<std::unique_ptr<CellInfo>> cell_store(get_u32());
+        std::vector<std::unique_ptr<NetInfo>> net_store(get_u32());
+        for (auto &ci : cell_store) {
+            ci = std::make_unique<CellInfo>(ctx, IdString(), IdString());
+            cells.push_back(ci.get());
+        }
+        for (auto &ni : net_store) {
+            ni = std::make_unique<NetInfo>(IdString());
+            nets.push_back(ni.get());
+        }
+
+        ctx->rngstate = get_u32();
+        ctx->rngstate |= uint64_t(get_u32()) << 32;
+        ctx->top_module = get_id();
+        // Settings are restored as they were, rather than merged with any already present
+        ctx->settings.clear();
+        get_props(ctx->settings);
+        get_props(ctx->attrs);
+
+        for (CellInfo *ci : cells) {
+            ci->name = get_id();
+            ci->type = get_id();
+            ci->hierpath = get_id();
+            get_props(ci->params);
+            get_props(ci->attrs, ci);
+            get_dict(ci->ports, [&](IdString &name, PortInfo &port) {
+                name = get_id();
+                port.name = name;
+                port.type = PortType(get_u8());
+                port.net = get_net();
+            });
+            if constexpr (save_clusters) {
+                ci->cluster = get_id();
+                ci->constr_children.resize(get_u32());
+                for (auto &child : ci->constr_children)
+                    child = get_cell();
+                ci->constr_x = int(get_u32());
+                ci->constr_y = int(get_u32());
+                ci->constr_z = int(get_u32());
+                ci->constr_abs_z = (get_u8() != 0);
+            }
+            if (get_u8()) {
+                ci->belStrength = PlaceStrength(get_u8());
+                IdStringList bel_name = get_list();
+                BelId bel = ctx->getBelByName(bel_name);
+                if (bel == BelId())
+                    log_error("Checkpoint places cell '%s' at unknown bel '%s'.\n", ci->name.c_str(ctx),
+                              bel_name.str(ctx).c_str());
+                ci->bel = bel;
+            }
+        }
+
+        for (NetInfo *ni : nets) {
+            ni->name = get_id();
+            ni->hierpath = get_id();
+            ni->constant_value = get_id();
+            get_props(ni->attrs, nullptr, ni);
+            ni->aliases = get_ids();
+            ni->driver.cell = get_cell();
+            ni->driver.port = get_id();
+            uint32_t user_count = get_u32();
+            for (uint32_t i = 0; i < user_count; i++) {
+                CellInfo *cell = get_cell();
+                IdString port = get_id();
+                if (!cell || !cell->ports.count(port))
+                    corrupt();
+                cell->ports.at(port).user_idx = ni->users.add(PortRef{cell, port});
+            }
+            // Routing is bound once the whole design is loaded
+            net_routing.push_back(get_entries<RoutingEntry>([&](RoutingEntry &entry) {
+                entry.strength = PlaceStrength(get_u8());
+                entry.kind = RoutingKind(get_u8());
+                if (entry.kind == ROUTE_WIRE || entry.kind == ROUTE_PIP) {
+                    entry.name = get_list();
+                } else if (entry.kind == ROUTE_DOWNHILL) {
+                    entry.src_idx = get_u32();
+                    entry.downhill_idx = get_u32();
+                } else {
+                    corrupt();
+                }
+            }));
+        }
+
+        get_dict(ctx->ports, [&](IdString &key, PortInfo &port) {
+            key = get_id();
+            port.name = get_id();
+            port.type = PortType(get_u8());
+            port.net = get_net();
+        });
+        get_dict(ctx->port_cells, [&](IdString &key, CellInfo *&cell) {
+            key = get_id();
+            cell = get_cell();
+        });
+        get_id_dict(ctx->net_aliases);
+
+        get_dict(ctx->hierarchy, [&](IdString &key, HierarchicalCell &hc) {
+            key = get_id();
+            hc.name = get_id();
+            hc.type = get_id();
+            hc.parent = get_id();
+            hc.fullpath = get_id();
+            get_id_dict(hc.leaf_cells);
+            get_id_dict(hc.nets);
+            get_id_dict(hc.leaf_cells_by_gname);
+            get_id_dict(hc.nets_by_gname);
+            get_id_dict(hc.hier_cells);
+            get_dict(hc.ports, [&](IdString &name, HierarchicalPort &port) {
+                name = get_id();
+                port.name = get_id();
+                port.dir = PortType(get_u8());
+                port.nets = get_ids();
+                port.offset = int(get_u32());
+                port.upto = (get_u8() != 0);
+            });
+            get_props(hc.attrs);
+        });
+
+        if (pos != size)
+            corrupt();
+
+        for (auto it = cell_store.rbegin(); it != cell_store.rend(); ++it)
+            ctx->cells[(*it)->name] = std::move(*it);
+        for (auto it = net_store.rbegin(); it != net_store.rend(); ++it)
+            ctx->nets[(*it)->name] = std::move(*it);
+        ctx->design_loaded = true;
+    }
+
+    // Find the wire (and pip) of a routing entry, first finding the source wire it is downhill of if need be
+    void resolve_routing(const NetInfo *ni, std::vector<RoutingEntry> &routing, uint32_t idx, uint32_t depth)
+    {
+        RoutingEntry &entry = routing.at(idx);
+        if (entry.wire != WireId())
+            return;
+        if (entry.kind == ROUTE_WIRE) {
+            entry.wire = ctx->getWireByName(entry.name);
+            if (entry.wire == WireId())
+                log_error("Checkpoint routes net '%s' through unknown wire '%s'.\n", ni->name.c_str(ctx),
+                          entry.name.str(ctx).c_str());
+            return;
+        }
+        if (entry.kind == ROUTE_PIP) {
+            entry.pip = ctx->getPipByName(entry.name);
+            if (entry.pip == PipId())
+                log_error("Checkpoint routes net '%s' through unknown pip '%s'.\n", ni->name.c_str(ctx),
+                          entry.name.str(ctx).c_str());
+        } else {
+            // A cycle would mean the file is corrupt, as routing is a tree
+            if (entry.src_idx >= routing.size() || depth > routing.size())
+                corrupt();
+            resolve_routing(ni, routing, entry.src_idx, depth + 1);
+            uint32_t downhill_idx = 0;
+            for (PipId downhill : ctx->getPipsDownhill(routing.at(entry.src_idx).wire)) {
+                if (downhill_idx++ == entry.downhill_idx) {
+                    entry.pip = downhill;
+                    break;
+                }
+            }
+            if (entry.pip == PipId())
+                corrupt();
+        }
+        entry.wire = ctx->getPipDstWire(entry.pip);
+    }
+
+    void bind_design()
+    {
+        for (CellInfo *ci : cells) {
+            if (ci->bel == BelId())
+                continue;
+            BelId bel = ci->bel;
+            ci->bel = BelId();
+            if (!ctx->checkBelAvail(bel))
+                log_error("Checkpoint places cell '%s' at bel '%s', which is already in use.\n", ci->name.c_str(ctx),
+                          ctx->nameOfBel(bel));
+            ctx->bindBel(bel, ci, ci->belStrength);
+        }
+        for (size_t i = 0; i < nets.size(); i++) {
+            NetInfo *ni = nets[i];
+            auto &routing = net_routing[i];
+            for (uint32_t j = 0; j < routing.size(); j++)
+                resolve_routing(ni, routing, j, 0);
+            // Bound backwards, so that the wires of the net end up in the same order as they were written
+            for (auto it = routing.rbegin(); it != routing.rend(); ++it) {
+                if (it->pip != PipId())
+                    ctx->bindPip(it->pip, ni, it->strength);
+                else
+                    ctx->bindWire(it->wire, ni, it->strength);
+            }
+        }
+        for (auto &attr : bel_name_attrs)
+            attr.first->attrs[attr.second] = ctx->getBelName(attr.first->bel).str(ctx);
+        for (auto &attr : routing_attrs)
+            attr.first->attrs[attr.second] = routing_attr(ctx, attr.first);
+        ctx->assignArchInfo();
+    }
+};
+
+} // namespace
+
+void write_checkpoint(Context *ctx, std::ostream &out)
+{
+    CheckpointWriter writer(ctx);
+    writer.write_design();
+    writer.write(out);
+}
+
+bool write_checkpoint(Context *ctx, const std::string &filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+        log_error("Failed to open checkpoint file '%s' for writing.\n", filename.c_str());
+    write_checkpoint(ctx, out);
+    if (!out)
+        log_error("Failed to write checkpoint file '%s'.\n", filename.c_str());
+    log_info("Wrote checkpoint with %d cells and %d nets to '%s'.\n", int(ctx->cells.size()), int(ctx->nets.size()),
+             filename.c_str());
+    return true;
+}
+
+bool load_checkpoint(Context *ctx, const char *data, size_t size, const std::string &name)
+{
+    auto startt = std::chrono::high_resolution_clock::now();
+    if (ctx->design_loaded)
+        log_error("Cannot load checkpoint '%s', as a design is already loaded.\n", name.c_str());
+    CheckpointReader reader(ctx, name, data, size);
+    reader.read_header();
+    reader.read_design();
+    reader.bind_design();
+    auto endt = std::chrono::high_resolution_clock::now();
+    log_info("Loaded checkpoint with %d cells and %d nets in %.02fs.\n", int(ctx->cells.size()),
+             int(ctx->nets.size()), std::chrono::duration<double>(endt - startt).count());
+    return true;
+}
+
+bool load_checkpoint(Context *ctx, const std::string &filename)
+{
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (std::exception &) {
+    }
+    if (!file.is_open())
+        log_error("Failed to open checkpoint file '%s'.\n", filename.c_str());
+    return load_checkpoint(ctx, file.data(), file.size(), filename);
+}
+
+bool is_checkpoint_file(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(checkpoint_magic)];
+    if (!in.read(magic, sizeof(magic)))
+        return false;
+    return memcmp(magic, checkpoint_magic, sizeof(magic)) == 0;
+}
+
+NEXTPNR_NAMESPACE_END
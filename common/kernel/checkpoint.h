@@ -0,0 +1,59 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <ostream>
+#include <string>
+
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+/*
+Binary design checkpoints.
+
+A checkpoint holds everything the JSON writer does - the netlist, attributes, settings, placement and routing - plus
+cluster constraints and the random state, in a compact form that loads much faster than reparsing JSON. Strings are
+stored once in tables up front and cells and nets are flat arrays that refer to each other by index. Placement is
+stored as bel names, and routing as a tree of downhill pip indices from its source wires, rather than as the
+NEXTPNR_BEL and ROUTING text attributes (which are rebuilt on load if they were present).
+
+The IdString table, the iteration order of all containers and the order of net users are preserved, so that a flow
+resumed from a checkpoint gives the same results as an uninterrupted one.
+
+Checkpoints are tied to the architecture and device they were written for and to the host byte order; they are
+intended for reuse between runs of the same flow (e.g. pack once, then place and route many times), not as an
+interchange format.
+*/
+
+bool write_checkpoint(Context *ctx, const std::string &filename);
+bool load_checkpoint(Context *ctx, const std::string &filename);
+// Whether a file starts like a checkpoint, for commands that also accept JSON
+bool is_checkpoint_file(const std::string &filename);
+
+// In-memory variants, reading from and writing to a buffer rather than a file
+void write_checkpoint(Context *ctx, std::ostream &out);
+bool load_checkpoint(Context *ctx, const char *data, size_t size, const std::string &name);
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* CHECKPOINT_H */
@@ -28,14 +28,18 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/join.hpp>
-#include <boost/filesystem/path.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <cinttypes>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <random>
 #include <set>
 
+#include "checkpoint.h"
 #include "command.h"
 #include "design_utils.h"
 #include "json_frontend.h"
@@ -231,6 +235,50 @@ std::string proc_share_dirname()
     return npnr_share_dirname;
 }
 
+std::string proc_cache_dirname()
+{
+#if defined(EMSCRIPTEN) || defined(__wasm)
+    return "";
+#else
+    static std::mutex cache_dir_mutex;
+    static std::string cache_dir;
+    static bool cache_dir_checked = false;
+    std::lock_guard<std::mutex> lock(cache_dir_mutex);
+    if (cache_dir_checked)
+        return cache_dir;
+    cache_dir_checked = true;
+    boost::filesystem::path path;
+    if (const char *env = getenv("NEXTPNR_CACHE_DIR")) {
+        path = env;
+    } else {
+#ifdef _WIN32
+        const char *base = getenv("LOCALAPPDATA");
+        if (base)
+            path = boost::filesystem::path(base) / "nextpnr" / "cache";
+#else
+        const char *base = getenv("XDG_CACHE_HOME");
+        if (base && base[0] == '/')
+            path = boost::filesystem::path(base) / "nextpnr";
+        else if ((base = getenv("HOME")) != nullptr)
+            path = boost::filesystem::path(base) / ".cache" / "nextpnr";
+#endif
+    }
+    if (path.empty())
+        return cache_dir;
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(path, ec);
+    if (ec || !boost::filesystem::is_directory(path))
+        return cache_dir;
+    cache_dir = path.make_preferred().string();
+#ifdef _WIN32
+    cache_dir += "\\";
+#else
+    cache_dir += "/";
+#endif
+    return cache_dir;
+#endif
+}
+
 struct no_separator : std::numpunct<char>
 {
   protected:
@@ -321,7 +369,8 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("debug", "debug output");
     general.add_options()("debug-placer", "debug output from placer only");
     general.add_options()("debug-router", "debug output from router only");
-    general.add_options()("threads", po::value<int>(), "number of threads for passes where this is configurable");
+    general.add_options()("threads", po::value<int>(),
+                          "number of threads for passes where this is configurable (default: 8)");
 
     general.add_options()("force,f", "keep running after errors");
 #ifndef NO_GUI
@@ -342,9 +391,17 @@ po::options_description CommandHandler::getGeneralOptions()
 #endif
     general.add_options()("json", po::value<std::string>(), "JSON design file to ingest");
     general.add_options()("write", po::value<std::string>(), "JSON design file to write");
+    general.add_options()("load-checkpoint", po::value<std::string>(), "binary design checkpoint to load");
+    general.add_options()("write-checkpoint", po::value<std::string>(), "binary design checkpoint to write");
+    general.add_options()("eco", po::value<std::string>(),
+                          "previous routed result (JSON or checkpoint) to keep placement and routing of unchanged "
+                          "logic from");
     general.add_options()("top", po::value<std::string>(), "name of top module");
     general.add_options()("seed", po::value<uint64_t>(), "seed value for random number generator");
     general.add_options()("randomize-seed,r", "randomize seed value for random number generator");
+    general.add_options()("seed-sweep", po::value<int>(),
+                          "place and route with N consecutive seeds, starting from --seed (default 1), in parallel "
+                          "and keep the result with the best Fmax");
 
     general.add_options()(
             "placer", po::value<std::string>(),
@@ -369,6 +426,11 @@ po::options_description CommandHandler::getGeneralOptions()
 
     general.add_options()("ignore-loops", "ignore combinational loops in timing analysis");
     general.add_options()("ignore-rel-clk", "ignore clock-to-clock relations in timing checks");
+    general.add_options()("no-incremental-timing", "always re-run timing analysis over the whole design");
+    general.add_options()("verify-incremental-timing",
+                          "check incremental timing analysis results against a full analysis (slow)");
+    general.add_options()("timing-benchmark", po::value<int>(),
+                          "time N full timing analysis runs, serial and parallel, after place and route");
 
     general.add_options()("version,V", "show version");
     general.add_options()("test", "check architecture database integrity");
@@ -386,6 +448,8 @@ po::options_description CommandHandler::getGeneralOptions()
     general.add_options()("placer-heap-critexp", po::value<int>(),
                           "placer heap criticality exponent (int, default: 2)");
     general.add_options()("placer-heap-timingweight", po::value<int>(), "placer heap timing weight (int, default: 10)");
+    general.add_options()("placer-heap-preconditioner", po::value<std::string>(),
+                          "placer heap solver preconditioner: jacobi or ichol (default: jacobi)");
     general.add_options()("placer-heap-cell-placement-timeout", po::value<int>(),
                           "allow placer to attempt up to max(10000, total cells^2 / N) iterations to place a cell (int "
                           "N, default: 8, 0 for no timeout)");
@@ -404,10 +468,17 @@ po::options_description CommandHandler::getGeneralOptions()
                           "enable experimental timing-driven ripup in router (deprecated; use --tmg-ripup instead)");
 
     general.add_options()("router2-alt-weights", "use alternate router2 weights");
+    general.add_options()("router2-perf-profile", "print router2 runtime and allocation profiling information");
 
     general.add_options()("report", po::value<std::string>(),
                           "write timing and utilization report in JSON format to file");
     general.add_options()("detailed-timing-report", "Append detailed net timing data to the JSON report");
+    general.add_options()("report-paths", po::value<int>(),
+                          "report the N worst setup paths of each clock domain pair in the log and JSON report");
+    general.add_options()("report-paths-per-endpoint", po::value<int>(),
+                          "how many of the reported worst paths may end at the same endpoint (int, default: 1)");
+    general.add_options()("profile-trace", po::value<std::string>(),
+                          "write time spent in each pass and stage as a Chrome trace-event JSON file");
 
     general.add_options()("placed-svg", po::value<std::string>(), "write render of placement to SVG file");
     general.add_options()("routed-svg", po::value<std::string>(), "write render of routing to SVG file");
@@ -481,6 +552,14 @@ void CommandHandler::setupContext(Context *ctx)
         ctx->settings[ctx->id("timing/ignoreRelClk")] = true;
     }
 
+    if (vm.count("no-incremental-timing")) {
+        ctx->settings[ctx->id("timing/incremental")] = false;
+    }
+
+    if (vm.count("verify-incremental-timing")) {
+        ctx->settings[ctx->id("timing/verifyIncremental")] = true;
+    }
+
     if (vm.count("timing-allow-fail")) {
         ctx->settings[ctx->id("timing/allowFail")] = true;
     }
@@ -531,6 +610,9 @@ void CommandHandler::setupContext(Context *ctx)
     if (vm.count("placer-heap-timingweight"))
         ctx->settings[ctx->id("placerHeap/timingWeight")] = std::to_string(vm["placer-heap-timingweight"].as<int>());
 
+    if (vm.count("placer-heap-preconditioner"))
+        ctx->settings[ctx->id("placerHeap/preconditioner")] = vm["placer-heap-preconditioner"].as<std::string>();
+
     if (vm.count("placer-heap-cell-placement-timeout"))
         ctx->settings[ctx->id("placerHeap/cellPlacementTimeout")] =
                 std::to_string(std::max(0, vm["placer-heap-cell-placement-timeout"].as<int>()));
@@ -545,10 +627,18 @@ void CommandHandler::setupContext(Context *ctx)
 
     if (vm.count("router2-alt-weights"))
         ctx->settings[ctx->id("router2/alt-weights")] = true;
+    if (vm.count("router2-perf-profile"))
+        ctx->settings[ctx->id("router2/perfProfile")] = true;
 
     if (vm.count("static-dump-density"))
         ctx->settings[ctx->id("static/dump_density")] = true;
 
+    if (vm.count("report-paths"))
+        ctx->settings[ctx->id("timing/reportPaths")] = std::to_string(std::max(0, vm["report-paths"].as<int>()));
+    if (vm.count("report-paths-per-endpoint"))
+        ctx->settings[ctx->id("timing/reportPathsPerEndpoint")] =
+                std::to_string(std::max(1, vm["report-paths-per-endpoint"].as<int>()));
+
     // Setting default values
     if (ctx->settings.find(ctx->id("target_freq")) == ctx->settings.end())
         ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
@@ -576,11 +666,181 @@ void CommandHandler::setupContext(Context *ctx)
     if (ctx->settings.find(ctx->id("placerHeap/timingWeight")) == ctx->settings.end())
         ctx->settings[ctx->id("placerHeap/timingWeight")] = std::to_string(10);
 
+    if (vm.count("profile-trace")) {
+        ctx->profiler.trace = true;
+    }
+
     if (vm.count("detailed-timing-report")) {
         ctx->detailed_timing_report = true;
     }
 }
 
+void CommandHandler::applyCheckpointOptions(Context *ctx)
+{
+    // Options given for this run take precedence over the settings saved in the checkpoint; but unless a new seed was
+    // given, carry on with the random state the checkpoint was saved with, as if the flow had not been interrupted
+    uint64_t rngstate = ctx->rngstate;
+    Property seed = get_or_default(ctx->settings, ctx->id("seed"), Property(ctx->rngstate, 64));
+    setupContext(ctx);
+    if (!vm.count("seed") && !vm.count("randomize-seed")) {
+        ctx->rngstate = rngstate;
+        ctx->settings[ctx->id("seed")] = seed;
+    }
+}
+
+std::unique_ptr<Context> CommandHandler::createEmptyContext()
+{
+    dict<std::string, Property> values;
+    std::unique_ptr<Context> ctx = createContext(values);
+    setupContext(ctx.get());
+    setupArchContext(ctx.get());
+    return ctx;
+}
+
+std::unique_ptr<Context> CommandHandler::loadPreviousResult(const std::string &filename)
+{
+    log_break();
+    log_info("Loading previous result from '%s'...\n", filename.c_str());
+    std::unique_ptr<Context> prev = createEmptyContext();
+    // Both restore placement and routing along with the netlist
+    bool loaded = is_checkpoint_file(filename) ? load_checkpoint(prev.get(), filename)
+                                               : parse_json_file(filename, prev.get());
+    if (!loaded)
+        log_error("Loading previous result failed.\n");
+    return prev;
+}
+
+std::unique_ptr<Context> CommandHandler::runSeedSweep(std::unique_ptr<Context> ctx, int count)
+{
+    if (count < 1)
+        log_error("--seed-sweep needs at least one seed.\n");
+    uint64_t first_seed = vm.count("seed") ? vm["seed"].as<uint64_t>() : 1;
+    log_break();
+    log_info("Placing and routing with %d seeds from %llu, on up to %d threads...\n", count,
+             (unsigned long long)first_seed, ctx->threadPool().size());
+
+    struct SeedRun
+    {
+        uint64_t seed;
+        std::unique_ptr<Context> ctx;
+        LogCapture log;
+        bool failed = false;
+        // Lowest ratio of achieved to constrained Fmax over all clocks, and the number of wires used by routing
+        float fmax_ratio = 0;
+        int64_t wirelength = 0;
+    };
+    std::vector<SeedRun> runs(count);
+
+    // Each run gets its own context, with a copy of the packed design
+    for (int i = 0; i < count; i++) {
+        SeedRun &run = runs.at(i);
+        run.seed = first_seed + i;
+        ScopedLogCapture capture(run.log);
+        run.ctx = createEmptyContext();
+        ctx->forkInto(run.ctx.get());
+        run.ctx->rngseed(run.seed);
+        run.ctx->settings[run.ctx->id("seed")] = Property(run.ctx->rngstate, 64);
+        // Parallelism comes from running seeds concurrently; this also keeps all of a run's logging on one thread
+        run.ctx->settings[run.ctx->id("threads")] = 1;
+    }
+
+    // Steps of the flow run on all remaining seeds in parallel, and script hooks one seed at a time, as they work on
+    // the global ctx
+    auto run_step = [&](std::function<void(Context *)> step) {
+        ctx->threadPool().parallel_for(count, [&](int i) {
+            SeedRun &run = runs.at(i);
+            if (run.failed)
+                return;
+            ScopedLogCapture capture(run.log);
+            try {
+                step(run.ctx.get());
+            } catch (log_execution_error_exception) {
+                run.failed = true;
+            }
+        });
+    };
+    auto run_hook = [&](const std::string &name) {
+        if (!vm.count(name))
+            return;
+        for (auto &run : runs) {
+            if (run.failed)
+                continue;
+            ScopedLogCapture capture(run.log);
+#ifndef NO_PYTHON
+            python_export_global("ctx", *run.ctx);
+#endif
+            try {
+                run_script_hook(name);
+            } catch (log_execution_error_exception) {
+                run.failed = true;
+            }
+        }
+    };
+
+    run_hook("pre-place");
+    run_step([&](Context *run_ctx) {
+        bool saved_debug = run_ctx->debug;
+        if (vm.count("debug-placer"))
+            run_ctx->debug = true;
+        {
+            ProfileScope profile(run_ctx->profiler, "place");
+            if (!run_ctx->place() && !run_ctx->force)
+                log_error("Placing design failed.\n");
+        }
+        run_ctx->debug = saved_debug;
+        run_ctx->check();
+    });
+    run_hook("pre-route");
+    run_step([&](Context *run_ctx) {
+        bool saved_debug = run_ctx->debug;
+        if (vm.count("debug-router"))
+            run_ctx->debug = true;
+        {
+            ProfileScope profile(run_ctx->profiler, "route");
+            if (!run_ctx->route() && !run_ctx->force)
+                log_error("Routing design failed.\n");
+        }
+        run_ctx->debug = saved_debug;
+    });
+    run_hook("post-route");
+
+    SeedRun *best = nullptr;
+    for (auto &run : runs) {
+        if (run.failed) {
+            log_info("    seed %llu: failed\n", (unsigned long long)run.seed);
+            continue;
+        }
+        run.fmax_ratio = std::numeric_limits<float>::max();
+        for (auto &clock : run.ctx->timing_result.clock_fmax)
+            run.fmax_ratio = std::min(run.fmax_ratio, clock.second.achieved / clock.second.constraint);
+        for (auto &net : run.ctx->nets)
+            run.wirelength += net.second->wires.size();
+        if (run.ctx->timing_result.clock_fmax.empty())
+            log_info("    seed %llu: wirelength %lld\n", (unsigned long long)run.seed, (long long)run.wirelength);
+        else
+            log_info("    seed %llu: %.1f%% of target Fmax, wirelength %lld\n", (unsigned long long)run.seed,
+                     100.0f * run.fmax_ratio, (long long)run.wirelength);
+        if (!best || run.fmax_ratio > best->fmax_ratio ||
+            (run.fmax_ratio == best->fmax_ratio && run.wirelength < best->wirelength))
+            best = &run;
+    }
+    if (!best) {
+        runs.front().log.replay();
+        log_error("Placement and routing failed for all seeds.\n");
+    }
+    log_info("Keeping the result of seed %llu:\n", (unsigned long long)best->seed);
+    // The kept run's warnings and errors count towards the summary, the exit status and --Werror as usual
+    best->log.replay();
+    // Routing doesn't move cells, so the placement can still be drawn from the routed design
+    if (vm.count("placed-svg"))
+        best->ctx->writeSVG(vm["placed-svg"].as<std::string>(), "scale=50 hide_routing");
+    if (vm.count("routed-svg"))
+        best->ctx->writeSVG(vm["routed-svg"].as<std::string>(), "scale=500");
+    // Keep the profile of loading and packing the design
+    best->ctx->profiler.adopt(ctx->profiler);
+    return std::move(best->ctx);
+}
+
 int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 {
     if (vm.count("on-failure")) {
@@ -596,16 +856,25 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         ctx->settings[ctx->id("frontend/top")] = vm["top"].as<std::string>();
     }
 
+    conflicting_options(vm, "json", "load-checkpoint");
+    conflicting_options(vm, "eco", "seed-sweep");
+
 #ifndef NO_GUI
     if (vm.count("gui")) {
         Application a(argc, argv, (vm.count("gui-no-aa") > 0));
         MainWindow w(std::move(ctx), this);
         try {
-            if (vm.count("json")) {
-                std::string filename = vm["json"].as<std::string>();
-                std::ifstream f(filename);
-                if (!parse_json(f, filename, w.getContext()))
-                    log_error("Loading design failed.\n");
+            if (vm.count("json") || vm.count("load-checkpoint")) {
+                if (vm.count("json")) {
+                    std::string filename = vm["json"].as<std::string>();
+                    if (!parse_json_file(filename, w.getContext()))
+                        log_error("Loading design failed.\n");
+                } else {
+                    std::string filename = vm["load-checkpoint"].as<std::string>();
+                    if (!load_checkpoint(w.getContext(), filename))
+                        log_error("Loading checkpoint failed.\n");
+                    applyCheckpointOptions(w.getContext());
+                }
 
                 if (vm.count("sdc")) {
                     std::string sdc_filename = vm["sdc"].as<std::string>();
@@ -627,11 +896,18 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         return a.exec();
     }
 #endif
-    if (vm.count("json")) {
-        std::string filename = vm["json"].as<std::string>();
-        std::ifstream f(filename);
-        if (!parse_json(f, filename, ctx.get()))
-            log_error("Loading design failed.\n");
+    if (vm.count("json") || vm.count("load-checkpoint")) {
+        ProfileScope profile(ctx->profiler, "load");
+        if (vm.count("json")) {
+            std::string filename = vm["json"].as<std::string>();
+            if (!parse_json_file(filename, ctx.get()))
+                log_error("Loading design failed.\n");
+        } else {
+            std::string filename = vm["load-checkpoint"].as<std::string>();
+            if (!load_checkpoint(ctx.get(), filename))
+                log_error("Loading checkpoint failed.\n");
+            applyCheckpointOptions(ctx.get());
+        }
 
         if (vm.count("sdc")) {
             std::string sdc_filename = vm["sdc"].as<std::string>();
@@ -660,19 +936,51 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 
         if (do_pack) {
             run_script_hook("pre-pack");
+            ProfileScope profile(ctx->profiler, "pack");
             if (!ctx->pack() && !ctx->force)
                 log_error("Packing design failed.\n");
         }
         ctx->check();
         print_utilisation(ctx.get());
 
+        if (do_place && vm.count("seed-sweep")) {
+            if (!do_route)
+                log_error("--seed-sweep requires both placement and routing to be run.\n");
+            if (!ctx->canForkDesign())
+                log_error("--seed-sweep is not supported for this architecture.\n");
+            ctx = runSeedSweep(std::move(ctx), vm["seed-sweep"].as<int>());
+#ifndef NO_PYTHON
+            python_export_global("ctx", *ctx);
+#endif
+            do_place = do_route = false;
+        }
+
         if (do_place) {
             run_script_hook("pre-place");
             bool saved_debug = ctx->debug;
             if (vm.count("debug-placer"))
                 ctx->debug = true;
-            if (!ctx->place() && !ctx->force)
-                log_error("Placing design failed.\n");
+            bool eco = vm.count("eco");
+            IdString id_placer = ctx->id("placer");
+            bool had_placer = ctx->settings.count(id_placer);
+            Property saved_placer = had_placer ? ctx->settings.at(id_placer) : Property();
+            if (eco) {
+                ctx->eco_previous = loadPreviousResult(vm["eco"].as<std::string>());
+                ctx->settings[id_placer] = std::string("eco");
+            }
+            {
+                ProfileScope profile(ctx->profiler, "place");
+                if (!ctx->place() && !ctx->force)
+                    log_error("Placing design failed.\n");
+            }
+            if (eco) {
+                // Don't leave the eco placer selected in the settings of the written design
+                if (had_placer)
+                    ctx->settings[id_placer] = saved_placer;
+                else
+                    ctx->settings.erase(id_placer);
+                ctx->eco_previous.reset();
+            }
             ctx->debug = saved_debug;
             ctx->check();
             if (vm.count("placed-svg"))
@@ -684,14 +992,21 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
             bool saved_debug = ctx->debug;
             if (vm.count("debug-router"))
                 ctx->debug = true;
-            if (!ctx->route() && !ctx->force)
-                log_error("Routing design failed.\n");
+            {
+                ProfileScope profile(ctx->profiler, "route");
+                if (!ctx->route() && !ctx->force)
+                    log_error("Routing design failed.\n");
+            }
             ctx->debug = saved_debug;
             run_script_hook("post-route");
             if (vm.count("routed-svg"))
                 ctx->writeSVG(vm["routed-svg"].as<std::string>(), "scale=500");
         }
 
+        if (vm.count("timing-benchmark"))
+            timing_benchmark(ctx.get(), vm["timing-benchmark"].as<int>());
+
+        ProfileScope profile(ctx->profiler, "bitstream");
         customBitstream(ctx.get());
     }
 
@@ -702,6 +1017,12 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
             log_error("Saving design failed.\n");
     }
 
+    if (vm.count("write-checkpoint")) {
+        std::string filename = vm["write-checkpoint"].as<std::string>();
+        if (!write_checkpoint(ctx.get(), filename))
+            log_error("Saving checkpoint failed.\n");
+    }
+
     if (vm.count("sdf")) {
         std::string filename = vm["sdf"].as<std::string>();
         std::ofstream f(filename);
@@ -718,6 +1039,14 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         ctx->writeJsonReport(f);
     }
 
+    if (vm.count("profile-trace")) {
+        std::string filename = vm["profile-trace"].as<std::string>();
+        std::ofstream f(filename);
+        if (!f)
+            log_error("Failed to open profile trace file '%s' for writing.\n", filename.c_str());
+        ctx->profiler.write_chrome_trace(f);
+    }
+
 #ifndef NO_PYTHON
     deinit_python();
 #endif
@@ -771,11 +1100,8 @@ void CommandHandler::load_json(Context *ctx, std::string filename)
 {
     setupContext(ctx);
     setupArchContext(ctx);
-    {
-        std::ifstream f(filename);
-        if (!parse_json(f, filename, ctx))
-            log_error("Loading design failed.\n");
-    }
+    if (!parse_json_file(filename, ctx))
+        log_error("Loading design failed.\n");
 }
 
 void CommandHandler::clear() { vm.clear(); }
@@ -54,6 +54,11 @@ class CommandHandler
     bool parseOptions();
     bool executeBeforeContext();
     void setupContext(Context *ctx);
+    void applyCheckpointOptions(Context *ctx);
+    // A context set up from the command line like the main one, but with no design loaded
+    std::unique_ptr<Context> createEmptyContext();
+    std::unique_ptr<Context> loadPreviousResult(const std::string &filename);
+    std::unique_ptr<Context> runSeedSweep(std::unique_ptr<Context> ctx, int count);
     int executeMain(std::unique_ptr<Context> ctx);
     po::options_description getGeneralOptions();
     void printFooter();
@@ -74,6 +79,9 @@ bool check_file_exists(std::string filename, bool is_exec);
 void init_share_dirname();
 std::string proc_self_dirname();
 std::string proc_share_dirname();
+// Per-user directory for files that can be regenerated, such as decompressed chip databases. Empty if there is none
+// that can be written.
+std::string proc_cache_dirname();
 
 NEXTPNR_NAMESPACE_END
 
@@ -486,4 +486,171 @@ struct FixupHierarchyWorker
 
 void Context::fixupHierarchy() { FixupHierarchyWorker(this).run(); }
 
+namespace {
+struct ForkWorker
+{
+    ForkWorker(const Context *ctx, Context *target) : ctx(ctx), target(target) {};
+    const Context *ctx;
+    Context *target;
+
+    void run()
+    {
+        if (!target->cells.empty() || !target->nets.empty())
+            log_error("Contexts can only be forked into a context without a design.\n");
+        if (!ctx->canForkDesign())
+            log_error("Forking a design is not supported for this architecture.\n");
+        copy_idstrings();
+        copy_netlist();
+        copy_design_state();
+        // Derived per-cell and per-net data, including any pointers in the arch-specific info, is recomputed for the
+        // new netlist before binding, which in turn rebuilds the arch's binding state
+        target->assignArchInfo();
+        ctx->forkArchState(target);
+        bind();
+    }
+
+    // Make the string table of the target the same as ours, so that all IdStrings can be copied verbatim. As both
+    // contexts were set up the same way, the target's table should be a prefix of ours.
+    void copy_idstrings()
+    {
+        const IdStringDb &src = *ctx->idstring_db;
+        IdStringDb &dst = *target->idstring_db;
+        int common = dst.size();
+        if (common > src.size())
+            log_error("Cannot fork a context into one with a larger string table.\n");
+        for (int i = 0; i < common; i++)
+            if (src.str(i) != dst.str(i))
+                log_error("Cannot fork a context into one that was set up differently (string %d is '%s', not "
+                          "'%s').\n",
+                          i, dst.str(i).c_str(), src.str(i).c_str());
+        for (int i = common; i < src.size(); i++)
+            NPNR_ASSERT(dst.intern(src.str(i)) == i);
+    }
+
+    CellInfo *map_cell(const CellInfo *cell) const { return cell ? target->cells.at(cell->name).get() : nullptr; }
+    NetInfo *map_net(const NetInfo *net) const { return net ? target->nets.at(net->name).get() : nullptr; }
+    Region *map_region(const Region *region) const
+    {
+        return region ? target->region.at(region->name).get() : nullptr;
+    }
+
+    void copy_netlist()
+    {
+        for (auto &region : ctx->region)
+            target->region[region.first] = std::make_unique<Region>(*region.second);
+        // hashlib dicts iterate in reverse order of insertion, so objects are created back to front to keep the same
+        // iteration order in both contexts
+        std::vector<const CellInfo *> cells;
+        for (auto &cell : ctx->cells)
+            cells.push_back(cell.second.get());
+        std::vector<const NetInfo *> nets;
+        for (auto &net : ctx->nets)
+            nets.push_back(net.second.get());
+        for (auto it = cells.rbegin(); it != cells.rend(); ++it)
+            target->cells[(*it)->name] = std::make_unique<CellInfo>(target, (*it)->name, (*it)->type);
+        for (auto it = nets.rbegin(); it != nets.rend(); ++it)
+            target->nets[(*it)->name] = std::make_unique<NetInfo>((*it)->name);
+
+        for (auto ci : cells) {
+            CellInfo *nc = map_cell(ci);
+            static_cast<ArchCellInfo &>(*nc) = static_cast<const ArchCellInfo &>(*ci);
+            for (auto &child : nc->constr_children)
+                child = map_cell(child);
+            nc->hierpath = ci->hierpath;
+            nc->udata = ci->udata;
+            nc->ports = ci->ports;
+            for (auto &port : nc->ports)
+                port.second.net = map_net(port.second.net);
+            nc->attrs = ci->attrs;
+            nc->params = ci->params;
+            nc->cluster = ci->cluster;
+            nc->region = map_region(ci->region);
+            if (ci->pseudo_cell) {
+                auto plug = dynamic_cast<const RegionPlug *>(ci->pseudo_cell.get());
+                if (!plug)
+                    log_error("Cannot fork a context containing pseudo cell '%s'.\n", ctx->nameOf(ci));
+                nc->pseudo_cell = std::make_unique<RegionPlug>(*plug);
+            }
+        }
+        for (auto ni : nets) {
+            NetInfo *nn = map_net(ni);
+            static_cast<ArchNetInfo &>(*nn) = static_cast<const ArchNetInfo &>(*ni);
+            nn->hierpath = ni->hierpath;
+            nn->udata = ni->udata;
+            nn->driver = PortRef{map_cell(ni->driver.cell), ni->driver.port};
+            nn->users = indexed_store<PortRef>(ni->users);
+            for (auto &usr : nn->users)
+                usr.cell = map_cell(usr.cell);
+            nn->attrs = ni->attrs;
+            nn->constant_value = ni->constant_value;
+            nn->aliases = ni->aliases;
+            if (ni->clkconstr)
+                nn->clkconstr = std::make_unique<ClockConstraint>(*ni->clkconstr);
+            nn->region = map_region(ni->region);
+        }
+    }
+
+    void copy_design_state()
+    {
+        target->settings = ctx->settings;
+        target->attrs = ctx->attrs;
+        target->top_module = ctx->top_module;
+        target->hierarchy = ctx->hierarchy;
+        target->net_aliases = ctx->net_aliases;
+        // Packers may delete the net a top-level port was connected to without clearing it here
+        pool<const NetInfo *, hash_ptr_ops> live_nets;
+        for (auto &net : ctx->nets)
+            live_nets.insert(net.second.get());
+        target->ports = ctx->ports;
+        for (auto &port : target->ports)
+            port.second.net = live_nets.count(port.second.net) ? map_net(port.second.net) : nullptr;
+        // Entries for cells that packing removed are dropped
+        for (auto &port_cell : ctx->port_cells) {
+            if (const CellInfo *cell = ctx->getPortCell(port_cell.first))
+                target->port_cells[port_cell.first] = map_cell(cell);
+        }
+        target->timing_result = ctx->timing_result;
+        target->design_loaded = ctx->design_loaded;
+        target->rngstate = ctx->rngstate;
+        target->verbose = ctx->verbose;
+        target->debug = ctx->debug;
+        target->force = ctx->force;
+        target->disable_critical_path_source_print = ctx->disable_critical_path_source_print;
+        target->detailed_timing_report = ctx->detailed_timing_report;
+    }
+
+    void bind()
+    {
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get();
+            if (ci->bel != BelId())
+                target->bindBel(ci->bel, map_cell(ci), ci->belStrength);
+        }
+        std::vector<std::pair<WireId, PipMap>> wires;
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get();
+            NetInfo *nn = map_net(ni);
+            wires.clear();
+            for (auto &wire : ni->wires)
+                wires.push_back(wire);
+            for (auto it = wires.rbegin(); it != wires.rend(); ++it) {
+                if (it->second.pip != PipId())
+                    target->bindPip(it->second.pip, nn, it->second.strength);
+                else
+                    target->bindWire(it->first, nn, it->second.strength);
+            }
+        }
+    }
+};
+} // namespace
+
+void Context::forkInto(Context *target) const { ForkWorker(this, target).run(); }
+
+ThreadPool &Context::threadPool()
+{
+    if (!thread_pool)
+        thread_pool = std::make_unique<ThreadPool>(threads());
+    return *thread_pool;
+}
+
 NEXTPNR_NAMESPACE_END
@@ -25,6 +25,8 @@
 
 #include "arch.h"
 #include "deterministic_rng.h"
+#include "profiler.h"
+#include "thread_pool.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -36,11 +38,19 @@ struct Context : Arch, DeterministicRNG
 
     // Should we disable printing of the location of nets in the critical path?
     bool disable_critical_path_source_print = false;
-    // True when detailed per-net timing is to be stored / reported
+    // True when detailed per-net timing is to be included in the JSON report
     bool detailed_timing_report = false;
 
     ArchArgs arch_args;
 
+    std::unique_ptr<ThreadPool> thread_pool;
+
+    // Time and memory used by each pass, see profiler.h
+    Profiler profiler;
+
+    // Result of an earlier run for the "eco" placer to start from (see eco.h)
+    std::unique_ptr<Context> eco_previous;
+
     Context(ArchArgs args) : Arch(args)
     {
         BaseCtx::as_ctx = this;
@@ -87,6 +97,11 @@ struct Context : Arch, DeterministicRNG
     // call after changing hierpath or adding/removing nets and cells
     void fixupHierarchy();
 
+    // Deep copy the design, including constraints, placement and routing, into `target`. The target must be a newly
+    // created context for the same device, set up with the same options and with no design loaded. Arch binding state
+    // is rebuilt through the usual bind calls, so the two contexts can then be placed and routed independently.
+    void forkInto(Context *target) const;
+
     // --------------------------------------------------------------
 
     // provided by sdf.cc
@@ -100,7 +115,7 @@ struct Context : Arch, DeterministicRNG
     // --------------------------------------------------------------
 
     // provided by report.cc
-    void writeJsonReport(std::ostream &out) const;
+    void writeJsonReport(std::ostream &out);
 
     // provided by timing_log.cc
     void log_timing_results(TimingResult &result, bool print_histogram, bool print_fmax, bool print_path,
@@ -111,6 +126,17 @@ struct Context : Arch, DeterministicRNG
 
     // --------------------------------------------------------------
 
+    // Number of threads for parallel passes, from the "threads" setting. Every pass that is configurable this way
+    // uses it, so that they all share one default.
+    static constexpr int default_threads = 8;
+    int threads() { return std::max(1, setting<int>("threads", default_threads)); }
+
+    // Worker pool shared by all parallel passes, sized by threads(). Created on first use, which must be from the
+    // main thread.
+    ThreadPool &threadPool();
+
+    // --------------------------------------------------------------
+
     uint32_t checksum() const;
 
     void check() const;
@@ -0,0 +1,488 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "eco.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "log.h"
+#include "placer1.h"
+#include "util.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+EcoCfg::EcoCfg(Context *ctx)
+{
+    radius = ctx->setting<int>("eco/radius", 0);
+    max_fanout = ctx->setting<int>("eco/maxFanout", 64);
+}
+
+namespace {
+struct EcoPlacer
+{
+    EcoPlacer(Context *ctx, const Context *prev, EcoCfg cfg) : ctx(ctx), prev(prev), cfg(cfg) {};
+    Context *ctx;
+    const Context *prev;
+    EcoCfg cfg;
+
+    // Our IdString indices to those of the previous context: -2 if not looked up yet, -1 if not present there
+    std::vector<int> id_map;
+    // Previous bel strength of cells that kept their placement
+    dict<IdString, PlaceStrength> kept_strength;
+    // Cells placed by their BEL attribute
+    std::vector<CellInfo *> constrained;
+    std::vector<CellInfo *> changed;
+    // Kept cells locked in place while refining the placement of changed ones
+    std::vector<CellInfo *> locked;
+    dict<ClusterId, std::vector<CellInfo *>> clusters;
+    int width = 0, height = 0;
+    std::vector<bool> near_changes;
+
+    IdString prev_id(IdString id)
+    {
+        if (id.index >= int(id_map.size()))
+            id_map.resize(std::max(id.index + 1, ctx->idstring_db->size()), -2);
+        int &mapped = id_map.at(id.index);
+        if (mapped == -2)
+            mapped = prev->idstring_db->lookup(id.str(ctx));
+        return IdString(mapped);
+    }
+
+    const CellInfo *prev_cell(const CellInfo *ci)
+    {
+        auto found = prev->cells.find(prev_id(ci->name));
+        return found == prev->cells.end() ? nullptr : found->second.get();
+    }
+
+    // The name of a port in the previous result. The JSON writer groups "I[0]", "I[1]" and so on into a bus "I",
+    // so a bus with only bit 0 connected comes back as a plain port "I".
+    IdString prev_port(const CellInfo *pc, IdString port)
+    {
+        IdString name = prev_id(port);
+        if (pc->ports.count(name))
+            return name;
+        const std::string &str = port.str(ctx);
+        if (str.size() > 3 && str.compare(str.size() - 3, 3, "[0]") == 0) {
+            int base = prev->idstring_db->lookup(str.substr(0, str.size() - 3));
+            if (base >= 0 && pc->ports.count(IdString(base)))
+                return IdString(base);
+        }
+        return name;
+    }
+
+    bool cell_unchanged(const CellInfo *ci, const CellInfo *pc)
+    {
+        if (prev_id(ci->type) != pc->type || ci->ports.size() != pc->ports.size())
+            return false;
+        for (auto &port : ci->ports) {
+            auto found = pc->ports.find(prev_port(pc, port.first));
+            if (found == pc->ports.end() || found->second.type != port.second.type)
+                return false;
+            const NetInfo *ni = port.second.net, *pn = found->second.net;
+            if ((ni == nullptr) != (pn == nullptr) || (ni && prev_id(ni->name) != pn->name))
+                return false;
+        }
+        return true;
+    }
+
+    bool bel_usable(const CellInfo *ci, BelId bel)
+    {
+        return bel != BelId() && ctx->checkBelAvail(bel) && ctx->isValidBelForCellType(ci->type, bel);
+    }
+
+    void unbind_group(const std::vector<CellInfo *> &group)
+    {
+        for (auto ci : group)
+            if (ci->bel != BelId())
+                ctx->unbindBel(ci->bel);
+    }
+
+    // Cells that have to be placed together: a whole cluster, or a single cell
+    std::vector<CellInfo *> placement_group(CellInfo *ci)
+    {
+        if (ci->cluster == ClusterId())
+            return {ci};
+        return clusters.at(ci->cluster);
+    }
+
+    void bind_constrained()
+    {
+        // User location constraints in the new netlist take priority over the previous placement
+        for (auto &cell : ctx->cells) {
+            CellInfo *ci = cell.second.get();
+            auto loc = ci->attrs.find(ctx->id("BEL"));
+            if (ci->isPseudo() || loc == ci->attrs.end())
+                continue;
+            std::string loc_name = loc->second.as_string();
+            BelId bel = ctx->getBelByNameStr(loc_name);
+            if (!bel_usable(ci, bel))
+                log_error("Cell '%s' cannot be placed at bel '%s' given by its BEL attribute.\n", ctx->nameOf(ci),
+                          loc_name.c_str());
+            ctx->bindBel(bel, ci, STRENGTH_USER);
+            constrained.push_back(ci);
+        }
+    }
+
+    void bind_kept()
+    {
+        dict<ClusterId, bool> cluster_kept;
+        for (auto &cell : ctx->cells) {
+            CellInfo *ci = cell.second.get();
+            const CellInfo *pc = prev_cell(ci);
+            bool kept = pc && pc->bel != BelId() && cell_unchanged(ci, pc);
+            if (ci->cluster != ClusterId()) {
+                auto found = cluster_kept.find(ci->cluster);
+                cluster_kept[ci->cluster] = kept && (found == cluster_kept.end() || found->second);
+            }
+        }
+        std::vector<CellInfo *> bound;
+        for (auto &cell : ctx->cells) {
+            CellInfo *ci = cell.second.get();
+            if (ci->isPseudo() || ci->bel != BelId())
+                continue;
+            if (ci->cluster != ClusterId()) {
+                // Clusters are bound as a whole from their root
+                if (!cluster_kept.at(ci->cluster) || ctx->getClusterRootCell(ci->cluster) != ci)
+                    continue;
+                auto group = placement_group(ci);
+                bool usable = std::all_of(group.begin(), group.end(),
+                                          [&](CellInfo *member) { return bel_usable(member, prev_cell(member)->bel); });
+                if (!usable)
+                    continue;
+                for (auto member : group) {
+                    const CellInfo *pc = prev_cell(member);
+                    ctx->bindBel(pc->bel, member, STRENGTH_WEAK);
+                    kept_strength[member->name] = pc->belStrength;
+                    bound.push_back(member);
+                }
+                continue;
+            }
+            const CellInfo *pc = prev_cell(ci);
+            if (!pc || pc->bel == BelId() || !cell_unchanged(ci, pc) || !bel_usable(ci, pc->bel))
+                continue;
+            ctx->bindBel(pc->bel, ci, STRENGTH_WEAK);
+            kept_strength[ci->name] = pc->belStrength;
+            bound.push_back(ci);
+        }
+        // Placements that were legal with the old netlist may not be with the new one, e.g. if a shared control
+        // signal of a slice changed
+        for (auto ci : bound) {
+            if (ci->bel == BelId() || ctx->isBelLocationValid(ci->bel))
+                continue;
+            for (auto member : placement_group(ci)) {
+                kept_strength.erase(member->name);
+                if (member->bel != BelId())
+                    ctx->unbindBel(member->bel);
+            }
+        }
+    }
+
+    Loc target_location(const CellInfo *ci)
+    {
+        int x = 0, y = 0, count = 0;
+        for (auto &port : ci->ports) {
+            const NetInfo *ni = port.second.net;
+            if (!ni || int(ni->users.entries()) > cfg.max_fanout)
+                continue;
+            auto add = [&](const CellInfo *other) {
+                if (!other || other == ci || other->bel == BelId())
+                    return;
+                Loc loc = ctx->getBelLocation(other->bel);
+                x += loc.x;
+                y += loc.y;
+                count++;
+            };
+            add(ni->driver.cell);
+            for (auto &usr : ni->users)
+                add(usr.cell);
+        }
+        if (count == 0)
+            return Loc(ctx->getGridDimX() / 2, ctx->getGridDimY() / 2, 0);
+        return Loc(x / count, y / count, 0);
+    }
+
+    bool try_place(CellInfo *ci, BelId bel)
+    {
+        if (ci->cluster == ClusterId()) {
+            if (!bel_usable(ci, bel))
+                return false;
+            ctx->bindBel(bel, ci, STRENGTH_WEAK);
+            if (ctx->isBelLocationValid(bel))
+                return true;
+            ctx->unbindBel(bel);
+            return false;
+        }
+        std::vector<std::pair<CellInfo *, BelId>> placement;
+        if (!ctx->getClusterPlacement(ci->cluster, bel, placement))
+            return false;
+        for (auto &p : placement)
+            if (!bel_usable(p.first, p.second))
+                return false;
+        std::vector<CellInfo *> group;
+        for (auto &p : placement) {
+            ctx->bindBel(p.second, p.first, STRENGTH_WEAK);
+            group.push_back(p.first);
+        }
+        for (auto &p : placement) {
+            if (!ctx->isBelLocationValid(p.second)) {
+                unbind_group(group);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Put each new or changed cell on the closest free bel to the cells it connects to
+    void place_changed()
+    {
+        std::vector<CellInfo *> to_place;
+        for (auto ci : changed)
+            if (ci->cluster == ClusterId() || ctx->getClusterRootCell(ci->cluster) == ci)
+                to_place.push_back(ci);
+        std::sort(to_place.begin(), to_place.end(), [](CellInfo *a, CellInfo *b) { return a->name < b->name; });
+        for (auto ci : to_place) {
+            if (ci->bel != BelId())
+                continue;
+            Loc target = target_location(ci);
+            std::vector<std::pair<int, BelId>> candidates;
+            for (BelId bel : ctx->getBelsInBucket(ctx->getBelBucketForCellType(ci->type))) {
+                if (!ctx->checkBelAvail(bel))
+                    continue;
+                Loc loc = ctx->getBelLocation(bel);
+                candidates.emplace_back(std::abs(loc.x - target.x) + std::abs(loc.y - target.y), bel);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const std::pair<int, BelId> &a, const std::pair<int, BelId> &b) {
+                                 return a.first < b.first;
+                             });
+            bool placed = false;
+            for (auto &candidate : candidates) {
+                if (try_place(ci, candidate.second)) {
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed)
+                log_error("ECO placement found no free bel for cell '%s' of type '%s'.\n", ctx->nameOf(ci),
+                          ci->type.c_str(ctx));
+        }
+    }
+
+    // Tiles within `radius` of a changed cell
+    void mark_changed_region()
+    {
+        width = ctx->getGridDimX();
+        height = ctx->getGridDimY();
+        near_changes.assign(width * height, false);
+        for (auto ci : changed) {
+            if (ci->bel == BelId())
+                continue;
+            Loc loc = ctx->getBelLocation(ci->bel);
+            for (int y = std::max(0, loc.y - cfg.radius); y <= std::min(height - 1, loc.y + cfg.radius); y++)
+                for (int x = std::max(0, loc.x - cfg.radius); x <= std::min(width - 1, loc.x + cfg.radius); x++)
+                    near_changes.at(y * width + x) = true;
+        }
+    }
+
+    bool is_near(int x, int y) const
+    {
+        return !near_changes.empty() && x >= 0 && x < width && y >= 0 && y < height && near_changes.at(y * width + x);
+    }
+
+    bool is_near(const CellInfo *ci) const
+    {
+        Loc loc = ctx->getBelLocation(ci->bel);
+        return is_near(loc.x, loc.y);
+    }
+
+    // Lock kept cells that are far from any changed cell, so that the refinement leaves them alone. Returns the
+    // number of cells left movable.
+    int lock_distant()
+    {
+        int movable = 0;
+        for (auto &cell : ctx->cells) {
+            CellInfo *ci = cell.second.get();
+            if (ci->bel == BelId() || ci->belStrength > STRENGTH_STRONG)
+                continue;
+            bool move = false;
+            if (ci->cluster == ClusterId()) {
+                move = is_near(ci);
+            } else {
+                auto group = placement_group(ci);
+                move = std::any_of(group.begin(), group.end(),
+                                   [&](const CellInfo *member) { return member->bel != BelId() && is_near(member); });
+            }
+            if (move) {
+                movable++;
+            } else {
+                ci->belStrength = STRENGTH_LOCKED;
+                locked.push_back(ci);
+            }
+        }
+        return movable;
+    }
+
+    bool net_unchanged(const NetInfo *ni, const NetInfo *pn)
+    {
+        auto same_endpoint = [&](const PortRef &ref, const PortRef &prev_ref) {
+            if ((ref.cell == nullptr) != (prev_ref.cell == nullptr))
+                return false;
+            if (!ref.cell)
+                return true;
+            return prev_id(ref.cell->name) == prev_ref.cell->name &&
+                   prev_port(prev_ref.cell, ref.port) == prev_ref.port && ref.cell->bel == prev_ref.cell->bel;
+        };
+        if (!same_endpoint(ni->driver, pn->driver) || ni->users.entries() != pn->users.entries() ||
+            prev_id(ni->constant_value) != pn->constant_value)
+            return false;
+        dict<std::pair<IdString, IdString>, const PortRef *> prev_users;
+        for (auto &usr : pn->users)
+            prev_users[std::make_pair(usr.cell->name, usr.port)] = &usr;
+        for (auto &usr : ni->users) {
+            const CellInfo *pc = prev_cell(usr.cell);
+            if (!pc)
+                return false;
+            auto found = prev_users.find(std::make_pair(pc->name, prev_port(pc, usr.port)));
+            if (found == prev_users.end() || !same_endpoint(usr, *found->second))
+                return false;
+        }
+        return true;
+    }
+
+    // Returns the number of nets that kept their routing, and sets routed_nets to the number of nets that had routing
+    // in the previous result
+    int bind_kept_routing(int &routed_nets)
+    {
+        int kept_nets = 0;
+        routed_nets = 0;
+        std::vector<std::pair<WireId, PipMap>> wires;
+        for (auto &net : ctx->nets) {
+            NetInfo *ni = net.second.get();
+            auto found = prev->nets.find(prev_id(ni->name));
+            if (found == prev->nets.end() || found->second->wires.empty())
+                continue;
+            routed_nets++;
+            if (!ni->wires.empty())
+                continue;
+            const NetInfo *pn = found->second.get();
+            if (!net_unchanged(ni, pn))
+                continue;
+            wires.clear();
+            bool keep = true;
+            for (auto &wire : pn->wires) {
+                // Routing through the area around the changes is left to the router, which otherwise has to
+                // negotiate the new connections with a region that is already full
+                BoundingBox loc = ctx->getRouteBoundingBox(wire.first, wire.first);
+                keep &= ctx->checkWireAvail(wire.first) &&
+                        (wire.second.pip == PipId() || ctx->checkPipAvail(wire.second.pip)) &&
+                        !is_near((loc.x0 + loc.x1) / 2, (loc.y0 + loc.y1) / 2);
+                wires.push_back(wire);
+            }
+            if (!keep)
+                continue;
+            // Bound backwards, to keep the same order of wires as the previous result
+            for (auto it = wires.rbegin(); it != wires.rend(); ++it) {
+                if (it->second.pip != PipId())
+                    ctx->bindPip(it->second.pip, ni, it->second.strength);
+                else
+                    ctx->bindWire(it->first, ni, it->second.strength);
+            }
+            kept_nets++;
+        }
+        return kept_nets;
+    }
+
+    bool run()
+    {
+        auto startt = std::chrono::high_resolution_clock::now();
+        if (!prev)
+            log_error("The eco placer needs a previous result to start from (see --eco).\n");
+        if (prev->getChipName() != ctx->getChipName())
+            log_error("Previous result is for device '%s', not '%s'.\n", prev->getChipName().c_str(),
+                      ctx->getChipName().c_str());
+
+        for (auto &cell : ctx->cells)
+            if (cell.second->cluster != ClusterId())
+                clusters[cell.second->cluster].push_back(cell.second.get());
+        bind_constrained();
+        bind_kept();
+        int total = 0;
+        for (auto &cell : ctx->cells) {
+            CellInfo *ci = cell.second.get();
+            if (ci->isPseudo())
+                continue;
+            total++;
+            if (ci->bel == BelId())
+                changed.push_back(ci);
+        }
+        log_info("Kept placement of %d/%d cells from the previous result, %d new or changed.\n",
+                 total - int(changed.size()), total, int(changed.size()));
+
+        bool result = true;
+        if (2 * changed.size() > size_t(total)) {
+            log_info("Most of the design has changed, running a full placement instead.\n");
+            // The full placer binds constrained cells itself, and fails on any that are already bound
+            for (auto ci : constrained)
+                ctx->unbindBel(ci->bel);
+            for (auto &kept : kept_strength)
+                ctx->unbindBel(ctx->cells.at(kept.first)->bel);
+            NPNR_ASSERT(cfg.full_placement);
+            return cfg.full_placement();
+        }
+        if (!changed.empty()) {
+            place_changed();
+            mark_changed_region();
+            int movable = lock_distant();
+            log_info("Refining placement of %d cells around the changes.\n", movable);
+            result = placer1_refine(ctx, Placer1Cfg(ctx));
+            for (auto ci : locked)
+                ci->belStrength = STRENGTH_WEAK;
+        }
+        // Kept cells get back the strength they had before, e.g. so user constraints stay in effect
+        for (auto &kept : kept_strength) {
+            CellInfo *ci = ctx->cells.at(kept.first).get();
+            if (ci->bel != BelId())
+                ci->belStrength = kept.second;
+        }
+
+        int routed_nets = 0;
+        int kept_nets = bind_kept_routing(routed_nets);
+        log_info("Kept routing of %d/%d routed nets from the previous result.\n", kept_nets, routed_nets);
+
+        auto endt = std::chrono::high_resolution_clock::now();
+        log_info("ECO placement time %.02fs\n", std::chrono::duration<float>(endt - startt).count());
+        return result;
+    }
+};
+} // namespace
+
+bool eco_place(Context *ctx, EcoCfg cfg)
+{
+    ProfileScope profile(ctx->profiler, "eco");
+    log_break();
+    log_info("Running ECO placement...\n");
+    try {
+        return EcoPlacer(ctx, ctx->eco_previous.get(), cfg).run();
+    } catch (log_execution_error_exception) {
+        return false;
+    }
+}
+
+NEXTPNR_NAMESPACE_END
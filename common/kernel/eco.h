@@ -0,0 +1,59 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef ECO_H
+#define ECO_H
+
+#include <functional>
+
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+/*
+Incremental ("ECO") placement, reusing the result of a previous run.
+
+Cells of the newly packed netlist are matched by name against the previous, placed and routed, design. A cell keeps
+its old bel if its type and the names of the nets on each of its ports are unchanged. The remaining new or changed
+cells are placed greedily next to the logic they connect to, and then a simulated annealing refinement runs with only
+those cells, and kept cells within `radius` tiles of them, allowed to move.
+
+Afterwards, nets whose driver and users are all unchanged and on the same bels as before get their old routing back,
+so the router only has to deal with the arcs that are new or no longer legal.
+
+This is run by arches as the "eco" placer, with the previous result in Context::eco_previous. When most of the design
+has changed, it falls back to a normal placement.
+*/
+
+struct EcoCfg
+{
+    EcoCfg(Context *ctx);
+    // Kept cells within this many tiles of a new or changed cell (0: in the same tile) may be moved by the refinement
+    int radius;
+    // Nets with more users than this are ignored when looking for where to put a changed cell
+    int max_fanout;
+    // Placement of the whole design from scratch, used instead when too much has changed
+    std::function<bool()> full_placement;
+};
+
+bool eco_place(Context *ctx, EcoCfg cfg);
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* ECO_H */
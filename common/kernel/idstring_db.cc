@@ -0,0 +1,109 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "idstring_db.h"
+
+#include <stdexcept>
+
+NEXTPNR_NAMESPACE_BEGIN
+
+IdStringDb::IdStringDb()
+{
+    for (auto &seg : segments)
+        seg.store(nullptr, std::memory_order_relaxed);
+}
+
+IdStringDb::~IdStringDb()
+{
+    for (auto &seg : segments)
+        delete[] seg.load(std::memory_order_relaxed);
+}
+
+IdStringDb::Shard &IdStringDb::shard_for(std::string_view s) const
+{
+    // Use the top bits of a mixed hash, as the low bits are what the shard's own map uses to pick a bucket
+    uint64_t h = uint64_t(std::hash<std::string_view>()(s)) * 0x9E3779B97F4A7C15ULL;
+    return shards[h >> (64 - shard_bits)];
+}
+
+std::atomic<const std::string *> &IdStringDb::slot(int idx, bool alloc) const
+{
+    // Map the index onto a segment, such that segment i starts at 2^(first_segment_bits + i) - 2^first_segment_bits
+    uint32_t v = uint32_t(idx) + (1U << first_segment_bits);
+#if defined(__GNUC__) || defined(__clang__)
+    int bit = 31 - __builtin_clz(v);
+#else
+    int bit = 31;
+    while (!(v & (1U << bit)))
+        bit--;
+#endif
+    auto &seg = segments.at(bit - first_segment_bits);
+    auto entries = seg.load(std::memory_order_acquire);
+    if (entries == nullptr) {
+        if (!alloc)
+            throw std::out_of_range("IdString index out of range");
+        auto fresh = new std::atomic<const std::string *>[size_t(1) << bit];
+        for (size_t i = 0; i < (size_t(1) << bit); i++)
+            fresh[i].store(nullptr, std::memory_order_relaxed);
+        // Another thread in a different shard might be allocating the same segment
+        if (seg.compare_exchange_strong(entries, fresh, std::memory_order_acq_rel))
+            entries = fresh;
+        else
+            delete[] fresh;
+    }
+    return entries[v - (1U << bit)];
+}
+
+int IdStringDb::lookup(std::string_view s) const
+{
+    auto &shard = shard_for(s);
+#ifndef NPNR_DISABLE_THREADS
+    std::lock_guard<std::mutex> lock(shard.mutex);
+#endif
+    auto found = shard.map.find(s);
+    return (found == shard.map.end()) ? -1 : found->second;
+}
+
+int IdStringDb::intern(std::string_view s)
+{
+    auto &shard = shard_for(s);
+#ifndef NPNR_DISABLE_THREADS
+    std::lock_guard<std::mutex> lock(shard.mutex);
+#endif
+    auto found = shard.map.find(s);
+    if (found != shard.map.end())
+        return found->second;
+    const std::string &stored = shard.arena.emplace_back(s);
+    int idx = next_index.fetch_add(1, std::memory_order_acq_rel);
+    slot(idx, true).store(&stored, std::memory_order_release);
+    shard.map.emplace(std::string_view(stored), idx);
+    return idx;
+}
+
+const std::string &IdStringDb::str(int idx) const
+{
+    if (idx < 0 || idx >= size())
+        throw std::out_of_range("IdString index out of range");
+    const std::string *s = slot(idx, false).load(std::memory_order_acquire);
+    if (s == nullptr)
+        throw std::out_of_range("IdString index out of range");
+    return *s;
+}
+
+NEXTPNR_NAMESPACE_END
@@ -0,0 +1,91 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef IDSTRING_DB_H
+#define IDSTRING_DB_H
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#ifndef NPNR_DISABLE_THREADS
+#include <mutex>
+#endif
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// The string table behind IdString, mapping names to dense indices and back.
+//
+// Names may be interned from several threads at once. The string to index map is split into shards by hash, each
+// with its own lock, so threads only contend when they hit the same shard; names themselves are stored in an
+// append-only arena per shard and never move. The index to string table is a list of segments of doubling size, which
+// are never reallocated, so looking up the string of an index takes no lock at all.
+//
+// Indices are handed out in order of first interning. When names are only interned from one thread, as is the case
+// for everything outside of explicitly parallel passes, this is deterministic; names interned concurrently may get
+// their indices in any order.
+class IdStringDb
+{
+  public:
+    IdStringDb();
+    ~IdStringDb();
+
+    IdStringDb(const IdStringDb &other) = delete;
+    IdStringDb &operator=(const IdStringDb &other) = delete;
+
+    // Index of a name, adding it if it isn't already present
+    int intern(std::string_view s);
+    // Index of a name, or -1 if it hasn't been interned
+    int lookup(std::string_view s) const;
+    // The name of an index; throws std::out_of_range for indices that don't exist
+    const std::string &str(int idx) const;
+    // Number of names interned
+    int size() const { return next_index.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr int shard_bits = 6;
+    static constexpr int first_segment_bits = 10;
+    static constexpr int max_segments = 31 - first_segment_bits;
+
+    struct Shard
+    {
+#ifndef NPNR_DISABLE_THREADS
+        mutable std::mutex mutex;
+#endif
+        std::unordered_map<std::string_view, int> map;
+        // Backing store for the keys of map; a deque doesn't move its elements when it grows
+        std::deque<std::string> arena;
+    };
+    mutable std::array<Shard, 1 << shard_bits> shards;
+
+    // Segment i holds 2^(first_segment_bits + i) entries
+    mutable std::array<std::atomic<std::atomic<const std::string *> *>, max_segments> segments;
+    std::atomic<int> next_index{0};
+
+    Shard &shard_for(std::string_view s) const;
+    std::atomic<const std::string *> &slot(int idx, bool alloc) const;
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* IDSTRING_DB_H */
@@ -39,7 +39,8 @@ std::string log_last_error;
 void (*log_error_atexit)() = NULL;
 
 dict<LogLevel, int, loglevel_hash_ops> message_count_by_level;
-static int log_newline_count = 0;
+static thread_local int log_newline_count = 0;
+static thread_local LogCapture *log_capture = nullptr;
 bool had_nonfatal_error = false;
 bool log_warn_as_error = false;
 
@@ -85,6 +86,30 @@ std::string vstringf(const char *fmt, va_list ap)
     return string;
 }
 
+static void log_write(const std::string &str, LogLevel level)
+{
+    size_t nnl_pos = str.find_last_not_of('\n');
+    if (nnl_pos == std::string::npos)
+        log_newline_count += str.size();
+    else
+        log_newline_count = str.size() - nnl_pos - 1;
+
+    if (log_capture) {
+        auto &messages = log_capture->messages;
+        if (!messages.empty() && messages.back().first == level)
+            messages.back().second += str;
+        else
+            messages.emplace_back(level, str);
+        return;
+    }
+
+    for (auto f : log_streams)
+        if (f.second <= level)
+            *f.first << str;
+    if (log_write_function)
+        log_write_function(str);
+}
+
 void logv(const char *format, va_list ap, LogLevel level = LogLevel::LOG_MSG)
 {
     //
@@ -99,22 +124,15 @@ void logv(const char *format, va_list ap, LogLevel level = LogLevel::LOG_MSG)
     if (str.empty())
         return;
 
-    size_t nnl_pos = str.find_last_not_of('\n');
-    if (nnl_pos == std::string::npos)
-        log_newline_count += str.size();
-    else
-        log_newline_count = str.size() - nnl_pos - 1;
-
-    for (auto f : log_streams)
-        if (f.second <= level)
-            *f.first << str;
-    if (log_write_function)
-        log_write_function(str);
+    log_write(str, level);
 }
 
 void log_with_level(LogLevel level, const char *format, ...)
 {
-    message_count_by_level[level]++;
+    if (log_capture)
+        log_capture->counts[level]++;
+    else
+        message_count_by_level[level]++;
     va_list ap;
     va_start(ap, format);
     logv(format, ap, level);
@@ -132,7 +150,10 @@ void logv_prefixed(const char *prefix, const char *format, va_list ap, LogLevel
 void logv_nonfatal_error(const char *format, va_list ap)
 {
     logv_prefixed("ERROR: ", format, ap, LogLevel::ERROR_MSG);
-    had_nonfatal_error = true;
+    if (log_capture)
+        log_capture->nonfatal_error = true;
+    else
+        had_nonfatal_error = true;
 }
 
 void logv_error(const char *format, va_list ap)
@@ -205,8 +226,31 @@ void log_nonfatal_error(const char *format, ...)
 
 void log_flush()
 {
+    if (log_capture)
+        return;
     for (auto f : log_streams)
         f.first->flush();
 }
 
+void LogCapture::replay() const
+{
+    for (auto &message : messages)
+        log_write(message.second, message.first);
+    // Replaying into another capture counts the messages there instead
+    auto &total_counts = log_capture ? log_capture->counts : message_count_by_level;
+    for (auto &count : counts)
+        total_counts[count.first] += count.second;
+    if (nonfatal_error) {
+        if (log_capture)
+            log_capture->nonfatal_error = true;
+        else
+            had_nonfatal_error = true;
+    }
+    log_flush();
+}
+
+ScopedLogCapture::ScopedLogCapture(LogCapture &capture) : prev_capture(log_capture) { log_capture = &capture; }
+
+ScopedLogCapture::~ScopedLogCapture() { log_capture = prev_capture; }
+
 NEXTPNR_NAMESPACE_END
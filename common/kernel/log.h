@@ -78,6 +78,34 @@ void log_nonfatal_error(const char *format, ...) NPNR_ATTRIBUTE(format(printf, 1
 void log_break();
 void log_flush();
 
+// Log output held back by ScopedLogCapture, along with the message counts and non-fatal error flag that it would
+// otherwise have updated
+struct LogCapture
+{
+    std::vector<std::pair<LogLevel, std::string>> messages;
+    // Counterparts of message_count_by_level and had_nonfatal_error
+    dict<LogLevel, int, loglevel_hash_ops> counts;
+    bool nonfatal_error = false;
+
+    // Write the captured messages to the log streams at their original levels, and add the counts and error flag to
+    // the global ones, as if the messages had been logged now
+    void replay() const;
+};
+
+// While in scope, log output from the calling thread goes to `capture` rather than the log streams, so that work
+// running in parallel can log without interleaving its output.
+struct ScopedLogCapture
+{
+    explicit ScopedLogCapture(LogCapture &capture);
+    ~ScopedLogCapture();
+
+    ScopedLogCapture(const ScopedLogCapture &other) = delete;
+    ScopedLogCapture &operator=(const ScopedLogCapture &other) = delete;
+
+  private:
+    LogCapture *prev_capture;
+};
+
 static inline void log_assert_worker(bool cond, const char *expr, const char *file, int line)
 {
     if (!cond)
@@ -486,14 +486,14 @@ struct TimingResult
     // Domains with no interior paths
     pool<IdString> empty_paths;
 
-    // Detailed net timing data
-    dict<IdString, std::vector<NetSinkTiming>> detailed_net_timings;
-
     // Histogram of slack
     dict<int, unsigned> slack_histogram;
 
     // Min delay violations, only hold time for now
     std::vector<CriticalPath> min_delay_violations;
+
+    // The worst setup paths of every domain pair (timing/reportPaths), grouped by domain pair and in order of slack
+    std::vector<CriticalPath> worst_paths;
 };
 
 // Represents the contents of a non-leaf cell in a design
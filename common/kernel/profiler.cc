@@ -0,0 +1,204 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+#include "json11.hpp"
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <cstring>
+#endif
+
+NEXTPNR_NAMESPACE_BEGIN
+
+Profiler::Sample Profiler::Sample::now()
+{
+    Sample s;
+    s.wall = std::chrono::steady_clock::now();
+    s.cpu = double(std::clock()) / CLOCKS_PER_SEC;
+    s.rss = current_rss();
+    return s;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()) { root_node.name = "total"; }
+
+int64_t Profiler::current_rss()
+{
+#if defined(__linux__)
+    // The second field of statm is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * int64_t(sysconf(_SC_PAGESIZE));
+#else
+    // Without a cheap way to get the current value, the peak is the best approximation available
+    return peak_rss();
+#endif
+}
+
+int64_t Profiler::peak_rss()
+{
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return int64_t(usage.ru_maxrss);
+#else
+    return int64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+Profiler::Node *Profiler::enter(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = open_scope.find(std::this_thread::get_id());
+    Node *parent = (found != open_scope.end()) ? found->second : &root_node;
+    Node *node = nullptr;
+    for (auto &child : parent->children) {
+        if (child->name == name) {
+            node = child.get();
+            break;
+        }
+    }
+    if (node == nullptr) {
+        parent->children.push_back(std::make_unique<Node>());
+        node = parent->children.back().get();
+        node->name = name;
+        node->parent = parent;
+    }
+    open_scope[std::this_thread::get_id()] = node;
+    return node;
+}
+
+void Profiler::leave(Node *node, const Sample &start)
+{
+    Sample end = Sample::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    node->calls++;
+    node->wall_time += std::chrono::duration<double>(end.wall - start.wall).count();
+    node->cpu_time += end.cpu - start.cpu;
+    node->rss_delta += end.rss - start.rss;
+    node->max_rss = std::max(node->max_rss, end.rss);
+    if (node->parent == &root_node)
+        open_scope.erase(std::this_thread::get_id());
+    else
+        open_scope[std::this_thread::get_id()] = node->parent;
+    if (trace) {
+        auto tid = thread_index.emplace(std::this_thread::get_id(), int(thread_index.size())).first->second;
+        auto to_us = [&](std::chrono::steady_clock::time_point t) {
+            return int64_t(std::chrono::duration_cast<std::chrono::microseconds>(t - epoch).count());
+        };
+        events.push_back(Event{node, tid, to_us(start.wall), to_us(end.wall) - to_us(start.wall), end.rss});
+    }
+}
+
+void Profiler::adopt(Profiler &other)
+{
+    std::lock(mutex, other.mutex);
+    std::lock_guard<std::mutex> lock(mutex, std::adopt_lock), other_lock(other.mutex, std::adopt_lock);
+    for (auto &child : other.root_node.children)
+        child->parent = &root_node;
+    std::move(root_node.children.begin(), root_node.children.end(), std::back_inserter(other.root_node.children));
+    root_node.children = std::move(other.root_node.children);
+    other.root_node.children.clear();
+    // Trace times are relative to the creation of each profiler, and the other one was created first
+    int64_t shift = std::chrono::duration_cast<std::chrono::microseconds>(epoch - other.epoch).count();
+    for (auto &ev : events)
+        ev.start_us += shift;
+    std::unordered_map<int, int> tid_map;
+    for (auto &thread : other.thread_index)
+        tid_map[thread.second] = thread_index.emplace(thread.first, int(thread_index.size())).first->second;
+    for (auto &ev : other.events)
+        ev.tid = tid_map.at(ev.tid);
+    events.insert(events.begin(), other.events.begin(), other.events.end());
+    other.events.clear();
+    epoch = other.epoch;
+}
+
+void Profiler::write_chrome_trace(std::ostream &out) const
+{
+    using namespace json11;
+    Json::array trace_events;
+    for (const auto &ev : events) {
+        trace_events.push_back(Json::object{
+                {"name", ev.node->name},
+                {"ph", "X"},
+                {"pid", 0},
+                {"tid", ev.tid},
+                {"ts", double(ev.start_us)},
+                {"dur", double(ev.duration_us)},
+                {"args", Json::object{{"rss_mib", double(ev.rss) / (1024 * 1024)}}},
+        });
+    }
+    out << Json(Json::object{{"traceEvents", trace_events}, {"displayTimeUnit", "ms"}}).dump() << std::endl;
+}
+
+CacheMissCounter::CacheMissCounter()
+{
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    // Only user space, which is all perf_event_paranoid=2 allows
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // This thread, on any CPU
+    fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+#if defined(__linux__)
+    if (fd != -1)
+        close(fd);
+#endif
+}
+
+int64_t CacheMissCounter::read() const
+{
+#if defined(__linux__)
+    uint64_t count = 0;
+    if (fd != -1 && ::read(fd, &count, sizeof(count)) == sizeof(count))
+        return int64_t(count);
+#endif
+    return 0;
+}
+
+NEXTPNR_NAMESPACE_END
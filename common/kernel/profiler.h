@@ -0,0 +1,141 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+/*
+Hierarchical profile of the passes of a run.
+
+A ProfileScope measures the wall time and process CPU time spent while it is alive, and the change in resident set
+size. Scopes opened while another one is open on the same thread nest under it, and scopes with the same name under
+the same parent are merged into one node that counts calls; so a scope inside a loop body sums over all iterations.
+
+The tree is part of the JSON report (Context::writeJsonReport). With `trace` set, each scope is also kept as a
+separate event to be written as a Chrome trace (viewable in chrome://tracing or Perfetto).
+*/
+struct Profiler
+{
+    struct Node
+    {
+        std::string name;
+        Node *parent = nullptr;
+        int calls = 0;
+        double wall_time = 0, cpu_time = 0;
+        // Total change in resident set size over all calls, and the largest resident set size when one ended, in
+        // bytes
+        int64_t rss_delta = 0, max_rss = 0;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    struct Sample
+    {
+        std::chrono::steady_clock::time_point wall;
+        double cpu;
+        int64_t rss;
+        static Sample now();
+    };
+
+    Profiler();
+
+    // Keep every scope as a trace event, for write_chrome_trace
+    bool trace = false;
+
+    Node *enter(const std::string &name);
+    void leave(Node *node, const Sample &start);
+
+    // Take over the scopes of the profiler of the context this one's was forked from, placing them first
+    void adopt(Profiler &other);
+
+    // Only to be used once no scopes are open in other threads
+    const Node &root() const { return root_node; }
+    void write_chrome_trace(std::ostream &out) const;
+
+    // Current and peak resident set size of the process, in bytes; or 0 if unknown
+    static int64_t current_rss();
+    static int64_t peak_rss();
+
+  private:
+    struct Event
+    {
+        const Node *node;
+        int tid;
+        int64_t start_us, duration_us, rss;
+    };
+
+    std::mutex mutex;
+    Node root_node;
+    std::chrono::steady_clock::time_point epoch;
+    // Innermost open scope of each thread, and a small number for each thread in the trace
+    std::unordered_map<std::thread::id, Node *> open_scope;
+    std::unordered_map<std::thread::id, int> thread_index;
+    std::vector<Event> events;
+};
+
+struct ProfileScope
+{
+    ProfileScope(Profiler &profiler, const std::string &name)
+            : profiler(profiler), node(profiler.enter(name)), start(Profiler::Sample::now())
+    {
+    }
+    ProfileScope(const ProfileScope &other) = delete;
+    ProfileScope &operator=(const ProfileScope &other) = delete;
+    ~ProfileScope() { profiler.leave(node, start); }
+
+  private:
+    Profiler &profiler;
+    Profiler::Node *node;
+    Profiler::Sample start;
+};
+
+// Counts the last level cache misses of the calling thread while it is alive, using the hardware performance counters.
+// Where they can't be read (other than on Linux, without a PMU, or when perf_event_paranoid doesn't allow it),
+// available() is false and nothing is counted.
+struct CacheMissCounter
+{
+    CacheMissCounter();
+    CacheMissCounter(const CacheMissCounter &other) = delete;
+    CacheMissCounter &operator=(const CacheMissCounter &other) = delete;
+    ~CacheMissCounter();
+
+    bool available() const { return fd != -1; }
+    // Misses counted so far
+    int64_t read() const;
+
+  private:
+    int fd = -1;
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* PROFILER_H */
@@ -50,10 +50,9 @@ bool operator==(const PortRef &a, const PortRef &b) { return (a.cell == b.cell)
 // Load a JSON file into a design
 void parse_json_shim(std::string filename, Context &d)
 {
-    std::ifstream inf(filename);
-    if (!inf)
+    if (!std::ifstream(filename))
         throw std::runtime_error("failed to open file " + filename);
-    parse_json(inf, filename, &d);
+    parse_json_file(filename, &d);
 }
 
 // Create a new Chip and load design from json file
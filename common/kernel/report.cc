@@ -19,6 +19,7 @@
 
 #include "json11.hpp"
 #include "nextpnr.h"
+#include "timing.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -70,47 +71,47 @@ static std::vector<std::string> net_sources(const NetInfo *net, const Context *c
     return source_entries;
 }
 
-static Json::array json_report_critical_paths(const Context *ctx)
+static Json::array json_report_path(const Context *ctx, const CriticalPath &report)
 {
+    Json::array pathJson;
 
-    auto report_critical_path = [ctx](const CriticalPath &report) {
-        Json::array pathJson;
-
-        for (const auto &segment : report.segments) {
+    for (const auto &segment : report.segments) {
 
-            const auto &driver = ctx->cells.at(segment.from.first);
-            const auto &sink = ctx->cells.at(segment.to.first);
+        const auto &driver = ctx->cells.at(segment.from.first);
+        const auto &sink = ctx->cells.at(segment.to.first);
 
-            auto fromLoc = ctx->getBelLocation(driver->bel);
-            auto toLoc = ctx->getBelLocation(sink->bel);
+        auto fromLoc = ctx->getBelLocation(driver->bel);
+        auto toLoc = ctx->getBelLocation(sink->bel);
 
-            auto fromJson = Json::object({{"cell", segment.from.first.c_str(ctx)},
-                                          {"port", segment.from.second.c_str(ctx)},
-                                          {"loc", Json::array({fromLoc.x, fromLoc.y})}});
+        auto fromJson = Json::object({{"cell", segment.from.first.c_str(ctx)},
+                                      {"port", segment.from.second.c_str(ctx)},
+                                      {"loc", Json::array({fromLoc.x, fromLoc.y})}});
 
-            auto toJson = Json::object({{"cell", segment.to.first.c_str(ctx)},
-                                        {"port", segment.to.second.c_str(ctx)},
-                                        {"loc", Json::array({toLoc.x, toLoc.y})}});
+        auto toJson = Json::object({{"cell", segment.to.first.c_str(ctx)},
+                                    {"port", segment.to.second.c_str(ctx)},
+                                    {"loc", Json::array({toLoc.x, toLoc.y})}});
 
-            auto segmentJson = Json::object({
-                    {"delay", ctx->getDelayNS(segment.delay)},
-                    {"from", fromJson},
-                    {"to", toJson},
-            });
+        auto segmentJson = Json::object({
+                {"delay", ctx->getDelayNS(segment.delay)},
+                {"from", fromJson},
+                {"to", toJson},
+        });
 
-            segmentJson["type"] = CriticalPath::Segment::type_to_str(segment.type);
-            if (segment.type == CriticalPath::Segment::Type::ROUTING) {
-                segmentJson["net"] = segment.net.c_str(ctx);
-                const NetInfo *net = ctx->nets.at(segment.net).get();
-                segmentJson["sources"] = net_sources(net, ctx);
-            }
-
-            pathJson.push_back(segmentJson);
+        segmentJson["type"] = CriticalPath::Segment::type_to_str(segment.type);
+        if (segment.type == CriticalPath::Segment::Type::ROUTING) {
+            segmentJson["net"] = segment.net.c_str(ctx);
+            const NetInfo *net = ctx->nets.at(segment.net).get();
+            segmentJson["sources"] = net_sources(net, ctx);
         }
 
-        return pathJson;
-    };
+        pathJson.push_back(segmentJson);
+    }
+
+    return pathJson;
+}
 
+static Json::array json_report_critical_paths(const Context *ctx)
+{
     auto critPathsJson = Json::array();
 
     // Critical paths
@@ -118,52 +119,101 @@ static Json::array json_report_critical_paths(const Context *ctx)
 
         critPathsJson.push_back(Json::object({{"from", clock_event_name(ctx, report.second.clock_pair.start)},
                                               {"to", clock_event_name(ctx, report.second.clock_pair.end)},
-                                              {"path", report_critical_path(report.second)}}));
+                                              {"path", json_report_path(ctx, report.second)}}));
     }
 
     // Cross-domain paths
     for (auto &report : ctx->timing_result.xclock_paths) {
         critPathsJson.push_back(Json::object({{"from", clock_event_name(ctx, report.clock_pair.start)},
                                               {"to", clock_event_name(ctx, report.clock_pair.end)},
-                                              {"path", report_critical_path(report)}}));
+                                              {"path", json_report_path(ctx, report)}}));
     }
 
     return critPathsJson;
 }
 
-static Json::array json_report_detailed_net_timings(const Context *ctx)
+static Json::array json_report_worst_paths(const Context *ctx)
 {
-    auto detailedNetTimingsJson = Json::array();
-
-    // Detailed per-net timing analysis
-    for (const auto &it : ctx->timing_result.detailed_net_timings) {
+    auto worstPathsJson = Json::array();
+    for (auto &report : ctx->timing_result.worst_paths) {
+        delay_t total = 0;
+        for (const auto &segment : report.segments)
+            total += segment.delay;
+        worstPathsJson.push_back(Json::object({{"from", clock_event_name(ctx, report.clock_pair.start)},
+                                               {"to", clock_event_name(ctx, report.clock_pair.end)},
+                                               {"slack", ctx->getDelayNS(report.max_delay - total)},
+                                               {"path", json_report_path(ctx, report)}}));
+    }
+    return worstPathsJson;
+}
 
-        const NetInfo *net = ctx->nets.at(it.first).get();
-        ClockEvent start = it.second[0].clock_pair.start;
+static Json json_report_net_timing(const Context *ctx, const NetInfo *net, const std::vector<NetSinkTiming> &sinks)
+{
+    ClockEvent start = sinks[0].clock_pair.start;
+
+    Json::array endpointsJson;
+    for (const auto &sink_timing : sinks) {
+        auto minDelay = ctx->getDelayNS(sink_timing.delay.minDelay());
+        auto maxDelay = ctx->getDelayNS(sink_timing.delay.maxDelay());
+
+        auto endpointJson = Json::object({{"cell", sink_timing.cell_port.first.c_str(ctx)},
+                                          {"port", sink_timing.cell_port.second.c_str(ctx)},
+                                          {"event", clock_event_name(ctx, sink_timing.clock_pair.end)},
+                                          {"delay", Json::array({minDelay, maxDelay})}});
+        endpointsJson.push_back(endpointJson);
+    }
 
-        Json::array endpointsJson;
-        for (const auto &sink_timing : it.second) {
-            auto minDelay = ctx->getDelayNS(sink_timing.delay.minDelay());
-            auto maxDelay = ctx->getDelayNS(sink_timing.delay.maxDelay());
+    return Json::object({{"net", net->name.c_str(ctx)},
+                         {"sources", net_sources(net, ctx)},
+                         {"driver", net->driver.cell->name.c_str(ctx)},
+                         {"port", net->driver.port.c_str(ctx)},
+                         {"event", clock_event_name(ctx, start)},
+                         {"endpoints", endpointsJson}});
+}
 
-            auto endpointJson = Json::object({{"cell", sink_timing.cell_port.first.c_str(ctx)},
-                                              {"port", sink_timing.cell_port.second.c_str(ctx)},
-                                              {"event", clock_event_name(ctx, sink_timing.clock_pair.end)},
-                                              {"delay", Json::array({minDelay, maxDelay})}});
-            endpointsJson.push_back(endpointJson);
+// The detailed per-net timing array can be very large, so rather than being built up in memory it is streamed from
+// a timing analysis a batch of nets at a time, with the nets of a batch converted to JSON in parallel
+static void write_detailed_net_timings(Context *ctx, std::ostream &out)
+{
+    TimingAnalyser tmg(ctx);
+    tmg.setup_only = false;
+    tmg.with_clock_skew = true;
+    tmg.setup();
+
+    std::vector<std::string> net_json;
+    bool first = true;
+    out << "[";
+    auto write_batch = [&](const std::vector<std::pair<IdString, std::vector<NetSinkTiming>>> &batch) {
+        net_json.assign(batch.size(), std::string());
+        ctx->threadPool().parallel_for(
+                int(batch.size()),
+                [&](int i) {
+                    const auto &net = batch.at(i);
+                    json_report_net_timing(ctx, ctx->nets.at(net.first).get(), net.second).dump(net_json.at(i));
+                },
+                64);
+        for (auto &json : net_json) {
+            out << (first ? "" : ", ") << json;
+            first = false;
         }
+    };
+    tmg.stream_detailed_net_timings(4096, write_batch);
+    out << "]";
+}
 
-        auto netTimingJson = Json::object({{"net", net->name.c_str(ctx)},
-                                           {"sources", net_sources(net, ctx)},
-                                           {"driver", net->driver.cell->name.c_str(ctx)},
-                                           {"port", net->driver.port.c_str(ctx)},
-                                           {"event", clock_event_name(ctx, start)},
-                                           {"endpoints", endpointsJson}});
-
-        detailedNetTimingsJson.push_back(netTimingJson);
+static Json::array json_report_profile(const Profiler::Node &node)
+{
+    auto passesJson = Json::array();
+    for (const auto &child : node.children) {
+        passesJson.push_back(Json::object({{"name", child->name},
+                                           {"calls", child->calls},
+                                           {"wall_time", child->wall_time},
+                                           {"cpu_time", child->cpu_time},
+                                           {"rss_delta", double(child->rss_delta)},
+                                           {"max_rss", double(child->max_rss)},
+                                           {"children", json_report_profile(*child)}}));
     }
-
-    return detailedNetTimingsJson;
+    return passesJson;
 }
 
 /*
@@ -216,6 +266,15 @@ Report JSON structure:
     },
     ...
   ],
+  "worst_paths": [
+    {
+      "from": <clock event edge and name>,
+      "to": <clock event edge and name>,
+      "slack": <setup slack of the path [ns]>,
+      "path": [<path segments, as for critical_paths>]
+    }
+    ...
+  ],
   "detailed_net_timings": [
     {
       "driver": <driving cell name>,
@@ -237,11 +296,26 @@ Report JSON structure:
       ]
     }
     ...
-  ]
+  ],
+  "profile": {
+    "peak_rss": <peak resident set size of the process [bytes]>,
+    "passes": [
+      {
+        "name": <pass or stage name>,
+        "calls": <number of times it ran>,
+        "wall_time": <total wall time [s]>,
+        "cpu_time": <total CPU time of the process, all threads [s]>,
+        "rss_delta": <total change in resident set size [bytes]>,
+        "max_rss": <largest resident set size at the end of a call [bytes]>,
+        "children": [<stages within the pass, with the same structure>]
+      }
+      ...
+    ]
+  }
 }
 */
 
-void Context::writeJsonReport(std::ostream &out) const
+void Context::writeJsonReport(std::ostream &out)
 {
     auto util = get_utilization(this);
     dict<std::string, Json> util_json;
@@ -262,11 +336,29 @@ void Context::writeJsonReport(std::ostream &out) const
     Json::object jsonRoot{
             {"utilization", util_json}, {"fmax", fmax_json}, {"critical_paths", json_report_critical_paths(this)}};
 
+    if (!timing_result.worst_paths.empty())
+        jsonRoot["worst_paths"] = json_report_worst_paths(this);
+
     if (detailed_timing_report) {
-        jsonRoot["detailed_net_timings"] = json_report_detailed_net_timings(this);
+        // Placeholder, so that the streamed array is written in its place in the key order
+        jsonRoot["detailed_net_timings"] = Json();
     }
 
-    out << Json(jsonRoot).dump() << std::endl;
+    jsonRoot["profile"] =
+            Json::object{{"peak_rss", double(Profiler::peak_rss())}, {"passes", json_report_profile(profiler.root())}};
+
+    // Written out like Json::dump of the whole object would
+    out << "{";
+    for (auto it = jsonRoot.begin(); it != jsonRoot.end(); ++it) {
+        if (it != jsonRoot.begin())
+            out << ", ";
+        out << Json(it->first).dump() << ": ";
+        if (it->first == "detailed_net_timings")
+            write_detailed_net_timings(this, out);
+        else
+            out << it->second.dump();
+    }
+    out << "}" << std::endl;
 }
 
 NEXTPNR_NAMESPACE_END
@@ -0,0 +1,189 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "thread_pool.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+// Index of the queue owned by the current thread, if it is a pool worker
+thread_local int worker_queue_idx = -1;
+thread_local const ThreadPool *worker_pool = nullptr;
+} // namespace
+
+ThreadPool::ThreadPool(int thread_count)
+{
+#ifndef NPNR_DISABLE_THREADS
+    worker_count = std::max(0, thread_count - 1);
+#endif
+    for (int i = 0; i < worker_count + 1; i++)
+        queues.emplace_back(std::make_unique<WorkQueue>());
+#ifndef NPNR_DISABLE_THREADS
+    for (int i = 0; i < worker_count; i++)
+        threads.emplace_back([this, i]() { this->worker(i); });
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+#ifndef NPNR_DISABLE_THREADS
+    {
+        std::lock_guard<std::mutex> lk(wake_mutex);
+        shutdown = true;
+    }
+    wake_cv.notify_all();
+    for (auto &t : threads)
+        t.join();
+#endif
+}
+
+void ThreadPool::submit(Task task)
+{
+    int queue_idx = (worker_pool == this) ? worker_queue_idx : int(queues.size()) - 1;
+    auto &q = *queues.at(queue_idx);
+#ifndef NPNR_DISABLE_THREADS
+    {
+        std::lock_guard<std::mutex> lk(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        // Taking the lock here avoids a lost wakeup between a thread checking `queued` and going to sleep
+        std::lock_guard<std::mutex> lk(wake_mutex);
+        queued.fetch_add(1);
+    }
+    wake_cv.notify_one();
+    done_cv.notify_all();
+#else
+    q.tasks.push_back(std::move(task));
+    queued.fetch_add(1);
+#endif
+}
+
+bool ThreadPool::try_pop(int queue_idx, Task &task)
+{
+    // Owners take the most recently pushed task, which is most likely to still be in cache
+    auto &q = *queues.at(queue_idx);
+#ifndef NPNR_DISABLE_THREADS
+    std::lock_guard<std::mutex> lk(q.mutex);
+#endif
+    if (q.tasks.empty())
+        return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    queued.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::try_steal(int thief_idx, Task &task)
+{
+    int N = int(queues.size());
+    for (int offset = 1; offset <= N; offset++) {
+        auto &q = *queues.at((thief_idx + offset) % N);
+#ifndef NPNR_DISABLE_THREADS
+        std::lock_guard<std::mutex> lk(q.mutex);
+#endif
+        if (q.tasks.empty())
+            continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::run_pending()
+{
+    Task task;
+    int own_idx = (worker_pool == this) ? worker_queue_idx : int(queues.size()) - 1;
+    if (!try_pop(own_idx, task) && !try_steal(own_idx, task))
+        return false;
+    execute(task);
+    return true;
+}
+
+void ThreadPool::execute(Task &task)
+{
+    TaskGroup *group = task.group;
+    try {
+        task.func();
+    } catch (...) {
+#ifndef NPNR_DISABLE_THREADS
+        std::lock_guard<std::mutex> lk(group->error_mutex);
+#endif
+        if (!group->error)
+            group->error = std::current_exception();
+    }
+#ifndef NPNR_DISABLE_THREADS
+    {
+        std::lock_guard<std::mutex> lk(wake_mutex);
+        group->outstanding.fetch_sub(1);
+    }
+    done_cv.notify_all();
+#else
+    group->outstanding.fetch_sub(1);
+#endif
+}
+
+void ThreadPool::worker(int idx)
+{
+#ifndef NPNR_DISABLE_THREADS
+    worker_queue_idx = idx;
+    worker_pool = this;
+    while (true) {
+        if (run_pending())
+            continue;
+        std::unique_lock<std::mutex> lk(wake_mutex);
+        wake_cv.wait(lk, [this] { return shutdown || queued.load() > 0; });
+        if (shutdown)
+            break;
+    }
+#endif
+}
+
+TaskGroup::~TaskGroup()
+{
+    // Never leave tasks running that refer to a destroyed group
+    wait_tasks();
+}
+
+void TaskGroup::wait_tasks()
+{
+    while (outstanding.load() > 0) {
+        if (pool.run_pending())
+            continue;
+#ifndef NPNR_DISABLE_THREADS
+        // Nothing left to steal; sleep until one of our tasks finishes elsewhere or more work arrives
+        std::unique_lock<std::mutex> lk(pool.wake_mutex);
+        pool.done_cv.wait(lk, [this] { return outstanding.load() == 0 || pool.queued.load() > 0; });
+#endif
+    }
+}
+
+void TaskGroup::wait()
+{
+    wait_tasks();
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+NEXTPNR_NAMESPACE_END
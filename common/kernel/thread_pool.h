@@ -0,0 +1,165 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+#ifndef NPNR_DISABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+class TaskGroup;
+
+// A work-stealing thread pool shared between all passes that want to run work in parallel (see
+// Context::threadPool). Each worker has its own task deque; tasks spawned by a worker go to the back of its own
+// deque and idle workers steal from the front of the others. Threads waiting on a TaskGroup run pending tasks
+// rather than blocking, so task groups may be nested.
+//
+// With NPNR_DISABLE_THREADS, or a pool size of one, tasks are run inline by the submitting thread.
+class ThreadPool
+{
+  public:
+    // thread_count includes the calling thread, which helps out while waiting
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    // Number of threads that may execute tasks concurrently
+    int size() const { return worker_count + 1; }
+
+    // Run func(i) for each i in [0, N), split into contiguous chunks of at least `grain` items; blocks until done
+    template <typename Func> void parallel_for(int N, Func func, int grain = 1);
+
+  private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        std::function<void()> func;
+        TaskGroup *group;
+    };
+
+    struct WorkQueue
+    {
+#ifndef NPNR_DISABLE_THREADS
+        std::mutex mutex;
+#endif
+        std::deque<Task> tasks;
+    };
+
+    // One queue per worker, plus a final one for tasks submitted from outside the pool
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    int worker_count = 0;
+#ifndef NPNR_DISABLE_THREADS
+    std::vector<std::thread> threads;
+    std::mutex wake_mutex;
+    // Signalled when work is queued, for idle workers
+    std::condition_variable wake_cv;
+    // Signalled when a task finishes or work is queued, for threads waiting on a TaskGroup
+    std::condition_variable done_cv;
+#endif
+    std::atomic<int> queued{0};
+    bool shutdown = false;
+
+    void submit(Task task);
+    bool try_pop(int queue_idx, Task &task);
+    bool try_steal(int thief_idx, Task &task);
+    // Run a single queued task, if any is available; returns false if all queues were empty
+    bool run_pending();
+    void execute(Task &task);
+    void worker(int idx);
+};
+
+// A set of tasks submitted to a pool that can be waited on together
+class TaskGroup
+{
+  public:
+    explicit TaskGroup(ThreadPool &pool) : pool(pool) {};
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &other) = delete;
+    TaskGroup &operator=(const TaskGroup &other) = delete;
+
+    template <typename Func> void run(Func &&func)
+    {
+        if (pool.worker_count == 0) {
+            func();
+            return;
+        }
+        outstanding.fetch_add(1);
+        pool.submit(ThreadPool::Task{std::forward<Func>(func), this});
+    }
+
+    // Wait for all tasks in this group to finish, running queued tasks in the meantime. If any task threw an
+    // exception, the first one is rethrown here.
+    void wait();
+
+  private:
+    friend class ThreadPool;
+
+    ThreadPool &pool;
+    std::atomic<int> outstanding{0};
+    void wait_tasks();
+#ifndef NPNR_DISABLE_THREADS
+    std::mutex error_mutex;
+#endif
+    std::exception_ptr error;
+};
+
+template <typename Func> void ThreadPool::parallel_for(int N, Func func, int grain)
+{
+    if (N <= 0)
+        return;
+    // A few chunks per thread so that stealing can balance uneven work
+    int chunk_count = std::max(1, std::min(N / std::max(1, grain), 4 * size()));
+    int chunk_size = (N + chunk_count - 1) / chunk_count;
+    if (worker_count == 0 || chunk_count == 1) {
+        for (int i = 0; i < N; i++)
+            func(i);
+        return;
+    }
+    TaskGroup group(*this);
+    for (int begin = 0; begin < N; begin += chunk_size) {
+        int end = std::min(N, begin + chunk_size);
+        group.run([&func, begin, end]() {
+            for (int i = begin; i < end; i++)
+                func(i);
+        });
+    }
+    group.wait();
+}
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* THREAD_POOL_H */
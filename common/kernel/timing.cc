@@ -22,8 +22,10 @@
 #include "timing.h"
 #include <algorithm>
 #include <boost/range/adaptor/reversed.hpp>
+#include <chrono>
 #include <deque>
 #include <map>
+#include <queue>
 #include <utility>
 #include "util.h"
 
@@ -35,40 +37,53 @@ TimingAnalyser::TimingAnalyser(Context *ctx) : ctx(ctx)
     domain_to_id.emplace(key, 0);
     domains.emplace_back(key);
     async_clock_id = 0;
+    incremental = bool_or_default(ctx->settings, ctx->id("timing/incremental"), true);
+    verify_incremental = bool_or_default(ctx->settings, ctx->id("timing/verifyIncremental"), false);
+    report_paths = int_or_default(ctx->settings, ctx->id("timing/reportPaths"), 0);
+    report_paths_per_endpoint = int_or_default(ctx->settings, ctx->id("timing/reportPathsPerEndpoint"), 1);
 };
 
-void TimingAnalyser::setup(bool update_net_timings, bool update_histogram, bool update_crit_paths)
+void TimingAnalyser::setup(bool update_histogram, bool update_crit_paths)
 {
+    ProfileScope profile(ctx->profiler, "timing setup");
+    times_valid = false;
     init_ports();
     get_cell_delays();
     topo_sort();
+    build_graph();
     setup_port_domains();
     identify_related_domains();
-    run(true, update_net_timings, update_histogram, update_crit_paths);
+    run(true, update_histogram, update_crit_paths);
 }
 
-void TimingAnalyser::run(bool update_route_delays, bool update_net_timings, bool update_histogram,
-                         bool update_crit_paths)
+void TimingAnalyser::run(bool update_route_delays, bool update_histogram, bool update_crit_paths)
 {
-    reset_times();
+    ProfileScope profile(ctx->profiler, "timing");
     if (update_route_delays)
         get_route_delays();
-    walk_forward();
-    walk_backward();
-    compute_slack();
-    compute_criticality();
+    if (can_run_incremental()) {
+        run_incremental();
+        if (verify_incremental)
+            verify_incremental_run();
+    } else {
+        reset_times();
+        walk_forward();
+        walk_backward();
+        compute_slack();
+        compute_criticality();
+    }
+    for (auto &port : dirty_ports)
+        ports.at(port).dirty = false;
+    dirty_ports.clear();
+    times_valid = true;
 
     // Ensure we clear all timing results if any of them has been marked as
     // as to be updated. This is done so we ensure it's not possible to have
     // timing_result which contains mixed reports
-    if (update_net_timings || update_histogram || update_crit_paths) {
+    if (update_histogram || update_crit_paths) {
         result = TimingResult();
     }
 
-    if (update_net_timings) {
-        build_detailed_net_timing_report();
-    }
-
     if (update_histogram) {
         build_slack_histogram_report();
     }
@@ -84,9 +99,13 @@ void TimingAnalyser::init_ports()
     for (auto &cell : ctx->cells) {
         CellInfo *ci = cell.second.get();
         for (auto &port : ci->ports) {
-            auto &data = ports[CellPortKey(ci->name, port.first)];
+            CellPortKey key(ci->name, port.first);
+            auto inserted = port_to_idx.emplace(key, int(ports.size()));
+            if (inserted.second)
+                ports.emplace_back();
+            auto &data = ports.at(inserted.first->second);
             data.type = port.second.type;
-            data.cell_port = CellPortKey(ci->name, port.first);
+            data.cell_port = key;
         }
     }
 }
@@ -95,12 +114,11 @@ void TimingAnalyser::get_cell_delays()
 {
     auto async_clk_key = domains.at(async_clock_id);
 
-    for (auto &port : ports) {
-        CellInfo *ci = cell_info(port.first);
-        auto &pi = port_info(port.first);
-        auto &pd = port.second;
+    for (auto &pd : ports) {
+        CellInfo *ci = cell_info(pd.cell_port);
+        auto &pi = port_info(pd.cell_port);
 
-        IdString name = port.first.port;
+        IdString name = pd.cell_port.port;
         // Ignore dangling ports altogether for timing purposes
         if (!pi.net)
             continue;
@@ -176,33 +194,42 @@ void TimingAnalyser::get_route_delays()
         for (auto &usr : ni->users) {
             if (usr.cell->bel == BelId())
                 continue;
-            ports.at(CellPortKey(usr)).route_delay = DelayPair(ctx->getNetinfoRouteDelay(ni, usr));
+            set_route_delay(CellPortKey(usr), DelayPair(ctx->getNetinfoRouteDelay(ni, usr)));
         }
     }
 }
 
-void TimingAnalyser::set_route_delay(CellPortKey port, DelayPair value) { ports.at(port).route_delay = value; }
+void TimingAnalyser::set_route_delay(int port, DelayPair value)
+{
+    auto &pd = ports.at(port);
+    if (pd.route_delay.min_delay == value.min_delay && pd.route_delay.max_delay == value.max_delay)
+        return;
+    pd.route_delay = value;
+    if (!pd.dirty) {
+        pd.dirty = true;
+        dirty_ports.push_back(port);
+    }
+}
 
 void TimingAnalyser::topo_sort()
 {
     TopoSort<CellPortKey> topo;
-    for (auto &port : ports) {
-        auto &pd = port.second;
+    for (auto &pd : reversed_range(ports)) {
         // All ports are nodes
-        topo.node(port.first);
+        topo.node(pd.cell_port);
         if (pd.type == PORT_IN) {
             // inputs: combinational arcs through the cell are edges
             for (auto &arc : pd.cell_arcs) {
                 if (arc.type != CellArc::COMBINATIONAL)
                     continue;
-                topo.edge(port.first, CellPortKey(port.first.cell, arc.other_port));
+                topo.edge(pd.cell_port, CellPortKey(pd.cell_port.cell, arc.other_port));
             }
         } else if (pd.type == PORT_OUT) {
             // output: routing arcs are edges
-            const NetInfo *pn = port_info(port.first).net;
+            const NetInfo *pn = port_info(pd.cell_port).net;
             if (pn != nullptr) {
                 for (auto &usr : pn->users)
-                    topo.edge(port.first, CellPortKey(usr));
+                    topo.edge(pd.cell_port, CellPortKey(usr));
             }
         }
     }
@@ -226,7 +253,61 @@ void TimingAnalyser::topo_sort()
             log_error("Timing analysis failed due to combinational loops.\n");
     }
     have_loops = !no_loops;
-    std::swap(topological_order, topo.sorted);
+    topological_order.clear();
+    for (auto &pd : ports)
+        pd.topo_index = -1;
+    for (auto &port : topo.sorted) {
+        int idx = port_index(port);
+        ports.at(idx).topo_index = int(topological_order.size());
+        topological_order.push_back(idx);
+    }
+}
+
+void TimingAnalyser::build_graph()
+{
+    int port_count = int(ports.size());
+    net_driver.assign(port_count, -1);
+    std::vector<std::vector<int>> users(port_count);
+    std::vector<std::vector<CombArc>> fwd(port_count), fwd_rev(port_count), bwd(port_count), bwd_rev(port_count);
+    for (int i = 0; i < port_count; i++) {
+        auto &pd = ports.at(i);
+        for (auto &arc : pd.cell_arcs)
+            arc.other_port_idx =
+                    (arc.other_port == IdString()) ? -1 : port_index(CellPortKey(pd.cell_port.cell, arc.other_port));
+        const NetInfo *net = port_info(pd.cell_port).net;
+        if (pd.type == PORT_OUT) {
+            if (net != nullptr)
+                for (auto &usr : net->users)
+                    users.at(i).push_back(port_index(CellPortKey(usr)));
+        } else if (net != nullptr && net->driver.cell != nullptr) {
+            net_driver.at(i) = port_index(CellPortKey(net->driver));
+        }
+        for (auto &arc : pd.cell_arcs) {
+            if (arc.type != CellArc::COMBINATIONAL)
+                continue;
+            CombArc comb{arc.other_port_idx, arc.value.delayPair()};
+            if (pd.type == PORT_IN) {
+                fwd.at(i).push_back(comb);
+                fwd_rev.at(comb.port).push_back(CombArc{i, comb.delay});
+            } else if (pd.type == PORT_OUT) {
+                bwd.at(i).push_back(comb);
+                bwd_rev.at(comb.port).push_back(CombArc{i, comb.delay});
+            }
+        }
+    }
+    auto topo_less = [&](int a, int b) { return ports.at(a).topo_index < ports.at(b).topo_index; };
+    auto arc_topo_less = [&](const CombArc &a, const CombArc &b) { return topo_less(a.port, b.port); };
+    for (int i = 0; i < port_count; i++) {
+        std::sort(users.at(i).begin(), users.at(i).end(), topo_less);
+        std::sort(fwd_rev.at(i).begin(), fwd_rev.at(i).end(), arc_topo_less);
+        std::sort(bwd_rev.at(i).begin(), bwd_rev.at(i).end(), arc_topo_less);
+    }
+    net_users.assign(users);
+    comb_fwd.assign(fwd);
+    comb_fwd_rev.assign(fwd_rev);
+    comb_bwd.assign(bwd);
+    comb_bwd_rev.assign(bwd_rev);
+    build_levels();
 }
 
 void TimingAnalyser::setup_port_domains()
@@ -235,86 +316,93 @@ void TimingAnalyser::setup_port_domains()
         d.startpoints.clear();
         d.endpoints.clear();
     }
+    // Domains are gathered per port first, and compiled into flat storage once the set for every port is known
+    std::vector<std::vector<domain_id_t>> arrival_domains(ports.size()), required_domains(ports.size());
+    auto add_domain = [](std::vector<domain_id_t> &port_domains, domain_id_t dom) {
+        if (std::find(port_domains.begin(), port_domains.end(), dom) == port_domains.end())
+            port_domains.push_back(dom);
+    };
     bool first_iter = true;
     do {
         // Go forward through the topological order (domains from the PoV of arrival time)
         updated_domains = false;
-        for (auto port : topological_order) {
+        for (int port : topological_order) {
             auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
+            if (pd.type == PORT_OUT) {
                 if (first_iter) {
                     for (auto &fanin : pd.cell_arcs) {
                         domain_id_t dom;
                         // registered outputs are startpoints
                         if (fanin.type == CellArc::CLK_TO_Q)
-                            dom = domain_id(port.cell, fanin.other_port, fanin.edge);
+                            dom = domain_id(pd.cell_port.cell, fanin.other_port, fanin.edge);
                         else if (fanin.type == CellArc::STARTPOINT)
                             dom = async_clock_id;
                         else
                             continue;
                         // create per-domain data
-                        pd.arrival[dom];
+                        add_domain(arrival_domains.at(port), dom);
                         domains.at(dom).startpoints.emplace_back(port, fanin.other_port);
                     }
                 }
                 // copy domains across routing
-                if (pi.net != nullptr)
-                    for (auto &usr : pi.net->users)
-                        copy_domains(port, CellPortKey(usr), false);
+                for (int usr : net_users[port])
+                    copy_domains(arrival_domains, port, usr);
             } else {
                 // copy domains from input to output
-                for (auto &fanout : pd.cell_arcs) {
-                    if (fanout.type != CellArc::COMBINATIONAL)
-                        continue;
-                    copy_domains(port, CellPortKey(port.cell, fanout.other_port), false);
-                }
+                for (auto &fanout : comb_fwd[port])
+                    copy_domains(arrival_domains, port, fanout.port);
             }
         }
         // Go backward through the topological order (domains from the PoV of required time)
-        for (auto port : reversed_range(topological_order)) {
+        for (int port : reversed_range(topological_order)) {
             auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
+            if (pd.type == PORT_OUT) {
                 // copy domains from output to input
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type != CellArc::COMBINATIONAL)
-                        continue;
-                    copy_domains(port, CellPortKey(port.cell, fanin.other_port), true);
-                }
+                for (auto &fanin : comb_bwd[port])
+                    copy_domains(required_domains, port, fanin.port);
             } else {
                 if (first_iter) {
                     for (auto &fanout : pd.cell_arcs) {
                         domain_id_t dom;
                         // registered inputs are endpoints
                         if (fanout.type == CellArc::SETUP)
-                            dom = domain_id(port.cell, fanout.other_port, fanout.edge);
+                            dom = domain_id(pd.cell_port.cell, fanout.other_port, fanout.edge);
                         else if (fanout.type == CellArc::ENDPOINT)
                             dom = async_clock_id;
                         else
                             continue;
                         // create per-domain data
-                        pd.required[dom];
+                        add_domain(required_domains.at(port), dom);
                         domains.at(dom).endpoints.emplace_back(port, fanout.other_port);
                     }
                 }
                 // copy port to driver
-                if (pi.net != nullptr && pi.net->driver.cell != nullptr)
-                    copy_domains(port, CellPortKey(pi.net->driver), true);
+                if (net_driver.at(port) != -1)
+                    copy_domains(required_domains, port, net_driver.at(port));
             }
         }
-        // Iterate over ports and find domain pairs
-        for (auto port : topological_order) {
-            auto &pd = ports.at(port);
-            for (auto &arr : pd.arrival)
-                for (auto &req : pd.required) {
-                    pd.domain_pairs[domain_pair_id(arr.first, req.first)];
-                }
-        }
         first_iter = false;
         // If there are loops, repeat the process until a fixed point is reached, as there might be unusual ways to
         // visit points, which would result in a missing domain key and therefore crash later on
     } while (have_loops && updated_domains);
+
+    // Compile the per-port domain lists into flat storage, and find domain pairs
+    std::vector<std::vector<ArrivReqTime>> arrival_lists(ports.size()), required_lists(ports.size());
+    std::vector<std::vector<PortDomainPairData>> pair_lists(ports.size());
+    for (int port = 0; port < int(ports.size()); port++) {
+        for (domain_id_t dom : reversed_range(arrival_domains.at(port)))
+            arrival_lists.at(port).emplace_back(dom);
+        for (domain_id_t dom : reversed_range(required_domains.at(port)))
+            required_lists.at(port).emplace_back(dom);
+    }
+    for (int port : topological_order)
+        for (auto &arr : arrival_lists.at(port))
+            for (auto &req : required_lists.at(port))
+                pair_lists.at(port).emplace_back(domain_pair_id(arr.domain, req.domain));
+    port_arrival.assign(arrival_lists);
+    port_required.assign(required_lists);
+    port_domain_pairs.assign(pair_lists);
+
     for (auto &dp : domain_pairs) {
         auto &launch_data = domains.at(dp.key.launch);
         auto &capture_data = domains.at(dp.key.capture);
@@ -504,57 +592,100 @@ void TimingAnalyser::reset_times()
 {
     static const auto init_delay =
             DelayPair(std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest());
-    for (auto &port : ports) {
-        auto do_reset = [&](dict<domain_id_t, ArrivReqTime> &times) {
-            for (auto &t : times) {
-                t.second.value = init_delay;
-                t.second.path_length = 0;
-                t.second.bwd_min = CellPortKey();
-                t.second.bwd_max = CellPortKey();
-            }
-        };
-        do_reset(port.second.arrival);
-        do_reset(port.second.required);
-        for (auto &dp : port.second.domain_pairs) {
-            dp.second.setup_slack = std::numeric_limits<delay_t>::max();
-            dp.second.hold_slack = std::numeric_limits<delay_t>::max();
-            dp.second.max_path_length = 0;
-            dp.second.criticality = 0;
+    auto do_reset = [&](std::vector<ArrivReqTime> &times) {
+        for (auto &t : times) {
+            t.value = init_delay;
+            t.path_length = 0;
+            t.bwd_min = -1;
+            t.bwd_max = -1;
         }
-        port.second.worst_crit = 0;
-        port.second.worst_setup_slack = std::numeric_limits<delay_t>::max();
-        port.second.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    };
+    do_reset(port_arrival.items);
+    do_reset(port_required.items);
+    for (auto &dp : port_domain_pairs.items) {
+        dp.setup_slack = std::numeric_limits<delay_t>::max();
+        dp.hold_slack = std::numeric_limits<delay_t>::max();
+        dp.max_path_length = 0;
+        dp.criticality = 0;
+    }
+    for (auto &pd : ports) {
+        pd.worst_crit = 0;
+        pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+        pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    }
+}
+
+void TimingAnalyser::set_arrival_time(int target, domain_id_t domain, DelayPair arrival, int path_length, int prev)
+{
+    auto arr = find_time(port_arrival[target], domain);
+    NPNR_ASSERT(arr != nullptr);
+    if (arrival.max_delay > arr->value.max_delay) {
+        arr->value.max_delay = arrival.max_delay;
+        arr->bwd_max = prev;
+    }
+    if (!setup_only && (arrival.min_delay < arr->value.min_delay)) {
+        arr->value.min_delay = arrival.min_delay;
+        arr->bwd_min = prev;
     }
+    arr->path_length = std::max(arr->path_length, path_length);
 }
 
-void TimingAnalyser::set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                                      CellPortKey prev)
+void TimingAnalyser::set_required_time(int target, domain_id_t domain, DelayPair required, int path_length, int prev)
 {
-    auto &arr = ports.at(target).arrival.at(domain);
-    if (arrival.max_delay > arr.value.max_delay) {
-        arr.value.max_delay = arrival.max_delay;
-        arr.bwd_max = prev;
+    auto req = find_time(port_required[target], domain);
+    NPNR_ASSERT(req != nullptr);
+    if (required.min_delay < req->value.min_delay) {
+        req->value.min_delay = required.min_delay;
+        req->bwd_min = prev;
     }
-    if (!setup_only && (arrival.min_delay < arr.value.min_delay)) {
-        arr.value.min_delay = arrival.min_delay;
-        arr.bwd_min = prev;
+    if (!setup_only && (required.max_delay > req->value.max_delay)) {
+        req->value.max_delay = required.max_delay;
+        req->bwd_max = prev;
     }
-    arr.path_length = std::max(arr.path_length, path_length);
+    req->path_length = std::max(req->path_length, path_length);
 }
 
-void TimingAnalyser::set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                                       CellPortKey prev)
+DelayPair TimingAnalyser::startpoint_arrival(int port, IdString clock_port, int &clock_idx)
 {
-    auto &req = ports.at(target).required.at(domain);
-    if (required.min_delay < req.value.min_delay) {
-        req.value.min_delay = required.min_delay;
-        req.bwd_min = prev;
+    DelayPair init_arrival(0);
+    clock_idx = -1;
+    if (clock_port == IdString())
+        return init_arrival;
+    // clocked startpoints have a clock-to-out time
+    for (auto &fanin : ports.at(port).cell_arcs) {
+        if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == clock_port) {
+            init_arrival += fanin.value.delayPair();
+            clock_idx = fanin.other_port_idx;
+            // Include the clock delay if clock_skew analysis is enabled
+            if (with_clock_skew) {
+                init_arrival += ports.at(fanin.other_port_idx).route_delay;
+            }
+            break;
+        }
     }
-    if (!setup_only && (required.max_delay > req.value.max_delay)) {
-        req.value.max_delay = required.max_delay;
-        req.bwd_max = prev;
+    return init_arrival;
+}
+
+DelayPair TimingAnalyser::endpoint_required(int port, IdString clock_port, int &clock_idx)
+{
+    DelayPair init_required(0);
+    clock_idx = -1;
+    if (clock_port == IdString())
+        return init_required;
+    // TODO: clock routing delay, if analysis of that is enabled
+    // Add setup/hold time, if this endpoint is clocked
+    for (auto &fanin : ports.at(port).cell_arcs) {
+        if (fanin.type == CellArc::SETUP && fanin.other_port == clock_port) {
+            clock_idx = fanin.other_port_idx;
+            if (with_clock_skew) {
+                init_required += ports.at(fanin.other_port_idx).route_delay;
+            }
+            init_required.min_delay -= fanin.value.maxDelay();
+        }
+        if (fanin.type == CellArc::HOLD && fanin.other_port == clock_port)
+            init_required.max_delay += fanin.value.maxDelay();
     }
-    req.path_length = std::max(req.path_length, path_length);
+    return init_required;
 }
 
 void TimingAnalyser::walk_forward()
@@ -563,49 +694,30 @@ void TimingAnalyser::walk_forward()
     for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
         auto &dom = domains.at(dom_id);
         for (auto &sp : dom.startpoints) {
-            auto &pd = ports.at(sp.first);
-            DelayPair init_arrival(0);
-            CellPortKey clock_key;
-            if (sp.second != IdString()) {
-                // clocked startpoints have a clock-to-out time
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == sp.second) {
-                        init_arrival += fanin.value.delayPair();
-                        // Include the clock delay if clock_skew analysis is enabled
-                        if (with_clock_skew) {
-                            init_arrival += ports.at(CellPortKey(sp.first.cell, fanin.other_port)).route_delay;
-                        }
-                        break;
-                    }
-                }
-                clock_key = CellPortKey(sp.first.cell, sp.second);
-            }
-            set_arrival_time(sp.first, dom_id, init_arrival, 1, clock_key);
+            int clock_idx;
+            DelayPair init_arrival = startpoint_arrival(sp.first, sp.second, clock_idx);
+            set_arrival_time(sp.first, dom_id, init_arrival, 1, clock_idx);
         }
     }
+    if (use_levels()) {
+        walk_forward_levels();
+        return;
+    }
     // Walk forward in topological order
-    for (auto p : topological_order) {
+    for (int p : topological_order) {
         auto &pd = ports.at(p);
-        for (auto &arr : pd.arrival) {
+        for (auto &arr : port_arrival[p]) {
             if (pd.type == PORT_OUT) {
                 // Output port: propagate delay through net, adding route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr)
-                    for (auto &usr : net->users) {
-                        CellPortKey usr_key(usr);
-                        auto &usr_pd = ports.at(usr_key);
-                        auto next_arr = arr.second.value + usr_pd.route_delay;
-                        set_arrival_time(usr_key, arr.first, next_arr, arr.second.path_length, p);
-                    }
+                for (int usr : net_users[p]) {
+                    auto next_arr = arr.value + ports.at(usr).route_delay;
+                    set_arrival_time(usr, arr.domain, next_arr, arr.path_length, p);
+                }
             } else if (pd.type == PORT_IN) {
                 // Input port; propagate delay through cell, adding combinational delay
-                for (auto &fanout : pd.cell_arcs) {
-                    if (fanout.type != CellArc::COMBINATIONAL)
-                        continue;
-
-                    auto next_arr = arr.second.value + fanout.value.delayPair();
-                    set_arrival_time(CellPortKey(p.cell, fanout.other_port), arr.first, next_arr,
-                                     arr.second.path_length + 1, p);
+                for (auto &fanout : comb_fwd[p]) {
+                    auto next_arr = arr.value + fanout.delay;
+                    set_arrival_time(fanout.port, arr.domain, next_arr, arr.path_length + 1, p);
                 }
             }
         }
@@ -620,53 +732,99 @@ void TimingAnalyser::walk_backward()
     for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
         auto &dom = domains.at(dom_id);
         for (auto &ep : dom.endpoints) {
-            auto &pd = ports.at(ep.first);
-            DelayPair init_required(0);
-            CellPortKey clock_key;
-            // TODO: clock routing delay, if analysis of that is enabled
-            if (ep.second != IdString()) {
-                // Add setup/hold time, if this endpoint is clocked
-                for (auto &fanin : pd.cell_arcs) {
-
-                    if (fanin.type == CellArc::SETUP && fanin.other_port == ep.second) {
-                        if (with_clock_skew) {
-                            init_required += ports.at(CellPortKey(ep.first.cell, fanin.other_port)).route_delay;
-                        }
-                        init_required.min_delay -= fanin.value.maxDelay();
-                    }
-                    if (fanin.type == CellArc::HOLD && fanin.other_port == ep.second)
-                        init_required.max_delay += fanin.value.maxDelay();
-                }
-                clock_key = CellPortKey(ep.first.cell, ep.second);
-            }
-            set_required_time(ep.first, dom_id, init_required, 1, clock_key);
+            int clock_idx;
+            DelayPair init_required = endpoint_required(ep.first, ep.second, clock_idx);
+            set_required_time(ep.first, dom_id, init_required, 1, clock_idx);
         }
     }
+    if (use_levels()) {
+        walk_backward_levels();
+        return;
+    }
     // Walk backwards in topological order
-    for (auto p : reversed_range(topological_order)) {
+    for (int p : reversed_range(topological_order)) {
         auto &pd = ports.at(p);
-        for (auto &req : pd.required) {
+        for (auto &req : port_required[p]) {
             if (pd.type == PORT_IN) {
                 // Input port: propagate delay back through net, subtracting route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr && net->driver.cell != nullptr)
-                    set_required_time(CellPortKey(net->driver), req.first,
-                                      req.second.value - DelayPair(pd.route_delay.maxDelay()), req.second.path_length,
-                                      p);
+                if (net_driver.at(p) != -1)
+                    set_required_time(net_driver.at(p), req.domain, req.value - DelayPair(pd.route_delay.maxDelay()),
+                                      req.path_length, p);
             } else if (pd.type == PORT_OUT) {
                 // Output port : propagate delay back through cell, subtracting combinational delay
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type != CellArc::COMBINATIONAL)
-                        continue;
-                    set_required_time(CellPortKey(p.cell, fanin.other_port), req.first,
-                                      req.second.value - DelayPair(fanin.value.maxDelay()), req.second.path_length + 1,
-                                      p);
+                for (auto &fanin : comb_bwd[p]) {
+                    set_required_time(fanin.port, req.domain, req.value - DelayPair(fanin.delay.maxDelay()),
+                                      req.path_length + 1, p);
                 }
             }
         }
     }
 }
 
+bool TimingAnalyser::use_levels() const
+{
+    // With loops there is no consistent ordering of fan-in before fan-out, and the serial walk must be used
+    return parallel && !have_loops && ctx->threadPool().size() > 1;
+}
+
+void TimingAnalyser::walk_forward_levels()
+{
+    // Rather than pushing times from each port to its fan-out, every port gathers them from its fan-in, so ports in
+    // the same level never write to the same data. Fan-in is applied in topological order, so ties resolve exactly as
+    // in the serial walk.
+    auto &pool = ctx->threadPool();
+    for (int level = 0; level < fwd_levels.size(); level++) {
+        auto level_ports = fwd_levels[level];
+        pool.parallel_for(level_ports.size(), [&](int i) { pull_arrival(level_ports[i]); }, 256);
+    }
+}
+
+void TimingAnalyser::walk_backward_levels()
+{
+    auto &pool = ctx->threadPool();
+    for (int level = 0; level < bwd_levels.size(); level++) {
+        auto level_ports = bwd_levels[level];
+        pool.parallel_for(level_ports.size(), [&](int i) { pull_required(level_ports[i]); }, 256);
+    }
+}
+
+void TimingAnalyser::build_levels()
+{
+    int port_count = int(ports.size());
+    std::vector<int> fwd_level(port_count, 0), bwd_level(port_count, 0);
+    int fwd_count = 0, bwd_count = 0;
+    for (int p : topological_order) {
+        auto &pd = ports.at(p);
+        int &level = fwd_level.at(p);
+        if (pd.type == PORT_OUT) {
+            for (auto &fanin : comb_fwd_rev[p])
+                level = std::max(level, fwd_level.at(fanin.port) + 1);
+        } else if (net_driver.at(p) != -1) {
+            level = std::max(level, fwd_level.at(net_driver.at(p)) + 1);
+        }
+        fwd_count = std::max(fwd_count, level + 1);
+    }
+    for (int p : reversed_range(topological_order)) {
+        auto &pd = ports.at(p);
+        int &level = bwd_level.at(p);
+        if (pd.type == PORT_IN) {
+            for (auto &fanout : comb_bwd_rev[p])
+                level = std::max(level, bwd_level.at(fanout.port) + 1);
+        } else {
+            for (int usr : net_users[p])
+                level = std::max(level, bwd_level.at(usr) + 1);
+        }
+        bwd_count = std::max(bwd_count, level + 1);
+    }
+    std::vector<std::vector<int>> fwd(fwd_count), bwd(bwd_count);
+    for (int p : topological_order) {
+        fwd.at(fwd_level.at(p)).push_back(p);
+        bwd.at(bwd_level.at(p)).push_back(p);
+    }
+    fwd_levels.assign(fwd);
+    bwd_levels.assign(bwd);
+}
+
 dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
 {
     dict<domain_id_t, delay_t> domain_delay;
@@ -677,9 +835,10 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
         for (auto &ep : capture.endpoints) {
             auto &ep_port = ports.at(ep.first);
 
-            auto &req = ep_port.required.at(capture_id);
+            auto &req = *find_time(port_required[ep.first], capture_id);
 
-            for (auto &[launch_id, arr] : ep_port.arrival) {
+            for (auto &arr : port_arrival[ep.first]) {
+                domain_id_t launch_id = arr.domain;
                 const auto &launch = domains.at(capture_id);
 
                 auto dp = domain_pair_id(launch_id, capture_id);
@@ -700,7 +859,7 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
                 if (with_clock_skew && !same_clock && !related_clocks) {
                     for (auto &fanin : ep_port.cell_arcs) {
                         if (fanin.type == CellArc::SETUP) {
-                            auto clock_delay = ports.at(CellPortKey(ep.first.cell, fanin.other_port)).route_delay;
+                            auto clock_delay = ports.at(fanin.other_port_idx).route_delay;
                             delay += clock_delay.minDelay();
                         }
                     }
@@ -709,11 +868,11 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
                     auto crit_path = walk_crit_path(domain_pair_id(launch_id, capture_id), ep.first, true);
                     auto first_inp = crit_path.back();
                     const auto &sp = first_inp.cell->ports.at(first_inp.port).net->driver;
-                    auto &sp_port = ports.at(CellPortKey{sp.cell->name, sp.port});
+                    auto &sp_port = ports.at(port_index(CellPortKey{sp.cell->name, sp.port}));
 
                     for (auto &fanin : sp_port.cell_arcs) {
                         if (fanin.type == CellArc::CLK_TO_Q) {
-                            auto clock_delay = ports.at(CellPortKey(sp.cell->name, fanin.other_port)).route_delay;
+                            auto clock_delay = ports.at(fanin.other_port_idx).route_delay;
                             delay -= clock_delay.maxDelay();
                         }
                     }
@@ -730,114 +889,438 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
 }
 
 void TimingAnalyser::compute_slack()
+{
+    if (use_levels()) {
+        ctx->threadPool().parallel_for(int(ports.size()), [&](int p) { compute_port_slack(p); }, 1024);
+    } else {
+        for (int p : topological_order)
+            compute_port_slack(p);
+    }
+    compute_domain_pair_slack();
+}
+
+void TimingAnalyser::compute_port_slack(int port)
+{
+    auto &pd = ports.at(port);
+    pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+    pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    for (auto &pdp : port_domain_pairs[port]) {
+        auto &dp = domain_pairs.at(pdp.pair);
+
+        // Get clock names
+        const auto &launch_clock = domains.at(dp.key.launch).key.clock;
+        const auto &capture_clock = domains.at(dp.key.capture).key.clock;
+
+        // Get clock-to-clock delay if any
+        delay_t clock_to_clock = 0;
+        auto clocks = std::make_pair(launch_clock, capture_clock);
+        if (clock_delays.count(clocks)) {
+            clock_to_clock = clock_delays.at(clocks);
+        }
+
+        auto &arr = *find_time(port_arrival[port], dp.key.launch);
+        auto &req = *find_time(port_required[port], dp.key.capture);
+        pdp.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
+        if (!setup_only)
+            pdp.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
+        pdp.max_path_length = arr.path_length + req.path_length;
+        if (dp.key.launch == dp.key.capture)
+            pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.setup_slack);
+        if (!setup_only)
+            pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.hold_slack);
+    }
+}
+
+void TimingAnalyser::compute_domain_pair_slack()
 {
     for (auto &dp : domain_pairs) {
         dp.worst_setup_slack = std::numeric_limits<delay_t>::max();
         dp.worst_hold_slack = std::numeric_limits<delay_t>::max();
     }
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-
-            // Get clock names
-            const auto &launch_clock = domains.at(dp.key.launch).key.clock;
-            const auto &capture_clock = domains.at(dp.key.capture).key.clock;
-
-            // Get clock-to-clock delay if any
-            delay_t clock_to_clock = 0;
-            auto clocks = std::make_pair(launch_clock, capture_clock);
-            if (clock_delays.count(clocks)) {
-                clock_to_clock = clock_delays.at(clocks);
+    for (int p : topological_order) {
+        for (auto &pdp : port_domain_pairs[p]) {
+            auto &dp = domain_pairs.at(pdp.pair);
+            dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.setup_slack);
+            if (!setup_only)
+                dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.hold_slack);
+        }
+    }
+}
+
+void TimingAnalyser::compute_criticality()
+{
+    if (use_levels()) {
+        ctx->threadPool().parallel_for(int(ports.size()), [&](int p) { compute_port_criticality(p); }, 1024);
+    } else {
+        for (int p : topological_order)
+            compute_port_criticality(p);
+    }
+}
+
+void TimingAnalyser::compute_port_criticality(int port)
+{
+    auto &pd = ports.at(port);
+    pd.worst_crit = 0;
+    for (auto &pdp : port_domain_pairs[port]) {
+        auto &dp = domain_pairs.at(pdp.pair);
+        // Do not set criticality for asynchronous paths
+        if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
+            continue;
+
+        float crit = 1.0f - (float(pdp.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
+        crit = std::min(crit, 1.0f);
+        crit = std::max(crit, 0.0f);
+        pdp.criticality = crit;
+        pd.worst_crit = std::max(pd.worst_crit, crit);
+    }
+}
+
+bool TimingAnalyser::can_run_incremental() const
+{
+    // Loops break the topological ordering the incremental walk relies on, and with clock skew analysis a change in
+    // clock routing affects every startpoint and endpoint of the clock
+    if (!incremental || !times_valid || have_loops || with_clock_skew)
+        return false;
+    // Past a certain point, walking the affected cones costs more than just redoing everything
+    return dirty_ports.size() * 8 < ports.size();
+}
+
+bool TimingAnalyser::update_arrival(int port)
+{
+    static const auto init_delay =
+            DelayPair(std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest());
+    auto &pd = ports.at(port);
+    auto times = port_arrival[port];
+    std::vector<std::pair<DelayPair, int>> old_times;
+    for (auto &arr : times) {
+        old_times.emplace_back(arr.value, arr.path_length);
+        arr.value = init_delay;
+        arr.path_length = 0;
+        arr.bwd_min = -1;
+        arr.bwd_max = -1;
+    }
+    // Apply contributions in the same order as walk_forward, so ties resolve the same way: startpoints first and then
+    // fan-in ports in topological order
+    if (pd.type == PORT_OUT) {
+        for (auto &fanin : pd.cell_arcs) {
+            int clock_idx;
+            if (fanin.type == CellArc::CLK_TO_Q) {
+                DelayPair init_arrival = startpoint_arrival(port, fanin.other_port, clock_idx);
+                set_arrival_time(port, domain_id(pd.cell_port.cell, fanin.other_port, fanin.edge), init_arrival, 1,
+                                 clock_idx);
+            } else if (fanin.type == CellArc::STARTPOINT) {
+                set_arrival_time(port, async_clock_id, startpoint_arrival(port, IdString(), clock_idx), 1);
             }
+        }
+    }
+    pull_arrival(port);
+    for (int i = 0; i < times.size(); i++) {
+        auto &arr = times[i];
+        auto &old = old_times.at(i);
+        if (arr.value.min_delay != old.first.min_delay || arr.value.max_delay != old.first.max_delay ||
+            arr.path_length != old.second)
+            return true;
+    }
+    return false;
+}
 
-            auto &arr = pd.arrival.at(dp.key.launch);
-            auto &req = pd.required.at(dp.key.capture);
-            pdp.second.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
-            if (!setup_only)
-                pdp.second.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
-            pdp.second.max_path_length = arr.path_length + req.path_length;
-            if (dp.key.launch == dp.key.capture)
-                pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.second.setup_slack);
-            dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.second.setup_slack);
-            if (!setup_only) {
-                pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.second.hold_slack);
-                dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.second.hold_slack);
+bool TimingAnalyser::update_required(int port)
+{
+    static const auto init_delay =
+            DelayPair(std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest());
+    auto &pd = ports.at(port);
+    auto times = port_required[port];
+    std::vector<std::pair<DelayPair, int>> old_times;
+    for (auto &req : times) {
+        old_times.emplace_back(req.value, req.path_length);
+        req.value = init_delay;
+        req.path_length = 0;
+        req.bwd_min = -1;
+        req.bwd_max = -1;
+    }
+    // As in update_arrival, but mirroring walk_backward: endpoints first and then fan-out ports in reverse
+    // topological order
+    if (pd.type == PORT_IN) {
+        for (auto &fanout : pd.cell_arcs) {
+            int clock_idx;
+            if (fanout.type == CellArc::SETUP) {
+                DelayPair init_required = endpoint_required(port, fanout.other_port, clock_idx);
+                set_required_time(port, domain_id(pd.cell_port.cell, fanout.other_port, fanout.edge), init_required,
+                                  1, clock_idx);
+            } else if (fanout.type == CellArc::ENDPOINT) {
+                set_required_time(port, async_clock_id, endpoint_required(port, IdString(), clock_idx), 1);
             }
         }
     }
+    pull_required(port);
+    for (int i = 0; i < times.size(); i++) {
+        auto &req = times[i];
+        auto &old = old_times.at(i);
+        if (req.value.min_delay != old.first.min_delay || req.value.max_delay != old.first.max_delay ||
+            req.path_length != old.second)
+            return true;
+    }
+    return false;
 }
 
-void TimingAnalyser::compute_criticality()
+void TimingAnalyser::pull_arrival(int port)
 {
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-            // Do not set criticality for asynchronous paths
-            if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
-                continue;
+    auto &pd = ports.at(port);
+    if (pd.type == PORT_OUT) {
+        for (auto &fanin : comb_fwd_rev[port])
+            for (auto &arr : port_arrival[fanin.port])
+                set_arrival_time(port, arr.domain, arr.value + fanin.delay, arr.path_length + 1, fanin.port);
+    } else if (pd.type == PORT_IN) {
+        int driver = net_driver.at(port);
+        if (driver != -1)
+            for (auto &arr : port_arrival[driver])
+                set_arrival_time(port, arr.domain, arr.value + pd.route_delay, arr.path_length, driver);
+    }
+}
+
+void TimingAnalyser::pull_required(int port)
+{
+    auto &pd = ports.at(port);
+    if (pd.type == PORT_IN) {
+        auto fanouts = comb_bwd_rev[port];
+        for (auto &fanout : reversed_range(fanouts))
+            for (auto &req : port_required[fanout.port])
+                set_required_time(port, req.domain, req.value - DelayPair(fanout.delay.maxDelay()),
+                                  req.path_length + 1, fanout.port);
+    } else if (pd.type == PORT_OUT) {
+        auto users = net_users[port];
+        for (int usr : reversed_range(users)) {
+            auto &usr_pd = ports.at(usr);
+            for (auto &req : port_required[usr])
+                set_required_time(port, req.domain, req.value - DelayPair(usr_pd.route_delay.maxDelay()),
+                                  req.path_length, usr);
+        }
+    }
+}
+
+void TimingAnalyser::run_incremental()
+{
+    typedef std::pair<int, int> QueuedPort;
+    std::vector<int> changed_ports;
+    auto mark_changed = [&](int port) {
+        auto &pd = ports.at(port);
+        if (!pd.changed) {
+            pd.changed = true;
+            changed_ports.push_back(port);
+        }
+    };
 
-            float crit =
-                    1.0f - (float(pdp.second.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
-            crit = std::min(crit, 1.0f);
-            crit = std::max(crit, 0.0f);
-            pdp.second.criticality = crit;
-            pd.worst_crit = std::max(pd.worst_crit, crit);
+    // Forward: a changed route delay changes the arrival time at that input, which might then change the arrival
+    // times of everything downstream. Ports are visited in topological order, so all of a port's fan-in is final by
+    // the time it is recomputed.
+    std::priority_queue<QueuedPort, std::vector<QueuedPort>, std::greater<QueuedPort>> fwd_queue;
+    auto queue_fwd = [&](int port) {
+        auto &pd = ports.at(port);
+        if (pd.queued)
+            return;
+        pd.queued = true;
+        fwd_queue.emplace(pd.topo_index, port);
+    };
+    for (int port : dirty_ports)
+        if (ports.at(port).type == PORT_IN)
+            queue_fwd(port);
+    while (!fwd_queue.empty()) {
+        int port = fwd_queue.top().second;
+        fwd_queue.pop();
+        auto &pd = ports.at(port);
+        pd.queued = false;
+        if (!update_arrival(port))
+            continue;
+        mark_changed(port);
+        if (pd.type == PORT_OUT) {
+            for (int usr : net_users[port])
+                queue_fwd(usr);
+        } else {
+            for (auto &fanout : comb_fwd[port])
+                queue_fwd(fanout.port);
+        }
+    }
+
+    // Backward: a changed route delay changes the required time at the driver of the net, and everything upstream
+    std::priority_queue<QueuedPort> bwd_queue;
+    auto queue_bwd = [&](int port) {
+        auto &pd = ports.at(port);
+        if (pd.queued)
+            return;
+        pd.queued = true;
+        bwd_queue.emplace(pd.topo_index, port);
+    };
+    for (int port : dirty_ports)
+        if (ports.at(port).type == PORT_IN && net_driver.at(port) != -1)
+            queue_bwd(net_driver.at(port));
+    while (!bwd_queue.empty()) {
+        int port = bwd_queue.top().second;
+        bwd_queue.pop();
+        auto &pd = ports.at(port);
+        pd.queued = false;
+        if (!update_required(port))
+            continue;
+        mark_changed(port);
+        if (pd.type == PORT_IN) {
+            if (net_driver.at(port) != -1)
+                queue_bwd(net_driver.at(port));
+        } else {
+            for (auto &fanin : comb_bwd[port])
+                queue_bwd(fanin.port);
         }
     }
+
+    // Slack only changes where arrival or required times did; but criticality is relative to the worst slack of
+    // the domain pair, so if that moved every port has to be updated
+    for (int port : changed_ports)
+        compute_port_slack(port);
+    std::vector<delay_t> old_worst_setup;
+    for (auto &dp : domain_pairs)
+        old_worst_setup.push_back(dp.worst_setup_slack);
+    compute_domain_pair_slack();
+    bool worst_changed = false;
+    for (size_t i = 0; i < domain_pairs.size(); i++)
+        if (domain_pairs.at(i).worst_setup_slack != old_worst_setup.at(i))
+            worst_changed = true;
+    if (worst_changed) {
+        compute_criticality();
+    } else {
+        for (int port : changed_ports)
+            compute_port_criticality(port);
+    }
+
+    if (ctx->debug)
+        log_info("Incremental timing update: %d dirty ports, %d ports changed%s.\n", int(dirty_ports.size()),
+                 int(changed_ports.size()), worst_changed ? ", worst slack changed" : "");
+    for (int port : changed_ports)
+        ports.at(port).changed = false;
 }
 
-void TimingAnalyser::build_detailed_net_timing_report()
+void TimingAnalyser::verify_incremental_run()
 {
-    auto &net_timings = result.detailed_net_timings;
+    // Keep the incremental results and compare them against a full analysis from scratch
+    std::vector<PerPort> incr_ports = ports;
+    std::vector<ArrivReqTime> incr_arrival = port_arrival.items, incr_required = port_required.items;
+    std::vector<PerDomainPair> incr_domain_pairs = domain_pairs;
+    reset_times();
+    walk_forward();
+    walk_backward();
+    compute_slack();
+    compute_criticality();
+
+    auto times_match = [](const std::vector<ArrivReqTime> &a, const std::vector<ArrivReqTime> &b, int begin,
+                          int end) {
+        for (int i = begin; i < end; i++) {
+            if (a.at(i).value.min_delay != b.at(i).value.min_delay ||
+                a.at(i).value.max_delay != b.at(i).value.max_delay || a.at(i).path_length != b.at(i).path_length)
+                return false;
+        }
+        return true;
+    };
+    for (int p : topological_order) {
+        auto &full = ports.at(p);
+        auto &incr = incr_ports.at(p);
+        auto &key = full.cell_port;
+        if (!times_match(port_arrival.items, incr_arrival, port_arrival.start.at(p), port_arrival.start.at(p + 1)))
+            log_error("Incremental timing analysis mismatch in arrival time at %s.%s\n", ctx->nameOf(key.cell),
+                      ctx->nameOf(key.port));
+        if (!times_match(port_required.items, incr_required, port_required.start.at(p),
+                         port_required.start.at(p + 1)))
+            log_error("Incremental timing analysis mismatch in required time at %s.%s\n", ctx->nameOf(key.cell),
+                      ctx->nameOf(key.port));
+        if (full.worst_setup_slack != incr.worst_setup_slack || full.worst_hold_slack != incr.worst_hold_slack ||
+            full.worst_crit != incr.worst_crit)
+            log_error("Incremental timing analysis mismatch in slack or criticality at %s.%s\n",
+                      ctx->nameOf(key.cell), ctx->nameOf(key.port));
+    }
+    for (size_t i = 0; i < domain_pairs.size(); i++) {
+        if (domain_pairs.at(i).worst_setup_slack != incr_domain_pairs.at(i).worst_setup_slack ||
+            domain_pairs.at(i).worst_hold_slack != incr_domain_pairs.at(i).worst_hold_slack)
+            log_error("Incremental timing analysis mismatch in worst slack of domain pair %d\n", int(i));
+    }
+}
 
+std::vector<IdString> TimingAnalyser::get_detailed_timing_nets()
+{
+    std::vector<IdString> nets;
+    net_endpoints.clear();
     for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
-        auto &dom = domains.at(dom_id);
-        for (auto &ep : dom.endpoints) {
-            auto &pd = ports.at(ep.first);
-            const NetInfo *net = port_info(ep.first).net;
-
-            for (auto &arr : pd.arrival) {
-                auto &launch = domains.at(arr.first).key;
-                for (auto &req : pd.required) {
-                    auto &capture = domains.at(req.first).key;
-
-                    NetSinkTiming sink_timing;
-                    sink_timing.clock_pair.start.clock = launch.clock;
-                    sink_timing.clock_pair.start.edge = launch.edge;
-                    sink_timing.clock_pair.end.clock = capture.clock;
-                    sink_timing.clock_pair.end.edge = capture.edge;
-                    sink_timing.cell_port = std::make_pair(pd.cell_port.cell, pd.cell_port.port);
-                    sink_timing.delay = arr.second.value;
-
-                    net_timings[net->name].push_back(sink_timing);
-                }
+        for (auto &ep : domains.at(dom_id).endpoints) {
+            const NetInfo *net = port_info(ports.at(ep.first).cell_port).net;
+            auto &endpoints = net_endpoints[net->name];
+            if (endpoints.empty())
+                nets.push_back(net->name);
+            endpoints.push_back(ep.first);
+        }
+    }
+    // Last seen first, which is the order the detailed report has always listed them in
+    std::reverse(nets.begin(), nets.end());
+    return nets;
+}
+
+void TimingAnalyser::get_net_sink_timings(IdString net, std::vector<NetSinkTiming> &sinks) const
+{
+    sinks.clear();
+    for (int ep : net_endpoints.at(net)) {
+        auto &pd = ports.at(ep);
+        for (auto &arr : port_arrival[ep]) {
+            auto &launch = domains.at(arr.domain).key;
+            for (auto &req : port_required[ep]) {
+                auto &capture = domains.at(req.domain).key;
+
+                NetSinkTiming sink_timing;
+                sink_timing.clock_pair.start.clock = launch.clock;
+                sink_timing.clock_pair.start.edge = launch.edge;
+                sink_timing.clock_pair.end.clock = capture.clock;
+                sink_timing.clock_pair.end.edge = capture.edge;
+                sink_timing.cell_port = std::make_pair(pd.cell_port.cell, pd.cell_port.port);
+                sink_timing.delay = arr.value;
+
+                sinks.push_back(sink_timing);
             }
         }
     }
 }
 
-std::vector<CellPortKey> TimingAnalyser::get_worst_eps(domain_id_t domain_pair, int count)
+void TimingAnalyser::stream_detailed_net_timings(
+        int batch_size, std::function<void(const std::vector<std::pair<IdString, std::vector<NetSinkTiming>>> &)> write)
+{
+    auto nets = get_detailed_timing_nets();
+    std::vector<std::pair<IdString, std::vector<NetSinkTiming>>> batch;
+    for (int start = 0; start < int(nets.size()); start += batch_size) {
+        batch.resize(std::min(batch_size, int(nets.size()) - start));
+        ctx->threadPool().parallel_for(
+                int(batch.size()),
+                [&](int i) {
+                    batch.at(i).first = nets.at(start + i);
+                    get_net_sink_timings(nets.at(start + i), batch.at(i).second);
+                },
+                256);
+        write(batch);
+    }
+}
+
+std::vector<int> TimingAnalyser::get_worst_eps(domain_id_t domain_pair, int count)
 {
-    std::vector<CellPortKey> worst_eps;
+    std::vector<int> worst_eps;
     delay_t last_slack = std::numeric_limits<delay_t>::lowest();
     auto &dp = domain_pairs.at(domain_pair);
     auto &cap_d = domains.at(dp.key.capture);
     while (int(worst_eps.size()) < count) {
-        CellPortKey next;
+        int next = -1;
         delay_t next_slack = std::numeric_limits<delay_t>::max();
         for (auto ep : cap_d.endpoints) {
-            auto &pd = ports.at(ep.first);
-            if (!pd.domain_pairs.count(domain_pair))
-                continue;
-            delay_t ep_slack = pd.domain_pairs.at(domain_pair).setup_slack;
-            if (ep_slack < next_slack && ep_slack > last_slack) {
-                next = ep.first;
-                next_slack = ep_slack;
+            for (auto &pdp : port_domain_pairs[ep.first]) {
+                if (pdp.pair != domain_pair)
+                    continue;
+                delay_t ep_slack = pdp.setup_slack;
+                if (ep_slack < next_slack && ep_slack > last_slack) {
+                    next = ep.first;
+                    next_slack = ep_slack;
+                }
             }
         }
-        if (next == CellPortKey())
+        if (next == -1)
             break;
         worst_eps.push_back(next);
         last_slack = next_slack;
@@ -845,19 +1328,234 @@ std::vector<CellPortKey> TimingAnalyser::get_worst_eps(domain_id_t domain_pair,
     return worst_eps;
 }
 
-std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path)
+std::vector<std::vector<PortRef>> TimingAnalyser::get_worst_paths(domain_id_t domain_pair, int count, int per_endpoint)
+{
+    // Paths are enumerated best-first, growing partial paths backwards from the endpoints. The arrival time at the
+    // start of a partial path is exactly the latest that any path through it can start, so the slack of a partial
+    // path with that arrival is that of its worst completion; and the order in which complete paths come off the
+    // queue is their order of slack. Every partial path that is taken off the queue is then a deviation from the
+    // worst path through its start onto another fan-in, and only about count * path length of them are expanded.
+    // Candidates that can no longer be among the worst paths are dropped, see `prune` below.
+    std::vector<std::vector<PortRef>> worst_paths;
+    const auto &dp = domain_pairs.at(domain_pair);
+    const auto &launch = domains.at(dp.key.launch);
+    const auto &capture = domains.at(dp.key.capture);
+
+    delay_t clock_to_clock = 0;
+    auto clocks = std::make_pair(launch.key.clock, capture.key.clock);
+    if (clock_delays.count(clocks))
+        clock_to_clock = clock_delays.at(clocks);
+
+    auto max_arrival = [&](int port, delay_t &arrival) {
+        auto arr = find_time(port_arrival[port], dp.key.launch);
+        if (arr == nullptr || arr->value.max_delay == std::numeric_limits<delay_t>::lowest())
+            return false;
+        arrival = arr->value.max_delay;
+        return true;
+    };
+
+    // Arrival times at the startpoints of the launch domain, where paths may end
+    dict<int, delay_t> start_arrival;
+    for (auto &sp : launch.startpoints) {
+        int clock_idx;
+        delay_t arrival = startpoint_arrival(sp.first, sp.second, clock_idx).max_delay;
+        auto found = start_arrival.find(sp.first);
+        if (found == start_arrival.end())
+            start_arrival.emplace(sp.first, arrival);
+        else
+            found->second = std::max(found->second, arrival);
+    }
+
+    // A partial path, from `port` to an endpoint through the partial path `next`
+    struct PathNode
+    {
+        int port, next;
+        // Delay from `port` to the endpoint; and the index of the endpoint
+        delay_t delay;
+        int endpoint;
+    };
+    // A partial path on the queue, or a complete one if it ends at a startpoint
+    struct Candidate
+    {
+        delay_t slack;
+        int seq, node;
+        bool complete;
+        bool operator>(const Candidate &other) const
+        {
+            return slack != other.slack ? slack > other.slack : seq > other.seq;
+        }
+    };
+    std::vector<PathNode> nodes;
+    // Binary heap ordered by Candidate::operator>, so that the candidate with the worst slack is at the front
+    std::vector<Candidate> queue;
+    int seq = 0;
+
+    // Required time of each endpoint less the clock-to-clock delay, so the slack of a path is this less its arrival
+    std::vector<delay_t> endpoint_required;
+    std::vector<int> endpoint_paths;
+    // All the paths still to be found have at most this slack, once prune has found enough candidates
+    delay_t slack_limit = std::numeric_limits<delay_t>::max();
+    auto push = [&](delay_t slack, int node, bool complete) {
+        int endpoint = nodes.at(node).endpoint;
+        if (slack > slack_limit || endpoint_paths.at(endpoint) >= per_endpoint)
+            return;
+        queue.push_back(Candidate{slack, seq++, node, complete});
+        std::push_heap(queue.begin(), queue.end(), std::greater<Candidate>());
+    };
+    pool<int> seen_endpoints;
+    for (auto &ep : capture.endpoints) {
+        if (!seen_endpoints.insert(ep.first).second)
+            continue;
+        auto pairs = port_domain_pairs[ep.first];
+        bool in_pair = std::any_of(pairs.begin(), pairs.end(),
+                                   [&](const PortDomainPairData &pdp) { return pdp.pair == domain_pair; });
+        delay_t arrival;
+        if (!in_pair || !max_arrival(ep.first, arrival))
+            continue;
+        auto req = find_time(port_required[ep.first], dp.key.capture);
+        endpoint_required.push_back(req->value.min_delay - clock_to_clock);
+        endpoint_paths.push_back(0);
+        nodes.push_back(PathNode{ep.first, -1, 0, int(endpoint_required.size()) - 1});
+        push(endpoint_required.back() - arrival, int(nodes.size()) - 1, false);
+    }
+
+    // With combinational loops the arrival times are no longer an exact bound, and paths have to be kept from going
+    // round a loop; the search is also cut off, as it could then take exponential time
+    auto on_path = [&](int node, int port) {
+        for (; node != -1; node = nodes.at(node).next)
+            if (nodes.at(node).port == port)
+                return true;
+        return false;
+    };
+    int64_t budget = have_loops ? 10000 * int64_t(count) + int64_t(nodes.size()) : -1;
+
+    auto extend = [&](int node, int fanin, delay_t arc_delay) {
+        delay_t arrival;
+        if (!max_arrival(fanin, arrival) || (have_loops && on_path(node, fanin)))
+            return;
+        PathNode next{fanin, node, nodes.at(node).delay + arc_delay, nodes.at(node).endpoint};
+        delay_t slack = endpoint_required.at(next.endpoint) - (arrival + next.delay);
+        if (slack > slack_limit)
+            return;
+        nodes.push_back(next);
+        push(slack, int(nodes.size()) - 1, false);
+    };
+
+    // Without combinational loops, each candidate on the queue stands for a different path with the candidate's
+    // slack: its worst completion. Once the best of them, taking no more from each endpoint than it may still report,
+    // make up the rest of the count, the paths still to be found all have at most the slack of the last of those. Any
+    // candidate with more is dropped, along with the nodes that only dropped candidates used; so the queue and `nodes`
+    // stay in proportion to the count, rather than to the number of near-critical paths.
+    std::vector<int> endpoint_taken(endpoint_required.size());
+    const size_t min_prune_size = std::max<size_t>(64, 4 * size_t(std::max(count, 0)));
+    size_t prune_size = min_prune_size;
+    auto prune = [&]() {
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [&](const Candidate &c) {
+                                       return endpoint_paths.at(nodes.at(c.node).endpoint) >= per_endpoint;
+                                   }),
+                    queue.end());
+        // In ascending order of slack, which is also a heap
+        std::sort(queue.begin(), queue.end(), [](const Candidate &a, const Candidate &b) { return b > a; });
+        int needed = count - int(worst_paths.size());
+        size_t keep = queue.size();
+        for (size_t i = 0; i < queue.size() && needed > 0; i++) {
+            int endpoint = nodes.at(queue.at(i).node).endpoint;
+            if (endpoint_paths.at(endpoint) + endpoint_taken.at(endpoint) >= per_endpoint)
+                continue;
+            ++endpoint_taken.at(endpoint);
+            if (--needed == 0) {
+                slack_limit = queue.at(i).slack;
+                keep = i + 1;
+                while (keep < queue.size() && queue.at(keep).slack <= slack_limit)
+                    ++keep;
+            }
+        }
+        for (auto &c : queue)
+            endpoint_taken.at(nodes.at(c.node).endpoint) = 0;
+        queue.resize(keep);
+
+        std::vector<int> new_index(nodes.size(), -1);
+        std::vector<PathNode> kept_nodes;
+        std::vector<int> chain;
+        for (auto &c : queue) {
+            for (int node = c.node; node != -1 && new_index.at(node) == -1; node = nodes.at(node).next)
+                chain.push_back(node);
+            // Nodes nearer the endpoint first, so that the new index of `next` is known
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                PathNode kept = nodes.at(*it);
+                if (kept.next != -1)
+                    kept.next = new_index.at(kept.next);
+                new_index.at(*it) = int(kept_nodes.size());
+                kept_nodes.push_back(kept);
+            }
+            chain.clear();
+            c.node = new_index.at(c.node);
+        }
+        nodes = std::move(kept_nodes);
+        prune_size = std::max(min_prune_size, 2 * nodes.size());
+    };
+
+    while (!queue.empty() && int(worst_paths.size()) < count && budget != 0) {
+        if (!have_loops && nodes.size() > prune_size) {
+            prune();
+            if (queue.empty())
+                break;
+        }
+        std::pop_heap(queue.begin(), queue.end(), std::greater<Candidate>());
+        Candidate cand = queue.back();
+        queue.pop_back();
+        if (budget > 0)
+            --budget;
+        PathNode node = nodes.at(cand.node);
+        if (endpoint_paths.at(node.endpoint) >= per_endpoint)
+            continue;
+        if (cand.complete) {
+            // The input ports of the path, from the endpoint back to the startpoint
+            std::vector<PortRef> path_rev;
+            for (int cursor = cand.node; cursor != -1; cursor = nodes.at(cursor).next) {
+                auto &pd = ports.at(nodes.at(cursor).port);
+                if (pd.type != PORT_IN)
+                    continue;
+                auto cell = cell_info(pd.cell_port);
+                int port_clocks;
+                auto port_class = ctx->getPortTimingClass(cell, pd.cell_port.port, port_clocks);
+                if (port_class != TMG_CLOCK_INPUT && port_class != TMG_IGNORE)
+                    path_rev.emplace_back(PortRef{cell, pd.cell_port.port});
+            }
+            std::reverse(path_rev.begin(), path_rev.end());
+            worst_paths.push_back(std::move(path_rev));
+            endpoint_paths.at(node.endpoint)++;
+            continue;
+        }
+        auto sp = start_arrival.find(node.port);
+        if (sp != start_arrival.end())
+            push(endpoint_required.at(node.endpoint) - (sp->second + node.delay), cand.node, true);
+        auto &pd = ports.at(node.port);
+        if (pd.type == PORT_IN) {
+            if (net_driver.at(node.port) != -1)
+                extend(cand.node, net_driver.at(node.port), pd.route_delay.max_delay);
+        } else {
+            for (auto &fanin : comb_fwd_rev[node.port])
+                extend(cand.node, fanin.port, fanin.delay.max_delay);
+        }
+    }
+    return worst_paths;
+}
+
+std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, int endpoint, bool longest_path)
 {
     const auto &dp = domain_pairs.at(domain_pair);
 
     // Walk the min or max path backwards to find a single crit path
     pool<std::pair<IdString, IdString>> visited;
     std::vector<PortRef> crit_path_rev;
-    auto cursor = endpoint;
+    int cursor = endpoint;
 
     bool is_startpoint = false;
     do {
-        auto cell = cell_info(cursor);
-        auto &port = port_info(cursor);
+        auto cell = cell_info(ports.at(cursor).cell_port);
+        auto &port = port_info(ports.at(cursor).cell_port);
         int port_clocks;
         auto portClass = ctx->getPortTimingClass(cell, port.name, port_clocks);
 
@@ -872,22 +1570,28 @@ std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, Cel
         if (is_input)
             crit_path_rev.emplace_back(PortRef{cell, port.name});
 
-        if (!ports.at(cursor).arrival.count(dp.key.launch))
+        auto arr = find_time(port_arrival[cursor], dp.key.launch);
+        if (arr == nullptr)
             break;
 
         if (longest_path) {
-            cursor = ports.at(cursor).arrival.at(dp.key.launch).bwd_max;
+            cursor = arr->bwd_max;
         } else {
-            cursor = ports.at(cursor).arrival.at(dp.key.launch).bwd_min;
+            cursor = arr->bwd_min;
         }
         is_startpoint = portClass == TMG_REGISTER_OUTPUT || portClass == TMG_STARTPOINT;
-    } while (!is_startpoint);
+    } while (!is_startpoint && cursor != -1);
 
     return crit_path_rev;
 }
 
-CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint,
-                                                        bool longest_path)
+CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, int endpoint, bool longest_path)
+{
+    return build_critical_path_report(domain_pair, walk_crit_path(domain_pair, endpoint, longest_path), longest_path);
+}
+
+CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair,
+                                                        const std::vector<PortRef> &crit_path_rev, bool longest_path)
 {
     CriticalPath report;
 
@@ -915,7 +1619,6 @@ CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair,
         }
     }
 
-    auto crit_path_rev = walk_crit_path(domain_pair, endpoint, longest_path);
     auto crit_path = boost::adaptors::reverse(crit_path_rev);
 
     // Get timing and clocking info on the startpoint
@@ -1090,6 +1793,21 @@ void TimingAnalyser::build_crit_path_reports()
         empty_clocks.insert(domains.at(i).key.clock);
     }
 
+    // Finding the worst endpoint of a domain pair, and building the report of its path, are independent between
+    // domain pairs and done in parallel; only picking the reported pairs is serial
+    std::vector<int> worst_endpoint(domain_pairs.size(), -1);
+    ctx->threadPool().parallel_for(int(domain_pairs.size()), [&](int i) {
+        auto worst_eps = get_worst_eps(i, 1);
+        if (!worst_eps.empty())
+            worst_endpoint.at(i) = worst_eps.front();
+    });
+
+    // Domain pair reported for each clock, and cross-domain pairs reported. The clocks are also kept in the order
+    // they were first reported in, which is the order clock_reports is filled in.
+    dict<IdString, int> clock_report_pair;
+    std::vector<IdString> report_clocks;
+    std::vector<int> xclock_report_pairs;
+
     for (int i = 0; i < int(domain_pairs.size()); i++) {
         auto &dp = domain_pairs.at(i);
         auto &launch = domains.at(dp.key.launch).key;
@@ -1112,14 +1830,15 @@ void TimingAnalyser::build_crit_path_reports()
             if (ctx->nets.at(launch.clock)->clkconstr)
                 target = 1000 / ctx->getDelayNS(ctx->nets.at(launch.clock)->clkconstr->period.minDelay());
 
-            auto worst_endpoint = get_worst_eps(i, 1);
-            if (worst_endpoint.empty())
+            if (worst_endpoint.at(i) == -1)
                 continue;
 
             clock_fmax[launch.clock].achieved = Fmax;
             clock_fmax[launch.clock].constraint = target;
 
-            clock_reports[launch.clock] = build_critical_path_report(i, worst_endpoint.at(0), true);
+            if (!clock_report_pair.count(launch.clock))
+                report_clocks.push_back(launch.clock);
+            clock_report_pair[launch.clock] = i;
 
             empty_clocks.erase(launch.clock);
         }
@@ -1133,13 +1852,27 @@ void TimingAnalyser::build_crit_path_reports()
         if (launch.clock == capture.clock && !launch.is_async())
             continue;
 
-        auto worst_endpoint = get_worst_eps(i, 1);
-        if (worst_endpoint.empty())
+        if (worst_endpoint.at(i) == -1)
             continue;
 
-        xclock_reports.emplace_back(build_critical_path_report(i, worst_endpoint.at(0), true));
+        xclock_report_pairs.push_back(i);
     }
 
+    std::vector<int> report_pairs;
+    for (auto clock : report_clocks)
+        report_pairs.push_back(clock_report_pair.at(clock));
+    report_pairs.insert(report_pairs.end(), xclock_report_pairs.begin(), xclock_report_pairs.end());
+    std::vector<CriticalPath> reports(report_pairs.size());
+    ctx->threadPool().parallel_for(int(report_pairs.size()), [&](int i) {
+        reports.at(i) = build_critical_path_report(report_pairs.at(i), worst_endpoint.at(report_pairs.at(i)), true);
+    });
+
+    size_t next_report = 0;
+    for (auto clock : report_clocks)
+        clock_reports[clock] = std::move(reports.at(next_report++));
+    while (next_report < reports.size())
+        xclock_reports.push_back(std::move(reports.at(next_report++)));
+
     auto cmp_crit_path = [&](const CriticalPath &ra, const CriticalPath &rb) {
         const auto &a = ra.clock_pair;
         const auto &b = rb.clock_pair;
@@ -1162,6 +1895,19 @@ void TimingAnalyser::build_crit_path_reports()
     };
 
     std::sort(xclock_reports.begin(), xclock_reports.end(), cmp_crit_path);
+
+    if (report_paths > 0) {
+        // Paths of each domain pair are enumerated in parallel, and then grouped in the same order as above
+        std::vector<std::vector<CriticalPath>> pair_paths(domain_pairs.size());
+        ctx->threadPool().parallel_for(int(domain_pairs.size()), [&](int i) {
+            for (auto &path : get_worst_paths(i, report_paths, std::max(1, report_paths_per_endpoint)))
+                pair_paths.at(i).push_back(build_critical_path_report(i, path, true));
+        });
+        for (auto &paths : pair_paths)
+            for (auto &path : paths)
+                result.worst_paths.push_back(std::move(path));
+        std::stable_sort(result.worst_paths.begin(), result.worst_paths.end(), cmp_crit_path);
+    }
 }
 
 void TimingAnalyser::build_slack_histogram_report()
@@ -1170,12 +1916,10 @@ void TimingAnalyser::build_slack_histogram_report()
 
     for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
         for (auto &ep : domains.at(dom_id).endpoints) {
-            auto &pd = ports.at(ep.first);
-
-            for (auto &req : pd.required) {
-                auto &capture = domains.at(req.first).key;
-                for (auto &arr : pd.arrival) {
-                    auto &launch = domains.at(arr.first).key;
+            for (auto &req : port_required[ep.first]) {
+                auto &capture = domains.at(req.domain).key;
+                for (auto &arr : port_arrival[ep.first]) {
+                    auto &launch = domains.at(arr.domain).key;
 
                     if (launch.clock != capture.clock || launch.is_async())
                         continue;
@@ -1187,7 +1931,7 @@ void TimingAnalyser::build_slack_histogram_report()
                     if (launch.edge != capture.edge)
                         clk_period = clk_period / 2;
 
-                    delay_t delay = arr.second.value.maxDelay() - req.second.value.minDelay();
+                    delay_t delay = arr.value.maxDelay() - req.value.minDelay();
                     delay_t slack = clk_period - delay;
 
                     int slack_ps = ctx->getDelayNS(slack) * 1000;
@@ -1200,24 +1944,25 @@ void TimingAnalyser::build_slack_histogram_report()
 
 std::vector<CriticalPath> TimingAnalyser::get_min_delay_violations()
 {
-    std::vector<CriticalPath> violations;
+    // Domain pair and endpoint of each violation
+    std::vector<std::pair<domain_id_t, int>> violating;
 
     for (domain_id_t capture_id = 0; capture_id < domain_id_t(domains.size()); ++capture_id) {
         const auto &capture = domains.at(capture_id);
         const auto &capture_clock = capture.key.clock;
 
         for (const auto &ep : capture.endpoints) {
-            const CellInfo *ci = cell_info(ep.first);
+            const CellPortKey &ep_key = ports.at(ep.first).cell_port;
+            const CellInfo *ci = cell_info(ep_key);
             int clkInfoCount = 0;
-            const TimingPortClass cls = ctx->getPortTimingClass(ci, ep.first.port, clkInfoCount);
+            const TimingPortClass cls = ctx->getPortTimingClass(ci, ep_key.port, clkInfoCount);
             if (cls != TMG_REGISTER_INPUT)
                 continue;
 
-            const auto &port = ports.at(ep.first);
-
-            const auto &req = port.required.at(capture_id);
+            const auto &req = *find_time(port_required[ep.first], capture_id);
 
-            for (auto &[launch_id, arr] : port.arrival) {
+            for (auto &arr : port_arrival[ep.first]) {
+                domain_id_t launch_id = arr.domain;
                 const auto &launch = domains.at(launch_id);
                 const auto &launch_clock = launch.key.clock;
                 const auto dom_pair_id = domain_pair_id(launch_id, capture_id);
@@ -1236,14 +1981,17 @@ std::vector<CriticalPath> TimingAnalyser::get_min_delay_violations()
 
                 auto hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
 
-                if (hold_slack <= 0) {
-                    auto report = build_critical_path_report(dom_pair_id, ep.first, false);
-                    violations.emplace_back(report);
-                }
+                if (hold_slack <= 0)
+                    violating.emplace_back(dom_pair_id, ep.first);
             }
         }
     }
 
+    std::vector<CriticalPath> violations(violating.size());
+    ctx->threadPool().parallel_for(int(violating.size()), [&](int i) {
+        violations.at(i) = build_critical_path_report(violating.at(i).first, violating.at(i).second, false);
+    });
+
     std::vector<std::pair<size_t, delay_t>> sum_indices;
     sum_indices.reserve(violations.size());
 
@@ -1294,11 +2042,16 @@ domain_id_t TimingAnalyser::domain_pair_id(domain_id_t launch, domain_id_t captu
     return inserted.first->second;
 }
 
-void TimingAnalyser::copy_domains(const CellPortKey &from, const CellPortKey &to, bool backward)
+void TimingAnalyser::copy_domains(std::vector<std::vector<domain_id_t>> &port_domains, int from, int to)
 {
-    auto &f = ports.at(from), &t = ports.at(to);
-    for (auto &dom : (backward ? f.required : f.arrival)) {
-        updated_domains |= (backward ? t.required : t.arrival).emplace(dom.first, ArrivReqTime{}).second;
+    if (from == to)
+        return;
+    auto &f = port_domains.at(from), &t = port_domains.at(to);
+    for (domain_id_t dom : reversed_range(f)) {
+        if (std::find(t.begin(), t.end(), dom) != t.end())
+            continue;
+        t.push_back(dom);
+        updated_domains = true;
     }
 }
 
@@ -1332,7 +2085,7 @@ void timing_analysis(Context *ctx, bool print_slack_histogram, bool print_fmax,
     TimingAnalyser tmg(ctx);
     tmg.setup_only = false;
     tmg.with_clock_skew = true;
-    tmg.setup(ctx->detailed_timing_report, print_slack_histogram, print_path || print_fmax);
+    tmg.setup(print_slack_histogram, print_path || print_fmax);
 
     auto &result = tmg.get_timing_result();
     ctx->log_timing_results(result, print_slack_histogram, print_fmax, print_path, warn_on_failure);
@@ -1341,4 +2094,39 @@ void timing_analysis(Context *ctx, bool print_slack_histogram, bool print_fmax,
         ctx->timing_result = result;
 }
 
+void timing_benchmark(Context *ctx, int iterations)
+{
+    TimingAnalyser tmg(ctx);
+    tmg.setup_only = false;
+    tmg.incremental = false;
+    tmg.setup();
+
+    std::vector<CellPortKey> keys;
+    for (auto &cell : ctx->cells)
+        for (auto &port : cell.second->ports)
+            keys.emplace_back(cell.second->name, port.first);
+
+    auto time_runs = [&](bool parallel, std::vector<float> &slacks) {
+        tmg.parallel = parallel;
+        auto startt = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++)
+            tmg.run(false);
+        auto endt = std::chrono::high_resolution_clock::now();
+        slacks.clear();
+        for (auto &key : keys) {
+            slacks.push_back(tmg.get_setup_slack(key));
+            slacks.push_back(tmg.get_criticality(key));
+        }
+        return std::chrono::duration<double>(endt - startt).count() * 1000.0 / iterations;
+    };
+
+    std::vector<float> serial_slacks, parallel_slacks;
+    double serial_ms = time_runs(false, serial_slacks);
+    double parallel_ms = time_runs(true, parallel_slacks);
+    log_info("Timing analysis of %d ports: %.02fms serial, %.02fms with %d threads (%.02fx)\n", int(keys.size()),
+             serial_ms, parallel_ms, ctx->threadPool().size(), serial_ms / parallel_ms);
+    if (serial_slacks != parallel_slacks)
+        log_error("Parallel timing analysis results differ from serial analysis.\n");
+}
+
 NEXTPNR_NAMESPACE_END
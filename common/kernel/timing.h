@@ -21,6 +21,8 @@
 #ifndef TIMING_H
 #define TIMING_H
 
+#include <functional>
+#include <iterator>
 #include "nextpnr.h"
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -76,21 +78,21 @@ struct TimingAnalyser
   public:
     TimingAnalyser(Context *ctx);
 
-    void setup(bool update_net_timings = false, bool update_histogram = false, bool update_crit_paths = false);
-    void run(bool update_route_delays = true, bool update_net_timings = false, bool update_histogram = false,
-             bool update_crit_paths = false);
+    void setup(bool update_histogram = false, bool update_crit_paths = false);
+    void run(bool update_route_delays = true, bool update_histogram = false, bool update_crit_paths = false);
 
     // This is used when routers etc are not actually binding detailed routing (due to congestion or an abstracted
-    // model), but want to re-run STA with their own calculated delays
-    void set_route_delay(CellPortKey port, DelayPair value);
+    // model), but want to re-run STA with their own calculated delays. Ports whose delay changed are re-analysed by the
+    // next incremental run.
+    void set_route_delay(CellPortKey port, DelayPair value) { set_route_delay(port_index(port), value); }
 
-    float get_criticality(CellPortKey port) const { return ports.at(port).worst_crit; }
-    float get_setup_slack(CellPortKey port) const { return ports.at(port).worst_setup_slack; }
+    float get_criticality(CellPortKey port) const { return ports.at(port_index(port)).worst_crit; }
+    float get_setup_slack(CellPortKey port) const { return ports.at(port_index(port)).worst_setup_slack; }
     float get_domain_setup_slack(CellPortKey port) const
     {
         delay_t slack = std::numeric_limits<delay_t>::max();
-        for (const auto &dp : ports.at(port).domain_pairs)
-            slack = std::min(slack, domain_pairs.at(dp.first).worst_setup_slack);
+        for (const auto &dp : port_domain_pairs[port_index(port)])
+            slack = std::min(slack, domain_pairs.at(dp.pair).worst_setup_slack);
         return slack;
     }
 
@@ -98,6 +100,17 @@ struct TimingAnalyser
 
     TimingResult &get_timing_result() { return result; }
 
+    // Nets with sinks that are timing endpoints, for get_net_sink_timings
+    std::vector<IdString> get_detailed_timing_nets();
+    // Timing of the arcs to those sinks of a net, for every pair of launch and capture domain. Once the list of nets
+    // has been built, this can be called for different nets in parallel.
+    void get_net_sink_timings(IdString net, std::vector<NetSinkTiming> &sinks) const;
+    // Pass the sink timings of all the nets of get_detailed_timing_nets to `write`, batch_size nets at a time and in
+    // the order of that list. Each batch is built in parallel, and only one batch is held at a time.
+    void stream_detailed_net_timings(
+            int batch_size,
+            std::function<void(const std::vector<std::pair<IdString, std::vector<NetSinkTiming>>> &)> write);
+
     // Enable analysis of clock skew between FFs.
     bool with_clock_skew = false;
 
@@ -105,30 +118,70 @@ struct TimingAnalyser
     bool have_loops = false;
     bool updated_domains = false;
 
+    // Only propagate arrival and required time changes through the fan-out/fan-in cones of ports whose route delay
+    // changed since the last run (timing/incremental)
+    bool incremental = true;
+    // Check the result of every incremental run against a full analysis (timing/verifyIncremental)
+    bool verify_incremental = false;
+    // Spread full runs over the context thread pool, one topological level at a time. Results are identical to a
+    // serial run; this only takes effect with more than one thread.
+    bool parallel = true;
+
+    // Number of worst setup paths of each domain pair to report along with the critical paths, and at most how many
+    // of those may end at the same endpoint (timing/reportPaths, timing/reportPathsPerEndpoint)
+    int report_paths = 0;
+    int report_paths_per_endpoint = 1;
+
   private:
     void init_ports();
     void get_cell_delays();
     void get_route_delays();
     void topo_sort();
+    void build_graph();
     void setup_port_domains();
     void identify_related_domains();
 
+    void set_route_delay(int port, DelayPair value);
+
     void reset_times();
 
     void walk_forward();
     void walk_backward();
+    bool use_levels() const;
+    void walk_forward_levels();
+    void walk_backward_levels();
+    void build_levels();
 
     void compute_slack();
     void compute_criticality();
+    void compute_domain_pair_slack();
+    void compute_port_slack(int port);
+    void compute_port_criticality(int port);
+
+    // Incremental analysis, starting from the ports in dirty_ports
+    bool can_run_incremental() const;
+    void run_incremental();
+    void verify_incremental_run();
+    // Recompute the arrival/required times of a single port from its fan-in/fan-out; returning true if they changed
+    bool update_arrival(int port);
+    bool update_required(int port);
+    // Apply the contributions of the fan-in (arrival) or fan-out (required) of a port to its times; the fan-in/fan-out
+    // must already be final
+    void pull_arrival(int port);
+    void pull_required(int port);
+    // Initial arrival/required times of startpoints and endpoints; also setting the index of the clock port
+    DelayPair startpoint_arrival(int port, IdString clock_port, int &clock_idx);
+    DelayPair endpoint_required(int port, IdString clock_port, int &clock_idx);
 
     // Walk the endpoint back to a startpoint and get back the input ports walked
     // and the startpoint.
-    std::vector<PortRef> walk_crit_path(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path);
+    std::vector<PortRef> walk_crit_path(domain_id_t domain_pair, int endpoint, bool longest_path);
 
-    void build_detailed_net_timing_report();
     // longest_path indicate whether to follow the longest or shortest path from endpoint to startpoint
     // longest paths are interesting for setup violations and shortest paths are interesting for hold violations
-    CriticalPath build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path);
+    CriticalPath build_critical_path_report(domain_id_t domain_pair, int endpoint, bool longest_path);
+    CriticalPath build_critical_path_report(domain_id_t domain_pair, const std::vector<PortRef> &crit_path_rev,
+                                            bool longest_path);
     void build_crit_path_reports();
     void build_slack_histogram_report();
 
@@ -137,27 +190,33 @@ struct TimingAnalyser
     dict<domain_id_t, delay_t> max_delay_by_domain_pairs();
 
     // get the N worst endpoints for a given domain pair
-    std::vector<CellPortKey> get_worst_eps(domain_id_t domain_pair, int count);
+    std::vector<int> get_worst_eps(domain_id_t domain_pair, int count);
+
+    // Enumerate the N worst setup paths of a domain pair in order of slack, with at most `per_endpoint` of them
+    // ending at the same endpoint. Paths are returned in the same form as walk_crit_path.
+    std::vector<std::vector<PortRef>> get_worst_paths(domain_id_t domain_pair, int count, int per_endpoint);
 
     // Set arrival/required times if more/less than the current value
-    void set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                          CellPortKey prev = CellPortKey());
-    void set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                           CellPortKey prev = CellPortKey());
+    void set_arrival_time(int target, domain_id_t domain, DelayPair arrival, int path_length, int prev = -1);
+    void set_required_time(int target, domain_id_t domain, DelayPair required, int path_length, int prev = -1);
 
     // To avoid storing the domain tag structure (which could get large when considering more complex constrained tag
     // cases), assign each domain an ID and use that instead
-    // An arrival or required time entry. Stores both the min/max delays; and the traversal to reach them for critical
-    // path reporting
+    // An arrival or required time entry. Stores both the min/max delays; and the traversal to reach them (as port
+    // indices, or -1) for critical path reporting
     struct ArrivReqTime
     {
+        explicit ArrivReqTime(domain_id_t domain) : domain(domain) {};
+        domain_id_t domain;
         DelayPair value;
-        CellPortKey bwd_min, bwd_max;
-        int path_length;
+        int bwd_min = -1, bwd_max = -1;
+        int path_length = 0;
     };
     // Data per port-domain tuple
     struct PortDomainPairData
     {
+        explicit PortDomainPairData(domain_id_t pair) : pair(pair) {};
+        domain_id_t pair;
         delay_t setup_slack = std::numeric_limits<delay_t>::max(), hold_slack = std::numeric_limits<delay_t>::max();
         int max_path_length = 0;
         float criticality = 0;
@@ -181,6 +240,8 @@ struct TimingAnalyser
         DelayQuad value;
         // Clock polarity, not used for combinational arcs
         ClockEdge edge;
+        // Index of other_port, or -1 for startpoint/endpoint arcs
+        int other_port_idx = -1;
 
         CellArc(ArcType type, IdString other_port, DelayQuad value)
                 : type(type), other_port(other_port), value(value), edge(RISING_EDGE) {};
@@ -193,10 +254,6 @@ struct TimingAnalyser
     {
         CellPortKey cell_port;
         PortType type;
-        // per domain timings
-        dict<domain_id_t, ArrivReqTime> arrival;
-        dict<domain_id_t, ArrivReqTime> required;
-        dict<domain_id_t, PortDomainPairData> domain_pairs;
         // cell timing arcs to (outputs)/from (inputs)  from this port
         std::vector<CellArc> cell_arcs;
         // routing delay into this port (input ports only)
@@ -205,14 +262,63 @@ struct TimingAnalyser
         float worst_crit = 0;
         delay_t worst_setup_slack = std::numeric_limits<delay_t>::max(),
                 worst_hold_slack = std::numeric_limits<delay_t>::max();
+        int topo_index = -1;
+        // incremental analysis state
+        bool dirty = false, queued = false, changed = false;
+    };
+
+    // A contiguous range of items belonging to one port
+    template <typename T> struct PortSlice
+    {
+        T *b, *e;
+        T *begin() const { return b; }
+        T *end() const { return e; }
+        std::reverse_iterator<T *> rbegin() const { return std::reverse_iterator<T *>(e); }
+        std::reverse_iterator<T *> rend() const { return std::reverse_iterator<T *>(b); }
+        int size() const { return int(e - b); }
+        T &operator[](int i) const { return b[i]; }
+    };
+
+    // Compressed sparse row storage of a list of items for every port
+    template <typename T> struct PortLists
+    {
+        std::vector<int> start{0};
+        std::vector<T> items;
+
+        PortSlice<T> operator[](int port)
+        {
+            return PortSlice<T>{items.data() + start.at(port), items.data() + start.at(port + 1)};
+        }
+        PortSlice<const T> operator[](int port) const
+        {
+            return PortSlice<const T>{items.data() + start.at(port), items.data() + start.at(port + 1)};
+        }
+        int size() const { return int(start.size()) - 1; }
+        void assign(const std::vector<std::vector<T>> &lists)
+        {
+            start.clear();
+            items.clear();
+            start.push_back(0);
+            for (auto &list : lists) {
+                items.insert(items.end(), list.begin(), list.end());
+                start.push_back(int(items.size()));
+            }
+        }
+    };
+
+    // A combinational arc through a cell in the compiled timing graph
+    struct CombArc
+    {
+        int port;
+        DelayPair delay;
     };
 
     struct PerDomain
     {
         PerDomain(ClockDomainKey key) : key(key) {};
         ClockDomainKey key;
-        // these are pairs (signal port; clock port)
-        std::vector<std::pair<CellPortKey, IdString>> startpoints, endpoints;
+        // these are pairs (signal port index; clock port)
+        std::vector<std::pair<int, IdString>> startpoints, endpoints;
     };
 
     struct PerDomainPair
@@ -225,23 +331,63 @@ struct TimingAnalyser
 
     CellInfo *cell_info(const CellPortKey &key);
     PortInfo &port_info(const CellPortKey &key);
+    int port_index(const CellPortKey &key) const { return port_to_idx.at(key); }
 
     domain_id_t domain_id(IdString cell, IdString clock_port, ClockEdge edge);
     domain_id_t domain_id(const NetInfo *net, ClockEdge edge);
     domain_id_t domain_pair_id(domain_id_t launch, domain_id_t capture);
 
-    void copy_domains(const CellPortKey &from, const CellPortKey &to, bool backwards);
+    void copy_domains(std::vector<std::vector<domain_id_t>> &port_domains, int from, int to);
+
+    // Find the arrival/required time entry of a port for a domain; or nullptr if the port isn't in that domain
+    template <typename T> static T *find_time(PortSlice<T> times, domain_id_t domain)
+    {
+        for (auto &t : times)
+            if (t.domain == domain)
+                return &t;
+        return nullptr;
+    }
 
     [[maybe_unused]] static const std::string arcType_to_str(CellArc::ArcType typ);
 
-    dict<CellPortKey, PerPort> ports;
+    // Ports are identified by their dense index into `ports`; and the rest of the timing graph and the per-domain
+    // timing data is stored in flat arrays indexed the same way, so the analysis is linear scans over contiguous
+    // memory instead of hash lookups per edge.
+    std::vector<PerPort> ports;
+    dict<CellPortKey, int> port_to_idx;
+
+    // Routing arcs: the driving output port of every other port (or -1), and the users of every output port; sorted
+    // in topological order
+    std::vector<int> net_driver;
+    PortLists<int> net_users;
+    // Combinational arcs. Input port cell arcs are used going forward and output port cell arcs going backward, as
+    // they may differ. The reverse lists are used to recompute a single port from its fan-in/fan-out in incremental
+    // analysis, and are sorted in topological order.
+    PortLists<CombArc> comb_fwd, comb_fwd_rev;
+    PortLists<CombArc> comb_bwd, comb_bwd_rev;
+
+    // Per domain arrival and required times, and per domain pair data, for every port
+    PortLists<ArrivReqTime> port_arrival, port_required;
+    PortLists<PortDomainPairData> port_domain_pairs;
+
     dict<ClockDomainKey, domain_id_t> domain_to_id;
     dict<ClockDomainPairKey, domain_id_t> pair_to_id;
     std::vector<PerDomain> domains;
     std::vector<PerDomainPair> domain_pairs;
     dict<std::pair<IdString, IdString>, delay_t> clock_delays;
 
-    std::vector<CellPortKey> topological_order;
+    // Endpoint ports of each net, for detailed per-net timing
+    dict<IdString, std::vector<int>> net_endpoints;
+
+    std::vector<int> topological_order;
+    // Ports grouped by the longest path from a startpoint to them (forward) and from them to an endpoint (backward).
+    // A port only depends on ports in earlier levels, so all ports in a level can be processed at once.
+    PortLists<int> fwd_levels, bwd_levels;
+
+    // Ports with a changed route delay since the last run
+    std::vector<int> dirty_ports;
+    // Whether the stored times are the result of a complete run, so an incremental run can start from them
+    bool times_valid = false;
 
     domain_id_t async_clock_id;
 
@@ -254,6 +400,9 @@ struct TimingAnalyser
 void timing_analysis(Context *ctx, bool slack_histogram = true, bool print_fmax = true, bool print_path = false,
                      bool warn_on_failure = false, bool update_results = false);
 
+// Time repeated full timing analysis runs of the current design, serially and level-parallel
+void timing_benchmark(Context *ctx, int iterations);
+
 NEXTPNR_NAMESPACE_END
 
 #endif
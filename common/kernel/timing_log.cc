@@ -40,7 +40,7 @@ static std::string clock_event_name(const Context *ctx, const ClockEvent &e, int
 
 static void log_crit_paths(const Context *ctx, TimingResult &result)
 {
-    static auto print_net_source = [ctx](const NetInfo *net) {
+    auto print_net_source = [ctx](const NetInfo *net) {
         // Check if this net is annotated with a source list
         auto sources = net->attrs.find(ctx->id("src"));
         if (sources == net->attrs.end()) {
@@ -68,7 +68,7 @@ static void log_crit_paths(const Context *ctx, TimingResult &result)
     };
 
     // A helper function for reporting one critical path
-    auto print_path_report = [ctx](const CriticalPath &path) {
+    auto print_path_report = [ctx, &print_net_source](const CriticalPath &path) {
         delay_t total(0), logic_total(0), route_total(0);
 
         log_info("      type curr  total name\n");
@@ -170,6 +170,36 @@ static void log_crit_paths(const Context *ctx, TimingResult &result)
         print_path_report(report);
     }
 
+    // Worst paths of each domain pair, one line each
+    for (size_t i = 0; i < result.worst_paths.size(); i++) {
+        auto &report = result.worst_paths.at(i);
+        if (i == 0 || !(report.clock_pair == result.worst_paths.at(i - 1).clock_pair)) {
+            log_break();
+            std::string start = clock_event_name(ctx, report.clock_pair.start);
+            std::string end = clock_event_name(ctx, report.clock_pair.end);
+            log_info("Worst paths for '%s' -> '%s':\n", start.c_str(), end.c_str());
+            log_info("     slack levels from -> to\n");
+        }
+        delay_t total = 0;
+        int levels = 0;
+        const CriticalPath::Segment *first = nullptr, *last = nullptr;
+        for (const auto &segment : report.segments) {
+            total += segment.delay;
+            if (segment.type == CriticalPath::Segment::Type::LOGIC)
+                levels++;
+            if (first == nullptr && (segment.type == CriticalPath::Segment::Type::CLK_TO_Q ||
+                                     segment.type == CriticalPath::Segment::Type::SOURCE))
+                first = &segment;
+            if (segment.type == CriticalPath::Segment::Type::ROUTING)
+                last = &segment;
+        }
+        if (first == nullptr || last == nullptr)
+            continue;
+        log_info("%10.2f %6d %s.%s -> %s.%s\n", ctx->getDelayNS(report.max_delay - total), levels,
+                 first->to.first.c_str(ctx), first->to.second.c_str(ctx), last->to.first.c_str(ctx),
+                 last->to.second.c_str(ctx));
+    }
+
     // Min delay violated paths
     // Show maximum of 10
     auto num_min_violations = result.min_delay_violations.size();
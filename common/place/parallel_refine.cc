@@ -29,7 +29,6 @@
 #include <mutex>
 #include <queue>
 #include <shared_mutex>
-#include <thread>
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -438,13 +437,7 @@ struct ParallelRefine
         }
 
         NPNR_ASSERT(parts.size() == t.size());
-        // TODO: thread pool to make this worthwhile...
-        std::vector<std::thread> workers;
-        for (size_t i = 0; i < t.size(); i++) {
-            workers.emplace_back([i, this]() { t.at(i).set_partition(parts.at(i)); });
-        }
-        for (auto &w : workers)
-            w.join();
+        ctx->threadPool().parallel_for(int(t.size()), [this](int i) { t.at(i).set_partition(parts.at(i)); });
     }
 
     void run()
@@ -498,12 +491,7 @@ struct ParallelRefine
 
             do_partition();
 
-            std::vector<std::thread> workers;
-            workers.reserve(t.size());
-            for (int j = 0; j < int(t.size()); j++)
-                workers.emplace_back([this, j]() { t.at(j).run_iter(); });
-            for (auto &w : workers)
-                w.join();
+            ctx->threadPool().parallel_for(int(t.size()), [this](int j) { t.at(j).run_iter(); });
             g.tmg.run();
             g.update_global_costs();
             iter++;
@@ -517,7 +505,7 @@ struct ParallelRefine
 
 ParallelRefineCfg::ParallelRefineCfg(Context *ctx) : DetailPlaceCfg(ctx)
 {
-    threads = ctx->setting<int>("threads", 8);
+    threads = ctx->threads();
     // snap to nearest power of two; and minimum thread size
     int actual_threads = 1;
     while ((actual_threads * 2) <= threads && (int(ctx->cells.size()) / (actual_threads * 2)) >= min_thread_size)
@@ -528,6 +516,7 @@ ParallelRefineCfg::ParallelRefineCfg(Context *ctx) : DetailPlaceCfg(ctx)
 bool parallel_refine(Context *ctx, ParallelRefineCfg cfg)
 {
     // TODO
+    ProfileScope profile(ctx->profiler, "refine");
     ParallelRefine refine(ctx, cfg);
     refine.run();
     timing_analysis(ctx);
@@ -1245,6 +1245,7 @@ Placer1Cfg::Placer1Cfg(Context *ctx)
 
 bool placer1(Context *ctx, Placer1Cfg cfg)
 {
+    ProfileScope profile(ctx->profiler, "sa");
     try {
         SAPlacer placer(ctx, cfg);
         placer.place();
@@ -1267,6 +1268,7 @@ bool placer1(Context *ctx, Placer1Cfg cfg)
 
 bool placer1_refine(Context *ctx, Placer1Cfg cfg)
 {
+    ProfileScope profile(ctx->profiler, "refine");
     try {
         SAPlacer placer(ctx, cfg);
         placer.place(true);
@@ -32,10 +32,9 @@
  */
 
 #include "placer_heap.h"
-#include <Eigen/Core>
-#include <Eigen/IterativeLinearSolvers>
 #include <boost/optional.hpp>
 #include <chrono>
+#include <cmath>
 #include <deque>
 #include <fstream>
 #include <numeric>
@@ -69,10 +68,15 @@ template <typename T> struct EquationSystem
     // Simple sparse format, easy to convert to CCS for solver
     std::vector<std::vector<std::pair<int, T>>> A; // col -> (row, x[row, col]) sorted by row
     std::vector<T> rhs;                            // RHS vector
+    // Set when add_coeff creates an entry outside the current sparsity pattern
+    bool pattern_changed = true;
     void reset()
     {
+        // Connectivity changes little between iterations, so keep the sparsity pattern and only clear the values; then
+        // the compiled matrix and preconditioner structure can be reused when the next system is solved
         for (auto &col : A)
-            col.clear();
+            for (auto &el : col)
+                el.second = T();
         std::fill(rhs.begin(), rhs.end(), T());
     }
 
@@ -93,42 +97,192 @@ template <typename T> struct EquationSystem
                 b = i + 1;
         }
         Ac.insert(Ac.begin() + b, std::make_pair(row, val));
+        pattern_changed = true;
     }
 
     void add_rhs(int row, T val) { rhs[row] += val; }
 
-    void solve(std::vector<T> &x, float tolerance)
+    // Compiled CCS matrix; as the matrix is symmetric, column i is also row i
+    std::vector<int> col_start, row_idx;
+    std::vector<T> values;
+    // Incomplete Cholesky factor L (with the sparsity pattern of the lower triangle of A), stored by row; diag_idx is
+    // the index of the diagonal entry, which is the last of each row
+    std::vector<int> lower_start, lower_col, lower_src, diag_idx;
+    std::vector<T> lower;
+    // Jacobi preconditioner
+    std::vector<T> inv_diag;
+
+    void compile()
+    {
+        int N = int(A.size());
+        if (pattern_changed) {
+            col_start.assign(1, 0);
+            row_idx.clear();
+            lower_start.assign(1, 0);
+            lower_col.clear();
+            lower_src.clear();
+            diag_idx.assign(N, -1);
+            for (int col = 0; col < N; col++) {
+                for (auto &el : A.at(col)) {
+                    // By symmetry, row `col` of the lower triangle is the upper part of column `col`
+                    if (el.first <= col) {
+                        if (el.first == col)
+                            diag_idx.at(col) = int(lower_col.size());
+                        lower_col.push_back(el.first);
+                        lower_src.push_back(int(row_idx.size()));
+                    }
+                    row_idx.push_back(el.first);
+                }
+                col_start.push_back(int(row_idx.size()));
+                lower_start.push_back(int(lower_col.size()));
+            }
+            values.resize(row_idx.size());
+            lower.resize(lower_col.size());
+            pattern_changed = false;
+        }
+        int i = 0;
+        for (auto &Ac : A)
+            for (auto &el : Ac)
+                values.at(i++) = el.second;
+    }
+
+    // y = A * x
+    void multiply(ThreadPool &pool, const std::vector<T> &x, std::vector<T> &y) const
+    {
+        pool.parallel_for(
+                int(x.size()),
+                [&](int col) {
+                    T sum = T();
+                    for (int i = col_start[col]; i < col_start[col + 1]; i++)
+                        sum += values[i] * x[row_idx[i]];
+                    y[col] = sum;
+                },
+                dot_block);
+    }
+
+    // Sums are accumulated in fixed blocks and then added in order, so the result doesn't depend on the thread count
+    static constexpr int dot_block = 4096;
+    T dot(ThreadPool &pool, const std::vector<T> &a, const std::vector<T> &b) const
+    {
+        int N = int(a.size());
+        std::vector<T> partial((N + dot_block - 1) / dot_block);
+        pool.parallel_for(int(partial.size()), [&](int blk) {
+            T sum = T();
+            for (int i = blk * dot_block; i < std::min(N, (blk + 1) * dot_block); i++)
+                sum += a[i] * b[i];
+            partial[blk] = sum;
+        });
+        return std::accumulate(partial.begin(), partial.end(), T());
+    }
+
+    // Compute the incomplete Cholesky factorisation with zero fill-in, IC(0); returns false if it broke down
+    bool factorise_ichol()
+    {
+        int N = int(A.size());
+        for (int row = 0; row < N; row++) {
+            if (diag_idx.at(row) == -1)
+                return false;
+            T diag_sum = T();
+            for (int i = lower_start[row]; i < diag_idx[row]; i++) {
+                // L[row][col] = (A[row][col] - sum_k<col L[row][k] * L[col][k]) / L[col][col]
+                int col = lower_col[i];
+                T sum = values[lower_src[i]];
+                int a = lower_start[row], b = lower_start[col];
+                while (a < i && b < diag_idx[col]) {
+                    if (lower_col[a] == lower_col[b])
+                        sum -= lower[a++] * lower[b++];
+                    else if (lower_col[a] < lower_col[b])
+                        a++;
+                    else
+                        b++;
+                }
+                lower[i] = sum / lower[diag_idx[col]];
+                diag_sum += lower[i] * lower[i];
+            }
+            T d = values[lower_src[diag_idx[row]]] - diag_sum;
+            if (!(d > T()))
+                return false;
+            lower[diag_idx[row]] = std::sqrt(d);
+        }
+        return true;
+    }
+
+    // z = (L * L^T)^-1 * r
+    void apply_ichol(const std::vector<T> &r, std::vector<T> &z) const
+    {
+        int N = int(r.size());
+        for (int row = 0; row < N; row++) {
+            T sum = r[row];
+            for (int i = lower_start[row]; i < diag_idx[row]; i++)
+                sum -= lower[i] * z[lower_col[i]];
+            z[row] = sum / lower[diag_idx[row]];
+        }
+        for (int row = N - 1; row >= 0; row--) {
+            z[row] /= lower[diag_idx[row]];
+            for (int i = lower_start[row]; i < diag_idx[row]; i++)
+                z[lower_col[i]] -= lower[i] * z[row];
+        }
+    }
+
+    // Preconditioned conjugate gradient, following Eigen's ConjugateGradient which this replaces. The matrix
+    // products, dot products and vector updates are spread over the thread pool; the incomplete Cholesky triangular
+    // solves are serial, so that preconditioner mostly pays off when it saves many iterations.
+    void solve(std::vector<T> &x, float tolerance, ThreadPool &pool, PlacerHeapCfg::Preconditioner precond)
     {
-        using namespace Eigen;
         if (x.empty())
             return;
         NPNR_ASSERT(x.size() == A.size());
+        int N = int(x.size());
+        compile();
+
+        bool use_ichol = (precond == PlacerHeapCfg::Preconditioner::IncompleteCholesky) && factorise_ichol();
+        if (!use_ichol) {
+            inv_diag.assign(N, T(1));
+            for (int col = 0; col < N; col++)
+                for (int i = col_start[col]; i < col_start[col + 1]; i++)
+                    if (row_idx[i] == col && values[i] != T())
+                        inv_diag[col] = T(1) / values[i];
+        }
+        auto precondition = [&](const std::vector<T> &r, std::vector<T> &z) {
+            if (use_ichol)
+                apply_ichol(r, z);
+            else
+                pool.parallel_for(N, [&](int i) { z[i] = inv_diag[i] * r[i]; }, dot_block);
+        };
+        auto vector_op = [&](auto func) { pool.parallel_for(N, func, dot_block); };
 
-        VectorXd vx(x.size()), vb(rhs.size());
-        SparseMatrix<T> mat(A.size(), A.size());
+        std::vector<T> r(N), z(N), p(N), tmp(N);
+        multiply(pool, x, tmp);
+        vector_op([&](int i) { r[i] = rhs[i] - tmp[i]; });
 
-        std::vector<int> colnnz;
-        for (auto &Ac : A)
-            colnnz.push_back(int(Ac.size()));
-        mat.reserve(colnnz);
-        for (int col = 0; col < int(A.size()); col++) {
-            auto &Ac = A.at(col);
-            for (auto &el : Ac)
-                mat.insert(el.first, col) = el.second;
+        T rhs_norm2 = dot(pool, rhs, rhs);
+        if (rhs_norm2 == T()) {
+            std::fill(x.begin(), x.end(), T());
+            return;
         }
+        T threshold = std::max<T>(T(tolerance) * T(tolerance) * rhs_norm2, std::numeric_limits<T>::min());
+        T residual_norm2 = dot(pool, r, r);
+        if (residual_norm2 < threshold)
+            return;
 
-        for (int i = 0; i < int(x.size()); i++)
-            vx[i] = x.at(i);
-        for (int i = 0; i < int(rhs.size()); i++)
-            vb[i] = rhs.at(i);
-
-        ConjugateGradient<SparseMatrix<T>, Lower | Upper> solver;
-        solver.setTolerance(tolerance);
-        VectorXd xr = solver.compute(mat).solveWithGuess(vb, vx);
-        for (int i = 0; i < int(x.size()); i++)
-            x.at(i) = xr[i];
-        // for (int i = 0; i < int(x.size()); i++)
-        //    log_info("x[%d] = %f\n", i, x.at(i));
+        precondition(r, p);
+        T abs_new = dot(pool, r, p);
+        for (int iter = 0; iter < 2 * N; iter++) {
+            multiply(pool, p, tmp);
+            T alpha = abs_new / dot(pool, p, tmp);
+            vector_op([&](int i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * tmp[i];
+            });
+            residual_norm2 = dot(pool, r, r);
+            if (residual_norm2 < threshold)
+                break;
+            precondition(r, z);
+            T abs_old = abs_new;
+            abs_new = dot(pool, r, z);
+            T beta = abs_new / abs_old;
+            vector_op([&](int i) { p[i] = z[i] + beta * p[i]; });
+        }
     }
 };
 
@@ -140,7 +294,6 @@ class HeAPPlacer
     HeAPPlacer(Context *ctx, PlacerHeapCfg cfg)
             : ctx(ctx), cfg(cfg), fast_bels(ctx, /*check_bel_available=*/true, -1), tmg(ctx)
     {
-        Eigen::initParallel();
         tmg.setup_only = true;
         tmg.setup();
 
@@ -164,14 +317,13 @@ class HeAPPlacer
         for (int i = 0; i < 4; i++) {
             setup_solve_cells();
             auto solve_startt = std::chrono::high_resolution_clock::now();
-#ifdef NPNR_DISABLE_THREADS
-            build_solve_direction(false, -1);
-            build_solve_direction(true, -1);
-#else
-            boost::thread xaxis([&]() { build_solve_direction(false, -1); });
-            build_solve_direction(true, -1);
-            xaxis.join();
-#endif
+            {
+                ProfileScope profile(ctx->profiler, "solve");
+                TaskGroup xaxis(ctx->threadPool());
+                xaxis.run([&]() { build_solve_direction(false, -1); });
+                build_solve_direction(true, -1);
+                xaxis.wait();
+            }
             auto solve_endt = std::chrono::high_resolution_clock::now();
             solve_time += std::chrono::duration<double>(solve_endt - solve_startt).count();
 
@@ -233,16 +385,17 @@ class HeAPPlacer
                 auto solve_startt = std::chrono::high_resolution_clock::now();
 
                 // Build the connectivity matrix and run the solver; multithreaded between x and y axes if applicable
-#ifndef NPNR_DISABLE_THREADS
-                if (solve_cells.size() >= 500) {
-                    boost::thread xaxis([&]() { build_solve_direction(false, (iter == 0) ? -1 : iter); });
-                    build_solve_direction(true, (iter == 0) ? -1 : iter);
-                    xaxis.join();
-                } else
-#endif
                 {
-                    build_solve_direction(false, (iter == 0) ? -1 : iter);
-                    build_solve_direction(true, (iter == 0) ? -1 : iter);
+                    ProfileScope profile(ctx->profiler, "solve");
+                    if (solve_cells.size() >= 500) {
+                        TaskGroup xaxis(ctx->threadPool());
+                        xaxis.run([&]() { build_solve_direction(false, (iter == 0) ? -1 : iter); });
+                        build_solve_direction(true, (iter == 0) ? -1 : iter);
+                        xaxis.wait();
+                    } else {
+                        build_solve_direction(false, (iter == 0) ? -1 : iter);
+                        build_solve_direction(true, (iter == 0) ? -1 : iter);
+                    }
                 }
                 auto solve_endt = std::chrono::high_resolution_clock::now();
                 solve_time += std::chrono::duration<double>(solve_endt - solve_startt).count();
@@ -252,13 +405,16 @@ class HeAPPlacer
                 update_all_chains();
 
                 // Run the spreader
-                for (const auto &group : cfg.cellGroups)
-                    CutSpreader(this, group).run();
-
-                for (auto type : run)
-                    if (std::all_of(cfg.cellGroups.begin(), cfg.cellGroups.end(),
-                                    [type](const pool<BelBucketId> &grp) { return !grp.count(type); }))
-                        CutSpreader(this, {type}).run();
+                {
+                    ProfileScope profile(ctx->profiler, "spread");
+                    for (const auto &group : cfg.cellGroups)
+                        CutSpreader(this, group).run();
+
+                    for (auto type : run)
+                        if (std::all_of(cfg.cellGroups.begin(), cfg.cellGroups.end(),
+                                        [type](const pool<BelBucketId> &grp) { return !grp.count(type); }))
+                            CutSpreader(this, {type}).run();
+                }
 
                 // Run strict legalisation to find a valid bel for all cells
                 update_all_chains();
@@ -523,8 +679,9 @@ class HeAPPlacer
     // Build and solve in one direction
     void build_solve_direction(bool yaxis, int iter)
     {
+        // The same system is reused between iterations so that its sparsity pattern carries over
+        EquationSystem<double> esx(solve_cells.size(), solve_cells.size());
         for (int i = 0; i < 5; i++) {
-            EquationSystem<double> esx(solve_cells.size(), solve_cells.size());
             build_equations(esx, yaxis, iter);
             solve_equations(esx, yaxis);
         }
@@ -803,7 +960,7 @@ class HeAPPlacer
         auto cell_pos = [&](CellInfo *cell) { return yaxis ? cell_locs.at(cell->name).y : cell_locs.at(cell->name).x; };
         std::vector<double> vals;
         std::transform(solve_cells.begin(), solve_cells.end(), std::back_inserter(vals), cell_pos);
-        es.solve(vals, cfg.solverTolerance);
+        es.solve(vals, cfg.solverTolerance, ctx->threadPool(), cfg.solverPreconditioner);
         for (size_t i = 0; i < vals.size(); i++)
             if (yaxis) {
                 cell_locs.at(solve_cells.at(i)->name).rawy = vals.at(i);
@@ -847,6 +1004,7 @@ class HeAPPlacer
     // Strict placement legalisation, performed after the initial HeAP spreading
     void legalise_placement_strict(bool require_validity = false)
     {
+        ProfileScope profile(ctx->profiler, "legalise");
         auto startt = std::chrono::high_resolution_clock::now();
 
         // Unbind all cells placed in this solution
@@ -1827,7 +1985,11 @@ class HeAPPlacer
 };
 int HeAPPlacer::CutSpreader::seq = 0;
 
-bool placer_heap(Context *ctx, PlacerHeapCfg cfg) { return HeAPPlacer(ctx, cfg).place(); }
+bool placer_heap(Context *ctx, PlacerHeapCfg cfg)
+{
+    ProfileScope profile(ctx->profiler, "heap");
+    return HeAPPlacer(ctx, cfg).place();
+}
 
 PlacerHeapCfg::PlacerHeapCfg(Context *ctx)
 {
@@ -1840,6 +2002,13 @@ PlacerHeapCfg::PlacerHeapCfg(Context *ctx)
 
     timing_driven = ctx->setting<bool>("timing_driven");
     solverTolerance = 1e-5;
+    std::string precond = str_or_default(ctx->settings, ctx->id("placerHeap/preconditioner"), "jacobi");
+    if (precond == "jacobi")
+        solverPreconditioner = Preconditioner::Jacobi;
+    else if (precond == "ichol")
+        solverPreconditioner = Preconditioner::IncompleteCholesky;
+    else
+        log_error("Unknown placer heap preconditioner '%s', expected 'jacobi' or 'ichol'.\n", precond.c_str());
     placeAllAtOnce = false;
 
     int timeout_divisor = ctx->setting<int>("placerHeap/cellPlacementTimeout", 8);
@@ -42,6 +42,13 @@ struct PlacerHeapCfg
     float timingWeight;
     bool timing_driven;
     float solverTolerance;
+    // Preconditioner for the conjugate gradient solver. Incomplete Cholesky converges in fewer iterations, but its
+    // triangular solves don't parallelise; it falls back to Jacobi if the factorisation breaks down.
+    enum class Preconditioner
+    {
+        Jacobi,
+        IncompleteCholesky,
+    } solverPreconditioner;
     bool placeAllAtOnce;
     float netShareWeight;
     bool parallelRefine;
@@ -40,14 +40,6 @@
 
 #include "fftsg.h"
 
-#ifndef NPNR_DISABLE_THREADS
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <thread>
-
-#endif
-
 NEXTPNR_NAMESPACE_BEGIN
 
 using namespace StaticUtil;
@@ -67,7 +59,7 @@ struct PlacerGroup
 
     array2d<double> conc_density; // excludes fillers and dark nodes
     array2d<double> density;
-    // FFT related data (TODO: should these be per group?)
+    // FFT related data
     FFTArray density_fft;
     FFTArray electro_phi;
     FFTArray electro_fx, electro_fy;
@@ -152,93 +144,6 @@ struct PlacerNet
     int hpwl() { return (b1.x - b0.x) + (b1.y - b0.y); }
 };
 
-#ifdef NPNR_DISABLE_THREADS
-struct ThreadPool
-{
-    ThreadPool(int) {};
-
-    void run(int N, std::function<void(int)> func)
-    {
-        for (int i = 0; i < N; i++)
-            func(i);
-    };
-};
-#else
-struct ThreadPool
-{
-    ThreadPool(int thread_count)
-    {
-        done.resize(thread_count, false);
-        for (int i = 0; i < thread_count; i++) {
-            threads.emplace_back([this, i]() { this->worker(i); });
-        }
-    }
-    std::vector<std::thread> threads;
-    std::condition_variable cv_start, cv_done;
-    std::mutex mutex;
-
-    bool work_available = false;
-    bool shutdown = false;
-    std::vector<bool> done;
-    std::function<void(int)> work;
-    int work_count;
-
-    ~ThreadPool()
-    {
-        {
-            std::lock_guard lk(mutex);
-            shutdown = true;
-        }
-        cv_start.notify_all();
-        for (auto &t : threads)
-            t.join();
-    }
-
-    void run(int N, std::function<void(int)> func)
-    {
-        {
-            std::lock_guard lk(mutex);
-            work = func;
-            work_count = N;
-            work_available = true;
-            std::fill(done.begin(), done.end(), false);
-        }
-        cv_start.notify_all();
-        {
-            std::unique_lock lk(mutex);
-            cv_done.wait(lk, [this] { return std::all_of(done.begin(), done.end(), [](bool x) { return x; }); });
-            work_available = false;
-        }
-    }
-
-    void worker(int idx)
-    {
-        while (true) {
-            std::unique_lock lk(mutex);
-            cv_start.wait(lk, [this, idx] { return (work_available && !done.at(idx)) || shutdown; });
-            if (shutdown) {
-                lk.unlock();
-                break;
-            } else if (work_available && !done.at(idx)) {
-                int work_per_thread = (work_count + int(threads.size()) - 1) / threads.size();
-                int begin = work_per_thread * idx;
-                int end = std::min(work_count, work_per_thread * (idx + 1));
-                lk.unlock();
-
-                for (int j = begin; j < end; j++) {
-                    work(j);
-                }
-
-                lk.lock();
-                done.at(idx) = true;
-                lk.unlock();
-                cv_done.notify_one();
-            }
-        }
-    }
-};
-#endif
-
 class StaticPlacer
 {
     Context *ctx;
@@ -253,10 +158,11 @@ class StaticPlacer
 
     FastBels fast_bels;
     TimingAnalyser tmg;
-    ThreadPool pool;
 
     int width, height;
     int iter = 0;
+    // Wall time spent in each stage of the gradient computation
+    double density_time = 0, fft_time = 0, wirelen_time = 0;
     bool fft_debug = false;
     bool dump_density = false;
 
@@ -587,7 +493,16 @@ class StaticPlacer
         cs_table_fft.resize(m * 3 / 2, 0);
         work_area_fft.resize(std::round(std::sqrt(m)) + 2, 0);
         work_area_fft.at(0) = 0;
+        // The transforms fill in the cos/sin tables the first time they're used; do that now, as afterwards they are
+        // only read and the per-group transforms can share them across threads
+        FFTArray scratch(m, m);
+        ddct2d(m, m, -1, scratch.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        fft_scale.resize(m);
+        for (int i = 0; i < m; i++)
+            fft_scale.at(i) = pi * (i / float(m));
     }
+    // Frequency of each row/column of the DCT coefficients
+    std::vector<float> fft_scale;
 
     template <typename TFunc> void iter_slithers(RealPair pos, StaticRect rect, TFunc func)
     {
@@ -701,40 +616,35 @@ class StaticPlacer
         // https://github.com/ALIGN-analoglayout/ALIGN-public/blob/master/PlaceRouteHierFlow/EA_placer/FFT/fft.cpp
         // initial DCT for coefficients
         ddct2d(m, m, -1, g.density_fft.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
-        // postprocess coefficients
-        for (int x = 0; x < m; x++)
-            g.density_fft.at(x, 0) *= 0.5f;
-        for (int y = 0; y < m; y++)
-            g.density_fft.at(0, y) *= 0.5f;
-        for (int x = 0; x < m; x++)
-            for (int y = 0; y < m; y++)
-                g.density_fft.at(x, y) *= (4.0f / (m * m));
-        // scale inputs to IDCT for potentials and field
+        // postprocess coefficients, and scale inputs to IDCT for potentials and field. This works on whole rows of the
+        // arrays at a time, so that the inner loop vectorises
+        const float *w = fft_scale.data();
         for (int x = 0; x < m; x++) {
-            float wx = pi * (x / float(m));
-            float wx2 = wx * wx;
+            float *dens = g.density_fft.data()[x];
+            float *phi = g.electro_phi.data()[x], *ex = g.electro_fx.data()[x], *ey = g.electro_fy.data()[x];
+            float row_scale = (4.0f / (m * m)) * (x == 0 ? 0.5f : 1.0f);
+            float wx = w[x], wx2 = wx * wx;
+            dens[0] *= 0.5f;
             for (int y = 0; y < m; y++) {
-                float wy = pi * (y / float(m));
-                float wy2 = wy * wy;
-
-                float dens = g.density_fft.at(x, y);
-                float phi = 0, ex = 0, ey = 0;
-
-                if (x != 0 || y != 0) { // avoid divide by zero...
-                    phi = dens / (wx2 + wy2);
-                    ex = phi * wx;
-                    ey = phi * wy;
-                }
-
-                g.electro_phi.at(x, y) = phi;
-                g.electro_fx.at(x, y) = ex;
-                g.electro_fy.at(x, y) = ey;
+                dens[y] *= row_scale;
+                // avoid divide by zero...
+                float wy2 = w[y] * w[y];
+                float p = (x == 0 && y == 0) ? 0.0f : dens[y] / (wx2 + wy2);
+                phi[y] = p;
+                ex[y] = p * wx;
+                ey[y] = p * w[y];
             }
         }
-        // IDCT for potential; 2D derivatives for field
+        // IDCT for potential; 2D derivatives for field. The three transforms are independent, so run them at once
+        TaskGroup transforms(ctx->threadPool());
+        transforms.run([&]() {
+            ddsct2d(m, m, 1, g.electro_fx.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        });
+        transforms.run([&]() {
+            ddcst2d(m, m, 1, g.electro_fy.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        });
         ddct2d(m, m, 1, g.electro_phi.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
-        ddsct2d(m, m, 1, g.electro_fx.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
-        ddcst2d(m, m, 1, g.electro_fy.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        transforms.wait();
         if (fft_debug) {
             g.electro_phi.write_csv(stringf("out_bin_phi_%d_%d.csv", iter, group));
             g.electro_fx.write_csv(stringf("out_bin_ex_%d_%d.csv", iter, group));
@@ -761,7 +671,7 @@ class StaticPlacer
     void update_nets(bool ref)
     {
         static constexpr float min_wirelen_force = -3000.f;
-        pool.run(2 * nets.size(), [&](int i) {
+        ctx->threadPool().parallel_for(2 * nets.size(), [&](int i) {
             auto &net = nets.at(i / 2);
             auto axis = (i % 2) ? Axis::Y : Axis::X;
             if (net.skip)
@@ -857,10 +767,13 @@ class StaticPlacer
     void update_gradients(bool ref = true, bool set_prev = true, bool init_penalty = false)
     {
         // TODO: skip non-group cells more efficiently?
-        pool.run(groups.size(), [&](int group) {
-            compute_density(group, ref);
-            run_fft(group);
-        });
+        auto density_startt = std::chrono::high_resolution_clock::now();
+        ctx->threadPool().parallel_for(groups.size(), [&](int group) { compute_density(group, ref); });
+        auto fft_startt = std::chrono::high_resolution_clock::now();
+        ctx->threadPool().parallel_for(groups.size(), [&](int group) { run_fft(group); });
+        auto wirelen_startt = std::chrono::high_resolution_clock::now();
+        density_time += std::chrono::duration<double>(fft_startt - density_startt).count();
+        fft_time += std::chrono::duration<double>(wirelen_startt - fft_startt).count();
         update_nets(ref);
         // First loop: back up gradients if required; set to zero; and compute density gradient
         for (auto &cell : mcells) {
@@ -890,7 +803,7 @@ class StaticPlacer
             }
         }
         // Compute wirelength gradients for cells in parallel, this is a slow part
-        pool.run(gathered_wirelen_grad.size(), [&](int i) {
+        ctx->threadPool().parallel_for(gathered_wirelen_grad.size(), [&](int i) {
             auto &entry = gathered_wirelen_grad.at(i);
             CellInfo *ci = entry.first;
             float wl_gx = wirelen_grad(ci, Axis::X, ref);
@@ -902,6 +815,8 @@ class StaticPlacer
             auto &mc = mcells.at(entry.first->udata);
             (ref ? mc.ref_wl_grad : mc.wl_grad) += entry.second;
         }
+        wirelen_time +=
+                std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - wirelen_startt).count();
         if (init_penalty) {
             // set initial density penalty
             double wirelen_sum = 0, force_sum = 0;
@@ -1461,7 +1376,7 @@ class StaticPlacer
 
   public:
     StaticPlacer(Context *ctx, PlacerStaticCfg cfg)
-            : ctx(ctx), cfg(cfg), fast_bels(ctx, true, 8), tmg(ctx), pool(ctx->setting<int>("threads", 8))
+            : ctx(ctx), cfg(cfg), fast_bels(ctx, true, 8), tmg(ctx)
     {
         groups.resize(cfg.cell_groups.size());
         tmg.setup_only = true;
@@ -1471,6 +1386,7 @@ class StaticPlacer
     void place()
     {
         log_info("Running Static placer...\n");
+        auto startt = std::chrono::high_resolution_clock::now();
         init_bels();
         prepare_cells();
         init_cells();
@@ -1513,6 +1429,11 @@ class StaticPlacer
             }
             ++iter;
         }
+        auto endt = std::chrono::high_resolution_clock::now();
+        log_info("Static Placer Time: %.02fs\n", std::chrono::duration<double>(endt - startt).count());
+        log_info("  of which computing density: %.02fs\n", density_time);
+        log_info("  of which FFT and field: %.02fs\n", fft_time);
+        log_info("  of which wirelength gradients: %.02fs\n", wirelen_time);
         {
             auto placer1_cfg = Placer1Cfg(ctx);
             placer1_cfg.hpwl_scale_x = cfg.hpwl_scale_x;
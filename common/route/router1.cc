@@ -1160,6 +1160,7 @@ Router1Cfg::Router1Cfg(Context *ctx)
 
 bool router1(Context *ctx, const Router1Cfg &cfg)
 {
+    ProfileScope profile(ctx->profiler, "router1");
     try {
         log_break();
         log_info("Routing..\n");
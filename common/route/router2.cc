@@ -29,11 +29,13 @@
 #include "router2.h"
 
 #include <algorithm>
+#include <atomic>
 #include <boost/container/flat_map.hpp>
 #include <chrono>
 #include <deque>
 #include <fstream>
 #include <limits>
+#include <memory>
 #include <queue>
 #include <set>
 
@@ -57,12 +59,200 @@ struct Router2
         bool routed = false;
     };
 
+    // Storage for the wire tables of nets. Blocks are a power of two in size and are carved out of large chunks, and
+    // blocks that are given back go onto a free list for their size; so once routing settles, the tables of nets that
+    // are ripped up and rerouted are served without touching the heap. Blocks never move, so a block handed out by one
+    // arena may be given back to another.
+    template <typename T> struct BlockArena
+    {
+        static constexpr int chunk_size_log2 = 14;
+        std::vector<std::unique_ptr<T[]>> chunks;
+        T *chunk = nullptr;
+        int chunk_used = 1 << chunk_size_log2;
+        std::vector<std::vector<T *>> free_blocks;
+        // Blocks handed out, blocks of those that came from a free list, and heap allocations made; for perf profiling
+        int64_t blocks = 0, reused_blocks = 0, heap_allocs = 0;
+
+        T *alloc(int size_log2)
+        {
+            ++blocks;
+            if (size_log2 < int(free_blocks.size()) && !free_blocks.at(size_log2).empty()) {
+                T *block = free_blocks.at(size_log2).back();
+                free_blocks.at(size_log2).pop_back();
+                ++reused_blocks;
+                return block;
+            }
+            int size = 1 << size_log2;
+            if (size_log2 >= chunk_size_log2) {
+                ++heap_allocs;
+                chunks.emplace_back(new T[size]);
+                return chunks.back().get();
+            }
+            if (chunk_used + size > (1 << chunk_size_log2)) {
+                ++heap_allocs;
+                chunks.emplace_back(new T[1 << chunk_size_log2]);
+                chunk = chunks.back().get();
+                chunk_used = 0;
+            }
+            T *block = chunk + chunk_used;
+            chunk_used += size;
+            return block;
+        }
+
+        void free(T *block, int size_log2)
+        {
+            if (int(free_blocks.size()) <= size_log2)
+                free_blocks.resize(size_log2 + 1);
+            free_blocks.at(size_log2).push_back(block);
+        }
+    };
+
+    // A wire used by a net
+    struct NetWire
+    {
+        WireId wire;
+        // The pip driving the wire, and the number of arcs of the net that use it
+        PipId pip;
+        int arcs = 0;
+        // The route_stamp of the net when the wire was last added to wire_by_loc, and when an arc to it was last
+        // routed
+        uint32_t loc_stamp = 0, sink_stamp = 0;
+    };
+
+    // The wires used by a net, in an open-addressing hash table with linear probing kept at most half full. The slots
+    // come from a BlockArena, and are kept as the net is ripped up.
+    struct NetWires
+    {
+        NetWire *slots = nullptr;
+        int size_log2 = 0, count = 0;
+
+        int slot_of(WireId wire) const { return (uint32_t(wire.hash()) * 2654435769u) >> (32 - size_log2); }
+        int mask() const { return (1 << size_log2) - 1; }
+
+        NetWire *find(WireId wire) const
+        {
+            if (count == 0)
+                return nullptr;
+            for (int i = slot_of(wire);; i = (i + 1) & mask()) {
+                if (slots[i].wire == wire)
+                    return &slots[i];
+                if (slots[i].wire == WireId())
+                    return nullptr;
+            }
+        }
+
+        NetWire &at(WireId wire) const
+        {
+            NetWire *found = find(wire);
+            NPNR_ASSERT(found != nullptr);
+            return *found;
+        }
+
+        // Returns the existing entry for the wire, or a new one
+        NetWire &insert(BlockArena<NetWire> &arena, WireId wire)
+        {
+            NetWire *found = find(wire);
+            if (found != nullptr)
+                return *found;
+            if (slots == nullptr || 2 * (count + 1) > (1 << size_log2))
+                grow(arena);
+            int i = slot_of(wire);
+            while (slots[i].wire != WireId())
+                i = (i + 1) & mask();
+            slots[i] = NetWire();
+            slots[i].wire = wire;
+            ++count;
+            return slots[i];
+        }
+
+        void erase(WireId wire)
+        {
+            int i = slot_of(wire);
+            while (slots[i].wire != wire) {
+                NPNR_ASSERT(slots[i].wire != WireId());
+                i = (i + 1) & mask();
+            }
+            // Shift back the entries after it that would no longer be found past the hole
+            for (int j = (i + 1) & mask(); slots[j].wire != WireId(); j = (j + 1) & mask()) {
+                int home = slot_of(slots[j].wire);
+                bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                if (stays)
+                    continue;
+                slots[i] = slots[j];
+                i = j;
+            }
+            slots[i] = NetWire();
+            --count;
+        }
+
+        void grow(BlockArena<NetWire> &arena)
+        {
+            NetWire *old_slots = slots;
+            int old_size_log2 = size_log2;
+            size_log2 = (slots == nullptr) ? 3 : (size_log2 + 1);
+            slots = arena.alloc(size_log2);
+            std::fill(slots, slots + (1 << size_log2), NetWire());
+            if (old_slots == nullptr)
+                return;
+            for (int j = 0; j < (1 << old_size_log2); j++) {
+                if (old_slots[j].wire == WireId())
+                    continue;
+                int i = slot_of(old_slots[j].wire);
+                while (slots[i].wire != WireId())
+                    i = (i + 1) & mask();
+                slots[i] = old_slots[j];
+            }
+            arena.free(old_slots, old_size_log2);
+        }
+
+        void clear_stamps()
+        {
+            for (auto &w : *this)
+                w.loc_stamp = w.sink_stamp = 0;
+        }
+
+        bool empty() const { return count == 0; }
+        int size() const { return count; }
+
+        struct iterator
+        {
+            NetWire *ptr, *end;
+            void skip_empty()
+            {
+                while (ptr != end && ptr->wire == WireId())
+                    ++ptr;
+            }
+            iterator &operator++()
+            {
+                ++ptr;
+                skip_empty();
+                return *this;
+            }
+            bool operator!=(const iterator &other) const { return ptr != other.ptr; }
+            NetWire &operator*() const { return *ptr; }
+        };
+        iterator begin() const
+        {
+            NetWire *end_ptr = slots ? (slots + (1 << size_log2)) : nullptr;
+            iterator it{slots, end_ptr};
+            it.skip_empty();
+            return it;
+        }
+        iterator end() const
+        {
+            NetWire *end_ptr = slots ? (slots + (1 << size_log2)) : nullptr;
+            return iterator{end_ptr, end_ptr};
+        }
+    };
+
     // As we allow overlap at first; the nextpnr bind functions can't be used
     // as the primary relation between arcs and wires/pips
     struct PerNetData
     {
         WireId src_wire;
-        dict<WireId, std::pair<PipId, int>> wires;
+        NetWires wires;
+        // Stamp of the current route_net of this net, so that the stamps in wires can be reset all at once
+        uint32_t route_stamp = 0;
         std::vector<std::vector<PerArcData>> arcs;
         BoundingBox bb;
         // Coordinates of the center of the net, used for the weight-to-average
@@ -84,19 +274,31 @@ struct Router2
     {
         // nextpnr
         WireId w;
-        // Historical congestion cost
+        // The notional location of the wire, to guarantee thread safety
+        int16_t x = 0, y = 0;
+    };
+
+    // Congestion and reservation state, stored separately to the above (indexed the same way) as it is what the A*
+    // inner loop reads for every wire it considers
+    struct PerWireCongestion
+    {
+        // Number of nets bound to the wire
         int curr_cong = 0;
+        // Historical congestion cost
         float hist_cong_cost = 1.0;
-        // Wire is unavailable as locked to another arc
-        bool unavailable = false;
         // This wire has to be used for this net
         int reserved_net = -1;
-        // The notional location of the wire, to guarantee thread safety
-        int16_t x = 0, y = 0;
-        // Visit data
+        // Wire is unavailable as locked to another arc
+        bool unavailable = false;
+    };
+
+    // Visit data, stored separately to the above (indexed the same way) so that the A* inner loop only pulls the
+    // fields it needs through the cache
+    struct PerWireVisitData
+    {
         PipId pip_fwd, pip_bwd;
-        bool visited_fwd = false, visited_bwd = false;
         float cost_fwd = 0.0, cost_bwd = 0.0;
+        bool visited_fwd = false, visited_bwd = false;
     };
 
     Context *ctx;
@@ -190,8 +392,15 @@ struct Router2
 
     dict<WireId, int> wire_to_idx;
     std::vector<PerWireData> flat_wires;
+    std::vector<PerWireCongestion> wire_cong;
+    std::vector<PerWireVisitData> wire_visits;
+    // Flat indices of the wires at the other end of the downhill and uphill pips of each wire, in the order the arch
+    // returns the pips, so that the search doesn't need a wire_to_idx lookup for each pip. They are filled in the
+    // first time a wire is expanded (see pip_wire_indices), as doing so for every wire of the chip up front takes
+    // longer than routing a small design.
+    std::vector<std::atomic<const int *>> downhill_wires, uphill_wires;
 
-    PerWireData &wire_data(WireId w) { return flat_wires[wire_to_idx.at(w)]; }
+    PerWireCongestion &wire_cong_data(WireId w) { return wire_cong[wire_to_idx.at(w)]; }
 
     void setup_wires()
     {
@@ -199,18 +408,19 @@ struct Router2
         // This is possibly quite wasteful and not cache-optimal; further consideration necessary
         for (auto wire : ctx->getWires()) {
             PerWireData pwd;
+            PerWireCongestion pwc;
             pwd.w = wire;
             NetInfo *bound = ctx->getBoundWireNet(wire);
             if (bound != nullptr) {
                 auto iter = bound->wires.find(wire);
                 if (iter != bound->wires.end()) {
                     auto &nd = nets.at(bound->udata);
-                    nd.wires[wire] = std::make_pair(bound->wires.at(wire).pip, 0);
-                    pwd.curr_cong = 1;
+                    nd.wires.insert(search_state(0).arena, wire).pip = bound->wires.at(wire).pip;
+                    pwc.curr_cong = 1;
                     if (bound->wires.at(wire).strength == STRENGTH_PLACER) {
-                        pwd.reserved_net = bound->udata;
+                        pwc.reserved_net = bound->udata;
                     } else if (bound->wires.at(wire).strength > STRENGTH_PLACER) {
-                        pwd.unavailable = true;
+                        pwc.unavailable = true;
                     }
                 }
             }
@@ -221,7 +431,11 @@ struct Router2
 
             wire_to_idx[wire] = int(flat_wires.size());
             flat_wires.push_back(pwd);
+            wire_cong.push_back(pwc);
         }
+        wire_visits.resize(flat_wires.size());
+        downhill_wires = std::vector<std::atomic<const int *>>(flat_wires.size());
+        uphill_wires = std::vector<std::atomic<const int *>>(flat_wires.size());
 
         for (auto &net_pair : ctx->nets) {
             auto *net = net_pair.second.get();
@@ -262,6 +476,33 @@ struct Router2
 
     double curr_cong_weight, hist_cong_weight, estimate_weight;
 
+    // Search storage used by a thread. These are pooled for the whole run, so their storage is reused between arcs,
+    // nets and iterations; and per-net state is reset by moving on to a new stamp rather than by clearing it.
+    struct SearchState
+    {
+        std::vector<std::pair<store_index<PortRef>, size_t>> route_arcs;
+
+        // Binary heaps ordered by QueuedWire::Greater
+        std::vector<QueuedWire> fwd_queue, bwd_queue;
+
+        std::vector<int> dirty_wires;
+
+        // Used to add existing routing to the heap. wire_by_loc has an entry per grid location, holding the index of
+        // the most recently added entry in loc_wires for pips at that location if its stamp is loc_stamp. Each entry
+        // of loc_wires chains to the previous entry for its location (or -1).
+        std::vector<std::pair<uint32_t, int>> wire_by_loc;
+        uint32_t loc_stamp = 0;
+        std::vector<std::pair<WireId, int>> loc_wires;
+
+        // Storage for the wire tables of the nets routed with this state
+        BlockArena<NetWire> arena;
+        // Storage for the downhill_wires and uphill_wires lists filled in by this state
+        BlockArena<int> pip_wire_arena;
+
+        // Number of per-net resets done by stamping, for perf profiling
+        int64_t stamped_resets = 0;
+    };
+
     struct ThreadContext
     {
         // Nets to route
@@ -269,24 +510,125 @@ struct Router2
         // Nets that failed routing
         std::vector<NetInfo *> failed_nets;
 
-        std::vector<std::pair<store_index<PortRef>, size_t>> route_arcs;
-
-        std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> fwd_queue, bwd_queue;
-        // Special case where one net has multiple logical arcs to the same physical sink
-        pool<WireId> processed_sinks;
-
-        std::vector<int> dirty_wires;
+        // Search storage, from search_states
+        SearchState *search = nullptr;
 
         // Thread bounding box
         BoundingBox bb;
 
         DeterministicRNG rng;
 
-        // Used to add existing routing to the heap
-        pool<WireId> in_wire_by_loc;
-        dict<std::pair<int, int>, pool<WireId>> wire_by_loc;
+        // Number of wires popped from the queues, and the cache misses while routing, for perf profiling
+        int64_t explored_wires = 0;
+        int64_t cache_misses = 0;
+        bool cache_misses_unavailable = false;
     };
 
+    // Runs func, adding the cache misses of this thread while it runs to those of t when profiling
+    template <typename Tfunc> void count_cache_misses(ThreadContext &t, Tfunc func)
+    {
+        if (!cfg.perf_profile) {
+            func();
+            return;
+        }
+        CacheMissCounter counter;
+        func();
+        if (counter.available())
+            t.cache_misses += counter.read();
+        else
+            t.cache_misses_unavailable = true;
+    }
+
+    std::vector<std::unique_ptr<SearchState>> search_states;
+
+    SearchState &search_state(int i)
+    {
+        while (int(search_states.size()) <= i) {
+            search_states.emplace_back(new SearchState());
+            search_states.back()->wire_by_loc.resize(ctx->getGridDimX() * ctx->getGridDimY());
+        }
+        return *search_states.at(i);
+    }
+
+    // The flat indices of the wires on the other side of the uphill or downhill pips of a wire, filling them in from
+    // the arch if this is the first time the wire is expanded
+    const int *pip_wire_indices(SearchState &s, int wire, bool uphill)
+    {
+        auto &entry = (uphill ? uphill_wires : downhill_wires)[wire];
+        const int *found = entry.load(std::memory_order_acquire);
+        if (found != nullptr)
+            return found;
+        WireId w = flat_wires[wire].w;
+        if (uphill)
+            return fill_pip_wire_indices(s, entry, ctx->getPipsUphill(w), uphill);
+        else
+            return fill_pip_wire_indices(s, entry, ctx->getPipsDownhill(w), uphill);
+    }
+
+    // Threads that race to fill in the same wire both build the list, and use whichever is published first
+    template <typename Tpips>
+    const int *fill_pip_wire_indices(SearchState &s, std::atomic<const int *> &entry, const Tpips &pips, bool uphill)
+    {
+        int count = 0;
+        for (PipId pip : pips) {
+            (void)pip;
+            ++count;
+        }
+        int size_log2 = 0;
+        while ((1 << size_log2) < count)
+            ++size_log2;
+        int *indices = s.pip_wire_arena.alloc(size_log2), *next = indices;
+        for (PipId pip : pips)
+            *next++ = wire_to_idx.at(uphill ? ctx->getPipSrcWire(pip) : ctx->getPipDstWire(pip));
+        const int *found = nullptr;
+        if (!entry.compare_exchange_strong(found, indices, std::memory_order_acq_rel)) {
+            s.pip_wire_arena.free(indices, size_log2);
+            return found;
+        }
+        return indices;
+    }
+
+    // The wire_by_loc entry for a location, reset if it was left by a previous net
+    int &loc_head(SearchState &s, int x, int y)
+    {
+        auto &entry = s.wire_by_loc.at(y * ctx->getGridDimX() + x);
+        if (entry.first != s.loc_stamp)
+            entry = std::make_pair(s.loc_stamp, -1);
+        return entry.second;
+    }
+
+    void queue_push(std::vector<QueuedWire> &queue, const QueuedWire &qw)
+    {
+        queue.push_back(qw);
+        std::push_heap(queue.begin(), queue.end(), QueuedWire::Greater());
+    }
+
+    QueuedWire queue_pop(std::vector<QueuedWire> &queue)
+    {
+        std::pop_heap(queue.begin(), queue.end(), QueuedWire::Greater());
+        QueuedWire top = queue.back();
+        queue.pop_back();
+        return top;
+    }
+
+    void reset_net_state(ThreadContext &t, PerNetData &nd)
+    {
+        auto &s = *t.search;
+        s.route_arcs.clear();
+        s.loc_wires.clear();
+        // Forget wire_by_loc, and which wires of the net were added to it and which of its sinks were routed. The
+        // stamps are only cleared when they wrap around.
+        if (++s.loc_stamp == 0) {
+            std::fill(s.wire_by_loc.begin(), s.wire_by_loc.end(), std::make_pair(uint32_t(0), -1));
+            s.loc_stamp = 1;
+        }
+        if (++nd.route_stamp == 0) {
+            nd.wires.clear_stamps();
+            nd.route_stamp = 1;
+        }
+        ++s.stamped_resets;
+    }
+
     bool thread_test_wire(ThreadContext &t, PerWireData &w)
     {
         return w.x >= t.bb.x0 && w.x <= t.bb.x1 && w.y >= t.bb.y0 && w.y <= t.bb.y1;
@@ -313,33 +655,36 @@ struct Router2
             log(__VA_ARGS__);                                                                                          \
     } while (0)
 
-    void bind_pip_internal(PerNetData &net, store_index<PortRef> user, int wire, PipId pip)
+    void bind_pip_internal(BlockArena<NetWire> &arena, PerNetData &net, store_index<PortRef> user, int wire,
+                           PipId pip)
     {
-        auto &wd = flat_wires.at(wire);
-        auto found = net.wires.find(wd.w);
-        if (found == net.wires.end()) {
+        WireId w = flat_wires.at(wire).w;
+        NetWire *found = net.wires.find(w);
+        if (found == nullptr) {
             // Not yet used for any arcs of this net, add to list
-            net.wires.emplace(wd.w, std::make_pair(pip, 1));
+            auto &bound = net.wires.insert(arena, w);
+            bound.pip = pip;
+            bound.arcs = 1;
             // Increase bound count of wire by 1
-            ++wd.curr_cong;
+            ++wire_cong.at(wire).curr_cong;
         } else {
             // Already used for at least one other arc of this net
             // Don't allow two uphill PIPs for the same net and wire
-            NPNR_ASSERT(found->second.first == pip);
+            NPNR_ASSERT(found->pip == pip);
             // Increase the count of bound arcs
-            ++found->second.second;
+            ++found->arcs;
         }
     }
 
     void unbind_pip_internal(PerNetData &net, store_index<PortRef> user, WireId wire)
     {
-        auto &wd = wire_data(wire);
-        auto &b = net.wires.at(wd.w);
-        --b.second;
-        if (b.second == 0) {
+        auto &wc = wire_cong_data(wire);
+        auto &b = net.wires.at(wire);
+        --b.arcs;
+        if (b.arcs == 0) {
             // No remaining arcs of this net bound to this wire
-            --wd.curr_cong;
-            net.wires.erase(wd.w);
+            --wc.curr_cong;
+            net.wires.erase(wire);
         }
     }
 
@@ -353,26 +698,28 @@ struct Router2
         WireId cursor = ad.sink_wire;
         while (cursor != src &&
                (net->constant_value == IdString() || ctx->getWireConstantValue(cursor) == net->constant_value)) {
-            PipId pip = nd.wires.at(cursor).first;
+            PipId pip = nd.wires.at(cursor).pip;
             unbind_pip_internal(nd, user, cursor);
             cursor = ctx->getPipSrcWire(pip);
         }
         ad.routed = false;
     }
 
-    float score_wire_for_arc(NetInfo *net, store_index<PortRef> user, size_t phys_pin, WireId wire, PipId pip,
+    float score_wire_for_arc(NetInfo *net, store_index<PortRef> user, size_t phys_pin, int wire_idx, PipId pip,
                              float crit_weight)
     {
-        auto &wd = wire_data(wire);
+        auto &wc = wire_cong[wire_idx];
+        WireId wire = flat_wires[wire_idx].w;
         auto &nd = nets.at(net->udata);
         float base_cost = cfg.get_base_cost(ctx, wire, pip, crit_weight);
-        int overuse = wd.curr_cong;
-        float hist_cost = 1.0f + crit_weight * (wd.hist_cong_cost - 1.0f);
+        int overuse = wc.curr_cong;
+        float hist_cost = 1.0f + crit_weight * (wc.hist_cong_cost - 1.0f);
         float bias_cost = 0;
         int source_uses = 0;
-        if (nd.wires.count(wire)) {
+        const NetWire *bound = nd.wires.find(wire);
+        if (bound != nullptr) {
             overuse -= 1;
-            source_uses = nd.wires.at(wire).second;
+            source_uses = bound->arcs;
         }
         float present_cost = 1.0f + overuse * curr_cong_weight * crit_weight;
         if (pip != PipId()) {
@@ -388,9 +735,9 @@ struct Router2
         auto &nd = nets.at(net->udata);
         auto &wd = flat_wires[wire];
         int source_uses = 0;
-        if (nd.wires.count(wd.w)) {
-            source_uses = nd.wires.at(wd.w).second;
-        }
+        const NetWire *bound = nd.wires.find(wd.w);
+        if (bound != nullptr)
+            source_uses = bound->arcs;
         // FIXME: timing/wirelength balance?
         delay_t est_delay = ctx->estimateDelay(bwd ? src_sink : wd.w, bwd ? wd.w : src_sink);
         return (ctx->getDelayNS(est_delay) / (1 + source_uses * crit_weight)) + cfg.ipin_cost_adder;
@@ -402,11 +749,10 @@ struct Router2
         auto &ad = nd.arcs.at(usr.idx()).at(phys_pin);
         WireId src_wire = nets.at(net->udata).src_wire;
         WireId cursor = ad.sink_wire;
-        while (nd.wires.count(cursor)) {
-            auto &wd = wire_data(cursor);
-            if (wd.curr_cong != 1)
+        for (const NetWire *bound = nd.wires.find(cursor); bound != nullptr; bound = nd.wires.find(cursor)) {
+            if (wire_cong_data(cursor).curr_cong != 1)
                 return false;
-            auto &uh = nd.wires.at(cursor).first;
+            auto &uh = bound->pip;
             if (uh == PipId())
                 break;
             cursor = ctx->getPipSrcWire(uh);
@@ -424,8 +770,8 @@ struct Router2
         WireId cursor = ad.sink_wire;
         while (cursor != src) {
             size_t wire_idx = wire_to_idx.at(cursor);
-            PipId pip = nd.wires.at(cursor).first;
-            bind_pip_internal(nd, usr, wire_idx, pip);
+            PipId pip = nd.wires.at(cursor).pip;
+            bind_pip_internal(search_state(0).arena, nd, usr, wire_idx, pip);
             cursor = ctx->getPipSrcWire(pip);
         }
     }
@@ -442,9 +788,10 @@ struct Router2
         // and LUT
         if (iter_count > 7)
             return false; // heuristic to assume we've hit general routing
-        if (wire_data(wire).unavailable)
+        auto &wc = wire_cong_data(wire);
+        if (wc.unavailable)
             return true;
-        if (wire_data(wire).reserved_net != -1 && wire_data(wire).reserved_net != net->udata)
+        if (wc.reserved_net != -1 && wc.reserved_net != net->udata)
             return true; // reserved for another net
         for (auto bp : ctx->getWireBelPins(wire))
             if ((net->driver.cell == nullptr || bp.bel == net->driver.cell->bel) &&
@@ -464,7 +811,7 @@ struct Router2
         bool did_something = false;
         WireId src = ctx->getNetinfoSourceWire(net);
         {
-            auto &src_wd = wire_data(src);
+            auto &src_wd = wire_cong_data(src);
             if (src_wd.reserved_net != -1 && src_wd.reserved_net != net->udata)
                 log_error("attempting to reserve src wire '%s' for nets '%s' and '%s'\n", ctx->nameOfWire(src),
                           ctx->nameOf(nets_by_udata.at(src_wd.reserved_net)), ctx->nameOf(net));
@@ -479,7 +826,7 @@ struct Router2
                 log("reserving wires for arc %d (%s.%s) of net %s\n", i.idx(), ctx->nameOf(usr.cell),
                     ctx->nameOf(usr.port), ctx->nameOf(net));
             while (!done) {
-                auto &wd = wire_data(cursor);
+                auto &wd = wire_cong_data(cursor);
                 if (ctx->debug)
                     log("      %s\n", ctx->nameOfWire(cursor));
                 did_something |= (wd.reserved_net != net->udata);
@@ -526,15 +873,10 @@ struct Router2
 
     void reset_wires(ThreadContext &t)
     {
-        for (auto w : t.dirty_wires) {
-            flat_wires[w].pip_fwd = PipId();
-            flat_wires[w].pip_bwd = PipId();
-            flat_wires[w].visited_fwd = false;
-            flat_wires[w].visited_bwd = false;
-            flat_wires[w].cost_fwd = 0.0;
-            flat_wires[w].cost_bwd = 0.0;
+        for (auto w : t.search->dirty_wires) {
+            wire_visits[w] = PerWireVisitData();
         }
-        t.dirty_wires.clear();
+        t.search->dirty_wires.clear();
     }
 
     // These nets have very-high-fanout pips and special rules must be followed (only working backwards) to avoid
@@ -547,36 +889,42 @@ struct Router2
             return;
         auto &nd = nets.at(net->udata);
         auto &ad = nd.arcs.at(i.idx()).at(phys_pin);
+        auto &s = *t.search;
         WireId cursor = ad.sink_wire;
-        if (!nd.wires.count(cursor))
+        if (nd.wires.find(cursor) == nullptr)
             return;
         while (cursor != nd.src_wire) {
-            if (!t.in_wire_by_loc.count(cursor)) {
-                t.in_wire_by_loc.insert(cursor);
+            auto &bound = nd.wires.at(cursor);
+            if (bound.loc_stamp != nd.route_stamp) {
+                bound.loc_stamp = nd.route_stamp;
                 for (auto dh : ctx->getPipsDownhill(cursor)) {
                     Loc dh_loc = ctx->getPipLocation(dh);
-                    t.wire_by_loc[std::make_pair(dh_loc.x, dh_loc.y)].insert(cursor);
+                    int &head = loc_head(s, dh_loc.x, dh_loc.y);
+                    if (head != -1 && s.loc_wires.at(head).first == cursor)
+                        continue; // another pip of this wire at the same location
+                    s.loc_wires.emplace_back(cursor, head);
+                    head = int(s.loc_wires.size()) - 1;
                 }
             }
-            cursor = ctx->getPipSrcWire(nd.wires.at(cursor).first);
+            cursor = ctx->getPipSrcWire(bound.pip);
         }
     }
 
     // Functions for marking wires as visited, and checking if they have already been visited
     void set_visited_fwd(ThreadContext &t, int wire, PipId pip, float cost)
     {
-        auto &wd = flat_wires.at(wire);
+        auto &wd = wire_visits.at(wire);
         if (!wd.visited_fwd && !wd.visited_bwd)
-            t.dirty_wires.push_back(wire);
+            t.search->dirty_wires.push_back(wire);
         wd.pip_fwd = pip;
         wd.visited_fwd = true;
         wd.cost_fwd = cost;
     }
     void set_visited_bwd(ThreadContext &t, int wire, PipId pip, float cost)
     {
-        auto &wd = flat_wires.at(wire);
+        auto &wd = wire_visits.at(wire);
         if (!wd.visited_fwd && !wd.visited_bwd)
-            t.dirty_wires.push_back(wire);
+            t.search->dirty_wires.push_back(wire);
         wd.pip_bwd = pip;
         wd.visited_bwd = true;
         wd.cost_bwd = cost;
@@ -584,11 +932,11 @@ struct Router2
 
     bool was_visited_fwd(int wire, float cost)
     {
-        return flat_wires.at(wire).visited_fwd && flat_wires.at(wire).cost_fwd <= cost;
+        return wire_visits.at(wire).visited_fwd && wire_visits.at(wire).cost_fwd <= cost;
     }
     bool was_visited_bwd(int wire, float cost)
     {
-        return flat_wires.at(wire).visited_bwd && flat_wires.at(wire).cost_bwd <= cost;
+        return wire_visits.at(wire).visited_bwd && wire_visits.at(wire).cost_bwd <= cost;
     }
 
     float get_arc_crit(NetInfo *net, store_index<PortRef> i)
@@ -611,6 +959,7 @@ struct Router2
         auto arc_start = std::chrono::high_resolution_clock::now();
         auto &nd = nets[net->udata];
         auto &ad = nd.arcs.at(i.idx()).at(phys_pin);
+        auto &s = *t.search;
         auto &usr = net->users.at(i);
         bool const_mode = is_dedi_const_net(net);
         ROUTE_LOG_DBG("Routing arc %d of net '%s' (%d, %d) -> (%d, %d)\n", i.idx(), ctx->nameOf(net), ad.bb.x0,
@@ -628,8 +977,10 @@ struct Router2
         float crit = get_arc_crit(net, i);
         float crit_weight = std::max<float>(0.05f, (1.0f - std::pow(crit, 2)));
         ROUTE_LOG_DBG("     crit=%.3f crit_weight=%.3f\n", crit, crit_weight);
-        // Check if arc was already done _in this iteration_
-        if (t.processed_sinks.count(dst_wire))
+        // Check if arc was already done _in this iteration_; for the special case where one net has multiple logical
+        // arcs to the same physical sink
+        const NetWire *dst_bound = nd.wires.find(dst_wire);
+        if (dst_bound != nullptr && dst_bound->sink_stamp == nd.route_stamp)
             return ARC_SUCCESS;
 
         // We have two modes:
@@ -645,14 +996,8 @@ struct Router2
 
         for (; mode < 2; mode++) {
             // Clear out the queues
-            if (!t.fwd_queue.empty()) {
-                std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
-                t.fwd_queue.swap(new_queue);
-            }
-            if (!t.bwd_queue.empty()) {
-                std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
-                t.bwd_queue.swap(new_queue);
-            }
+            s.fwd_queue.clear();
+            s.bwd_queue.clear();
             // Unvisit any previously visited wires
             reset_wires(t);
 
@@ -665,23 +1010,24 @@ struct Router2
                 base_score.cost = 0;
                 int wire_idx = wire_to_idx.at(wire);
                 base_score.togo_cost = get_togo_cost(net, i, wire_idx, dst_wire, false, crit_weight);
-                t.fwd_queue.push(QueuedWire(wire_idx, base_score));
+                queue_push(s.fwd_queue, QueuedWire(wire_idx, base_score));
                 set_visited_fwd(t, wire_idx, PipId(), 0.0);
             };
             auto &dst_data = flat_wires.at(dst_wire_idx);
             // Look for nearby existing routing
             for (int dy = -cfg.bb_margin_y; dy <= cfg.bb_margin_y; dy++)
                 for (int dx = -cfg.bb_margin_x; dx <= cfg.bb_margin_x; dx++) {
-                    auto fnd = t.wire_by_loc.find(std::make_pair(dst_data.x + dx, dst_data.y + dy));
-                    if (fnd == t.wire_by_loc.end())
+                    int x = dst_data.x + dx, y = dst_data.y + dy;
+                    if (x < 0 || x >= ctx->getGridDimX() || y < 0 || y >= ctx->getGridDimY())
                         continue;
-                    for (WireId wire : fnd->second) {
+                    for (int entry = loc_head(s, x, y); entry != -1; entry = s.loc_wires.at(entry).second) {
+                        WireId wire = s.loc_wires.at(entry).first;
                         ROUTE_LOG_DBG("   seeding with %s\n", ctx->nameOfWire(wire));
                         seed_queue_fwd(wire);
                     }
                 }
 
-            if (mode == 0 && t.fwd_queue.size() < 4)
+            if (mode == 0 && s.fwd_queue.size() < 4)
                 continue;
             if (!const_mode) {
                 if (mode == 1) {
@@ -697,7 +1043,7 @@ struct Router2
                 base_score.cost = 0;
                 int wire_idx = wire_to_idx.at(wire);
                 base_score.togo_cost = get_togo_cost(net, i, wire_idx, src_wire, true, crit_weight);
-                t.bwd_queue.push(QueuedWire(wire_idx, base_score));
+                queue_push(s.bwd_queue, QueuedWire(wire_idx, base_score));
                 set_visited_bwd(t, wire_idx, PipId(), 0.0);
             };
 
@@ -708,14 +1054,13 @@ struct Router2
             int iter = 0;
 
             // Mode 0 required both queues to be live
-            while (((mode == 0) ? (!t.fwd_queue.empty() && !t.bwd_queue.empty())
-                                : (!t.fwd_queue.empty() || !t.bwd_queue.empty())) &&
+            while (((mode == 0) ? (!s.fwd_queue.empty() && !s.bwd_queue.empty())
+                                : (!s.fwd_queue.empty() || !s.bwd_queue.empty())) &&
                    (!is_bb || iter < toexplore)) {
                 ++iter;
-                if (!t.fwd_queue.empty() && !const_mode) {
+                if (!s.fwd_queue.empty() && !const_mode) {
                     // Explore forwards
-                    auto curr = t.fwd_queue.top();
-                    t.fwd_queue.pop();
+                    auto curr = queue_pop(s.fwd_queue);
                     ++explored;
                     if (was_visited_bwd(curr.wire, std::numeric_limits<float>::max())) {
                         // Meet in the middle; done
@@ -723,43 +1068,45 @@ struct Router2
                         break;
                     }
                     auto &curr_data = flat_wires.at(curr.wire);
+                    const int *dh_dst = pip_wire_indices(s, curr.wire, /*uphill=*/false);
                     for (PipId dh : ctx->getPipsDownhill(curr_data.w)) {
+                        int next_idx = *dh_dst++;
                         // Skip pips outside of box in bounding-box mode
                         if (is_bb && !hit_test_pip(nd.bb, ctx->getPipLocation(dh)))
                             continue;
                         if (!ctx->checkPipAvailForNet(dh, net))
                             continue;
-                        WireId next = ctx->getPipDstWire(dh);
-                        int next_idx = wire_to_idx.at(next);
+                        auto &nwd = flat_wires[next_idx];
+                        WireId next = nwd.w;
                         WireScore next_score;
                         next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, next, dh, crit_weight);
-                        next_score.cost = curr.score.cost + score_wire_for_arc(net, i, phys_pin, next, dh, crit_weight);
+                        next_score.cost =
+                                curr.score.cost + score_wire_for_arc(net, i, phys_pin, next_idx, dh, crit_weight);
                         next_score.togo_cost =
                                 cfg.estimate_weight * get_togo_cost(net, i, next_idx, dst_wire, false, crit_weight);
                         if (was_visited_fwd(next_idx, next_score.delay)) {
                             // Don't expand the same node twice.
                             continue;
                         }
-                        auto &nwd = flat_wires.at(next_idx);
-                        if (nwd.unavailable)
+                        auto &nwc = wire_cong[next_idx];
+                        if (nwc.unavailable)
                             continue;
                         // Reserved for another net
-                        if (nwd.reserved_net != -1 && nwd.reserved_net != net->udata)
+                        if (nwc.reserved_net != -1 && nwc.reserved_net != net->udata)
                             continue;
                         // Don't allow the same wire to be bound to the same net with a different driving pip
-                        auto fnd_wire = nd.wires.find(next);
-                        if (fnd_wire != nd.wires.end() && fnd_wire->second.first != dh)
+                        const NetWire *fnd_wire = nd.wires.find(next);
+                        if (fnd_wire != nullptr && fnd_wire->pip != dh)
                             continue;
                         if (!thread_test_wire(t, nwd))
                             continue; // thread safety issue
                         set_visited_fwd(t, next_idx, dh, next_score.delay);
-                        t.fwd_queue.push(QueuedWire(next_idx, next_score, t.rng.rng()));
+                        queue_push(s.fwd_queue, QueuedWire(next_idx, next_score, t.rng.rng()));
                     }
                 }
-                if (!t.bwd_queue.empty()) {
+                if (!s.bwd_queue.empty()) {
                     // Explore backwards
-                    auto curr = t.bwd_queue.top();
-                    t.bwd_queue.pop();
+                    auto curr = queue_pop(s.bwd_queue);
                     ++explored;
                     auto &curr_data = flat_wires.at(curr.wire);
                     if (was_visited_fwd(curr.wire, std::numeric_limits<float>::max()) ||
@@ -770,22 +1117,25 @@ struct Router2
                     }
                     // Don't allow the same wire to be bound to the same net with a different driving pip
                     PipId bound_pip;
-                    auto fnd_wire = nd.wires.find(curr_data.w);
-                    if (fnd_wire != nd.wires.end())
-                        bound_pip = fnd_wire->second.first;
+                    const NetWire *fnd_wire = nd.wires.find(curr_data.w);
+                    if (fnd_wire != nullptr)
+                        bound_pip = fnd_wire->pip;
 
+                    const int *uh_src = pip_wire_indices(s, curr.wire, /*uphill=*/true);
                     for (PipId uh : ctx->getPipsUphill(curr_data.w)) {
+                        int next_idx = *uh_src++;
                         if (bound_pip != PipId() && bound_pip != uh)
                             continue;
                         if (is_bb && !hit_test_pip(nd.bb, ctx->getPipLocation(uh)))
                             continue;
                         if (!ctx->checkPipAvailForNet(uh, net))
                             continue;
-                        WireId next = ctx->getPipSrcWire(uh);
-                        int next_idx = wire_to_idx.at(next);
+                        auto &nwd = flat_wires[next_idx];
+                        WireId next = nwd.w;
                         WireScore next_score;
                         next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, next, uh, crit_weight);
-                        next_score.cost = curr.score.cost + score_wire_for_arc(net, i, phys_pin, next, uh, crit_weight);
+                        next_score.cost =
+                                curr.score.cost + score_wire_for_arc(net, i, phys_pin, next_idx, uh, crit_weight);
                         next_score.togo_cost = const_mode
                                                        ? 0
                                                        : cfg.estimate_weight * get_togo_cost(net, i, next_idx, src_wire,
@@ -794,16 +1144,16 @@ struct Router2
                             // Don't expand the same node twice.
                             continue;
                         }
-                        auto &nwd = flat_wires.at(next_idx);
-                        if (nwd.unavailable)
+                        auto &nwc = wire_cong[next_idx];
+                        if (nwc.unavailable)
                             continue;
                         // Reserved for another net
-                        if (nwd.reserved_net != -1 && nwd.reserved_net != net->udata)
+                        if (nwc.reserved_net != -1 && nwc.reserved_net != net->udata)
                             continue;
                         if (!thread_test_wire(t, nwd))
                             continue; // thread safety issue
                         set_visited_bwd(t, next_idx, uh, next_score.delay);
-                        t.bwd_queue.push(QueuedWire(next_idx, next_score, t.rng.rng()));
+                        queue_push(s.bwd_queue, QueuedWire(next_idx, next_score, t.rng.rng()));
                     }
                 }
             }
@@ -814,18 +1164,19 @@ struct Router2
         if (midpoint_wire != -1) {
             ROUTE_LOG_DBG("   Routed (explored %d wires): ", explored);
             if (const_mode) {
-                bind_pip_internal(nd, i, midpoint_wire, PipId());
+                bind_pip_internal(s.arena, nd, i, midpoint_wire, PipId());
             } else {
                 int cursor_bwd = midpoint_wire;
                 while (was_visited_fwd(cursor_bwd, std::numeric_limits<float>::max())) {
-                    PipId pip = flat_wires.at(cursor_bwd).pip_fwd;
+                    PipId pip = wire_visits.at(cursor_bwd).pip_fwd;
                     if (pip == PipId() && cursor_bwd != src_wire_idx)
                         break;
-                    bind_pip_internal(nd, i, cursor_bwd, pip);
+                    bind_pip_internal(s.arena, nd, i, cursor_bwd, pip);
                     if (ctx->debug && !is_mt) {
                         auto &wd = flat_wires.at(cursor_bwd);
+                        auto &wc = wire_cong.at(cursor_bwd);
                         ROUTE_LOG_DBG("      fwd wire: %s (curr %d hist %f share %d)\n", ctx->nameOfWire(wd.w),
-                                      wd.curr_cong - 1, wd.hist_cong_cost, nd.wires.at(wd.w).second);
+                                      wc.curr_cong - 1, wc.hist_cong_cost, nd.wires.at(wd.w).arcs);
                     }
                     if (pip == PipId()) {
                         break;
@@ -838,16 +1189,17 @@ struct Router2
                 while (cursor_bwd != src_wire_idx) {
                     // Tack onto existing routing
                     WireId bwd_w = flat_wires.at(cursor_bwd).w;
-                    if (!nd.wires.count(bwd_w))
+                    const NetWire *bound = nd.wires.find(bwd_w);
+                    if (bound == nullptr)
                         break;
-                    auto &bound = nd.wires.at(bwd_w);
-                    PipId pip = bound.first;
+                    PipId pip = bound->pip;
                     if (ctx->debug && !is_mt) {
                         auto &wd = flat_wires.at(cursor_bwd);
+                        auto &wc = wire_cong.at(cursor_bwd);
                         ROUTE_LOG_DBG("      ext wire: %s (curr %d hist %f share %d)\n", ctx->nameOfWire(wd.w),
-                                      wd.curr_cong - 1, wd.hist_cong_cost, bound.second);
+                                      wc.curr_cong - 1, wc.hist_cong_cost, bound->arcs);
                     }
-                    bind_pip_internal(nd, i, cursor_bwd, pip);
+                    bind_pip_internal(s.arena, nd, i, cursor_bwd, pip);
                     if (pip == PipId())
                         break;
                     cursor_bwd = wire_to_idx.at(ctx->getPipSrcWire(pip));
@@ -858,24 +1210,25 @@ struct Router2
 
             int cursor_fwd = midpoint_wire;
             while (was_visited_bwd(cursor_fwd, std::numeric_limits<float>::max())) {
-                PipId pip = flat_wires.at(cursor_fwd).pip_bwd;
+                PipId pip = wire_visits.at(cursor_fwd).pip_bwd;
                 if (pip == PipId()) {
                     break;
                 }
                 ROUTE_LOG_DBG("         bwd pip: %s (%d, %d)\n", ctx->nameOfPip(pip), ctx->getPipLocation(pip).x,
                               ctx->getPipLocation(pip).y);
                 cursor_fwd = wire_to_idx.at(ctx->getPipDstWire(pip));
-                bind_pip_internal(nd, i, cursor_fwd, pip);
+                bind_pip_internal(s.arena, nd, i, cursor_fwd, pip);
                 if (ctx->debug && !is_mt) {
                     auto &wd = flat_wires.at(cursor_fwd);
+                    auto &wc = wire_cong.at(cursor_fwd);
                     ROUTE_LOG_DBG("      bwd wire: %s (curr %d hist %f share %d)\n", ctx->nameOfWire(wd.w),
-                                  wd.curr_cong - 1, wd.hist_cong_cost, nd.wires.at(wd.w).second);
+                                  wc.curr_cong - 1, wc.hist_cong_cost, nd.wires.at(wd.w).arcs);
                 }
             }
             NPNR_ASSERT(cursor_fwd == dst_wire_idx);
 
             update_wire_by_loc(t, net, i, phys_pin, is_mt);
-            t.processed_sinks.insert(dst_wire);
+            nd.wires.at(dst_wire).sink_stamp = nd.route_stamp;
             ad.routed = true;
             auto arc_end = std::chrono::high_resolution_clock::now();
             ROUTE_LOG_DBG("Routing arc %d of net '%s' (is_bb = %d) took %02fs\n", i.idx(), ctx->nameOf(net), is_bb,
@@ -887,6 +1240,7 @@ struct Router2
             result = ARC_RETRY_WITHOUT_BB;
         }
         reset_wires(t);
+        t.explored_wires += explored;
         return result;
     }
 #undef ARC_ERR
@@ -908,11 +1262,8 @@ struct Router2
             return true;
 
         bool have_failures = false;
-        t.processed_sinks.clear();
-        t.route_arcs.clear();
-        t.wire_by_loc.clear();
-        t.in_wire_by_loc.clear();
         auto &nd = nets.at(net->udata);
+        reset_net_state(t, nd);
         bool failed_slack = false;
         for (auto usr : net->users.enumerate())
             failed_slack |= arc_failed_slack(net, usr.index);
@@ -928,15 +1279,15 @@ struct Router2
 
                 // Ripup arc to start with
                 ripup_arc(net, usr.index, j);
-                t.route_arcs.emplace_back(usr.index, j);
+                t.search->route_arcs.emplace_back(usr.index, j);
             }
         }
         // Route most critical arc first
-        std::stable_sort(t.route_arcs.begin(), t.route_arcs.end(),
+        std::stable_sort(t.search->route_arcs.begin(), t.search->route_arcs.end(),
                          [&](std::pair<store_index<PortRef>, size_t> a, std::pair<store_index<PortRef>, size_t> b) {
                              return get_arc_crit(net, a.first) > get_arc_crit(net, b.first);
                          });
-        for (auto a : t.route_arcs) {
+        for (auto a : t.search->route_arcs) {
             auto res1 = route_arc(t, net, a.first, a.second, is_mt, true);
             if (res1 == ARC_FATAL)
                 return false; // Arc failed irrecoverably
@@ -993,15 +1344,15 @@ struct Router2
             auto &nd = nets.at(i);
             for (const auto &w : nd.wires) {
                 ++total_wire_use;
-                auto &wd = wire_data(w.first);
+                auto &wd = wire_cong_data(w.wire);
                 if (wd.curr_cong > 1) {
-                    if (already_updated.count(w.first)) {
+                    if (already_updated.count(w.wire)) {
                         ++total_overuse;
                     } else {
                         if (curr_cong_weight > 0)
                             wd.hist_cong_cost =
                                     std::min(1e9, wd.hist_cong_cost + (wd.curr_cong - 1) * hist_cong_weight);
-                        already_updated.insert(w.first);
+                        already_updated.insert(w.wire);
                         ++overused_wires;
                     }
                     failed_nets.insert(i);
@@ -1067,13 +1418,13 @@ struct Router2
                     break;
                 }
             }
-            if (!nd.wires.count(cursor)) {
+            if (nd.wires.find(cursor) == nullptr) {
                 log("Failure details:\n");
                 log("    Cursor: %s\n", ctx->nameOfWire(cursor));
                 log_error("Internal error; incomplete route tree for arc %d of net %s.\n", usr_idx.idx(),
                           ctx->nameOf(net));
             }
-            PipId p = nd.wires.at(cursor).first;
+            PipId p = nd.wires.at(cursor).pip;
             if (ctx->checkPipAvailForNet(p, net)) {
                 NetInfo *bound_net = ctx->getBoundPipNet(p);
                 if (bound_net == nullptr) {
@@ -1157,9 +1508,9 @@ struct Router2
         dict<IdString, std::vector<int>> cong_by_type;
         size_t max_cong = 0;
         // Build histogram
-        for (auto &wd : flat_wires) {
-            size_t val = wd.curr_cong;
-            IdString type = ctx->getWireType(wd.w);
+        for (size_t i = 0; i < flat_wires.size(); i++) {
+            size_t val = wire_cong[i].curr_cong;
+            IdString type = ctx->getWireType(flat_wires[i].w);
             max_cong = std::max(max_cong, val);
             if (cong_by_type[type].size() <= max_cong)
                 cong_by_type[type].resize(max_cong + 1);
@@ -1181,10 +1532,10 @@ struct Router2
     void write_utilisation_by_wiretype_heatmap(std::ostream &out)
     {
         dict<IdString, int> util_by_type;
-        for (auto &wd : flat_wires) {
-            IdString type = ctx->getWireType(wd.w);
-            if (wd.curr_cong > 0)
-                util_by_type[type] += wd.curr_cong;
+        for (size_t i = 0; i < flat_wires.size(); i++) {
+            IdString type = ctx->getWireType(flat_wires[i].w);
+            if (wire_cong[i].curr_cong > 0)
+                util_by_type[type] += wire_cong[i].curr_cong;
         }
         // Write csv
         for (auto &u : util_by_type)
@@ -1195,9 +1546,9 @@ struct Router2
     {
         auto util_by_coord =
                 std::vector<std::vector<int>>(ctx->getGridDimX() + 1, std::vector<int>(ctx->getGridDimY() + 1, 0));
-        for (auto &wd : flat_wires)
-            if (wd.curr_cong > 1)
-                util_by_coord[wd.x][wd.y] += wd.curr_cong;
+        for (size_t i = 0; i < flat_wires.size(); i++)
+            if (wire_cong[i].curr_cong > 1)
+                util_by_coord[flat_wires[i].x][flat_wires[i].y] += wire_cong[i].curr_cong;
         // Write csv
         for (auto &x : util_by_coord) {
             for (auto y : x)
@@ -1206,51 +1557,79 @@ struct Router2
         }
     }
 
-    int mid_x = 0, mid_y = 0;
+    // A node of the k-d partitioning used for multithreaded routing. Nodes at the same level never overlap, so can
+    // be routed concurrently; nets that cross the split line of a node stay with that node and are routed after
+    // both of its children.
+    struct PartitionNode
+    {
+        int level = 0;
+        ThreadContext tc;
+        float route_time = 0;
+    };
 
-    void partition_nets()
+    struct PartitionLevelStats
     {
-        // Create a histogram of positions in X and Y positions
-        std::map<int, int> cxs, cys;
-        for (auto &n : nets) {
-            if (n.cx != -1)
-                ++cxs[n.cx];
-            if (n.cy != -1)
-                ++cys[n.cy];
-        }
-        // 4-way split for now
-        int accum_x = 0, accum_y = 0;
-        int halfway = int(nets.size()) / 2;
-        for (auto &p : cxs) {
-            if (accum_x < halfway && (accum_x + p.second) >= halfway)
-                mid_x = p.first;
-            accum_x += p.second;
-        }
-        for (auto &p : cys) {
-            if (accum_y < halfway && (accum_y + p.second) >= halfway)
-                mid_y = p.first;
-            accum_y += p.second;
+        int parts = 0, nets = 0;
+        // Sum of per-partition routing time, and elapsed time for the whole level
+        float busy_time = 0, wall_time = 0;
+    };
+    std::vector<PartitionLevelStats> level_stats;
+    int64_t total_explored_wires = 0;
+    int64_t total_cache_misses = 0;
+    bool cache_misses_unavailable = false;
+
+    // Don't split regions containing fewer nets than this (heuristic)
+    static constexpr int min_partition_nets = 64;
+
+    void partition_region(std::vector<PartitionNode> &parts, const BoundingBox &region, int level, int k,
+                          const std::vector<int> &region_nets)
+    {
+        int idx = int(parts.size());
+        parts.emplace_back();
+        parts.back().level = level;
+        parts.back().tc.bb = region;
+        parts.back().tc.rng.rngseed(ctx->rng64());
+        parts.back().tc.search = &search_state(idx);
+        // Split along the longest axis of the region, clamped to the device grid
+        int x1 = std::min(region.x1, ctx->getGridDimX()), y1 = std::min(region.y1, ctx->getGridDimY());
+        bool split_x = (x1 - region.x0) >= (y1 - region.y0);
+        int lo_bound = split_x ? region.x0 : region.y0, hi_bound = split_x ? x1 : y1;
+        if (k <= 1 || (hi_bound - lo_bound) < 4 || int(region_nets.size()) < min_partition_nets) {
+            for (int n : region_nets)
+                parts.at(idx).tc.route_nets.push_back(nets_by_udata.at(n));
+            return;
         }
-        if (ctx->verbose) {
-            log_info("    x splitpoint: %d\n", mid_x);
-            log_info("    y splitpoint: %d\n", mid_y);
+        // Place the split so that the net count on each side is proportional to the number of leaves below it
+        int k_lo = k / 2, k_hi = k - k_lo;
+        std::vector<int> centres;
+        centres.reserve(region_nets.size());
+        for (int n : region_nets)
+            centres.push_back(split_x ? nets.at(n).cx : nets.at(n).cy);
+        size_t pos = (centres.size() * k_lo) / k;
+        std::nth_element(centres.begin(), centres.begin() + pos, centres.end());
+        int split = std::max(lo_bound + 1, std::min(centres.at(pos), hi_bound - 2));
+        BoundingBox lo_bb = region, hi_bb = region;
+        if (split_x) {
+            lo_bb.x1 = split;
+            hi_bb.x0 = split + 1;
+        } else {
+            lo_bb.y1 = split;
+            hi_bb.y0 = split + 1;
         }
-        std::vector<int> bins(5, 0);
-        for (auto &n : nets) {
-            if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[0]; // TL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[1]; // TR
-            else if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[2]; // BL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[3]; // BR
+        std::vector<int> lo_nets, hi_nets;
+        for (int n : region_nets) {
+            auto &nd = nets.at(n);
+            int n0 = split_x ? nd.bb.x0 : nd.bb.y0, n1 = split_x ? nd.bb.x1 : nd.bb.y1;
+            // Keep a margin of one tile either side of the split, as wire locations are only notional
+            if (n1 < split)
+                lo_nets.push_back(n);
+            else if (n0 > (split + 1))
+                hi_nets.push_back(n);
             else
-                ++bins[4]; // cross-boundary
+                parts.at(idx).tc.route_nets.push_back(nets_by_udata.at(n));
         }
-        if (ctx->verbose)
-            for (int i = 0; i < 5; i++)
-                log_info("        bin %d N=%d\n", i, bins[i]);
+        partition_region(parts, lo_bb, level + 1, k_lo, lo_nets);
+        partition_region(parts, hi_bb, level + 1, k_hi, hi_nets);
     }
 
     void router_thread(ThreadContext &t, bool is_mt)
@@ -1265,112 +1644,92 @@ struct Router2
     void do_route()
     {
         // Don't multithread if fewer than 200 nets (heuristic)
-        if (route_queue.size() < 200) {
+        if (route_queue.size() < 200 || cfg.threads <= 1) {
             ThreadContext st;
+            st.search = &search_state(0);
             st.rng.rngseed(ctx->rng64());
             st.bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-            for (size_t j = 0; j < route_queue.size(); j++) {
-                route_net(st, nets_by_udata[route_queue[j]], false);
-            }
+            count_cache_misses(st, [&]() {
+                for (size_t j = 0; j < route_queue.size(); j++) {
+                    route_net(st, nets_by_udata[route_queue[j]], false);
+                }
+            });
+            total_explored_wires += st.explored_wires;
+            total_cache_misses += st.cache_misses;
+            cache_misses_unavailable |= st.cache_misses_unavailable;
             return;
         }
-        const int Nq = 4, Nv = 2, Nh = 2;
-        const int N = Nq + Nv + Nh;
-        std::vector<ThreadContext> tcs(N + 1);
-        for (auto &th : tcs) {
-            th.rng.rngseed(ctx->rng64());
-        }
-        int le_x = mid_x;
-        int rs_x = mid_x;
-        int le_y = mid_y;
-        int rs_y = mid_y;
-        // Set up thread bounding boxes
-        tcs.at(0).bb = BoundingBox(0, 0, mid_x, mid_y);
-        tcs.at(1).bb = BoundingBox(mid_x + 1, 0, std::numeric_limits<int>::max(), le_y);
-        tcs.at(2).bb = BoundingBox(0, mid_y + 1, mid_x, std::numeric_limits<int>::max());
-        tcs.at(3).bb =
-                BoundingBox(mid_x + 1, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(4).bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), mid_y);
-        tcs.at(5).bb = BoundingBox(0, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(6).bb = BoundingBox(0, 0, mid_x, std::numeric_limits<int>::max());
-        tcs.at(7).bb = BoundingBox(mid_x + 1, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(8).bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        for (auto n : route_queue) {
-            auto &nd = nets.at(n);
-            auto ni = nets_by_udata.at(n);
-            int bin = N;
-            // Quadrants
-            if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 1;
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 2;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 3;
-            // Vertical split
-            else if (nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = Nq + 0;
-            else if (nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = Nq + 1;
-            // Horizontal split
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x)
-                bin = Nq + Nv + 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x)
-                bin = Nq + Nv + 1;
-            tcs.at(bin).route_nets.push_back(ni);
-        }
+        std::vector<PartitionNode> parts;
+        partition_region(parts, BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()),
+                         0, cfg.threads, route_queue);
+        int max_level = 0;
+        for (auto &p : parts)
+            max_level = std::max(max_level, p.level);
+        if (int(level_stats.size()) <= max_level)
+            level_stats.resize(max_level + 1);
         if (ctx->verbose)
-            log_info("%d/%d nets not multi-threadable\n", int(tcs.at(N).route_nets.size()), int(route_queue.size()));
-#ifdef NPNR_DISABLE_THREADS
-        // Singlethreaded routing - quadrants
-        for (int i = 0; i < Nq; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-        // Vertical splits
-        for (int i = Nq; i < Nq + Nv; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-        // Horizontal splits
-        for (int i = Nq + Nv; i < Nq + Nv + Nh; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-#else
-        // Multithreaded part of routing - quadrants
-        std::vector<boost::thread> threads;
-        for (int i = 0; i < Nq; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
+            log_info("%d/%d nets not multi-threadable\n", int(parts.at(0).tc.route_nets.size()),
+                     int(route_queue.size()));
+        // Route the partitions bottom-up, one level at a time; the root (level 0) is routed singlethreaded
+        for (int level = max_level; level >= 1; level--) {
+            std::vector<int> level_parts;
+            for (int i = 0; i < int(parts.size()); i++)
+                if (parts.at(i).level == level)
+                    level_parts.push_back(i);
+            auto route_part = [this, &parts](int i, bool is_mt) {
+                auto pstart = std::chrono::high_resolution_clock::now();
+                count_cache_misses(parts.at(i).tc, [&]() { router_thread(parts.at(i).tc, is_mt); });
+                auto pend = std::chrono::high_resolution_clock::now();
+                parts.at(i).route_time = std::chrono::duration<float>(pend - pstart).count();
+            };
+            auto lstart = std::chrono::high_resolution_clock::now();
+            TaskGroup level_tasks(ctx->threadPool());
+            for (int i : level_parts)
+                level_tasks.run([&route_part, i]() { route_part(i, /*is_mt=*/true); });
+            level_tasks.wait();
+            auto lend = std::chrono::high_resolution_clock::now();
+            auto &stats = level_stats.at(level);
+            stats.parts = std::max(stats.parts, int(level_parts.size()));
+            stats.wall_time += std::chrono::duration<float>(lend - lstart).count();
+            for (int i : level_parts) {
+                stats.nets += int(parts.at(i).tc.route_nets.size());
+                stats.busy_time += parts.at(i).route_time;
+            }
         }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-        // Vertical splits
-        for (int i = Nq; i < Nq + Nv; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
+        // Singlethreaded part of routing - nets that cross the root partition
+        // or don't fit within bounding box
+        auto &root = parts.at(0);
+        auto sstart = std::chrono::high_resolution_clock::now();
+        count_cache_misses(root.tc, [&]() {
+            for (auto st_net : root.tc.route_nets)
+                route_net(root.tc, st_net, false);
+            // Failed nets
+            for (int i = 1; i < int(parts.size()); i++)
+                for (auto fail : parts.at(i).tc.failed_nets)
+                    route_net(root.tc, fail, false);
+        });
+        auto send = std::chrono::high_resolution_clock::now();
+        auto &root_stats = level_stats.at(0);
+        root_stats.parts = 1;
+        root_stats.nets += int(root.tc.route_nets.size());
+        root_stats.wall_time += std::chrono::duration<float>(send - sstart).count();
+        root_stats.busy_time += std::chrono::duration<float>(send - sstart).count();
+        for (auto &p : parts) {
+            total_explored_wires += p.tc.explored_wires;
+            total_cache_misses += p.tc.cache_misses;
+            cache_misses_unavailable |= p.tc.cache_misses_unavailable;
         }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-        // Horizontal splits
-        for (int i = Nq + Nv; i < Nq + Nv + Nh; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
+    }
+
+    void log_partition_stats()
+    {
+        log_info("Partition utilisation by level (%d threads):\n", cfg.threads);
+        for (int level = int(level_stats.size()) - 1; level >= 0; level--) {
+            auto &stats = level_stats.at(level);
+            float util = stats.wall_time > 0 ? (stats.busy_time / (stats.wall_time * stats.parts)) : 0;
+            log_info("    level %d: %3d partitions %8d nets %8.02fs %5.1f%% utilisation\n", level, stats.parts,
+                     stats.nets, stats.wall_time, 100.0f * util);
         }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-#endif
-        // Singlethreaded part of routing - nets that cross partitions
-        // or don't fit within bounding box
-        for (auto st_net : tcs.at(N).route_nets)
-            route_net(tcs.at(N), st_net, false);
-        // Failed nets
-        for (int i = 0; i < N; i++)
-            for (auto fail : tcs.at(i).failed_nets)
-                route_net(tcs.at(N), fail, false);
     }
 
     delay_t get_route_delay(int net, store_index<PortRef> usr_idx, int phys_idx)
@@ -1385,13 +1744,13 @@ struct Router2
         delay_t delay = 0;
         while (true) {
             delay += ctx->getWireDelay(cursor).maxDelay();
-            if (!nd.wires.count(cursor))
+            const NetWire *bound = nd.wires.find(cursor);
+            if (bound == nullptr)
                 break;
-            auto &bound = nd.wires.at(cursor);
-            if (bound.first == PipId())
+            if (bound->pip == PipId())
                 break;
-            delay += ctx->getPipDelay(bound.first).maxDelay();
-            cursor = ctx->getPipSrcWire(bound.first);
+            delay += ctx->getPipDelay(bound->pip).maxDelay();
+            cursor = ctx->getPipSrcWire(bound->pip);
         }
         NPNR_ASSERT(cursor == nd.src_wire);
         return delay;
@@ -1417,13 +1776,16 @@ struct Router2
 
     void operator()()
     {
+        ProfileScope profile(ctx->profiler, "router2");
         log_info("Running router2...\n");
         log_info("Setting up routing resources...\n");
         auto rstart = std::chrono::high_resolution_clock::now();
-        setup_nets();
-        setup_wires();
-        find_all_reserved_wires();
-        partition_nets();
+        {
+            ProfileScope setup_profile(ctx->profiler, "setup");
+            setup_nets();
+            setup_wires();
+            find_all_reserved_wires();
+        }
         curr_cong_weight = cfg.init_curr_cong_weight;
         hist_cong_weight = cfg.hist_cong_weight;
         ThreadContext st;
@@ -1443,6 +1805,7 @@ struct Router2
         if (timing_driven)
             tmg.run(true);
         do {
+            ProfileScope iter_profile(ctx->profiler, "iteration");
             ctx->sorted_shuffle(route_queue);
 
             if (timing_driven && int(route_queue.size()) >= 30) {
@@ -1535,7 +1898,31 @@ struct Router2
                     int(ctx->nets.at(nets_by_runtime.at(i).second)->users.entries()),
                     nets_by_runtime.at(i).first / 1000.0);
             }
+            int64_t total_us = 0;
+            for (auto &n : nets)
+                total_us += n.total_route_us;
+            log_info("%lld wires explored, %.1fns per explored wire\n", (long long)total_explored_wires,
+                     total_explored_wires > 0 ? (1000.0 * total_us) / total_explored_wires : 0.0);
+            if (cache_misses_unavailable)
+                log_info("cache misses not counted, as the hardware performance counters are unavailable\n");
+            else
+                log_info("%lld last level cache misses while routing, %.2f per explored wire\n",
+                         (long long)total_cache_misses,
+                         total_explored_wires > 0 ? double(total_cache_misses) / total_explored_wires : 0.0);
+            int64_t blocks = 0, reused_blocks = 0, heap_allocs = 0, stamped_resets = 0;
+            for (auto &s : search_states) {
+                blocks += s->arena.blocks;
+                reused_blocks += s->arena.reused_blocks;
+                heap_allocs += s->arena.heap_allocs;
+                stamped_resets += s->stamped_resets;
+            }
+            log_info("%lld net wire table blocks allocated, %lld of them reused, with %lld heap allocations\n",
+                     (long long)blocks, (long long)reused_blocks, (long long)heap_allocs);
+            log_info("%lld per-net search state resets by stamp, using %d pooled search states\n",
+                     (long long)stamped_resets, int(search_states.size()));
         }
+        if ((ctx->verbose || cfg.perf_profile) && !level_stats.empty())
+            log_partition_stats();
         auto rend = std::chrono::high_resolution_clock::now();
         log_info("Router2 time %.02fs\n", std::chrono::duration<float>(rend - rstart).count());
 
@@ -1575,6 +1962,7 @@ Router2Cfg::Router2Cfg(Context *ctx)
         estimate_weight = ctx->setting<float>("router2/estimateWeight", 1.25f);
     }
     perf_profile = ctx->setting<bool>("router2/perfProfile", false);
+    threads = ctx->threads();
     if (ctx->settings.count(ctx->id("router2/heatmap")))
         heatmap = ctx->settings.at(ctx->id("router2/heatmap")).as_string();
     else
@@ -54,6 +54,10 @@ struct Router2Cfg
     // of choosing a less congestion/delay-optimal route
     float estimate_weight;
 
+    // Number of leaf partitions used for multithreaded routing, and so the
+    // maximum number of nets routed concurrently
+    int threads;
+
     // Print additional performance profiling information
     bool perf_profile = false;
 
@@ -1016,6 +1016,9 @@ struct Arch : BaseArch<ArchRanges>
 
     void assign_arch_info_for_cell(CellInfo *ci);
     void assignArchInfo() override;
+    // tile_status and lutperm_allowed follow from binding, the GSR clock wire is copied
+    bool canForkDesign() const override { return true; }
+    void forkArchState(Context *target) const override;
 
     std::vector<std::pair<std::string, std::string>> get_tiles_at_loc(int row, int col);
     std::string get_tile_by_type_loc(int row, int col, std::string type) const
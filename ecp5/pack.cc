@@ -3035,6 +3035,7 @@ void Arch::assign_arch_info_for_cell(CellInfo *ci)
     if (ci->type == id_TRELLIS_COMB) {
         std::string mode = str_or_default(ci->params, id_MODE, "LOGIC");
         ci->combInfo.flags = ArchCellInfo::COMB_NONE;
+        ci->combInfo.mux_fxad = nullptr;
         if (mode == "CCU2")
             ci->combInfo.flags |= ArchCellInfo::COMB_CARRY;
         if (mode == "DPRAM") {
@@ -3162,6 +3163,8 @@ void Arch::assign_arch_info_for_cell(CellInfo *ci)
     }
 }
 
+void Arch::forkArchState(Context *target) const { target->gsrclk_wire = gsrclk_wire; }
+
 void Arch::assignArchInfo()
 {
     for (auto &cell : cells) {
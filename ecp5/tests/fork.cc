@@ -0,0 +1,177 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <sstream>
+#include "gtest/gtest.h"
+#include "json_frontend.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+// Two LUTs and two registers with a global set/reset, which the packer records the clock wire of
+const char *design = R"({"modules": {"top": {
+    "attributes": {"top": "00000000000000000000000000000001"},
+    "ports": {
+        "clk": {"direction": "input", "bits": [2]},
+        "a": {"direction": "input", "bits": [3]},
+        "b": {"direction": "input", "bits": [4]},
+        "rst_n": {"direction": "input", "bits": [5]},
+        "q": {"direction": "output", "bits": [6]}
+    },
+    "cells": {
+        "gsr": {"type": "GSR", "port_directions": {"GSR": "input"}, "connections": {"GSR": [5]}},
+        "lut0": {"type": "LUT4", "parameters": {"INIT": "0110011001100110"},
+                 "port_directions": {"A": "input", "B": "input", "C": "input", "D": "input", "Z": "output"},
+                 "connections": {"A": [3], "B": [4], "C": ["0"], "D": ["0"], "Z": [7]}},
+        "ff0": {"type": "TRELLIS_FF", "parameters": {"GSR": "ENABLED", "CEMUX": "1", "CLKMUX": "CLK",
+                                                     "LSRMUX": "LSR", "REGSET": "RESET", "SRMODE": "LSR_OVER_CE"},
+                "port_directions": {"CLK": "input", "DI": "input", "Q": "output"},
+                "connections": {"CLK": [2], "DI": [7], "Q": [8]}},
+        "lut1": {"type": "LUT4", "parameters": {"INIT": "0101010101010101"},
+                 "port_directions": {"A": "input", "B": "input", "C": "input", "D": "input", "Z": "output"},
+                 "connections": {"A": [8], "B": ["0"], "C": ["0"], "D": ["0"], "Z": [9]}},
+        "ff1": {"type": "TRELLIS_FF", "parameters": {"GSR": "ENABLED", "CEMUX": "1", "CLKMUX": "CLK",
+                                                     "LSRMUX": "LSR", "REGSET": "RESET", "SRMODE": "LSR_OVER_CE"},
+                "port_directions": {"CLK": "input", "DI": "input", "Q": "output"},
+                "connections": {"CLK": [2], "DI": [9], "Q": [6]}}
+    },
+    "netnames": {
+        "clk": {"bits": [2]}, "a": {"bits": [3]}, "b": {"bits": [4]}, "rst_n": {"bits": [5]}, "q": {"bits": [6]},
+        "d0": {"bits": [7]}, "q0": {"bits": [8]}, "d1": {"bits": [9]}
+    }
+}}})";
+} // namespace
+
+class ECP5ForkTest : public ::testing::Test
+{
+  protected:
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.type = ArchArgs::LFE5U_25F;
+        chipArgs.package = "CABGA256";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        // The defaults the command line handler would set
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        ctx->settings[ctx->id("timing_driven")] = true;
+        ctx->settings[ctx->id("slack_redist_iter")] = 0;
+        ctx->settings[ctx->id("auto_freq")] = false;
+        ctx->settings[ctx->id("placer")] = std::string("sa");
+        ctx->settings[ctx->id("router")] = Arch::defaultRouter;
+        return ctx;
+    }
+
+    std::unique_ptr<Context> load_design()
+    {
+        auto ctx = create_context();
+        std::istringstream in(design);
+        EXPECT_TRUE(parse_json(in, "design.json", ctx.get()));
+        EXPECT_TRUE(ctx->pack());
+        return ctx;
+    }
+
+    std::unique_ptr<Context> fork_design(const Context *ctx)
+    {
+        auto forked = create_context();
+        ctx->forkInto(forked.get());
+        return forked;
+    }
+
+    const char *name_of(const Context *ctx, const CellInfo *cell) { return cell ? ctx->nameOf(cell) : "-"; }
+
+    // Checks that forked has the netlist, placement and routing of ctx, and that the arch state built from binding
+    // them is the same
+    void expect_same_design(const Context *ctx, const Context *forked)
+    {
+        ASSERT_EQ(forked->cells.size(), ctx->cells.size());
+        ASSERT_EQ(forked->nets.size(), ctx->nets.size());
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get(), *fi = forked->cells.at(cell.first).get();
+            EXPECT_EQ(fi->type, ci->type);
+            EXPECT_EQ(fi->params, ci->params);
+            EXPECT_EQ(fi->bel, ci->bel) << ctx->nameOf(ci);
+            if (ci->type == id_TRELLIS_COMB) {
+                EXPECT_EQ(fi->combInfo.flags, ci->combInfo.flags);
+            } else if (ci->type == id_TRELLIS_FF) {
+                EXPECT_EQ(fi->ffInfo.flags, ci->ffInfo.flags);
+                EXPECT_EQ(fi->ffInfo.clk_sig, ci->ffInfo.clk_sig);
+            }
+            for (auto &port : ci->ports) {
+                const NetInfo *fn = fi->getPort(port.first);
+                EXPECT_EQ(fn ? fn->name : IdString(), port.second.net ? port.second.net->name : IdString());
+            }
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get(), *fn = forked->nets.at(net.first).get();
+            EXPECT_EQ(fn->is_global, ni->is_global);
+            ASSERT_EQ(fn->wires.size(), ni->wires.size()) << ctx->nameOf(ni);
+            for (auto &wire : ni->wires) {
+                EXPECT_EQ(fn->wires.at(wire.first).pip, wire.second.pip);
+                EXPECT_EQ(forked->getBoundWireNet(wire.first), fn);
+            }
+        }
+        EXPECT_NE(ctx->gsrclk_wire, WireId());
+        EXPECT_EQ(forked->gsrclk_wire, ctx->gsrclk_wire);
+        EXPECT_EQ(forked->lutperm_allowed, ctx->lutperm_allowed);
+        ASSERT_EQ(forked->tile_status.size(), ctx->tile_status.size());
+        for (size_t i = 0; i < ctx->tile_status.size(); i++) {
+            auto &ts = ctx->tile_status.at(i), &fts = forked->tile_status.at(i);
+            ASSERT_EQ(fts.boundcells.size(), ts.boundcells.size());
+            for (size_t j = 0; j < ts.boundcells.size(); j++)
+                EXPECT_STREQ(name_of(forked, fts.boundcells.at(j)), name_of(ctx, ts.boundcells.at(j)));
+            ASSERT_EQ(fts.lts == nullptr, ts.lts == nullptr);
+            if (ts.lts) {
+                for (size_t z = 0; z < ts.lts->cells.size(); z++)
+                    EXPECT_STREQ(name_of(forked, fts.lts->cells.at(z)), name_of(ctx, ts.lts->cells.at(z)));
+            }
+        }
+    }
+};
+
+TEST_F(ECP5ForkTest, packed)
+{
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->canForkDesign());
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ECP5ForkTest, routed)
+{
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ECP5ForkTest, same_result)
+{
+    auto ctx = load_design();
+    auto forked = fork_design(ctx.get());
+    for (Context *c : {ctx.get(), forked.get()}) {
+        c->rngseed(3);
+        ASSERT_TRUE(c->place());
+        ASSERT_TRUE(c->route());
+    }
+    expect_same_design(ctx.get(), forked.get());
+}
@@ -65,8 +65,8 @@
  *   const BitVectorDataType &get_port_bits(const ModulePortDataType &port) const;
  *       gets the bit vector of a module port
  *
- *   const std::string& get_cell_type(const CellDataType &cell) const;
- *       gets the type of a cell
+ *   std::string get_cell_type(const CellDataType &cell) const;
+ *       gets the type of a cell (may also return a const reference)
  *
  *   void foreach_attr(const {ModuleDataType|CellDataType|ModulePortDataType|NetnameDataType} &obj, Func) const;
  *       calls Func(const std::string &name, const Property &value);
@@ -19,61 +19,493 @@
 
 #include "json_frontend.h"
 #include "frontend_base.h"
-#include "json11.hpp"
 #include "log.h"
 #include "nextpnr.h"
 
+#include <algorithm>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <limits>
 #include <streambuf>
+#include <string_view>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
 
 NEXTPNR_NAMESPACE_BEGIN
 
-using namespace json11;
+namespace {
+
+/*
+A compact, read-only JSON document.
+
+The whole input is tokenised in a single pass into flat arrays of nodes and object/array items, with no per-value
+allocation; strings are views into the input buffer (which must outlive the document), except for those containing
+escapes which are decoded into a side arena. Object members are sorted by key once parsed, so lookups are a binary
+search and iteration order is the same as the map-based DOM this replaces (including the last of any duplicate keys
+winning), so the design is imported identically.
+
+Comments are accepted as in the json11 COMMENTS mode.
+*/
+struct JsonDoc
+{
+    enum NodeType : uint8_t
+    {
+        J_NULL,
+        J_BOOL,
+        J_NUMBER,
+        J_STRING,
+        J_ARRAY,
+        J_OBJECT,
+    };
+
+    struct Node
+    {
+        NodeType type = J_NULL;
+        bool bool_value = false;
+        double number = 0;
+        std::string_view str;
+        // Range of children in items; array elements in order, and object members sorted by key
+        int first = 0, count = 0;
+
+        bool is_null() const { return type == J_NULL; }
+        bool is_number() const { return type == J_NUMBER; }
+        bool is_string() const { return type == J_STRING; }
+        int int_value() const { return (type == J_NUMBER) ? int(number) : 0; }
+    };
+
+    struct Item
+    {
+        std::string_view key;
+        int node;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    std::deque<std::string> decoded;
+
+    const Node &root() const { return nodes.front(); }
+    const Node &child(const Node &parent, int i) const { return nodes[items[parent.first + i].node]; }
+    std::string_view key(const Node &parent, int i) const { return items[parent.first + i].key; }
+
+    // Member of an object, or a null node if it isn't present
+    const Node &get(const Node &obj, std::string_view key) const
+    {
+        static const Node null_node;
+        if (obj.type != J_OBJECT)
+            return null_node;
+        auto begin = items.begin() + obj.first, end = begin + obj.count;
+        auto found = std::lower_bound(begin, end, key, [](const Item &a, std::string_view b) { return a.key < b; });
+        if (found == end || found->key != key)
+            return null_node;
+        return nodes[found->node];
+    }
+
+    bool parse(std::string_view buffer, std::string &error)
+    {
+        buf = buffer;
+        pos = 0;
+        err.clear();
+        nodes.clear();
+        items.clear();
+        parse_value(0);
+        if (err.empty()) {
+            skip_ws();
+            if (err.empty() && pos != buf.size())
+                fail("unexpected trailing " + esc(buf[pos]));
+        }
+        error = err;
+        scratch.clear();
+        scratch.shrink_to_fit();
+        return err.empty();
+    }
+
+  private:
+    static constexpr int max_depth = 200;
+
+    std::string_view buf;
+    size_t pos = 0;
+    std::string err;
+    // Items of the objects and arrays currently being parsed, before they are moved into `items`
+    std::vector<Item> scratch;
+
+    static std::string esc(char c)
+    {
+        char tmp[12];
+        if (uint8_t(c) >= 0x20 && uint8_t(c) <= 0x7f)
+            snprintf(tmp, sizeof tmp, "'%c' (%d)", c, c);
+        else
+            snprintf(tmp, sizeof tmp, "(%d)", c);
+        return std::string(tmp);
+    }
+
+    void fail(const std::string &msg)
+    {
+        if (err.empty())
+            err = msg + stringf(" at offset %zu", pos);
+    }
+
+    void skip_ws()
+    {
+        while (pos < buf.size()) {
+            char c = buf[pos];
+            if (c == ' ' || c == '\r' || c == '\n' || c == '\t') {
+                pos++;
+            } else if (c == '/' && pos + 1 < buf.size() && buf[pos + 1] == '/') {
+                while (pos < buf.size() && buf[pos] != '\n')
+                    pos++;
+            } else if (c == '/' && pos + 1 < buf.size() && buf[pos + 1] == '*') {
+                size_t end = buf.find("*/", pos + 2);
+                if (end == std::string_view::npos) {
+                    fail("unexpected end of input inside multi-line comment");
+                    pos = buf.size();
+                    return;
+                }
+                pos = end + 2;
+            } else {
+                return;
+            }
+        }
+    }
+
+    static void encode_utf8(long pt, std::string &out)
+    {
+        if (pt < 0)
+            return;
+        if (pt < 0x80) {
+            out += char(pt);
+        } else if (pt < 0x800) {
+            out += char((pt >> 6) | 0xC0);
+            out += char((pt & 0x3F) | 0x80);
+        } else if (pt < 0x10000) {
+            out += char((pt >> 12) | 0xE0);
+            out += char(((pt >> 6) & 0x3F) | 0x80);
+            out += char((pt & 0x3F) | 0x80);
+        } else {
+            out += char((pt >> 18) | 0xF0);
+            out += char(((pt >> 12) & 0x3F) | 0x80);
+            out += char(((pt >> 6) & 0x3F) | 0x80);
+            out += char((pt & 0x3F) | 0x80);
+        }
+    }
+
+    // Parse a string starting after the opening quote
+    std::string_view parse_string()
+    {
+        size_t start = pos;
+        // Fast path: no escapes, so the string can be used in place
+        while (pos < buf.size()) {
+            char c = buf[pos];
+            if (c == '"') {
+                return buf.substr(start, pos++ - start);
+            } else if (c == '\\') {
+                break;
+            } else if (uint8_t(c) < 0x20) {
+                fail("unescaped " + esc(c) + " in string");
+                return {};
+            }
+            pos++;
+        }
+        std::string out(buf.substr(start, pos - start));
+        long last_escaped_codepoint = -1;
+        while (true) {
+            if (pos >= buf.size()) {
+                fail("unexpected end of input in string");
+                return {};
+            }
+            char c = buf[pos++];
+            if (c == '"') {
+                encode_utf8(last_escaped_codepoint, out);
+                break;
+            }
+            if (uint8_t(c) < 0x20) {
+                fail("unescaped " + esc(c) + " in string");
+                return {};
+            }
+            if (c != '\\') {
+                encode_utf8(last_escaped_codepoint, out);
+                last_escaped_codepoint = -1;
+                out += c;
+                continue;
+            }
+            if (pos >= buf.size()) {
+                fail("unexpected end of input in string");
+                return {};
+            }
+            c = buf[pos++];
+            if (c == 'u') {
+                // Escaped unicode, combining UTF-16 surrogate pairs as json11 does
+                if (pos + 4 > buf.size()) {
+                    fail("bad \\u escape");
+                    return {};
+                }
+                long codepoint = 0;
+                for (int i = 0; i < 4; i++) {
+                    char h = buf[pos + i];
+                    int v = (h >= '0' && h <= '9')   ? (h - '0')
+                            : (h >= 'a' && h <= 'f') ? (h - 'a' + 10)
+                            : (h >= 'A' && h <= 'F') ? (h - 'A' + 10)
+                                                     : -1;
+                    if (v < 0) {
+                        fail("bad \\u escape");
+                        return {};
+                    }
+                    codepoint = codepoint * 16 + v;
+                }
+                pos += 4;
+                if (last_escaped_codepoint >= 0xD800 && last_escaped_codepoint <= 0xDBFF && codepoint >= 0xDC00 &&
+                    codepoint <= 0xDFFF) {
+                    encode_utf8((((last_escaped_codepoint - 0xD800) << 10) | (codepoint - 0xDC00)) + 0x10000, out);
+                    last_escaped_codepoint = -1;
+                } else {
+                    encode_utf8(last_escaped_codepoint, out);
+                    last_escaped_codepoint = codepoint;
+                }
+                continue;
+            }
+            encode_utf8(last_escaped_codepoint, out);
+            last_escaped_codepoint = -1;
+            switch (c) {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case '"':
+            case '\\':
+            case '/':
+                out += c;
+                break;
+            default:
+                fail("invalid escape character " + esc(c));
+                return {};
+            }
+        }
+        return decoded.emplace_back(std::move(out));
+    }
+
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    double parse_number()
+    {
+        size_t start = pos;
+        if (pos < buf.size() && buf[pos] == '-')
+            pos++;
+        if (pos < buf.size() && buf[pos] == '0') {
+            pos++;
+            if (pos < buf.size() && is_digit(buf[pos])) {
+                fail("leading 0s not permitted in numbers");
+                return 0;
+            }
+        } else if (pos < buf.size() && buf[pos] >= '1' && buf[pos] <= '9') {
+            while (pos < buf.size() && is_digit(buf[pos]))
+                pos++;
+        } else {
+            fail("invalid " + esc(pos < buf.size() ? buf[pos] : 0) + " in number");
+            return 0;
+        }
+        bool is_int = (pos >= buf.size() || (buf[pos] != '.' && buf[pos] != 'e' && buf[pos] != 'E'));
+        if (is_int && (pos - start) <= size_t(std::numeric_limits<int>::digits10)) {
+            // Integers that certainly fit in an int
+            int value = 0;
+            for (size_t i = start; i < pos; i++)
+                if (is_digit(buf[i]))
+                    value = value * 10 + (buf[i] - '0');
+            return (buf[start] == '-') ? -value : value;
+        }
+        if (pos < buf.size() && buf[pos] == '.') {
+            pos++;
+            if (pos >= buf.size() || !is_digit(buf[pos])) {
+                fail("at least one digit required in fractional part");
+                return 0;
+            }
+            while (pos < buf.size() && is_digit(buf[pos]))
+                pos++;
+        }
+        if (pos < buf.size() && (buf[pos] == 'e' || buf[pos] == 'E')) {
+            pos++;
+            if (pos < buf.size() && (buf[pos] == '+' || buf[pos] == '-'))
+                pos++;
+            if (pos >= buf.size() || !is_digit(buf[pos])) {
+                fail("at least one digit required in exponent");
+                return 0;
+            }
+            while (pos < buf.size() && is_digit(buf[pos]))
+                pos++;
+        }
+        // The input buffer isn't necessarily null terminated
+        std::string tmp(buf.substr(start, pos - start));
+        return std::strtod(tmp.c_str(), nullptr);
+    }
+
+    bool expect(std::string_view literal)
+    {
+        if (buf.substr(pos, literal.size()) != literal) {
+            fail("expected '" + std::string(literal) + "'");
+            return false;
+        }
+        pos += literal.size();
+        return true;
+    }
+
+    // Move the items of an object/array from the scratch stack into their final place
+    void finish_items(int node, size_t scratch_base, bool is_object)
+    {
+        auto begin = scratch.begin() + scratch_base, end = scratch.end();
+        nodes[node].first = int(items.size());
+        if (is_object) {
+            std::stable_sort(begin, end, [](const Item &a, const Item &b) { return a.key < b.key; });
+            // Of duplicate keys, the last one wins
+            for (auto it = begin; it != end; ++it)
+                if (std::next(it) == end || std::next(it)->key != it->key)
+                    items.push_back(*it);
+        } else {
+            items.insert(items.end(), begin, end);
+        }
+        nodes[node].count = int(items.size()) - nodes[node].first;
+        scratch.resize(scratch_base);
+    }
+
+    int parse_value(int depth)
+    {
+        if (depth > max_depth) {
+            fail("exceeded maximum nesting depth");
+            return -1;
+        }
+        skip_ws();
+        int idx = int(nodes.size());
+        nodes.emplace_back();
+        if (!err.empty())
+            return idx;
+        if (pos >= buf.size()) {
+            fail("unexpected end of input");
+            return idx;
+        }
+        char c = buf[pos];
+        if (c == '{' || c == '[') {
+            bool is_object = (c == '{');
+            char close = is_object ? '}' : ']';
+            nodes[idx].type = is_object ? J_OBJECT : J_ARRAY;
+            pos++;
+            size_t scratch_base = scratch.size();
+            skip_ws();
+            if (pos < buf.size() && buf[pos] == close) {
+                pos++;
+                finish_items(idx, scratch_base, is_object);
+                return idx;
+            }
+            while (err.empty()) {
+                std::string_view key;
+                if (is_object) {
+                    skip_ws();
+                    if (pos >= buf.size() || buf[pos] != '"') {
+                        fail("expected '\"' in object");
+                        break;
+                    }
+                    pos++;
+                    key = parse_string();
+                    skip_ws();
+                    if (pos >= buf.size() || buf[pos] != ':') {
+                        fail("expected ':' in object");
+                        break;
+                    }
+                    pos++;
+                }
+                int child = parse_value(depth + 1);
+                scratch.push_back(Item{key, child});
+                skip_ws();
+                if (pos < buf.size() && buf[pos] == close) {
+                    pos++;
+                    break;
+                }
+                if (pos >= buf.size() || buf[pos] != ',') {
+                    fail(std::string("expected ',' or '") + close + "'");
+                    break;
+                }
+                pos++;
+            }
+            finish_items(idx, scratch_base, is_object);
+        } else if (c == '"') {
+            pos++;
+            std::string_view str = parse_string();
+            nodes[idx].type = J_STRING;
+            nodes[idx].str = str;
+        } else if (c == '-' || is_digit(c)) {
+            double number = parse_number();
+            nodes[idx].type = J_NUMBER;
+            nodes[idx].number = number;
+        } else if (c == 't') {
+            if (expect("true")) {
+                nodes[idx].type = J_BOOL;
+                nodes[idx].bool_value = true;
+            }
+        } else if (c == 'f') {
+            if (expect("false"))
+                nodes[idx].type = J_BOOL;
+        } else if (c == 'n') {
+            expect("null");
+        } else {
+            fail("expected value, got " + esc(c));
+        }
+        return idx;
+    }
+};
 
 struct JsonFrontendImpl
 {
     // See specification in frontend_base.h
-    JsonFrontendImpl(Json &root) : root(root) {};
-    Json &root;
-    typedef const Json &ModuleDataType;
-    typedef const Json &ModulePortDataType;
-    typedef const Json &CellDataType;
-    typedef const Json &NetnameDataType;
-    typedef const Json::array &BitVectorDataType;
+    JsonFrontendImpl(const JsonDoc &doc, const JsonDoc::Node &root) : doc(doc), root(root) {};
+    const JsonDoc &doc;
+    const JsonDoc::Node &root;
+    typedef const JsonDoc::Node &ModuleDataType;
+    typedef const JsonDoc::Node &ModulePortDataType;
+    typedef const JsonDoc::Node &CellDataType;
+    typedef const JsonDoc::Node &NetnameDataType;
+    typedef const JsonDoc::Node &BitVectorDataType;
 
-    template <typename TFunc> void foreach_module(TFunc Func) const
+    // Call Func(name, value) for each member of an object. The name buffer is reused between members, so strings are
+    // only allocated for names too long for small string optimisation
+    template <typename TFunc> void foreach_member(const JsonDoc::Node &obj, TFunc Func) const
     {
-        for (const auto &mod : root.object_items())
-            Func(mod.first, mod.second);
+        if (obj.type != JsonDoc::J_OBJECT)
+            return;
+        std::string name;
+        for (int i = 0; i < obj.count; i++) {
+            name.assign(doc.key(obj, i));
+            Func(name, doc.child(obj, i));
+        }
     }
 
+    template <typename TFunc> void foreach_module(TFunc Func) const { foreach_member(root, Func); }
+
     template <typename TFunc> void foreach_port(ModuleDataType &mod, TFunc Func) const
     {
-        const auto &ports = mod["ports"];
-        if (ports.is_null())
-            return;
-        for (const auto &port : ports.object_items())
-            Func(port.first, port.second);
+        foreach_member(doc.get(mod, "ports"), Func);
     }
 
     template <typename TFunc> void foreach_cell(ModuleDataType &mod, TFunc Func) const
     {
-        const auto &cells = mod["cells"];
-        if (cells.is_null())
-            return;
-        for (const auto &cell : cells.object_items())
-            Func(cell.first, cell.second);
+        foreach_member(doc.get(mod, "cells"), Func);
     }
 
     template <typename TFunc> void foreach_netname(ModuleDataType &mod, TFunc Func) const
     {
-        const auto &netnames = mod["netnames"];
-        if (netnames.is_null())
-            return;
-        for (const auto &netname : netnames.object_items())
-            Func(netname.first, netname.second);
+        foreach_member(doc.get(mod, "netnames"), Func);
     }
 
-    PortType lookup_portdir(const std::string &dir) const
+    PortType lookup_portdir(std::string_view dir) const
     {
         if (dir == "input")
             return PORT_IN;
@@ -85,126 +517,156 @@ struct JsonFrontendImpl
             NPNR_ASSERT_FALSE("invalid json port direction");
     }
 
-    PortType get_port_dir(ModulePortDataType &port) const { return lookup_portdir(port["direction"].string_value()); }
+    PortType get_port_dir(ModulePortDataType &port) const { return lookup_portdir(doc.get(port, "direction").str); }
 
-    int get_array_offset(const Json &obj) const
-    {
-        auto offset = obj["offset"];
-        return offset.is_null() ? 0 : offset.int_value();
-    }
+    int get_array_offset(const JsonDoc::Node &obj) const { return doc.get(obj, "offset").int_value(); }
 
-    bool is_array_upto(const Json &obj) const
-    {
-        auto upto = obj["upto"];
-        return upto.is_null() ? false : bool(upto.int_value());
-    }
+    bool is_array_upto(const JsonDoc::Node &obj) const { return bool(doc.get(obj, "upto").int_value()); }
 
-    BitVectorDataType &get_port_bits(ModulePortDataType &port) const { return port["bits"].array_items(); }
+    BitVectorDataType &get_port_bits(ModulePortDataType &port) const { return doc.get(port, "bits"); }
 
-    const std::string &get_cell_type(CellDataType &cell) const { return cell["type"].string_value(); }
+    std::string get_cell_type(CellDataType &cell) const { return std::string(doc.get(cell, "type").str); }
 
-    Property parse_property(const Json &val) const
+    Property parse_property(const JsonDoc::Node &val) const
     {
         if (val.is_number()) {
-            if (val.int_value() != val.number_value())
+            if (val.int_value() != val.number)
                 log_error("Found an out-of-range integer parameter in the JSON file.\n"
                           "Please regenerate the input file with an up-to-date version of yosys.\n");
             return Property(val.int_value(), 32);
         } else {
-            return Property::from_string(val.string_value());
+            return Property::from_string(std::string(val.str));
         }
     }
 
-    template <typename TFunc> void foreach_attr(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_property(const JsonDoc::Node &obj, TFunc Func) const
     {
-        const auto &attrs = obj["attributes"];
-        if (attrs.is_null())
-            return;
-        for (const auto &attr : attrs.object_items()) {
-            Func(attr.first, parse_property(attr.second));
-        }
+        foreach_member(obj, [&](const std::string &name, const JsonDoc::Node &value) {
+            Func(name, parse_property(value));
+        });
     }
 
-    template <typename TFunc> void foreach_param(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_attr(const JsonDoc::Node &obj, TFunc Func) const
     {
-        const auto &params = obj["parameters"];
-        if (params.is_null())
-            return;
-        for (const auto &param : params.object_items()) {
-            Func(param.first, parse_property(param.second));
-        }
+        foreach_property(doc.get(obj, "attributes"), Func);
     }
 
-    template <typename TFunc> void foreach_setting(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_param(const JsonDoc::Node &obj, TFunc Func) const
     {
-        const auto &settings = obj["settings"];
-        if (settings.is_null())
-            return;
-        for (const auto &setting : settings.object_items()) {
-            Func(setting.first, parse_property(setting.second));
-        }
+        foreach_property(doc.get(obj, "parameters"), Func);
+    }
+
+    template <typename TFunc> void foreach_setting(const JsonDoc::Node &obj, TFunc Func) const
+    {
+        foreach_property(doc.get(obj, "settings"), Func);
     }
 
     template <typename TFunc> void foreach_port_dir(CellDataType &cell, TFunc Func) const
     {
-        for (const auto &pdir : cell["port_directions"].object_items())
-            Func(pdir.first, lookup_portdir(pdir.second.string_value()));
+        foreach_member(doc.get(cell, "port_directions"), [&](const std::string &name, const JsonDoc::Node &dir) {
+            Func(name, lookup_portdir(dir.str));
+        });
     }
 
     template <typename TFunc> void foreach_port_conn(CellDataType &cell, TFunc Func) const
     {
-        for (const auto &pconn : cell["connections"].object_items())
-            Func(pconn.first, pconn.second.array_items());
+        foreach_member(doc.get(cell, "connections"), Func);
     }
 
-    BitVectorDataType &get_net_bits(NetnameDataType &net) const { return net["bits"].array_items(); }
+    BitVectorDataType &get_net_bits(NetnameDataType &net) const { return doc.get(net, "bits"); }
 
-    int get_vector_length(BitVectorDataType &bits) const { return int(bits.size()); }
+    int get_vector_length(BitVectorDataType &bits) const { return (bits.type == JsonDoc::J_ARRAY) ? bits.count : 0; }
 
     bool is_vector_bit_undef(BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(i < int(bits.size()));
-        return bits[i] == "x";
+        NPNR_ASSERT(i < get_vector_length(bits));
+        auto &bit = doc.child(bits, i);
+        return bit.is_string() && bit.str == "x";
     }
 
     bool is_vector_bit_constant(BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(i < int(bits.size()));
-        return bits[i].is_string();
+        NPNR_ASSERT(i < get_vector_length(bits));
+        return doc.child(bits, i).is_string();
     }
 
     char get_vector_bit_constval(BitVectorDataType &bits, int i) const
     {
-        auto s = bits.at(i).string_value();
-        NPNR_ASSERT(s.size() == 1);
-        return s.at(0);
+        NPNR_ASSERT(i < get_vector_length(bits));
+        auto &bit = doc.child(bits, i);
+        NPNR_ASSERT(bit.is_string() && bit.str.size() == 1);
+        return bit.str.at(0);
     }
 
     int get_vector_bit_signal(BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(bits.at(i).is_number());
-        return bits.at(i).int_value();
+        NPNR_ASSERT(i < get_vector_length(bits));
+        auto &bit = doc.child(bits, i);
+        NPNR_ASSERT(bit.is_number());
+        return bit.int_value();
     }
 };
 
-bool parse_json(std::istream &in, const std::string &filename, Context *ctx)
+// Peak resident set size of the process so far, in MiB; or -1 if unknown
+long peak_rss_mib()
 {
-    Json root;
-    {
-        if (!in)
-            log_error("Failed to open JSON file '%s'.\n", filename.c_str());
-        std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-        std::string error;
-        root = Json::parse(json_str, error, JsonParse::COMMENTS);
-        if (root.is_null())
-            log_error("Failed to parse JSON file '%s': %s.\n", filename.c_str(), error.c_str());
-        root = root["modules"];
-        if (root.is_null())
-            log_error("JSON file '%s' doesn't look like a netlist (doesn't contain \"modules\" key)\n",
-                      filename.c_str());
-    }
-    GenericFrontend<JsonFrontendImpl>(ctx, JsonFrontendImpl(root), /*split_io=*/true)();
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(__APPLE__)
+    return long(usage.ru_maxrss / (1024 * 1024));
+#else
+    return long(usage.ru_maxrss / 1024);
+#endif
+#else
+    return -1;
+#endif
+}
+
+bool parse_json_buffer(std::string_view buffer, const std::string &filename, Context *ctx)
+{
+    auto startt = std::chrono::high_resolution_clock::now();
+    JsonDoc doc;
+    std::string error;
+    if (!doc.parse(buffer, error))
+        log_error("Failed to parse JSON file '%s': %s.\n", filename.c_str(), error.c_str());
+    const auto &modules = doc.get(doc.root(), "modules");
+    if (modules.is_null())
+        log_error("JSON file '%s' doesn't look like a netlist (doesn't contain \"modules\" key)\n", filename.c_str());
+    auto parsedt = std::chrono::high_resolution_clock::now();
+    GenericFrontend<JsonFrontendImpl>(ctx, JsonFrontendImpl(doc, modules), /*split_io=*/true)();
+    auto endt = std::chrono::high_resolution_clock::now();
+    log_info("Loaded JSON netlist in %.02fs (parse %.02fs, import %.02fs); peak memory %ld MiB.\n",
+             std::chrono::duration<double>(endt - startt).count(),
+             std::chrono::duration<double>(parsedt - startt).count(),
+             std::chrono::duration<double>(endt - parsedt).count(), peak_rss_mib());
     return true;
 }
 
+} // namespace
+
+bool parse_json(std::istream &in, const std::string &filename, Context *ctx)
+{
+    if (!in)
+        log_error("Failed to open JSON file '%s'.\n", filename.c_str());
+    std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return parse_json_buffer(json_str, filename, ctx);
+}
+
+bool parse_json_file(const std::string &filename, Context *ctx)
+{
+    // Map the file rather than reading it, so the parser works directly on the page cache. Fall back to reading it
+    // if that isn't possible; for example for empty files and pipes
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (std::exception &) {
+    }
+    if (file.is_open())
+        return parse_json_buffer(std::string_view(file.data(), file.size()), filename, ctx);
+    std::ifstream in(filename);
+    return parse_json(in, filename, ctx);
+}
+
 NEXTPNR_NAMESPACE_END
@@ -22,5 +22,7 @@
 NEXTPNR_NAMESPACE_BEGIN
 
 bool parse_json(std::istream &in, const std::string &filename, Context *ctx);
+// As parse_json, but memory-maps the file where possible rather than reading it into a buffer
+bool parse_json_file(const std::string &filename, Context *ctx);
 
 NEXTPNR_NAMESPACE_END
@@ -18,22 +18,34 @@
  */
 
 #include "arch.h"
-#include <boost/filesystem/path.hpp>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
 #include "archdefs.h"
 #include "chipdb.h"
 #include "log.h"
 #include "nextpnr.h"
 
 #include "command.h"
+#include "eco.h"
 #include "placer1.h"
 #include "placer_heap.h"
 #include "router1.h"
 #include "router2.h"
+#include "thread_pool.h"
 #include "util.h"
 
+#ifdef NEXTPNR_CHIPDB_ZLIB
+#include <zlib.h>
+#endif
+
 NEXTPNR_NAMESPACE_BEGIN
 
-static constexpr int database_version = 6;
+static constexpr int database_version = 7;
 
 static const ChipInfoPOD *get_chip_info(const RelPtr<ChipInfoPOD> *ptr) { return ptr->get(); }
 
@@ -54,7 +66,37 @@ Arch::Arch(ArchArgs args) : args(args)
         log_error("uarch didn't load any chipdb, probably a load_chipdb call was missing\n");
 
     init_tiles();
+    init_binding();
+}
+
+namespace {
+// Header of the compressed container written by bbasm --z, followed by the compressed size of each block and then the
+// blocks themselves. See bba/README.md.
+const char compressed_chipdb_magic[8] = {'B', 'B', 'A', 'Z', 'L', 'I', 'B', '1'};
+struct CompressedChipdbHeader
+{
+    char magic[8];
+    uint32_t raw_size;
+    uint32_t block_size;
+    uint32_t block_count;
+};
+
+uint64_t hash_chipdb_data(const char *data, size_t size)
+{
+    // FNV-1a over 64-bit words, which is fast enough to run over a whole chipdb
+    uint64_t h = 0xcbf29ce484222325ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0x100000001b3ULL;
+        h ^= h >> 32;
+    }
+    for (; i < size; i++)
+        h = (h ^ uint8_t(data[i])) * 0x100000001b3ULL;
+    return h;
 }
+} // namespace
 
 void Arch::load_chipdb(const std::string &path)
 {
@@ -68,15 +110,10 @@ void Arch::load_chipdb(const std::string &path)
         boost::filesystem::path p(db_path);
         db_path = p.make_preferred().string();
     }
-    try {
-        blob_file.open(db_path);
-        if (db_path.empty() || !blob_file.is_open())
-            log_error("Unable to read chipdb %s\n", db_path.c_str());
-        const char *blob = reinterpret_cast<const char *>(blob_file.data());
-        chip_info = get_chip_info(reinterpret_cast<const RelPtr<ChipInfoPOD> *>(blob));
-    } catch (...) {
-        log_error("Unable to read chipdb %s\n", db_path.c_str());
-    }
+    chipdb_path = db_path;
+    chipdb_blob = open_chipdb();
+    blob_size = chipdb_blob->size;
+    chip_info = get_chip_info(reinterpret_cast<const RelPtr<ChipInfoPOD> *>(chipdb_blob->blob));
     // Check consistency of blob
     if (chip_info->magic != 0x00ca7ca7)
         log_error("chipdb %s does not look like a valid himbächel database!\n", db_path.c_str());
@@ -95,6 +132,160 @@ void Arch::load_chipdb(const std::string &path)
     }
 }
 
+std::shared_ptr<const ChipdbBlob> Arch::open_chipdb()
+{
+    static std::mutex loaded_mutex;
+    static dict<std::string, std::weak_ptr<const ChipdbBlob>> loaded;
+    std::lock_guard<std::mutex> lock(loaded_mutex);
+    auto &cached = loaded[chipdb_path];
+    if (auto db = cached.lock())
+        return db;
+
+    auto db = std::make_shared<ChipdbBlob>();
+    try {
+        db->file.open(chipdb_path);
+        if (chipdb_path.empty() || !db->file.is_open())
+            log_error("Unable to read chipdb %s\n", chipdb_path.c_str());
+        db->blob = db->file.data();
+        db->size = db->file.size();
+    } catch (...) {
+        log_error("Unable to read chipdb %s\n", chipdb_path.c_str());
+    }
+    if (db->size >= sizeof(CompressedChipdbHeader) &&
+        std::equal(compressed_chipdb_magic, compressed_chipdb_magic + 8, db->blob))
+        open_compressed_chipdb(*db);
+    cached = db;
+    return db;
+}
+
+void Arch::open_compressed_chipdb(ChipdbBlob &db)
+{
+    // The decompressed chipdb is written to the user cache directory once, and from then on mapped from there like a
+    // raw chipdb. So only the pages that are used count towards memory use, and later runs skip decompression. The
+    // file is named by a hash of the compressed chipdb, so a rebuilt chipdb never picks up a stale copy.
+    std::string cache_dir = proc_cache_dirname();
+    std::string stem = boost::filesystem::path(chipdb_path).stem().string();
+    std::string cache_file;
+    if (!cache_dir.empty()) {
+        cache_file =
+                stringf("%s%s-%016" PRIx64 ".bin", cache_dir.c_str(), stem.c_str(), hash_chipdb_data(db.blob, db.size));
+        if (map_decompressed_chipdb(db, cache_file))
+            return;
+    }
+
+    std::unique_ptr<char[]> data = decompress_chipdb(db.blob, db.size);
+    size_t raw_size = reinterpret_cast<const CompressedChipdbHeader *>(db.blob)->raw_size;
+    if (!cache_file.empty()) {
+        // Written under a temporary name and then renamed into place, so that other runs never map a partial file
+        std::string tmp_file = stringf("%s.tmp%u", cache_file.c_str(), unsigned(std::random_device{}()));
+        std::ofstream out(tmp_file, std::ios::binary);
+        out.write(data.get(), raw_size);
+        out.close();
+        if (!out || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0)
+            std::remove(tmp_file.c_str());
+        if (map_decompressed_chipdb(db, cache_file)) {
+            remove_stale_chipdb_copies(cache_dir, stem, cache_file);
+            return;
+        }
+        log_info("Unable to cache the decompressed chipdb in '%s', keeping it in memory.\n", cache_dir.c_str());
+    }
+    db.file.close();
+    db.data = std::move(data);
+    db.blob = db.data.get();
+    db.size = raw_size;
+}
+
+void Arch::remove_stale_chipdb_copies(const std::string &cache_dir, const std::string &stem,
+                                      const std::string &cache_file)
+{
+    // Copies of earlier builds of the same chipdb are never mapped again, and for the large devices each one is the
+    // size of the raw chipdb. Failures are ignored: another run may still have an old copy open, which stops it from
+    // being removed on Windows.
+    namespace fs = boost::filesystem;
+    boost::system::error_code ec;
+    fs::path keep(cache_file);
+    for (fs::directory_iterator it(cache_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        // <stem>-<16 hex digits>.bin
+        if (name.size() != stem.size() + 21 || name.compare(0, stem.size() + 1, stem + "-") != 0 ||
+            name.compare(name.size() - 4, 4, ".bin") != 0 ||
+            name.find_first_not_of("0123456789abcdef", stem.size() + 1) != name.size() - 4)
+            continue;
+        boost::system::error_code remove_ec;
+        if (!fs::equivalent(it->path(), keep, remove_ec))
+            fs::remove(it->path(), remove_ec);
+    }
+}
+
+bool Arch::map_decompressed_chipdb(ChipdbBlob &db, const std::string &cache_file)
+{
+    size_t raw_size = reinterpret_cast<const CompressedChipdbHeader *>(db.blob)->raw_size;
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(cache_file);
+    } catch (...) {
+        return false;
+    }
+    if (!file.is_open() || file.size() != raw_size)
+        return false;
+    db.file = file;
+    db.blob = db.file.data();
+    db.size = db.file.size();
+    return true;
+}
+
+std::unique_ptr<char[]> Arch::decompress_chipdb(const char *data, size_t size)
+{
+#ifdef NEXTPNR_CHIPDB_ZLIB
+    const auto &header = *reinterpret_cast<const CompressedChipdbHeader *>(data);
+    const uint32_t *block_sizes = reinterpret_cast<const uint32_t *>(data + sizeof(CompressedChipdbHeader));
+    int block_count = header.block_count;
+    size_t data_start = sizeof(CompressedChipdbHeader) + sizeof(uint32_t) * size_t(block_count);
+    if (header.block_size == 0 ||
+        size_t(block_count) != (size_t(header.raw_size) + header.block_size - 1) / header.block_size)
+        log_error("chipdb %s has an invalid header\n", chipdb_path.c_str());
+    if (data_start > size)
+        log_error("chipdb %s is truncated\n", chipdb_path.c_str());
+    std::vector<size_t> block_offsets(block_count + 1);
+    block_offsets.at(0) = data_start;
+    for (int i = 0; i < block_count; i++)
+        block_offsets.at(i + 1) = block_offsets.at(i) + block_sizes[i];
+    if (block_offsets.back() > size)
+        log_error("chipdb %s is truncated\n", chipdb_path.c_str());
+
+    std::unique_ptr<char[]> raw(new char[header.raw_size]);
+    std::atomic<bool> failed{false};
+    // The blocks are independent, so they are decompressed in parallel
+#ifndef NPNR_DISABLE_THREADS
+    // Chipdbs are loaded before the --threads setting is known, so this uses its default
+    ThreadPool pool(std::max(1, std::min(block_count, Context::default_threads)));
+#else
+    ThreadPool pool(1);
+#endif
+    pool.parallel_for(block_count, [&](int i) {
+        size_t start = size_t(i) * header.block_size;
+        uLongf expected_size = std::min<size_t>(header.block_size, header.raw_size - start);
+        uLongf raw_size = expected_size;
+        if (uncompress(reinterpret_cast<Bytef *>(raw.get() + start), &raw_size,
+                       reinterpret_cast<const Bytef *>(data + block_offsets.at(i)), block_sizes[i]) != Z_OK ||
+            raw_size != expected_size)
+            failed = true;
+    });
+    if (failed)
+        log_error("chipdb %s is corrupt\n", chipdb_path.c_str());
+    return raw;
+#else
+    log_error("chipdb %s is compressed, but nextpnr was built without zlib\n", chipdb_path.c_str());
+#endif
+}
+
+uint64_t Arch::chipdb_hash() const
+{
+    std::call_once(chipdb_blob->hashed,
+                   [&]() { chipdb_blob->hash = hash_chipdb_data(chipdb_blob->blob, chipdb_blob->size); });
+    return chipdb_blob->hash;
+}
+
 void Arch::set_speed_grade(const std::string &speed)
 {
     if (speed.empty())
@@ -127,18 +318,60 @@ void Arch::set_package(const std::string &package)
     }
 }
 
-void Arch::init_tiles()
+void Arch::init_tiles() { tile_name_ids = std::vector<std::atomic<int32_t>>(chip_info->tile_insts.size()); }
+
+IdString Arch::tile_name(int tile) const
 {
-    for (int y = 0; y < chip_info->height; y++) {
-        for (int x = 0; x < chip_info->width; x++) {
-            int tile = y * chip_info->width + x;
-            auto &inst = chip_info->tile_insts[tile];
-            IdString name = idf("%sX%dY%d", IdString(inst.name_prefix).c_str(this), x, y);
-            NPNR_ASSERT(int(tile_name.size()) == tile);
-            tile_name.push_back(name);
-            tile_name2idx[name] = tile;
-        }
+    // Zero is the empty string, which is never the name of a tile
+    int32_t index = tile_name_ids.at(tile).load(std::memory_order_acquire);
+    if (index != 0)
+        return IdString(index);
+    std::lock_guard<std::mutex> lock(tile_name_mutex);
+    index = tile_name_ids.at(tile).load(std::memory_order_relaxed);
+    if (index == 0) {
+        auto &inst = chip_info->tile_insts[tile];
+        int x = tile % chip_info->width, y = tile / chip_info->width;
+        index = idf("%sX%dY%d", IdString(inst.name_prefix).c_str(this), x, y).index;
+        tile_name_ids.at(tile).store(index, std::memory_order_release);
     }
+    return IdString(index);
+}
+
+int Arch::tile_by_name(IdString name) const
+{
+    // Split "<prefix>X<x>Y<y>" from the end, as the prefix may itself contain an X or Y
+    const std::string &str = name.str(this);
+    auto parse_coord = [&](size_t begin, size_t end) {
+        if (begin >= end || end - begin > 6)
+            return -1;
+        int value = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (str[i] < '0' || str[i] > '9')
+                return -1;
+            value = value * 10 + (str[i] - '0');
+        }
+        return value;
+    };
+    size_t y_pos = str.rfind('Y');
+    if (y_pos == std::string::npos || y_pos == 0)
+        return -1;
+    size_t x_pos = str.rfind('X', y_pos - 1);
+    if (x_pos == std::string::npos)
+        return -1;
+    int x = parse_coord(x_pos + 1, y_pos), y = parse_coord(y_pos + 1, str.size());
+    if (x < 0 || x >= chip_info->width || y < 0 || y >= chip_info->height)
+        return -1;
+    int tile = y * chip_info->width + x;
+    // This checks the prefix, and rejects coordinates with leading zeros
+    if (tile_name(tile) != name)
+        return -1;
+    return tile;
+}
+
+void Arch::init_binding()
+{
+    bel2cell.resize(chip_info->tile_insts.size());
+    wire_binding.resize(chip_info->tile_insts.size());
 }
 
 void Arch::late_init()
@@ -150,39 +383,52 @@ void Arch::late_init()
 BelId Arch::getBelByName(IdStringList name) const
 {
     NPNR_ASSERT(name.size() == 2);
-    int tile = tile_name2idx.at(name[0]);
+    int tile = tile_by_name(name[0]);
+    if (tile == -1)
+        return BelId();
     const auto &tdata = chip_tile_info(chip_info, tile);
-    for (int bel = 0; bel < tdata.bels.ssize(); bel++) {
+    if (tdata.bel_name_index.ssize() == 0)
+        return BelId();
+    uint32_t mask = uint32_t(tdata.bel_name_index.ssize()) - 1;
+    // The table is never more than half full, so there is always an empty slot to end the probe
+    for (uint32_t slot = chipdb_name_hash(name[1].index) & mask;; slot = (slot + 1) & mask) {
+        int32_t bel = tdata.bel_name_index[slot];
+        if (bel == -1)
+            return BelId();
         if (IdString(tdata.bels[bel].name) == name[1])
             return BelId(tile, bel);
     }
-    return BelId();
 }
 
 IdStringList Arch::getBelName(BelId bel) const
 {
-    return IdStringList::concat(tile_name.at(bel.tile), IdString(chip_bel_info(chip_info, bel).name));
+    return IdStringList::concat(tile_name(bel.tile), IdString(chip_bel_info(chip_info, bel).name));
 }
 
-WireId Arch::getBelPinWire(BelId bel, IdString pin) const
+const BelPinPOD *Arch::find_bel_pin(BelId bel, IdString pin) const
 {
-    // TODO: binary search
     auto &info = chip_bel_info(chip_info, bel);
-    for (auto &bel_pin : info.pins) {
-        if (IdString(bel_pin.name) == pin)
-            return normalise_wire(bel.tile, bel_pin.wire);
-    }
-    return WireId();
+    auto found = std::lower_bound(info.pins.begin(), info.pins.end(), pin.index,
+                                  [](const BelPinPOD &bel_pin, int name) { return bel_pin.name < name; });
+    if (found == info.pins.end() || found->name != pin.index)
+        return nullptr;
+    return &*found;
+}
+
+WireId Arch::getBelPinWire(BelId bel, IdString pin) const
+{
+    auto bel_pin = find_bel_pin(bel, pin);
+    if (bel_pin == nullptr)
+        return WireId();
+    return normalise_wire(bel.tile, bel_pin->wire);
 }
 
 PortType Arch::getBelPinType(BelId bel, IdString pin) const
 {
-    auto &info = chip_bel_info(chip_info, bel);
-    for (auto &bel_pin : info.pins) {
-        if (IdString(bel_pin.name) == pin)
-            return PortType(bel_pin.type);
-    }
-    NPNR_ASSERT_FALSE("bel pin not found");
+    auto bel_pin = find_bel_pin(bel, pin);
+    if (bel_pin == nullptr)
+        NPNR_ASSERT_FALSE("bel pin not found");
+    return PortType(bel_pin->type);
 }
 
 std::vector<IdString> Arch::getBelPins(BelId bel) const
@@ -205,21 +451,28 @@ bool Arch::pack()
     return true;
 }
 
-bool Arch::place()
+bool Arch::run_placer(const std::string &placer)
 {
-    bool retVal = false;
-    uarch->prePlace();
-    std::string placer = str_or_default(settings, id("placer"), defaultPlacer);
     if (placer == "heap") {
         PlacerHeapCfg cfg(getCtx());
         uarch->configurePlacerHeap(cfg);
         cfg.ioBufTypes.insert(id("GENERIC_IOB"));
-        retVal = placer_heap(getCtx(), cfg);
+        return placer_heap(getCtx(), cfg);
     } else if (placer == "sa") {
-        retVal = placer1(getCtx(), Placer1Cfg(getCtx()));
+        return placer1(getCtx(), Placer1Cfg(getCtx()));
+    } else if (placer == "eco") {
+        EcoCfg cfg(getCtx());
+        cfg.full_placement = [this]() { return run_placer(defaultPlacer); };
+        return eco_place(getCtx(), cfg);
     } else {
         log_error("Himbächel architecture does not support placer '%s'\n", placer.c_str());
     }
+}
+
+bool Arch::place()
+{
+    uarch->prePlace();
+    bool retVal = run_placer(str_or_default(settings, id("placer"), defaultPlacer));
     uarch->postPlace();
     getCtx()->settings[getCtx()->id("place")] = 1;
     archInfoToAttributes();
@@ -229,6 +482,7 @@ bool Arch::place()
 bool Arch::route()
 {
     set_fast_pip_delays(true);
+    init_lookahead();
     uarch->preRoute();
     std::string router = str_or_default(settings, id("router"), defaultRouter);
     bool result;
@@ -266,10 +520,14 @@ void Arch::assignArchInfo()
     }
 }
 
+void Arch::forkArchState(Context *target) const { uarch->forkState(target->uarch.get()); }
+
 WireId Arch::getWireByName(IdStringList name) const
 {
     NPNR_ASSERT(name.size() == 2);
-    int tile = tile_name2idx.at(name[0]);
+    int tile = tile_by_name(name[0]);
+    if (tile == -1)
+        return WireId();
     const auto &tdata = chip_tile_info(chip_info, tile);
     for (int wire = 0; wire < tdata.wires.ssize(); wire++) {
         if (IdString(tdata.wires[wire].name) == name[1])
@@ -280,13 +538,15 @@ WireId Arch::getWireByName(IdStringList name) const
 
 IdStringList Arch::getWireName(WireId wire) const
 {
-    return IdStringList::concat(tile_name.at(wire.tile), IdString(chip_wire_info(chip_info, wire).name));
+    return IdStringList::concat(tile_name(wire.tile), IdString(chip_wire_info(chip_info, wire).name));
 }
 
 PipId Arch::getPipByName(IdStringList name) const
 {
     NPNR_ASSERT(name.size() == 3 || (name.size() == 4 && name[3] == id("INV")));
-    const int tile = tile_name2idx.at(name[0]);
+    const int tile = tile_by_name(name[0]);
+    if (tile == -1)
+        return PipId();
     const auto &tdata = chip_tile_info(chip_info, tile);
     for (int pip = 0; pip < tdata.pips.ssize(); pip++) {
         if (IdString(tdata.wires[tdata.pips[pip].dst_wire].name) == name[1] &&
@@ -305,7 +565,7 @@ IdStringList Arch::getPipName(PipId pip) const
 {
     const auto &tdata = chip_tile_info(chip_info, pip.tile);
     const auto &pdata = tdata.pips[pip.index];
-    const auto name = IdStringList::concat(tile_name.at(pip.tile),
+    const auto name = IdStringList::concat(tile_name(pip.tile),
                                            IdStringList::concat(IdString(tdata.wires[pdata.dst_wire].name),
                                                                 IdString(tdata.wires[pdata.src_wire].name)));
     if (isPipInverting(pip))
@@ -318,7 +578,9 @@ IdString Arch::getPipType(PipId pip) const { return IdString(); }
 GroupId Arch::getGroupByName(IdStringList name) const
 {
     NPNR_ASSERT(name.size() == 2);
-    int tile = tile_name2idx.at(name[0]);
+    int tile = tile_by_name(name[0]);
+    if (tile == -1)
+        return GroupId();
     const auto &tdata = chip_tile_info(chip_info, tile);
     for (int group = 0; group < tdata.groups.ssize(); group++) {
         if (IdString(tdata.groups[group].name) == name[1])
@@ -329,7 +591,7 @@ GroupId Arch::getGroupByName(IdStringList name) const
 
 IdStringList Arch::getGroupName(GroupId group) const
 {
-    return IdStringList::concat(tile_name.at(group.tile), IdString(chip_group_info(chip_info, group).name));
+    return IdStringList::concat(tile_name(group.tile), IdString(chip_group_info(chip_info, group).name));
 }
 
 std::string Arch::getChipName() const { return chip_info->name.get(); }
@@ -374,6 +636,28 @@ void Arch::set_fast_pip_delays(bool fast_mode)
     fast_pip_delays = fast_mode;
 }
 
+void Arch::init_lookahead()
+{
+    if (lookahead.ready() || !bool_or_default(settings, id("himbaechel/lookahead"), true))
+        return;
+    int radius = int_or_default(settings, id("himbaechel/lookaheadRadius"), 12);
+    // Cached in the user cache directory, as the directory the chipdb is installed in is usually read-only
+    std::string cache_dir = proc_cache_dirname();
+    std::string cache_prefix;
+    if (!cache_dir.empty())
+        cache_prefix = cache_dir + boost::filesystem::path(chipdb_path).stem().string();
+    lookahead.init(getCtx(), cache_prefix, radius);
+}
+
+delay_t Arch::estimateDelay(WireId src, WireId dst) const
+{
+    // Once built, the lookahead answers every query, so that the router never compares estimates from two different
+    // models
+    if (lookahead.ready())
+        return lookahead.estimate(getCtx(), src, dst);
+    return uarch->estimateDelay(src, dst);
+}
+
 // Helper for cell timing lookups
 namespace {
 template <typename Tres, typename Tgetter, typename Tkey>
@@ -22,11 +22,15 @@
 #define HIMBAECHEL_ARCH_H
 
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 #include "base_arch.h"
 #include "chipdb.h"
 #include "himbaechel_api.h"
+#include "himbaechel_lookahead.h"
 #include "nextpnr_namespaces.h"
 #include "nextpnr_types.h"
 
@@ -465,6 +469,21 @@ struct ArchRanges : BaseArchRanges
     using GroupGroupsRangeT = GroupGroupRange;
 };
 
+// A chip database loaded into memory. Contexts in the same process that use the same chipdb file, such as one per seed
+// with --seed-sweep, share a single copy.
+struct ChipdbBlob
+{
+    // The raw chipdb, or for a compressed chipdb its decompressed copy in the cache directory
+    boost::iostreams::mapped_file_source file;
+    // For a compressed chipdb that couldn't be cached, the decompressed blob in memory
+    std::unique_ptr<char[]> data;
+    const char *blob = nullptr;
+    size_t size = 0;
+    // Hash of the blob, only computed when first needed as it reads the whole chipdb
+    mutable std::once_flag hashed;
+    mutable uint64_t hash = 0;
+};
+
 struct Arch : BaseArch<ArchRanges>
 {
     ArchArgs args;
@@ -478,7 +497,9 @@ struct Arch : BaseArch<ArchRanges>
     void late_init();
 
     // Database references
-    boost::iostreams::mapped_file_source blob_file;
+    std::string chipdb_path;
+    std::shared_ptr<const ChipdbBlob> chipdb_blob;
+    size_t blob_size = 0;
     const ChipInfoPOD *chip_info;
     const PackageInfoPOD *package_info = nullptr;
     const SpeedGradePOD *speed_grade = nullptr;
@@ -527,6 +548,8 @@ struct Arch : BaseArch<ArchRanges>
     IdString getBelType(BelId bel) const override { return IdString(chip_bel_info(chip_info, bel).bel_type); }
 
     WireId getBelPinWire(BelId bel, IdString pin) const override;
+    // The chipdb entry for a pin of a bel, or nullptr if there is no such pin
+    const BelPinPOD *find_bel_pin(BelId bel, IdString pin) const;
     PortType getBelPinType(BelId bel, IdString pin) const override;
     std::vector<IdString> getBelPins(BelId bel) const override;
 
@@ -548,17 +571,37 @@ struct Arch : BaseArch<ArchRanges>
     {
         if (!uarch->checkWireAvail(wire))
             return false;
-        return BaseArch::checkWireAvail(wire);
+        return getBoundWireNet(wire) == nullptr;
     }
     void bindWire(WireId wire, NetInfo *net, PlaceStrength strength) override
     {
         uarch->notifyWireChange(wire, net);
-        BaseArch::bindWire(wire, net, strength);
+        auto &entry = wire_binding_entry(wire);
+        NPNR_ASSERT(entry.net == nullptr);
+        net->wires[wire].pip = PipId();
+        net->wires[wire].strength = strength;
+        entry.net = net;
+        refreshUiWire(wire);
     }
     void unbindWire(WireId wire) override
     {
         uarch->notifyWireChange(wire, nullptr);
-        BaseArch::unbindWire(wire);
+        auto &entry = wire_binding_entry(wire);
+        NPNR_ASSERT(entry.net != nullptr);
+
+        auto &net_wires = entry.net->wires;
+        auto it = net_wires.find(wire);
+        NPNR_ASSERT(it != net_wires.end());
+        NPNR_ASSERT(it->second.pip == entry.pip);
+
+        net_wires.erase(it);
+        entry = WireBinding();
+        refreshUiWire(wire);
+    }
+    NetInfo *getBoundWireNet(WireId wire) const override
+    {
+        auto &tile_wires = wire_binding.at(wire.tile);
+        return tile_wires.empty() ? nullptr : tile_wires[wire.index].net;
     }
 
     // -------------------------------------------------
@@ -625,14 +668,24 @@ struct Arch : BaseArch<ArchRanges>
     {
         if (!uarch->checkPipAvail(pip))
             return false;
-        return BaseArch::checkPipAvail(pip);
+        return getBoundPipNet(pip) == nullptr;
     }
 
     bool checkPipAvailForNet(PipId pip, const NetInfo *net) const override
     {
         if (!uarch->checkPipAvailForNet(pip, net))
             return false;
-        return BaseArch::checkPipAvailForNet(pip, net);
+        NetInfo *bound_net = getBoundPipNet(pip);
+        return bound_net == nullptr || bound_net == net;
+    }
+    NetInfo *getBoundPipNet(PipId pip) const override
+    {
+        // A pip is bound exactly when its destination wire is bound through it
+        WireId dst = getPipDstWire(pip);
+        auto &tile_wires = wire_binding.at(dst.tile);
+        if (tile_wires.empty() || tile_wires[dst.index].pip != pip)
+            return nullptr;
+        return tile_wires[dst.index].net;
     }
     void bindPip(PipId pip, NetInfo *net, PlaceStrength strength) override
     {
@@ -648,7 +701,14 @@ struct Arch : BaseArch<ArchRanges>
             }
         }
         uarch->notifyPipChange(pip, net);
-        BaseArch::bindPip(pip, net, strength);
+        NPNR_ASSERT(pip != PipId());
+        WireId dst = getPipDstWire(pip);
+        auto &entry = wire_binding_entry(dst);
+        NPNR_ASSERT(entry.net == nullptr);
+        entry.net = net;
+        entry.pip = pip;
+        net->wires[dst].pip = pip;
+        net->wires[dst].strength = strength;
     }
     void unbindPip(PipId pip) override
     {
@@ -660,13 +720,19 @@ struct Arch : BaseArch<ArchRanges>
             }
         }
         uarch->notifyPipChange(pip, nullptr);
-        BaseArch::unbindPip(pip);
+        NPNR_ASSERT(pip != PipId());
+        WireId dst = getPipDstWire(pip);
+        auto &entry = wire_binding_entry(dst);
+        NPNR_ASSERT(entry.net != nullptr && entry.pip == pip);
+
+        entry.net->wires.erase(dst);
+        entry = WireBinding();
     }
     bool isPipInverting(PipId pip) const override { return uarch->isPipInverting(pip); }
 
     // -------------------------------------------------
 
-    delay_t estimateDelay(WireId src, WireId dst) const override { return uarch->estimateDelay(src, dst); }
+    delay_t estimateDelay(WireId src, WireId dst) const override;
     delay_t predictDelay(BelId src_bel, IdString src_pin, BelId dst_bel, IdString dst_pin) const override
     {
         return uarch->predictDelay(src_bel, src_pin, dst_bel, dst_pin);
@@ -684,6 +750,8 @@ struct Arch : BaseArch<ArchRanges>
     // -------------------------------------------------
 
     void assignArchInfo() override;
+    bool canForkDesign() const override { return uarch->canForkDesign(); }
+    void forkArchState(Context *target) const override;
     bool isBelLocationValid(BelId bel, bool explain_invalid = false) const override
     {
         return uarch->isBelLocationValid(bel, explain_invalid);
@@ -702,25 +770,37 @@ struct Arch : BaseArch<ArchRanges>
     void bindBel(BelId bel, CellInfo *cell, PlaceStrength strength) override
     {
         uarch->notifyBelChange(bel, cell);
-        BaseArch::bindBel(bel, cell, strength); // TODO: faster?
+        auto &entry = bel_binding_entry(bel);
+        NPNR_ASSERT(entry == nullptr);
+        cell->bel = bel;
+        cell->belStrength = strength;
+        entry = cell;
+        refreshUiBel(bel);
     }
 
     void unbindBel(BelId bel) override
     {
         uarch->notifyBelChange(bel, nullptr);
-        BaseArch::unbindBel(bel); // TODO: faster?
-        // TODO: fast tile status and bind
+        auto &entry = bel_binding_entry(bel);
+        NPNR_ASSERT(entry != nullptr);
+        entry->bel = BelId();
+        entry->belStrength = STRENGTH_NONE;
+        entry = nullptr;
+        refreshUiBel(bel);
     }
 
     bool checkBelAvail(BelId bel) const override
     {
-        // TODO: fast tile status and bind
         if (!uarch->checkBelAvail(bel))
             return false;
-        return BaseArch::checkBelAvail(bel);
+        return getBoundBelCell(bel) == nullptr;
     }
 
-    // getBoundBelCell: BaseArch
+    CellInfo *getBoundBelCell(BelId bel) const override
+    {
+        auto &tile_bels = bel2cell.at(bel.tile);
+        return tile_bels.empty() ? nullptr : tile_bels[bel.index];
+    }
 
     // ------------------------------------------------
 
@@ -790,6 +870,7 @@ struct Arch : BaseArch<ArchRanges>
 
     bool pack() override;
     bool place() override;
+    bool run_placer(const std::string &placer);
     bool route() override;
 
     static const std::string defaultPlacer;
@@ -873,10 +954,54 @@ struct Arch : BaseArch<ArchRanges>
     TimingClockingInfo getPortClockingInfo(const CellInfo *cell, IdString port, int index) const override;
 
     // -------------------------------------------------
+    std::shared_ptr<const ChipdbBlob> open_chipdb();
+    void open_compressed_chipdb(ChipdbBlob &db);
+    bool map_decompressed_chipdb(ChipdbBlob &db, const std::string &cache_file);
+    void remove_stale_chipdb_copies(const std::string &cache_dir, const std::string &stem,
+                                    const std::string &cache_file);
+    std::unique_ptr<char[]> decompress_chipdb(const char *data, size_t size);
+    uint64_t chipdb_hash() const;
     void init_tiles();
+    void init_binding();
     void set_fast_pip_delays(bool fast_mode);
-    std::vector<IdString> tile_name;
-    dict<IdString, int> tile_name2idx;
+    void init_lookahead();
+    HimbaechelLookahead lookahead;
+
+    // Tile names are "<prefix>X<x>Y<y>". Rather than interning a name for every tile up front, lookups parse the
+    // coordinates back out of the name, and the IdString for a tile is only created the first time it is named.
+    IdString tile_name(int tile) const;
+    int tile_by_name(IdString name) const;
+    mutable std::vector<std::atomic<int32_t>> tile_name_ids;
+    mutable std::mutex tile_name_mutex;
+
+    // Faster replacements for base_bel2cell, base_wire2net and base_pip2net: for every tile, an array over the bels
+    // and tile wires of its tile type. A tile's arrays are only allocated when something in it is first bound; until
+    // then they are empty and everything in the tile is unbound. Only node root wires are ever bound. Rather than an
+    // array over the many more pips, the wire entry records the pip driving it, if bound through one.
+    struct WireBinding
+    {
+        NetInfo *net = nullptr;
+        PipId pip;
+    };
+    std::vector<std::vector<CellInfo *>> bel2cell;
+    std::vector<std::vector<WireBinding>> wire_binding;
+
+    CellInfo *&bel_binding_entry(BelId bel)
+    {
+        NPNR_ASSERT(bel != BelId());
+        auto &tile_bels = bel2cell.at(bel.tile);
+        if (tile_bels.empty())
+            tile_bels.resize(chip_tile_info(chip_info, bel.tile).bels.ssize(), nullptr);
+        return tile_bels.at(bel.index);
+    }
+    WireBinding &wire_binding_entry(WireId wire)
+    {
+        NPNR_ASSERT(wire != WireId());
+        auto &tile_wires = wire_binding.at(wire.tile);
+        if (tile_wires.empty())
+            tile_wires.resize(chip_tile_info(chip_info, wire.tile).wires.ssize());
+        return tile_wires.at(wire.index);
+    }
 
     // -------------------------------------------------
     IdString get_tile_type(int tile) const;
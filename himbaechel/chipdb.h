@@ -27,6 +27,9 @@
 
 NEXTPNR_NAMESPACE_BEGIN
 
+// Hash of the IdString index of a name in the chipdb name lookup tables; must match name_hash in chip.py
+inline uint32_t chipdb_name_hash(int32_t name) { return uint32_t(name) * 2654435761U; }
+
 NPNR_PACKED_STRUCT(struct BelPinPOD {
     int32_t name;
     int32_t wire;
@@ -50,6 +53,7 @@ NPNR_PACKED_STRUCT(struct BelDataPOD {
     int32_t site;
     int32_t checker_idx;
 
+    // Sorted by name, for binary search
     RelSlice<BelPinPOD> pins;
     RelPtr<uint8_t> extra_data;
 });
@@ -107,6 +111,9 @@ NPNR_PACKED_STRUCT(struct GroupDataPOD {
 NPNR_PACKED_STRUCT(struct TileTypePOD {
     int32_t type_name;
     RelSlice<BelDataPOD> bels;
+    // Open addressing hash table of bel indices by bel name, with linear probing and -1 for empty slots; its size is a
+    // power of two at least twice the number of bels (or zero if there are none). See chipdb_name_hash.
+    RelSlice<int32_t> bel_name_index;
     RelSlice<TileWireDataPOD> wires;
     RelSlice<PipDataPOD> pips;
     RelSlice<GroupDataPOD> groups;
@@ -43,7 +43,7 @@ bool HimbaechelAPI::isValidBelForCellType(IdString cell_type, BelId bel) const
 
 delay_t HimbaechelAPI::estimateDelay(WireId src, WireId dst) const
 {
-    // TODO: configurable lookahead
+    // Only used when the precomputed routing lookahead is disabled (see himbaechel_lookahead.h)
     int sx, sy, dx, dy;
     tile_xy(ctx->chip_info, src.tile, sx, sy);
     tile_xy(ctx->chip_info, dst.tile, dx, dy);
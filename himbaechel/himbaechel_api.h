@@ -127,6 +127,11 @@ struct HimbaechelAPI
     virtual void postPlace() {};
     virtual void preRoute() {};
     virtual void postRoute() {};
+    // Whether all the state set up by pack() is recomputed by prePlace() etc, or copied by forkState(), so that a
+    // packed design can be forked
+    virtual bool canForkDesign() const { return false; }
+    // Copies the state pack() left in this uarch into the uarch of a forked context, whose netlist is already there
+    virtual void forkState(HimbaechelAPI *target) const {};
 
     // For custom placer configuration
     virtual void configurePlacerHeap(PlacerHeapCfg &cfg) {};
@@ -1,5 +1,5 @@
 from dataclasses import dataclass, field
-from .bba import BBAWriter
+from .bba import BBAWriter, BinaryBBAWriter
 from enum import Enum
 from typing import Optional
 import abc
@@ -29,6 +29,10 @@ class BBAStruct(abc.ABC):
 class IdString:
     index: int = 0
 
+def name_hash(index: int):
+    # Hash of an IdString index for the name lookup tables; must match chipdb_name_hash in chipdb.h
+    return (index * 2654435761) & 0xFFFFFFFF
+
 class StringPool:
     def __init__(self):
         self.strs = {"": 0}
@@ -255,6 +259,7 @@ class TileType(BBAStruct):
 
     _wire2idx: dict[IdString, int] = field(default_factory=dict)
     _group2idx: dict[IdString, int] = field(default_factory=dict)
+    _bel_name_index: list[int] = field(default_factory=list)
 
     extra_data: object = None
 
@@ -336,6 +341,10 @@ class TileType(BBAStruct):
         bba.label(f"{context}_bels")
         for i, bel in enumerate(self.bels):
             bel.serialise(f"{context}_bel{i}", bba)
+        self._bel_name_index = self.bel_name_index()
+        bba.label(f"{context}_bel_name_index")
+        for bel_idx in self._bel_name_index:
+            bba.u32(bel_idx)
         bba.label(f"{context}_wires")
         for i, wire in enumerate(self.wires):
             wire.serialise(f"{context}_wire{i}", bba)
@@ -350,9 +359,24 @@ class TileType(BBAStruct):
             self.extra_data.serialise_lists(f"{context}_extra_data", bba)
             bba.label(f"{context}_extra_data")
             self.extra_data.serialise(f"{context}_extra_data", bba)
+    def bel_name_index(self):
+        # Open addressing hash table of bel indices by name, at most half full, for fast bel lookup by name
+        size = 1
+        while size < 2 * len(self.bels):
+            size *= 2
+        if len(self.bels) == 0:
+            size = 0
+        table = [-1] * size
+        for bel in self.bels:
+            slot = name_hash(bel.name.index) & (size - 1)
+            while table[slot] != -1:
+                slot = (slot + 1) & (size - 1)
+            table[slot] = bel.index
+        return table
     def serialise(self, context: str, bba: BBAWriter):
         bba.u32(self.type_name.index)
         bba.slice(f"{context}_bels", len(self.bels))
+        bba.slice(f"{context}_bel_name_index", len(self._bel_name_index))
         bba.slice(f"{context}_wires", len(self.wires))
         bba.slice(f"{context}_pips", len(self.pips))
         bba.slice(f"{context}_groups", len(self.groups))
@@ -908,7 +932,7 @@ class Chip:
 
         bba.label("chip_info")
         bba.u32(0x00ca7ca7) # magic
-        bba.u32(6) # version
+        bba.u32(7) # version
         bba.u32(self.width)
         bba.u32(self.height)
 
@@ -932,10 +956,11 @@ class Chip:
         else:
             bba.u32(0)
 
-    def write_bba(self, filename):
+    def write_bba(self, filename, binary=False):
+        # The binary form is smaller and faster to assemble, but drops comments, see BinaryBBAWriter
         self.timing.finalise()
-        with open(filename, "w") as f:
-            bba = BBAWriter(f)
+        with open(filename, "wb" if binary else "w") as f:
+            bba = BinaryBBAWriter(f) if binary else BBAWriter(f)
             bba.pre('#include \"nextpnr.h\"')
             bba.pre('NEXTPNR_NAMESPACE_BEGIN')
             bba.post('NEXTPNR_NAMESPACE_END')
@@ -943,6 +968,8 @@ class Chip:
             bba.ref('chip_info')
             self.serialise(bba)
             bba.pop()
+            if binary:
+                bba.flush()
 
     def read_gfxids(self, filename):
         idx = 1
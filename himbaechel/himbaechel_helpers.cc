@@ -50,8 +50,10 @@ void HimbaechelHelpers::remove_nextpnr_iobs(const pool<CellTypePort> &top_ports)
         ci.disconnectPort(ctx->id("O"));
         to_remove.push_back(ci.name);
     }
-    for (IdString cell_name : to_remove)
+    for (IdString cell_name : to_remove) {
+        ctx->port_cells.erase(cell_name);
         ctx->cells.erase(cell_name);
+    }
 }
 
 int HimbaechelHelpers::constrain_cell_pairs(const pool<CellTypePort> &src_ports, const pool<CellTypePort> &sink_ports,
@@ -0,0 +1,374 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "himbaechel_lookahead.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <random>
+
+#include "log.h"
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+// Bump whenever the layout of the cache file or the way the table is computed changes
+static constexpr int32_t lookahead_format_version = 2;
+static constexpr char lookahead_magic[8] = {'N', 'P', 'N', 'R', 'L', 'K', 'A', 'H'};
+// Number of source wires searched from for each class
+static constexpr int samples_per_class = 4;
+// Bound on the wires settled by a single search, so that very dense graphs don't blow up build time
+static constexpr int max_settled_wires = 250000;
+
+struct QueuedWire
+{
+    WireId wire;
+    delay_t delay;
+    bool operator>(const QueuedWire &other) const { return delay > other.delay; }
+};
+
+uint64_t hash_mix(uint64_t h, uint64_t v)
+{
+    // FNV-1a over the bytes of v
+    for (int i = 0; i < 8; i++) {
+        h ^= (v >> (8 * i)) & 0xFF;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+uint64_t hash_mix(uint64_t h, const std::string &s)
+{
+    for (char c : s)
+        h = hash_mix(h, uint64_t(uint8_t(c)));
+    return hash_mix(h, uint64_t(s.size()));
+}
+
+// The part of a wire's class key after its tile type. This is the wire type, but wires without one each get their own
+// class (keyed by a negative value derived from the wire index) rather than all sharing the empty wire type.
+int32_t class_key(const TileWireDataPOD &wire_data, int index)
+{
+    return wire_data.wire_type != 0 ? wire_data.wire_type : -1 - index;
+}
+
+template <typename T> void write_value(std::ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool read_value(std::istream &in, T &value)
+{
+    return bool(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+} // namespace
+
+void HimbaechelLookahead::init(Context *ctx, const std::string &cache_prefix, int radius)
+{
+    this->radius = radius;
+    std::string cache_file;
+    if (!cache_prefix.empty())
+        cache_file = stringf("%s-%016" PRIx64 ".lookahead", cache_prefix.c_str(), cache_key(ctx));
+    if (!cache_file.empty() && load(ctx, cache_file)) {
+        log_info("Loaded routing lookahead from '%s'.\n", cache_file.c_str());
+        return;
+    }
+    build(ctx);
+    if (!cache_file.empty())
+        save(ctx, cache_file);
+}
+
+int HimbaechelLookahead::class_of(const Context *ctx, WireId wire) const
+{
+    int type = ctx->chip_info->tile_insts[wire.tile].type;
+    auto &type_wires = wire_class.at(type);
+    if (wire.index >= int(type_wires.size()))
+        return -1;
+    return type_wires.at(wire.index);
+}
+
+delay_t HimbaechelLookahead::estimate(const Context *ctx, WireId src, WireId dst) const
+{
+    int sx, sy, dx, dy;
+    tile_xy(ctx->chip_info, src.tile, sx, sy);
+    tile_xy(ctx->chip_info, dst.tile, dx, dy);
+    int ox = dx - sx, oy = dy - sy;
+    // Clamp to the window and extrapolate the remainder
+    int cx = std::max(-radius, std::min(radius, ox));
+    int cy = std::max(-radius, std::min(radius, oy));
+    int cls = class_of(ctx, src);
+    int32_t base = (cls == -1) ? -1 : entry(cls, cx, cy);
+    if (base < 0)
+        return per_tile_delay * (std::abs(ox) + std::abs(oy));
+    int excess = (std::abs(ox) - std::abs(cx)) + (std::abs(oy) - std::abs(cy));
+    return base + per_tile_delay * excess;
+}
+
+void HimbaechelLookahead::build(Context *ctx)
+{
+    auto build_start = std::chrono::high_resolution_clock::now();
+    const ChipInfoPOD *chip = ctx->chip_info;
+    int mid_x = chip->width / 2, mid_y = chip->height / 2;
+
+    // The instance of each tile type closest to the middle of the device, which is used as the search source so
+    // that as much of the window as possible is inside the device
+    std::vector<int> type_tile(chip->tile_types.ssize(), -1);
+    std::vector<int> type_dist(chip->tile_types.ssize(), std::numeric_limits<int>::max());
+    for (int tile = 0; tile < chip->tile_insts.ssize(); tile++) {
+        int x, y;
+        tile_xy(chip, tile, x, y);
+        int type = chip->tile_insts[tile].type;
+        int dist = std::abs(x - mid_x) + std::abs(y - mid_y);
+        if (dist < type_dist.at(type)) {
+            type_dist.at(type) = dist;
+            type_tile.at(type) = tile;
+        }
+    }
+
+    classes.clear();
+    class_keys.clear();
+    std::vector<WireId> sources;
+    std::vector<int> source_class;
+    std::vector<int> class_sample_count;
+    pool<WireId> seen;
+    for (int type = 0; type < chip->tile_types.ssize(); type++) {
+        int tile = type_tile.at(type);
+        if (tile == -1)
+            continue;
+        for (int index = 0; index < chip->tile_types[type].wires.ssize(); index++) {
+            WireId wire = ctx->normalise_wire(tile, index);
+            if (seen.count(wire))
+                continue;
+            seen.insert(wire);
+            auto downhill = ctx->getPipsDownhill(wire);
+            if (!(downhill.begin() != downhill.end()))
+                continue;
+            auto key =
+                    std::make_pair(chip->tile_insts[wire.tile].type, class_key(chip_wire_info(chip, wire), wire.index));
+            auto found = classes.find(key);
+            int cls;
+            if (found == classes.end()) {
+                cls = int(class_keys.size());
+                classes[key] = cls;
+                class_keys.push_back(key);
+                class_sample_count.push_back(0);
+            } else {
+                cls = found->second;
+            }
+            if (class_sample_count.at(cls) >= samples_per_class)
+                continue;
+            class_sample_count.at(cls)++;
+            sources.push_back(wire);
+            source_class.push_back(cls);
+        }
+    }
+
+    log_info("Building routing lookahead for %d wire classes (%d searches, radius %d)...\n", int(class_keys.size()),
+             int(sources.size()), radius);
+
+    // Searches are independent and only read the routing graph, so they can all run in parallel
+    int win = window();
+    int margin = std::max(2, radius / 2);
+    std::vector<std::vector<int32_t>> results(sources.size());
+    ctx->threadPool().parallel_for(int(sources.size()), [&](int i) {
+        WireId src = sources.at(i);
+        auto &result = results.at(i);
+        result.assign(win * win, -1);
+        int sx, sy;
+        tile_xy(chip, src.tile, sx, sy);
+
+        dict<WireId, delay_t> best;
+        std::priority_queue<QueuedWire, std::vector<QueuedWire>, std::greater<QueuedWire>> queue;
+        best[src] = 0;
+        queue.push(QueuedWire{src, 0});
+        int settled = 0;
+        while (!queue.empty() && settled < max_settled_wires) {
+            QueuedWire curr = queue.top();
+            queue.pop();
+            if (best.at(curr.wire) < curr.delay)
+                continue;
+            settled++;
+            int x, y;
+            tile_xy(chip, curr.wire.tile, x, y);
+            int ox = x - sx, oy = y - sy;
+            if (std::abs(ox) <= radius && std::abs(oy) <= radius) {
+                int32_t &r = result.at((oy + radius) * win + ox + radius);
+                if (r == -1 || curr.delay < r)
+                    r = int32_t(curr.delay);
+            }
+            for (PipId pip : ctx->getPipsDownhill(curr.wire)) {
+                WireId dst = ctx->getPipDstWire(pip);
+                int dx, dy;
+                tile_xy(chip, dst.tile, dx, dy);
+                // Allow some slack outside the window, as the fastest path might briefly leave it
+                if (std::abs(dx - sx) > radius + margin || std::abs(dy - sy) > radius + margin)
+                    continue;
+                delay_t next = curr.delay + ctx->getPipDelay(pip).maxDelay() + ctx->getWireDelay(dst).maxDelay();
+                auto fnd = best.find(dst);
+                if (fnd != best.end() && fnd->second <= next)
+                    continue;
+                best[dst] = next;
+                queue.push(QueuedWire{dst, next});
+            }
+        }
+    });
+
+    // Merge the samples for each class by taking the minimum
+    table.assign(class_keys.size() * win * win, -1);
+    for (size_t i = 0; i < sources.size(); i++) {
+        int cls = source_class.at(i);
+        for (int oy = -radius; oy <= radius; oy++) {
+            for (int ox = -radius; ox <= radius; ox++) {
+                int32_t r = results.at(i).at((oy + radius) * win + ox + radius);
+                int32_t &e = entry(cls, ox, oy);
+                if (r != -1 && (e == -1 || r < e))
+                    e = r;
+            }
+        }
+    }
+
+    // The best delay per tile seen far enough out to be dominated by long-distance routing, for extrapolation
+    double best_per_tile = -1;
+    for (int cls = 0; cls < int(class_keys.size()); cls++) {
+        for (int oy = -radius; oy <= radius; oy++) {
+            for (int ox = -radius; ox <= radius; ox++) {
+                int dist = std::abs(ox) + std::abs(oy);
+                int32_t e = entry(cls, ox, oy);
+                if (e == -1 || dist < std::max(1, radius / 2))
+                    continue;
+                double per_tile = double(e) / dist;
+                if (best_per_tile < 0 || per_tile < best_per_tile)
+                    best_per_tile = per_tile;
+            }
+        }
+    }
+    per_tile_delay = best_per_tile < 0 ? 0 : delay_t(best_per_tile);
+
+    setup_wire_class(ctx);
+
+    auto build_end = std::chrono::high_resolution_clock::now();
+    log_info("Built routing lookahead in %.02fs (%.1f ps per tile beyond window).\n",
+             std::chrono::duration<double>(build_end - build_start).count(), best_per_tile < 0 ? 0.0 : best_per_tile);
+}
+
+void HimbaechelLookahead::setup_wire_class(const Context *ctx)
+{
+    const ChipInfoPOD *chip = ctx->chip_info;
+    classes.clear();
+    for (int cls = 0; cls < int(class_keys.size()); cls++)
+        classes[class_keys.at(cls)] = cls;
+    wire_class.clear();
+    wire_class.resize(chip->tile_types.ssize());
+    for (int type = 0; type < chip->tile_types.ssize(); type++) {
+        auto &tt = chip->tile_types[type];
+        auto &type_wires = wire_class.at(type);
+        type_wires.resize(tt.wires.ssize(), -1);
+        for (int index = 0; index < tt.wires.ssize(); index++) {
+            auto found = classes.find(std::make_pair(int32_t(type), class_key(tt.wires[index], index)));
+            if (found != classes.end())
+                type_wires.at(index) = found->second;
+        }
+    }
+}
+
+uint64_t HimbaechelLookahead::cache_key(const Context *ctx) const
+{
+    const ChipInfoPOD *chip = ctx->chip_info;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = hash_mix(h, uint64_t(lookahead_format_version));
+    h = hash_mix(h, uint64_t(chip->version));
+    h = hash_mix(h, std::string(chip->uarch.get()));
+    h = hash_mix(h, std::string(chip->name.get()));
+    h = hash_mix(h, ctx->chipdb_hash());
+    h = hash_mix(h, uint64_t(chip->width));
+    h = hash_mix(h, uint64_t(chip->height));
+    h = hash_mix(h, ctx->speed_grade ? IdString(ctx->speed_grade->name).str(ctx) : std::string());
+    h = hash_mix(h, uint64_t(radius));
+    return h;
+}
+
+bool HimbaechelLookahead::load(const Context *ctx, const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+    char magic[sizeof(lookahead_magic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, lookahead_magic, sizeof(magic)) != 0)
+        return false;
+    uint64_t key;
+    if (!read_value(in, key) || key != cache_key(ctx)) {
+        log_info("Routing lookahead cache '%s' is out of date, rebuilding.\n", filename.c_str());
+        return false;
+    }
+    int32_t class_count, per_tile;
+    if (!read_value(in, per_tile) || !read_value(in, class_count) || class_count < 0)
+        return false;
+    std::vector<std::pair<int32_t, int32_t>> keys(class_count);
+    for (auto &key : keys) {
+        if (!read_value(in, key.first) || !read_value(in, key.second))
+            return false;
+        if (key.first < 0 || key.first >= ctx->chip_info->tile_types.ssize())
+            return false;
+    }
+    std::vector<int32_t> data(size_t(class_count) * window() * window());
+    if (!in.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(int32_t)))
+        return false;
+    class_keys = std::move(keys);
+    table = std::move(data);
+    per_tile_delay = per_tile;
+    setup_wire_class(ctx);
+    return true;
+}
+
+void HimbaechelLookahead::save(const Context *ctx, const std::string &filename) const
+{
+    // Written under a temporary name and then renamed into place, so that other runs (including concurrent ones in
+    // the same process) never see a partial cache file
+    std::string tmp_filename = stringf("%s.tmp%u", filename.c_str(), unsigned(std::random_device{}()));
+    std::ofstream out(tmp_filename, std::ios::binary);
+    if (!out) {
+        log_info("Unable to write routing lookahead cache '%s', it will be rebuilt on the next run.\n",
+                 filename.c_str());
+        return;
+    }
+    out.write(lookahead_magic, sizeof(lookahead_magic));
+    write_value(out, cache_key(ctx));
+    write_value(out, int32_t(per_tile_delay));
+    write_value(out, int32_t(class_keys.size()));
+    for (auto &key : class_keys) {
+        write_value(out, key.first);
+        write_value(out, key.second);
+    }
+    out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(int32_t));
+    out.close();
+    if (!out) {
+        log_info("Failed to write routing lookahead cache '%s'.\n", filename.c_str());
+        std::remove(tmp_filename.c_str());
+        return;
+    }
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+        std::remove(tmp_filename.c_str());
+}
+
+NEXTPNR_NAMESPACE_END
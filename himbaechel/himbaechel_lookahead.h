@@ -0,0 +1,92 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef HIMBAECHEL_LOOKAHEAD_H
+#define HIMBAECHEL_LOOKAHEAD_H
+
+#include <string>
+#include <vector>
+
+#include "hashlib.h"
+#include "nextpnr_namespaces.h"
+#include "nextpnr_types.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+struct Context;
+
+/*
+Precomputed routing lookahead for the router's A* cost-to-go estimate.
+
+Routing wires are grouped into classes by the type of the tile they are rooted in and their wire type; wires without a
+wire type are each a class of their own. For a few
+representative wires of each class, near the middle of the device, a bounded Dijkstra search through the routing graph
+finds the minimum delay to reach any wire rooted at each tile offset within `radius` tiles. Offsets outside the
+searched window are extrapolated from the window edge using the best per-tile delay seen anywhere.
+
+Only delay is tabulated; congestion is left to the router's own cost terms.
+
+Estimates for wires that don't start a tabulated class, or for offsets that no search reached, are extrapolated from
+the per-tile delay over the whole distance, so that all estimates share one scale.
+
+As building the table means a search from every class, it is cached in the user cache directory, in a file named by a
+hash of the chipdb contents, speed grade and search parameters.
+*/
+struct HimbaechelLookahead
+{
+    // Build the table, or load it from the cache file for the current database starting with cache_prefix. An empty
+    // cache_prefix disables the cache.
+    void init(Context *ctx, const std::string &cache_prefix, int radius);
+    bool ready() const { return !table.empty(); }
+    // Estimated delay from src to dst
+    delay_t estimate(const Context *ctx, WireId src, WireId dst) const;
+
+  private:
+    int radius = 0;
+    // Extrapolated delay per tile beyond the edge of the window
+    delay_t per_tile_delay = 0;
+    // (tile type, class_key) -> class index
+    dict<std::pair<int32_t, int32_t>, int> classes;
+    std::vector<std::pair<int32_t, int32_t>> class_keys;
+    // [tile type][wire index] -> class index, or -1 for wires that don't start a tabulated search
+    std::vector<std::vector<int>> wire_class;
+    // [class][dy + radius][dx + radius]; -1 where no wire at that offset was reached
+    std::vector<int32_t> table;
+
+    int class_of(const Context *ctx, WireId wire) const;
+    int window() const { return 2 * radius + 1; }
+    int32_t &entry(int cls, int dx, int dy)
+    {
+        return table.at((cls * window() + dy + radius) * window() + dx + radius);
+    }
+    int32_t entry(int cls, int dx, int dy) const
+    {
+        return table.at((cls * window() + dy + radius) * window() + dx + radius);
+    }
+
+    void build(Context *ctx);
+    void setup_wire_class(const Context *ctx);
+    uint64_t cache_key(const Context *ctx) const;
+    bool load(const Context *ctx, const std::string &filename);
+    void save(const Context *ctx, const std::string &filename) const;
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif
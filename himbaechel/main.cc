@@ -52,6 +52,8 @@ po::options_description HimbaechelCommandHandler::getArchOptions()
     specific.add_options()("chipdb", po::value<std::string>(), "override path to chip database file");
     specific.add_options()("list-uarch", "list included uarches");
     specific.add_options()("vopt,o", po::value<std::vector<std::string>>(), "options to pass to the himbächel uarch");
+    specific.add_options()("no-lookahead", "use the uarch's delay estimate rather than a precomputed routing lookahead");
+    specific.add_options()("lookahead-radius", po::value<int>(), "radius in tiles of the routing lookahead searches");
 
     return specific;
 }
@@ -92,6 +94,10 @@ std::unique_ptr<Context> HimbaechelCommandHandler::createContext(dict<std::strin
         }
     }
     auto ctx = std::unique_ptr<Context>(new Context(chipArgs));
+    if (vm.count("no-lookahead"))
+        ctx->settings[ctx->id("himbaechel/lookahead")] = false;
+    if (vm.count("lookahead-radius"))
+        ctx->settings[ctx->id("himbaechel/lookaheadRadius")] = vm["lookahead-radius"].as<int>();
     if (vm.count("gui"))
         ctx->uarch->with_gui = true;
     ctx->uarch->init(ctx.get());
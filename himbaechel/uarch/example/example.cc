@@ -54,6 +54,8 @@ struct ExampleImpl : HimbaechelAPI
     }
 
     void prePlace() override { assign_cell_info(); }
+    // Packing only rewrites the netlist, and the validity cache is rebuilt by prePlace
+    bool canForkDesign() const override { return true; }
 
     void pack() override
     {
@@ -0,0 +1,206 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <algorithm>
+#include <sstream>
+#include "checkpoint.h"
+#include "command.h"
+#include "gtest/gtest.h"
+#include "json_frontend.h"
+#include "jsonwrite.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+// A registered LUT between three inputs and an output, with the IO buffers that synthesis would have inserted. The clock
+// input is constrained to a pad that the global clock network can be reached from.
+const char *design = R"({"modules": {"top": {
+    "attributes": {"top": "00000000000000000000000000000001"},
+    "ports": {
+        "clk": {"direction": "input", "bits": [2]},
+        "a": {"direction": "input", "bits": [3]},
+        "b": {"direction": "input", "bits": [4]},
+        "q": {"direction": "output", "bits": [5]}
+    },
+    "cells": {
+        "clk_ibuf": {"type": "INBUF", "attributes": {"BEL": "X1Y0/IO0"},
+                     "port_directions": {"PAD": "input", "O": "output"},
+                     "connections": {"PAD": [2], "O": [6]}},
+        "a_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [3], "O": [7]}},
+        "b_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [4], "O": [8]}},
+        "lut": {"type": "LUT4", "parameters": {"INIT": "0110100110010110"},
+                "port_directions": {"I[0]": "input", "I[1]": "input", "I[2]": "input", "F": "output"},
+                "connections": {"I[0]": [7], "I[1]": [8], "I[2]": [10], "F": [9]}},
+        "ff": {"type": "DFF", "port_directions": {"CLK": "input", "D": "input", "Q": "output"},
+               "connections": {"CLK": [6], "D": [9], "Q": [10]}},
+        "q_obuf": {"type": "OUTBUF", "port_directions": {"I": "input", "PAD": "output"},
+                   "connections": {"I": [10], "PAD": [5]}}
+    },
+    "netnames": {
+        "clk_i": {"bits": [6]}, "a_i": {"bits": [7]}, "b_i": {"bits": [8]}, "d": {"bits": [9]}, "q_o": {"bits": [10]}
+    }
+}}})";
+} // namespace
+
+class ExampleCheckpointTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() override { init_share_dirname(); }
+
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.device = "EXAMPLE";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        ctx->uarch->init(ctx.get());
+        ctx->late_init();
+        // The defaults the command line handler would set
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        ctx->settings[ctx->id("timing_driven")] = true;
+        ctx->settings[ctx->id("slack_redist_iter")] = 0;
+        ctx->settings[ctx->id("auto_freq")] = false;
+        ctx->settings[ctx->id("placer")] = std::string("sa");
+        ctx->settings[ctx->id("router")] = Arch::defaultRouter;
+        return ctx;
+    }
+
+    std::unique_ptr<Context> load_design()
+    {
+        auto ctx = create_context();
+        std::istringstream in(design);
+        EXPECT_TRUE(parse_json(in, "design.json", ctx.get()));
+        return ctx;
+    }
+
+    // Writes a checkpoint of ctx and loads it into a new context
+    std::unique_ptr<Context> round_trip(Context *ctx)
+    {
+        std::ostringstream out;
+        write_checkpoint(ctx, out);
+        std::string data = out.str();
+        auto loaded = create_context();
+        EXPECT_TRUE(load_checkpoint(loaded.get(), data.data(), data.size(), "design.ckpt"));
+        return loaded;
+    }
+
+    // The netlist, placement and routing of a design by name, independent of IdString indices and container order.
+    // Unconnected nets are left out, as reading back a packed design from JSON adds one for each top-level port.
+    std::vector<std::string> describe(const Context *ctx)
+    {
+        auto prop = [](const Property &p) { return p.is_string ? p.as_string() : p.to_string(); };
+        auto port_ref = [&](const PortRef &ref) {
+            return ref.cell ? stringf("%s.%s", ctx->nameOf(ref.cell), ref.port.c_str(ctx)) : std::string("-");
+        };
+        std::vector<std::string> result;
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get();
+            result.push_back(stringf("cell %s %s %s", ctx->nameOf(ci), ci->type.c_str(ctx),
+                                     ci->bel == BelId() ? "-" : ctx->nameOfBel(ci->bel)));
+            for (auto &param : ci->params)
+                result.push_back(stringf("cell %s param %s=%s", ctx->nameOf(ci), param.first.c_str(ctx),
+                                         prop(param.second).c_str()));
+            for (auto &attr : ci->attrs)
+                result.push_back(stringf("cell %s attr %s=%s", ctx->nameOf(ci), attr.first.c_str(ctx),
+                                         prop(attr.second).c_str()));
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get();
+            if (!ni->driver.cell && ni->users.empty())
+                continue;
+            result.push_back(stringf("net %s driver %s", ctx->nameOf(ni), port_ref(ni->driver).c_str()));
+            for (auto &usr : ni->users)
+                result.push_back(stringf("net %s user %s", ctx->nameOf(ni), port_ref(usr).c_str()));
+            for (auto &wire : ni->wires)
+                result.push_back(stringf("net %s wire %s %s", ctx->nameOf(ni), ctx->nameOfWire(wire.first),
+                                         wire.second.pip == PipId() ? "-" : ctx->nameOfPip(wire.second.pip)));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::string to_json(Context *ctx)
+    {
+        std::ostringstream out;
+        std::string filename = "design.json";
+        EXPECT_TRUE(write_json_file(out, filename, ctx));
+        return out.str();
+    }
+};
+
+TEST_F(ExampleCheckpointTest, unpacked)
+{
+    auto ctx = load_design();
+    auto loaded = round_trip(ctx.get());
+    ASSERT_EQ(loaded->cells.size(), ctx->cells.size());
+    ASSERT_EQ(loaded->nets.size(), ctx->nets.size());
+    ASSERT_EQ(loaded->port_cells.size(), ctx->port_cells.size());
+    ASSERT_EQ(to_json(loaded.get()), to_json(ctx.get()));
+}
+
+TEST_F(ExampleCheckpointTest, packed)
+{
+    // Packing deletes the $nextpnr_[io]buf cells that port_cells refers to
+    auto ctx = load_design();
+    ctx->pack();
+    auto loaded = round_trip(ctx.get());
+    ASSERT_EQ(loaded->cells.size(), ctx->cells.size());
+    ASSERT_EQ(loaded->nets.size(), ctx->nets.size());
+    for (auto &port : loaded->port_cells)
+        ASSERT_EQ(loaded->getPortCell(port.first), port.second);
+    ASSERT_EQ(to_json(loaded.get()), to_json(ctx.get()));
+}
+
+TEST_F(ExampleCheckpointTest, routed)
+{
+    auto ctx = load_design();
+    ctx->pack();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    auto loaded = round_trip(ctx.get());
+    for (auto &cell : ctx->cells) {
+        ASSERT_NE(cell.second->bel, BelId());
+        ASSERT_EQ(loaded->cells.at(cell.first)->bel, cell.second->bel);
+    }
+    for (auto &net : ctx->nets) {
+        auto &loaded_wires = loaded->nets.at(net.first)->wires;
+        ASSERT_EQ(loaded_wires.size(), net.second->wires.size());
+        for (auto &wire : net.second->wires)
+            ASSERT_EQ(loaded_wires.at(wire.first).pip, wire.second.pip);
+    }
+    ASSERT_EQ(to_json(loaded.get()), to_json(ctx.get()));
+}
+
+TEST_F(ExampleCheckpointTest, reload_json)
+{
+    // A routed design written as JSON and as a checkpoint must load to the same state
+    auto ctx = load_design();
+    ctx->pack();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    std::string json = to_json(ctx.get());
+
+    auto from_json = create_context();
+    std::istringstream in(json);
+    ASSERT_TRUE(parse_json(in, "routed.json", from_json.get()));
+    auto from_checkpoint = round_trip(ctx.get());
+    ASSERT_EQ(describe(from_checkpoint.get()), describe(from_json.get()));
+}
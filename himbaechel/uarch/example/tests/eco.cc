@@ -0,0 +1,147 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <sstream>
+#include "command.h"
+#include "gtest/gtest.h"
+#include "json_frontend.h"
+#include "jsonwrite.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+// Two registers, one fed by a LUT of two inputs and the other by an inverter of the first. The inverter only uses
+// I[0], which the JSON writer turns into a single bit bus "I".
+const char *design = R"({"modules": {"top": {
+    "attributes": {"top": "00000000000000000000000000000001"},
+    "ports": {
+        "clk": {"direction": "input", "bits": [2]},
+        "a": {"direction": "input", "bits": [3]},
+        "b": {"direction": "input", "bits": [4]},
+        "q": {"direction": "output", "bits": [5]}
+    },
+    "cells": {
+        "clk_ibuf": {"type": "INBUF", "attributes": {"BEL": "X1Y0/IO0"},
+                     "port_directions": {"PAD": "input", "O": "output"},
+                     "connections": {"PAD": [2], "O": [6]}},
+        "a_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [3], "O": [7]}},
+        "b_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [4], "O": [8]}},
+        "lut": {"type": "LUT4", "parameters": {"INIT": "0110011001100110"},
+                "port_directions": {"I[0]": "input", "I[1]": "input", "F": "output"},
+                "connections": {"I[0]": [7], "I[1]": [8], "F": [9]}},
+        "ff0": {"type": "DFF", "port_directions": {"CLK": "input", "D": "input", "Q": "output"},
+                "connections": {"CLK": [6], "D": [9], "Q": [10]}},
+        "inv": {"type": "LUT4", "parameters": {"INIT": "0101010101010101"},
+                "port_directions": {"I[0]": "input", "F": "output"},
+                "connections": {"I[0]": [10], "F": [11]}},
+        "ff1": {"type": "DFF", "port_directions": {"CLK": "input", "D": "input", "Q": "output"},
+                "connections": {"CLK": [6], "D": [11], "Q": [12]}},
+        "q_obuf": {"type": "OUTBUF", "port_directions": {"I": "input", "PAD": "output"},
+                   "connections": {"I": [12], "PAD": [5]}}
+    },
+    "netnames": {
+        "clk_i": {"bits": [6]}, "a_i": {"bits": [7]}, "b_i": {"bits": [8]}, "d0": {"bits": [9]},
+        "q0": {"bits": [10]}, "d1": {"bits": [11]}, "q_o": {"bits": [12]}
+    }
+}}})";
+} // namespace
+
+class ExampleEcoTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() override { init_share_dirname(); }
+
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.device = "EXAMPLE";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        ctx->uarch->init(ctx.get());
+        ctx->late_init();
+        // The defaults the command line handler would set
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        ctx->settings[ctx->id("timing_driven")] = true;
+        ctx->settings[ctx->id("slack_redist_iter")] = 0;
+        ctx->settings[ctx->id("auto_freq")] = false;
+        ctx->settings[ctx->id("placer")] = std::string("sa");
+        ctx->settings[ctx->id("router")] = Arch::defaultRouter;
+        return ctx;
+    }
+
+    std::unique_ptr<Context> load_design()
+    {
+        auto ctx = create_context();
+        std::istringstream in(design);
+        EXPECT_TRUE(parse_json(in, "design.json", ctx.get()));
+        ctx->pack();
+        return ctx;
+    }
+
+    // Checks that ctx has the placement and routing of prev, matching cells and nets by name
+    void expect_same_result(Context *ctx, const Context *prev)
+    {
+        for (auto &cell : ctx->cells) {
+            const CellInfo *pc = prev->cells.at(prev->id(cell.first.str(ctx))).get();
+            ASSERT_NE(cell.second->bel, BelId());
+            EXPECT_EQ(ctx->nameOfBel(cell.second->bel), std::string(prev->nameOfBel(pc->bel)))
+                    << "cell " << ctx->nameOf(cell.second.get());
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get();
+            const NetInfo *pn = prev->nets.at(prev->id(net.first.str(ctx))).get();
+            EXPECT_EQ(ni->wires.size(), pn->wires.size()) << "net " << ctx->nameOf(ni);
+            for (auto &wire : pn->wires) {
+                auto found = ni->wires.find(ctx->getWireByNameStr(prev->nameOfWire(wire.first)));
+                ASSERT_NE(found, ni->wires.end()) << "net " << ctx->nameOf(ni) << " wire "
+                                                  << prev->nameOfWire(wire.first);
+                EXPECT_EQ(found->second.pip == PipId(), wire.second.pip == PipId());
+                if (wire.second.pip != PipId()) {
+                    EXPECT_EQ(ctx->nameOfPip(found->second.pip), std::string(prev->nameOfPip(wire.second.pip)));
+                }
+            }
+        }
+    }
+};
+
+TEST_F(ExampleEcoTest, unchanged)
+{
+    // ECO with a design's own routed output as the previous result keeps all of it
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    std::ostringstream out;
+    std::string filename = "design.json";
+    ASSERT_TRUE(write_json_file(out, filename, ctx.get()));
+
+    auto prev = create_context();
+    std::istringstream in(out.str());
+    ASSERT_TRUE(parse_json(in, "routed.json", prev.get()));
+
+    auto eco = load_design();
+    eco->eco_previous = std::move(prev);
+    eco->settings[eco->id("placer")] = std::string("eco");
+    ASSERT_TRUE(eco->place());
+    // All of the placement and routing is already there before the router runs
+    expect_same_result(eco.get(), eco->eco_previous.get());
+    ASSERT_TRUE(eco->route());
+    expect_same_result(eco.get(), eco->eco_previous.get());
+}
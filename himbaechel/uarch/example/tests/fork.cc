@@ -0,0 +1,171 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <sstream>
+#include "command.h"
+#include "gtest/gtest.h"
+#include "json_frontend.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+// A registered XOR of two inputs, fed back into itself through a second LUT
+const char *design = R"({"modules": {"top": {
+    "attributes": {"top": "00000000000000000000000000000001"},
+    "ports": {
+        "clk": {"direction": "input", "bits": [2]},
+        "a": {"direction": "input", "bits": [3]},
+        "b": {"direction": "input", "bits": [4]},
+        "q": {"direction": "output", "bits": [5]}
+    },
+    "cells": {
+        "clk_ibuf": {"type": "INBUF", "attributes": {"BEL": "X1Y0/IO0"},
+                     "port_directions": {"PAD": "input", "O": "output"},
+                     "connections": {"PAD": [2], "O": [6]}},
+        "a_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [3], "O": [7]}},
+        "b_ibuf": {"type": "INBUF", "port_directions": {"PAD": "input", "O": "output"},
+                   "connections": {"PAD": [4], "O": [8]}},
+        "lut0": {"type": "LUT4", "parameters": {"INIT": "0110100110010110"},
+                 "port_directions": {"I[0]": "input", "I[1]": "input", "I[2]": "input", "F": "output"},
+                 "connections": {"I[0]": [7], "I[1]": [8], "I[2]": [11], "F": [9]}},
+        "ff0": {"type": "DFF", "port_directions": {"CLK": "input", "D": "input", "Q": "output"},
+                "connections": {"CLK": [6], "D": [9], "Q": [10]}},
+        "lut1": {"type": "LUT4", "parameters": {"INIT": "0101010101010101"},
+                 "port_directions": {"I[0]": "input", "F": "output"},
+                 "connections": {"I[0]": [10], "F": [11]}},
+        "q_obuf": {"type": "OUTBUF", "port_directions": {"I": "input", "PAD": "output"},
+                   "connections": {"I": [10], "PAD": [5]}}
+    },
+    "netnames": {
+        "clk_i": {"bits": [6]}, "a_i": {"bits": [7]}, "b_i": {"bits": [8]}, "d": {"bits": [9]}, "q_o": {"bits": [10]},
+        "fb": {"bits": [11]}
+    }
+}}})";
+} // namespace
+
+class ExampleForkTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() override { init_share_dirname(); }
+
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.device = "EXAMPLE";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        ctx->uarch->init(ctx.get());
+        ctx->late_init();
+        // The defaults the command line handler would set
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        ctx->settings[ctx->id("timing_driven")] = true;
+        ctx->settings[ctx->id("slack_redist_iter")] = 0;
+        ctx->settings[ctx->id("auto_freq")] = false;
+        ctx->settings[ctx->id("placer")] = std::string("sa");
+        ctx->settings[ctx->id("router")] = Arch::defaultRouter;
+        return ctx;
+    }
+
+    std::unique_ptr<Context> load_design()
+    {
+        auto ctx = create_context();
+        std::istringstream in(design);
+        EXPECT_TRUE(parse_json(in, "design.json", ctx.get()));
+        ctx->pack();
+        return ctx;
+    }
+
+    std::unique_ptr<Context> fork_design(const Context *ctx)
+    {
+        auto forked = create_context();
+        ctx->forkInto(forked.get());
+        return forked;
+    }
+
+    // Checks that forked has the netlist, placement and routing of ctx, and that the arch agrees about what is bound
+    void expect_same_design(const Context *ctx, const Context *forked)
+    {
+        ASSERT_EQ(forked->cells.size(), ctx->cells.size());
+        ASSERT_EQ(forked->nets.size(), ctx->nets.size());
+        auto fc = forked->cells.begin();
+        for (auto &cell : ctx->cells) {
+            // Same iteration order, so that flows on both contexts make the same choices
+            ASSERT_EQ(fc->first, cell.first);
+            const CellInfo *ci = cell.second.get(), *fi = fc->second.get();
+            ++fc;
+            EXPECT_EQ(fi->type, ci->type);
+            EXPECT_EQ(fi->params, ci->params);
+            EXPECT_EQ(fi->bel, ci->bel) << ctx->nameOf(ci);
+            if (ci->bel != BelId()) {
+                EXPECT_EQ(forked->getBoundBelCell(ci->bel), fi);
+            }
+            ASSERT_EQ(fi->ports.size(), ci->ports.size());
+            for (auto &port : ci->ports) {
+                const NetInfo *fn = fi->getPort(port.first);
+                EXPECT_EQ(fn ? fn->name : IdString(), port.second.net ? port.second.net->name : IdString());
+                if (fn) {
+                    EXPECT_EQ(fn, forked->nets.at(fn->name).get());
+                }
+            }
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get(), *fn = forked->nets.at(net.first).get();
+            EXPECT_EQ(fn->driver.cell ? fn->driver.cell->name : IdString(),
+                      ni->driver.cell ? ni->driver.cell->name : IdString());
+            EXPECT_EQ(fn->users.entries(), ni->users.entries());
+            ASSERT_EQ(fn->wires.size(), ni->wires.size()) << ctx->nameOf(ni);
+            for (auto &wire : ni->wires) {
+                EXPECT_EQ(fn->wires.at(wire.first).pip, wire.second.pip);
+                EXPECT_EQ(forked->getBoundWireNet(wire.first), fn);
+            }
+        }
+    }
+};
+
+TEST_F(ExampleForkTest, packed)
+{
+    auto ctx = load_design();
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ExampleForkTest, routed)
+{
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ExampleForkTest, same_result)
+{
+    // A fork of a packed design places and routes the same way as the original, as --seed-sweep relies on
+    auto ctx = load_design();
+    auto forked = fork_design(ctx.get());
+    for (Context *c : {ctx.get(), forked.get()}) {
+        c->rngseed(3);
+        ASSERT_TRUE(c->place());
+        ASSERT_TRUE(c->route());
+    }
+    expect_same_design(ctx.get(), forked.get());
+}
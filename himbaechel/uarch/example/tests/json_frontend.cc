@@ -0,0 +1,328 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <algorithm>
+#include <sstream>
+#include "command.h"
+#include "frontend_base.h"
+#include "gtest/gtest.h"
+#include "json11.hpp"
+#include "json_frontend.h"
+#include "jsonwrite.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+using namespace json11;
+
+// The JSON frontend as it was before it got its own parser, which reads the netlist through the json11 DOM. The
+// frontend must import every netlist exactly as this does.
+struct Json11FrontendImpl
+{
+    Json11FrontendImpl(Json &root) : root(root) {};
+    Json &root;
+    typedef const Json &ModuleDataType;
+    typedef const Json &ModulePortDataType;
+    typedef const Json &CellDataType;
+    typedef const Json &NetnameDataType;
+    typedef const Json::array &BitVectorDataType;
+
+    template <typename TFunc> void foreach_module(TFunc Func) const
+    {
+        for (const auto &mod : root.object_items())
+            Func(mod.first, mod.second);
+    }
+
+    template <typename TFunc> void foreach_port(ModuleDataType &mod, TFunc Func) const
+    {
+        for (const auto &port : mod["ports"].object_items())
+            Func(port.first, port.second);
+    }
+
+    template <typename TFunc> void foreach_cell(ModuleDataType &mod, TFunc Func) const
+    {
+        for (const auto &cell : mod["cells"].object_items())
+            Func(cell.first, cell.second);
+    }
+
+    template <typename TFunc> void foreach_netname(ModuleDataType &mod, TFunc Func) const
+    {
+        for (const auto &netname : mod["netnames"].object_items())
+            Func(netname.first, netname.second);
+    }
+
+    PortType lookup_portdir(const std::string &dir) const
+    {
+        if (dir == "input")
+            return PORT_IN;
+        else if (dir == "inout")
+            return PORT_INOUT;
+        else if (dir == "output")
+            return PORT_OUT;
+        else
+            NPNR_ASSERT_FALSE("invalid json port direction");
+    }
+
+    PortType get_port_dir(ModulePortDataType &port) const { return lookup_portdir(port["direction"].string_value()); }
+
+    int get_array_offset(const Json &obj) const { return obj["offset"].int_value(); }
+
+    bool is_array_upto(const Json &obj) const { return bool(obj["upto"].int_value()); }
+
+    BitVectorDataType &get_port_bits(ModulePortDataType &port) const { return port["bits"].array_items(); }
+
+    const std::string &get_cell_type(CellDataType &cell) const { return cell["type"].string_value(); }
+
+    Property parse_property(const Json &val) const
+    {
+        if (val.is_number()) {
+            if (val.int_value() != val.number_value())
+                log_error("Found an out-of-range integer parameter in the JSON file.\n");
+            return Property(val.int_value(), 32);
+        } else {
+            return Property::from_string(val.string_value());
+        }
+    }
+
+    template <typename TFunc> void foreach_attr(const Json &obj, TFunc Func) const
+    {
+        for (const auto &attr : obj["attributes"].object_items())
+            Func(attr.first, parse_property(attr.second));
+    }
+
+    template <typename TFunc> void foreach_param(const Json &obj, TFunc Func) const
+    {
+        for (const auto &param : obj["parameters"].object_items())
+            Func(param.first, parse_property(param.second));
+    }
+
+    template <typename TFunc> void foreach_setting(const Json &obj, TFunc Func) const
+    {
+        for (const auto &setting : obj["settings"].object_items())
+            Func(setting.first, parse_property(setting.second));
+    }
+
+    template <typename TFunc> void foreach_port_dir(CellDataType &cell, TFunc Func) const
+    {
+        for (const auto &pdir : cell["port_directions"].object_items())
+            Func(pdir.first, lookup_portdir(pdir.second.string_value()));
+    }
+
+    template <typename TFunc> void foreach_port_conn(CellDataType &cell, TFunc Func) const
+    {
+        for (const auto &pconn : cell["connections"].object_items())
+            Func(pconn.first, pconn.second.array_items());
+    }
+
+    BitVectorDataType &get_net_bits(NetnameDataType &net) const { return net["bits"].array_items(); }
+
+    int get_vector_length(BitVectorDataType &bits) const { return int(bits.size()); }
+
+    bool is_vector_bit_undef(BitVectorDataType &bits, int i) const { return bits.at(i) == "x"; }
+
+    bool is_vector_bit_constant(BitVectorDataType &bits, int i) const { return bits.at(i).is_string(); }
+
+    char get_vector_bit_constval(BitVectorDataType &bits, int i) const
+    {
+        auto s = bits.at(i).string_value();
+        NPNR_ASSERT(s.size() == 1);
+        return s.at(0);
+    }
+
+    int get_vector_bit_signal(BitVectorDataType &bits, int i) const
+    {
+        NPNR_ASSERT(bits.at(i).is_number());
+        return bits.at(i).int_value();
+    }
+};
+
+void parse_json11(const std::string &json, Context *ctx)
+{
+    std::string error;
+    Json root = Json::parse(json, error, JsonParse::COMMENTS);
+    if (root.is_null())
+        log_error("Failed to parse JSON: %s.\n", error.c_str());
+    root = root["modules"];
+    if (root.is_null())
+        log_error("JSON doesn't contain \"modules\" key\n");
+    GenericFrontend<Json11FrontendImpl>(ctx, Json11FrontendImpl(root), /*split_io=*/true)();
+}
+
+// Exercises the less common parts of the syntax and of the netlist format: escapes (including a surrogate pair),
+// comments, duplicate keys, constant and undefined bits, bus ports with an offset and upto, inout ports, numeric and
+// string properties, settings and a level of hierarchy.
+const char *features_design = R"({
+    // Written by hand, not by yosys
+    "creator": "test",
+    "modules": {
+        "sub": {
+            "attributes": {"keep_hierarchy": 1},
+            "ports": {"i": {"direction": "input", "bits": [2]}, "o": {"direction": "output", "bits": [3]}},
+            "cells": {
+                "inv": {"type": "LUT4", "parameters": {"INIT": "0101010101010101"},
+                        "port_directions": {"I[0]": "input", "F": "output"},
+                        "connections": {"I[0]": [2], "F": [3]}}
+            },
+            "netnames": {"i": {"bits": [2]}, "o": {"bits": [3]}}
+        },
+        "top": {
+            "attributes": {"top": "00000000000000000000000000000001", "src": "top.v:1.1-40.10"},
+            "settings": {"seed": 7, "comment": "a \"quoted\"\tsetting"},
+            "ports": {
+                "bus": {"direction": "input", "bits": [2, 3, 4, 5], "offset": 4, "upto": 1},
+                "io": {"direction": "inout", "bits": [6]},
+                "q": {"direction": "output", "bits": [7, 8, "0", "1"]}
+            },
+            "cells": {
+                /* The second definition of a key wins */
+                "luté": {"type": "LUT4", "parameters": {"INIT": "0000000000000000"}},
+                "lut\u00e9": {"type": "LUT4",
+                              "parameters": {"INIT": "0110100110010110", "WIDTH": 4, "NEG": -3},
+                              "attributes": {"name\ud83d\ude00": "x", "keep": "00000000000000000000000000000001"},
+                              "port_directions": {"I[0]": "input", "I[1]": "input", "I[2]": "input",
+                                                  "I[3]": "input", "F": "output"},
+                              "connections": {"I[0]": [2], "I[1]": [3], "I[2]": ["x"], "I[3]": ["1"], "F": [9]}},
+                "child": {"type": "sub", "port_directions": {"i": "input", "o": "output"},
+                          "connections": {"i": [9], "o": [7]}},
+                "ff": {"type": "DFF", "port_directions": {"CLK": "input", "D": "input", "Q": "output"},
+                       "connections": {"CLK": [4], "D": [6], "Q": [8]}}
+            },
+            "netnames": {
+                "bus": {"bits": [2, 3, 4, 5], "offset": 4, "upto": 1},
+                "io": {"bits": [6]},
+                "q": {"bits": [7, 8, "0", "1"], "attributes": {"hdlname": "q\\out"}},
+                "$auto$lut.cc:1$9": {"hide_name": 1, "bits": [9]}
+            }
+        }
+    }
+})";
+
+// A larger netlist in the compact style nextpnr writes, with a long chain of LUTs and registers
+std::string chain_design(int length)
+{
+    std::ostringstream out;
+    out << R"({"modules": {"top": {"attributes": {"top": "00000000000000000000000000000001"}, )";
+    out << R"("ports": {"clk": {"direction": "input", "bits": [2]}, "d": {"direction": "input", "bits": [3]}, )";
+    out << R"("q": {"direction": "output", "bits": [)" << (2 * length + 3) << "]}}, \"cells\": {";
+    for (int i = 0; i < length; i++) {
+        int in = 2 * i + 3, mid = 2 * i + 4, q = 2 * i + 5;
+        out << (i ? ", " : "") << "\"lut" << i << "\": {\"type\": \"LUT4\", \"parameters\": {\"INIT\": " << (i * 7919)
+            << R"(}, "attributes": {"src": "chain.v:)" << i << R"(.1-)" << i << R"(.20"}, )"
+            << R"("port_directions": {"I[0]": "input", "F": "output"}, )" << R"("connections": {"I[0]": [)" << in
+            << "], \"F\": [" << mid << "]}}, ";
+        out << "\"ff" << i << "\": {\"type\": \"DFF\", "
+            << R"("port_directions": {"CLK": "input", "D": "input", "Q": "output"}, )"
+            << R"("connections": {"CLK": [2], "D": [)" << mid << "], \"Q\": [" << q << "]}}";
+    }
+    out << "}, \"netnames\": {";
+    for (int i = 0; i < length; i++)
+        out << (i ? ", " : "") << "\"stage" << i << "\": {\"bits\": [" << (2 * i + 5) << "]}";
+    out << "}}}}";
+    return out.str();
+}
+} // namespace
+
+class JsonFrontendTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() override { init_share_dirname(); }
+
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.device = "EXAMPLE";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        ctx->uarch->init(ctx.get());
+        ctx->late_init();
+        return ctx;
+    }
+
+    // Everything the frontend creates, as JSON plus the parts that the JSON writer leaves out
+    std::string describe(Context *ctx)
+    {
+        std::ostringstream out;
+        std::string filename = "design.json";
+        EXPECT_TRUE(write_json_file(out, filename, ctx));
+        std::vector<std::string> extra;
+        for (auto &hier : ctx->hierarchy)
+            extra.push_back(stringf("hierarchy %s %s %s", hier.first.c_str(ctx), hier.second.name.c_str(ctx),
+                                    hier.second.type.c_str(ctx)));
+        for (auto &port : ctx->ports)
+            extra.push_back(stringf("port %s %d %s", port.first.c_str(ctx), int(port.second.type),
+                                    port.second.net ? ctx->nameOf(port.second.net) : "-"));
+        for (auto &setting : ctx->settings)
+            extra.push_back(stringf("setting %s %s", setting.first.c_str(ctx), setting.second.to_string().c_str()));
+        std::sort(extra.begin(), extra.end());
+        for (auto &line : extra)
+            out << line << "\n";
+        return out.str();
+    }
+
+    void check_equivalent(const std::string &json)
+    {
+        auto reference = create_context();
+        parse_json11(json, reference.get());
+        auto ctx = create_context();
+        std::istringstream in(json);
+        ASSERT_TRUE(parse_json(in, "design.json", ctx.get()));
+        ASSERT_EQ(ctx->cells.size(), reference->cells.size());
+        ASSERT_EQ(ctx->nets.size(), reference->nets.size());
+        ASSERT_EQ(describe(ctx.get()), describe(reference.get()));
+    }
+};
+
+TEST_F(JsonFrontendTest, features)
+{
+    check_equivalent(features_design);
+    // The same netlist with all optional whitespace removed
+    std::string compact;
+    bool in_string = false, escaped = false;
+    for (const char *p = features_design; *p; p++) {
+        if (*p == '/' && !in_string && p[1] == '/') {
+            while (*p && *p != '\n')
+                p++;
+            continue;
+        }
+        if (in_string || (*p != ' ' && *p != '\n' && *p != '\t'))
+            compact += *p;
+        if (in_string && !escaped && *p == '"')
+            in_string = false;
+        else if (!in_string && *p == '"')
+            in_string = true;
+        escaped = in_string && !escaped && *p == '\\';
+    }
+    check_equivalent(compact);
+}
+
+TEST_F(JsonFrontendTest, chain) { check_equivalent(chain_design(500)); }
+
+TEST_F(JsonFrontendTest, invalid)
+{
+    // Both parsers must reject these
+    for (std::string json : {R"({"modules": {}} x)", R"({"modules": {"top": "unterminated})", R"({"modules": [01]})",
+                             R"({"modules": {"a" 1}})", R"({"modules": {"a": 1,}})", R"({"modules": "\q"})",
+                             R"({"no_modules": {}})"}) {
+        auto reference = create_context();
+        EXPECT_THROW(parse_json11(json, reference.get()), log_execution_error_exception) << json;
+        auto ctx = create_context();
+        std::istringstream in(json);
+        EXPECT_THROW(parse_json(in, "design.json", ctx.get()), log_execution_error_exception) << json;
+    }
+}
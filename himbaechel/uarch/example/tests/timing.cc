@@ -0,0 +1,197 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include "command.h"
+#include "gtest/gtest.h"
+#include "nextpnr.h"
+#include "timing.h"
+
+USING_NEXTPNR_NAMESPACE
+
+class ExampleTimingTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() override
+    {
+        init_share_dirname();
+        ArchArgs chipArgs;
+        chipArgs.device = "EXAMPLE";
+        ctx = std::make_unique<Context>(chipArgs);
+        ctx->uarch->init(ctx.get());
+        ctx->late_init();
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        build_design();
+    }
+
+    // A path, as the input ports it goes through from the startpoint register to the endpoint one
+    typedef std::vector<std::pair<IdString, IdString>> Path;
+
+    CellInfo *add_cell(const std::string &name, IdString type, Loc loc)
+    {
+        CellInfo *cell = ctx->createCell(ctx->id(name), type);
+        ctx->bindBel(ctx->getBelByLocation(loc), cell, STRENGTH_LOCKED);
+        return cell;
+    }
+
+    void add_input(CellInfo *cell, IdString port, NetInfo *net)
+    {
+        cell->addInput(port);
+        cell->connectPort(port, net);
+    }
+
+    // Registers on two clocks, feeding each other through layers of LUTs that take their inputs from the layer
+    // before and from the registers. The route delay of each LUT input comes from a small set, and the delays of the
+    // LUT inputs step by the same amount, so that many paths have the same delay.
+    void build_design()
+    {
+        const int regs = 6, layers = 6, luts = 5;
+        NetInfo *clks[2] = {ctx->createNet(ctx->id("clk0")), ctx->createNet(ctx->id("clk1"))};
+        ctx->addClock(clks[0]->name, 100);
+        ctx->addClock(clks[1]->name, 50);
+        std::vector<NetInfo *> prev_layer;
+        for (int i = 0; i < regs; i++) {
+            CellInfo *ff = add_cell("ff" + std::to_string(i), ctx->id("DFF"), Loc(2 + i, 2, 1));
+            add_input(ff, ctx->id("CLK"), clks[i % 2]);
+            ff->addOutput(ctx->id("Q"));
+            NetInfo *q = ctx->createNet(ctx->id("q" + std::to_string(i)));
+            ff->connectPort(ctx->id("Q"), q);
+            prev_layer.push_back(q);
+            regs_q.push_back(q);
+        }
+        int next_route = 0;
+        for (int l = 0; l < layers; l++) {
+            std::vector<NetInfo *> layer;
+            for (int i = 0; i < luts; i++) {
+                std::string name = "lut" + std::to_string(l) + "_" + std::to_string(i);
+                CellInfo *lut = add_cell(name, ctx->id("LUT4"), Loc(2 + i, 4 + l, 0));
+                for (int j = 0; j < 3; j++) {
+                    NetInfo *in = (j == 2 && l > 0) ? regs_q.at((i + l) % regs)
+                                                     : prev_layer.at((i + j * (l + 1)) % prev_layer.size());
+                    IdString port = ctx->idf("I[%d]", j);
+                    add_input(lut, port, in);
+                    route_delays[CellPortKey(lut->name, port)] = 15 * (next_route++ % 3);
+                }
+                lut->addOutput(ctx->id("F"));
+                NetInfo *f = ctx->createNet(ctx->id(name + "_f"));
+                lut->connectPort(ctx->id("F"), f);
+                layer.push_back(f);
+            }
+            prev_layer = layer;
+        }
+        for (int i = 0; i < regs; i++) {
+            CellInfo *ff = ctx->cells.at(ctx->id("ff" + std::to_string(i))).get();
+            add_input(ff, ctx->id("D"), prev_layer.at(i % luts));
+            route_delays[CellPortKey(ff->name, ctx->id("D"))] = 15 * (next_route++ % 3);
+        }
+        ctx->assignArchInfo();
+    }
+
+    // Every register to register path, with its delay from the startpoint to the endpoint, by pair of clocks
+    void enumerate_paths(const NetInfo *net, IdString launch, Path &path, delay_t delay,
+                         std::map<std::pair<IdString, IdString>, std::vector<std::pair<delay_t, Path>>> &paths)
+    {
+        for (auto &usr : net->users) {
+            CellPortKey key(usr);
+            path.emplace_back(usr.cell->name, usr.port);
+            delay_t usr_delay = delay + route_delays.at(key);
+            if (usr.cell->type == ctx->id("DFF")) {
+                paths[std::make_pair(launch, usr.cell->getPort(ctx->id("CLK"))->name)].emplace_back(usr_delay, path);
+            } else {
+                DelayQuad lut_delay;
+                ASSERT_TRUE(ctx->getCellDelay(usr.cell, usr.port, ctx->id("F"), lut_delay));
+                enumerate_paths(usr.cell->getPort(ctx->id("F")), launch, path, usr_delay + lut_delay.maxDelay(),
+                                paths);
+            }
+            path.pop_back();
+        }
+    }
+
+    // The delays of the paths to report, taking the longest first but no more than per_endpoint to each endpoint
+    std::vector<delay_t> expected_delays(std::vector<std::pair<delay_t, Path>> paths, int count, int per_endpoint)
+    {
+        std::stable_sort(paths.begin(), paths.end(),
+                         [](const std::pair<delay_t, Path> &a, const std::pair<delay_t, Path> &b) {
+                             return a.first > b.first;
+                         });
+        std::map<IdString, int> endpoint_paths;
+        std::vector<delay_t> delays;
+        for (auto &path : paths) {
+            if (int(delays.size()) >= count)
+                break;
+            if (endpoint_paths[path.second.back().first]++ < per_endpoint)
+                delays.push_back(path.first);
+        }
+        return delays;
+    }
+
+    void check_worst_paths(int count, int per_endpoint)
+    {
+        SCOPED_TRACE("count " + std::to_string(count) + ", per endpoint " + std::to_string(per_endpoint));
+        std::map<std::pair<IdString, IdString>, std::vector<std::pair<delay_t, Path>>> paths;
+        for (auto q : regs_q) {
+            Path path;
+            enumerate_paths(q, q->driver.cell->getPort(ctx->id("CLK"))->name, path, 0, paths);
+        }
+        ASSERT_EQ(paths.size(), 4U);
+
+        TimingAnalyser tmg(ctx.get());
+        tmg.report_paths = count;
+        tmg.report_paths_per_endpoint = per_endpoint;
+        tmg.setup();
+        for (auto &rd : route_delays)
+            tmg.set_route_delay(rd.first, DelayPair(rd.second));
+        tmg.run(/*update_route_delays=*/false, /*update_histogram=*/false, /*update_crit_paths=*/true);
+
+        // The reported paths, identified by the input ports they go through, with their delays from the enumeration
+        std::map<std::pair<IdString, IdString>, std::vector<delay_t>> reported;
+        std::set<Path> seen;
+        for (auto &report : tmg.get_timing_result().worst_paths) {
+            auto clocks = std::make_pair(report.clock_pair.start.clock, report.clock_pair.end.clock);
+            Path path;
+            for (auto &seg : report.segments)
+                if (seg.type == CriticalPath::Segment::Type::ROUTING)
+                    path.push_back(seg.to);
+            EXPECT_TRUE(seen.insert(path).second) << "path reported twice";
+            auto &pair_paths = paths[clocks];
+            auto found = std::find_if(pair_paths.begin(), pair_paths.end(),
+                                      [&](const std::pair<delay_t, Path> &p) { return p.second == path; });
+            ASSERT_NE(found, pair_paths.end()) << "reported path does not exist";
+            reported[clocks].push_back(found->first);
+        }
+        for (auto &pair_paths : paths) {
+            SCOPED_TRACE(std::string(pair_paths.first.first.c_str(ctx.get())) + " -> " +
+                         pair_paths.first.second.c_str(ctx.get()));
+            EXPECT_EQ(reported[pair_paths.first], expected_delays(pair_paths.second, count, per_endpoint));
+        }
+    }
+
+    std::unique_ptr<Context> ctx;
+    std::vector<NetInfo *> regs_q;
+    dict<CellPortKey, delay_t> route_delays;
+};
+
+TEST_F(ExampleTimingTest, worst_paths)
+{
+    for (int per_endpoint : {1, 2, 5, 1000})
+        for (int count : {1, 3, 10, 40, 200, 100000})
+            check_worst_paths(count, per_endpoint);
+}
@@ -181,6 +181,18 @@ bool GateMateImpl::getClusterPlacement(ClusterId cluster, BelId root_bel,
 
 void GateMateImpl::prePlace() { assign_cell_info(); }
 
+void GateMateImpl::forkState(HimbaechelAPI *target) const
+{
+    // The CCF and the IO packer use up pads and choose the die, and the packer records DDR clock nets and multipliers
+    GateMateImpl *impl = static_cast<GateMateImpl *>(target);
+    impl->available_pads = available_pads;
+    impl->ddr_nets = ddr_nets;
+    impl->preferred_die = preferred_die;
+    impl->multipliers.clear();
+    for (CellInfo *mult : multipliers)
+        impl->multipliers.push_back(impl->ctx->cells.at(mult->name).get());
+}
+
 void GateMateImpl::postPlace() { repack(); }
 
 void GateMateImpl::preRoute()
@@ -43,6 +43,8 @@ struct GateMateImpl : HimbaechelAPI
     void postPlace() override;
     void preRoute() override;
     void postRoute() override;
+    bool canForkDesign() const override { return true; }
+    void forkState(HimbaechelAPI *target) const override;
 
     bool isBelLocationValid(BelId bel, bool explain_invalid = false) const override;
     delay_t estimateDelay(WireId src, WireId dst) const override;
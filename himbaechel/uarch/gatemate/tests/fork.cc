@@ -0,0 +1,130 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <memory>
+#include "testing.h"
+#define HIMBAECHEL_CONSTIDS "uarch/gatemate/constids.inc"
+#include "himbaechel_constids.h"
+
+USING_NEXTPNR_NAMESPACE
+
+class GateMateForkTest : public GateMateTest
+{
+  protected:
+    virtual void SetUp() override
+    {
+        GateMateTest::SetUp();
+        set_defaults(ctx);
+        // A register fed by the XOR of two inputs, clocked from a third
+        CellInfo *clk = create_cell_ptr(id_CC_IBUF, "clk_ibuf");
+        CellInfo *a = create_cell_ptr(id_CC_IBUF, "a_ibuf");
+        CellInfo *b = create_cell_ptr(id_CC_IBUF, "b_ibuf");
+        CellInfo *lut = create_cell_ptr(id_CC_LUT2, "lut");
+        lut->params[id_INIT] = Property(0b0110, 4);
+        CellInfo *dff = create_cell_ptr(id_CC_DFF, "dff");
+        CellInfo *obuf = create_cell_ptr(id_CC_OBUF, "q_obuf");
+        a->connectPorts(id_Y, lut, id_I0);
+        b->connectPorts(id_Y, lut, id_I1);
+        lut->connectPorts(id_O, dff, id_D);
+        clk->connectPorts(id_Y, dff, id_CLK);
+        dff->connectPorts(id_Q, obuf, id_A);
+        ASSERT_TRUE(ctx->pack());
+    }
+
+    // The defaults the command line handler would set
+    void set_defaults(Context *c)
+    {
+        c->settings[c->id("target_freq")] = std::to_string(12e6);
+        c->settings[c->id("timing_driven")] = true;
+        c->settings[c->id("slack_redist_iter")] = 0;
+        c->settings[c->id("auto_freq")] = false;
+        c->settings[c->id("placer")] = std::string("sa");
+        c->settings[c->id("router")] = Arch::defaultRouter;
+    }
+
+    std::unique_ptr<Context> fork_design()
+    {
+        auto forked = std::make_unique<Context>(chipArgs);
+        forked->uarch->init(forked.get());
+        forked->late_init();
+        set_defaults(forked.get());
+        ctx->forkInto(forked.get());
+        return forked;
+    }
+
+    // Checks that forked has the netlist, placement and routing of ctx, and the state the packer left in the uarch
+    void expect_same_design(const Context *forked)
+    {
+        ASSERT_EQ(forked->cells.size(), ctx->cells.size());
+        ASSERT_EQ(forked->nets.size(), ctx->nets.size());
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get(), *fi = forked->cells.at(cell.first).get();
+            EXPECT_EQ(fi->type, ci->type);
+            EXPECT_EQ(fi->params, ci->params);
+            EXPECT_EQ(fi->bel, ci->bel) << ctx->nameOf(ci);
+            for (auto &port : ci->ports) {
+                const NetInfo *fn = fi->getPort(port.first);
+                EXPECT_EQ(fn ? fn->name : IdString(), port.second.net ? port.second.net->name : IdString());
+            }
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get(), *fn = forked->nets.at(net.first).get();
+            ASSERT_EQ(fn->wires.size(), ni->wires.size()) << ctx->nameOf(ni);
+            for (auto &wire : ni->wires) {
+                EXPECT_EQ(fn->wires.at(wire.first).pip, wire.second.pip);
+                EXPECT_EQ(forked->getBoundWireNet(wire.first), fn);
+            }
+        }
+        const GateMateImpl *fimpl = static_cast<const GateMateImpl *>(forked->uarch.get());
+        EXPECT_EQ(fimpl->preferred_die, impl->preferred_die);
+        EXPECT_EQ(fimpl->available_pads, impl->available_pads);
+        EXPECT_EQ(fimpl->ddr_nets, impl->ddr_nets);
+        ASSERT_EQ(fimpl->multipliers.size(), impl->multipliers.size());
+        for (size_t i = 0; i < impl->multipliers.size(); i++)
+            EXPECT_EQ(fimpl->multipliers.at(i), forked->cells.at(impl->multipliers.at(i)->name).get());
+    }
+};
+
+TEST_F(GateMateForkTest, packed)
+{
+    ASSERT_TRUE(ctx->canForkDesign());
+    auto forked = fork_design();
+    expect_same_design(forked.get());
+    forked->check();
+}
+
+TEST_F(GateMateForkTest, routed)
+{
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    auto forked = fork_design();
+    expect_same_design(forked.get());
+    forked->check();
+}
+
+TEST_F(GateMateForkTest, same_result)
+{
+    auto forked = fork_design();
+    for (Context *c : {ctx, forked.get()}) {
+        c->rngseed(3);
+        ASSERT_TRUE(c->place());
+        ASSERT_TRUE(c->route());
+    }
+    expect_same_design(forked.get());
+}
@@ -31,6 +31,8 @@ struct GowinImpl : HimbaechelAPI
     void postPlace() override;
     void preRoute() override;
     void postRoute() override;
+    // Packing only rewrites and binds the netlist; the HCLK reservations and the validity cache are made by prePlace
+    bool canForkDesign() const override { return true; }
 
     bool isBelLocationValid(BelId bel, bool explain_invalid) const override;
     void notifyBelChange(BelId bel, CellInfo *cell) override;
@@ -315,6 +315,19 @@ bool NgUltraImpl::update_bff_to_scc(CellInfo *cell, BelId bel, PipId dst_pip)
     return false;
 }
 
+void NgUltraImpl::forkState(HimbaechelAPI *target) const
+{
+    // The packer assigns clock generators and GCKs, blocks pips used by its fixed routing, and the CSV sets bank
+    // voltages
+    NgUltraImpl *impl = static_cast<NgUltraImpl *>(target);
+    impl->bank_voltage = bank_voltage;
+    impl->gck_per_lobe = gck_per_lobe;
+    impl->blocked_pips = blocked_pips;
+    impl->bank_to_ckg = bank_to_ckg;
+    impl->unused_wfg = unused_wfg;
+    impl->unused_pll = unused_pll;
+}
+
 void NgUltraImpl::postRoute()
 {
     ctx->assignArchInfo();
@@ -53,6 +53,8 @@ struct NgUltraImpl : HimbaechelAPI
     void pack() override;
     void postPlace() override;
     void postRoute() override;
+    bool canForkDesign() const override { return true; }
+    void forkState(HimbaechelAPI *target) const override;
 
     void configurePlacerHeap(PlacerHeapCfg &cfg) override;
 
@@ -0,0 +1,116 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <memory>
+#include "command.h"
+#include "gtest/gtest.h"
+#include "nextpnr.h"
+#include "uarch/ng-ultra/ng_ultra.h"
+#define HIMBAECHEL_CONSTIDS "uarch/ng-ultra/constids.inc"
+#include "himbaechel_constids.h"
+
+USING_NEXTPNR_NAMESPACE
+
+class NGUltraForkTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        init_share_dirname();
+        chipArgs.device = "NG-ULTRA";
+        ctx = new Context(chipArgs);
+        ctx->uarch->init(ctx);
+        ctx->late_init();
+        impl = (NgUltraImpl *)(ctx->uarch.get());
+    }
+
+    virtual void TearDown() { delete ctx; }
+
+    std::unique_ptr<Context> fork_design()
+    {
+        auto forked = std::make_unique<Context>(chipArgs);
+        forked->uarch->init(forked.get());
+        forked->late_init();
+        ctx->forkInto(forked.get());
+        return forked;
+    }
+
+    void add_port(CellInfo *cell, const std::string &name, PortType dir)
+    {
+        IdString id = ctx->id(name);
+        cell->ports[id].name = id;
+        cell->ports[id].type = dir;
+    };
+
+    ArchArgs chipArgs;
+    Context *ctx;
+    NgUltraImpl *impl;
+};
+
+TEST_F(NGUltraForkTest, packer_state)
+{
+    // A placed LUT, and the state the packer and the CSV leave in the uarch
+    CellInfo *lut = ctx->createCell(ctx->id("lut"), id_BEYOND_FE);
+    add_port(lut, "I1", PORT_IN);
+    add_port(lut, "LO", PORT_OUT);
+    lut->params[id_lut_table] = Property(0xaaaa, 16);
+    lut->params[id_lut_used] = Property(1, 1);
+    lut->connectPort(id_LO, ctx->createNet(ctx->id("o")));
+    BelId lut_bel;
+    for (auto bel : ctx->getBels()) {
+        if (ctx->isValidBelForCellType(id_BEYOND_FE, bel)) {
+            lut_bel = bel;
+            break;
+        }
+    }
+    ASSERT_NE(lut_bel, BelId());
+    ctx->bindBel(lut_bel, lut, STRENGTH_LOCKED);
+
+    impl->bank_voltage["IOB0"] = "3.3V";
+    impl->blocked_pips.insert(*ctx->getPips().begin());
+    ASSERT_FALSE(impl->unused_wfg.empty());
+    impl->unused_wfg.erase(impl->unused_wfg.begin()->first);
+    ASSERT_FALSE(impl->unused_pll.empty());
+    impl->unused_pll.erase(impl->unused_pll.begin()->first);
+    GckConfig &gck = impl->gck_per_lobe.at(1).at(0);
+    gck.si1 = id_P17RI;
+    gck.used = true;
+
+    ASSERT_TRUE(ctx->canForkDesign());
+    auto forked = fork_design();
+    const CellInfo *fl = forked->cells.at(ctx->id("lut")).get();
+    EXPECT_EQ(fl->bel, lut_bel);
+    EXPECT_EQ(forked->getBoundBelCell(lut_bel), fl);
+    EXPECT_EQ(fl->params, lut->params);
+    ASSERT_NE(fl->getPort(id_LO), nullptr);
+    EXPECT_EQ(fl->getPort(id_LO)->name, ctx->id("o"));
+
+    const NgUltraImpl *fimpl = static_cast<const NgUltraImpl *>(forked->uarch.get());
+    EXPECT_EQ(fimpl->bank_voltage, impl->bank_voltage);
+    EXPECT_EQ(fimpl->blocked_pips, impl->blocked_pips);
+    EXPECT_FALSE(forked->checkPipAvail(*ctx->getPips().begin()));
+    EXPECT_EQ(fimpl->unused_wfg, impl->unused_wfg);
+    EXPECT_EQ(fimpl->unused_pll, impl->unused_pll);
+    EXPECT_EQ(fimpl->bank_to_ckg, impl->bank_to_ckg);
+    const GckConfig &fgck = fimpl->gck_per_lobe.at(1).at(0);
+    EXPECT_EQ(fgck.bel, gck.bel);
+    EXPECT_EQ(fgck.si1, gck.si1);
+    EXPECT_TRUE(fgck.used);
+    forked->check();
+}
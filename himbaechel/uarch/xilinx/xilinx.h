@@ -133,6 +133,8 @@ struct XilinxImpl : HimbaechelAPI
     void preRoute() override;
     void postPlace() override;
     void postRoute() override;
+    // The cell tags are assigned by prePlace, and tile_status follows from binding
+    bool canForkDesign() const override { return true; }
     void write_fasm(const std::string &filename);
 
     void configurePlacerHeap(PlacerHeapCfg &cfg) override;
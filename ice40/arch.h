@@ -850,6 +850,8 @@ struct Arch : BaseArch<ArchRanges>
     // netlist modifications, and validity checks
     void assignArchInfo() override;
     void assignCellInfo(CellInfo *cell);
+    // Packing only rewrites the netlist, and bel_carry and the switch state follow from binding
+    bool canForkDesign() const override { return true; }
 
     // -------------------------------------------------
     BelPin get_iob_sharing_pll_pin(BelId pll, IdString pll_pin) const
@@ -0,0 +1,157 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2025  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <sstream>
+#include "gtest/gtest.h"
+#include "json_frontend.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+namespace {
+// An adder bit and a register, so that packing makes a carry chain and a LUT/DFF pair
+const char *design = R"({"modules": {"top": {
+    "attributes": {"top": "00000000000000000000000000000001"},
+    "ports": {
+        "clk": {"direction": "input", "bits": [2]},
+        "a": {"direction": "input", "bits": [3]},
+        "b": {"direction": "input", "bits": [4]},
+        "q": {"direction": "output", "bits": [5]},
+        "co": {"direction": "output", "bits": [6]}
+    },
+    "cells": {
+        "sum": {"type": "SB_LUT4", "parameters": {"LUT_INIT": "0110100110010110"},
+                "port_directions": {"I0": "input", "I1": "input", "I2": "input", "I3": "input", "O": "output"},
+                "connections": {"I0": ["0"], "I1": [3], "I2": [4], "I3": ["0"], "O": [7]}},
+        "carry": {"type": "SB_CARRY",
+                  "port_directions": {"CI": "input", "I0": "input", "I1": "input", "CO": "output"},
+                  "connections": {"CI": ["0"], "I0": [3], "I1": [4], "CO": [8]}},
+        "carry_out": {"type": "SB_LUT4", "parameters": {"LUT_INIT": "1111111100000000"},
+                      "port_directions": {"I0": "input", "I1": "input", "I2": "input", "I3": "input", "O": "output"},
+                      "connections": {"I0": ["0"], "I1": ["0"], "I2": ["0"], "I3": [8], "O": [6]}},
+        "ff": {"type": "SB_DFF", "port_directions": {"C": "input", "D": "input", "Q": "output"},
+               "connections": {"C": [2], "D": [7], "Q": [5]}}
+    },
+    "netnames": {
+        "clk": {"bits": [2]}, "a": {"bits": [3]}, "b": {"bits": [4]}, "q": {"bits": [5]}, "co": {"bits": [6]},
+        "s": {"bits": [7]}, "c": {"bits": [8]}
+    }
+}}})";
+} // namespace
+
+class ICE40ForkTest : public ::testing::Test
+{
+  protected:
+    std::unique_ptr<Context> create_context()
+    {
+        ArchArgs chipArgs;
+        chipArgs.type = ArchArgs::HX1K;
+        chipArgs.package = "tq144";
+        auto ctx = std::make_unique<Context>(chipArgs);
+        // The defaults the command line handler would set
+        ctx->settings[ctx->id("target_freq")] = std::to_string(12e6);
+        ctx->settings[ctx->id("timing_driven")] = true;
+        ctx->settings[ctx->id("slack_redist_iter")] = 0;
+        ctx->settings[ctx->id("auto_freq")] = false;
+        ctx->settings[ctx->id("placer")] = std::string("sa");
+        ctx->settings[ctx->id("router")] = Arch::defaultRouter;
+        return ctx;
+    }
+
+    std::unique_ptr<Context> load_design()
+    {
+        auto ctx = create_context();
+        std::istringstream in(design);
+        EXPECT_TRUE(parse_json(in, "design.json", ctx.get()));
+        EXPECT_TRUE(ctx->pack());
+        return ctx;
+    }
+
+    std::unique_ptr<Context> fork_design(const Context *ctx)
+    {
+        auto forked = create_context();
+        ctx->forkInto(forked.get());
+        return forked;
+    }
+
+    // Checks that forked has the netlist, placement and routing of ctx, and that the arch state built from binding
+    // them is the same
+    void expect_same_design(const Context *ctx, const Context *forked)
+    {
+        ASSERT_EQ(forked->cells.size(), ctx->cells.size());
+        ASSERT_EQ(forked->nets.size(), ctx->nets.size());
+        for (auto &cell : ctx->cells) {
+            const CellInfo *ci = cell.second.get(), *fi = forked->cells.at(cell.first).get();
+            EXPECT_EQ(fi->type, ci->type);
+            EXPECT_EQ(fi->params, ci->params);
+            EXPECT_EQ(fi->bel, ci->bel) << ctx->nameOf(ci);
+            if (ci->type == id_ICESTORM_LC) {
+                EXPECT_EQ(fi->lcInfo.carryEnable, ci->lcInfo.carryEnable);
+                EXPECT_EQ(fi->lcInfo.inputCount, ci->lcInfo.inputCount);
+                EXPECT_EQ(fi->lcInfo.clk, fi->getPort(id_CLK));
+            }
+            for (auto &port : ci->ports) {
+                const NetInfo *fn = fi->getPort(port.first);
+                EXPECT_EQ(fn ? fn->name : IdString(), port.second.net ? port.second.net->name : IdString());
+            }
+        }
+        for (auto &net : ctx->nets) {
+            const NetInfo *ni = net.second.get(), *fn = forked->nets.at(net.first).get();
+            EXPECT_EQ(fn->is_global, ni->is_global);
+            ASSERT_EQ(fn->wires.size(), ni->wires.size()) << ctx->nameOf(ni);
+            for (auto &wire : ni->wires) {
+                EXPECT_EQ(fn->wires.at(wire.first).pip, wire.second.pip);
+                EXPECT_EQ(forked->getBoundWireNet(wire.first), fn);
+            }
+        }
+        EXPECT_EQ(forked->bel_carry, ctx->bel_carry);
+        EXPECT_EQ(forked->switches_locked, ctx->switches_locked);
+    }
+};
+
+TEST_F(ICE40ForkTest, packed)
+{
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->canForkDesign());
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ICE40ForkTest, routed)
+{
+    auto ctx = load_design();
+    ASSERT_TRUE(ctx->place());
+    ASSERT_TRUE(ctx->route());
+    auto forked = fork_design(ctx.get());
+    expect_same_design(ctx.get(), forked.get());
+    forked->check();
+}
+
+TEST_F(ICE40ForkTest, same_result)
+{
+    auto ctx = load_design();
+    auto forked = fork_design(ctx.get());
+    for (Context *c : {ctx.get(), forked.get()}) {
+        c->rngseed(3);
+        ASSERT_TRUE(c->place());
+        ASSERT_TRUE(c->route());
+    }
+    expect_same_design(ctx.get(), forked.get());
+}